@@ -0,0 +1,101 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/pcl_exports.h>
+
+#include <cstddef>
+#include <string>
+
+namespace pcl
+{
+  /** \brief Read-only memory mapping of an entire file.
+    *
+    * The mapping is released when the object is destroyed or close () is
+    * called. Pages are only loaded from disk when they are first accessed,
+    * so mapping a large file does not by itself consume any memory.
+    *
+    * \ingroup common
+    */
+  class PCL_EXPORTS MappedFile
+  {
+    public:
+      MappedFile () = default;
+      MappedFile (const MappedFile&) = delete;
+      MappedFile (MappedFile &&other) noexcept;
+
+      MappedFile&
+      operator = (const MappedFile&) = delete;
+      MappedFile&
+      operator = (MappedFile &&other) noexcept;
+
+      ~MappedFile () { close (); }
+
+      /** \brief Map the given file into memory (read-only).
+        * \param[in] file_name the name of the file to map
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      open (const std::string &file_name);
+
+      /** \brief Release the mapping (if any). */
+      void
+      close ();
+
+      /** \brief Whether a file is currently mapped. */
+      inline bool
+      isOpen () const { return (data_ != nullptr); }
+
+      /** \brief Get a pointer to the first byte of the mapped file, nullptr if no file is mapped. */
+      inline const unsigned char*
+      data () const { return (data_); }
+
+      /** \brief Get the size of the mapped file in bytes. */
+      inline std::size_t
+      size () const { return (size_); }
+
+    private:
+      /** \brief The start of the mapping. */
+      const unsigned char *data_{nullptr};
+
+      /** \brief The size of the mapping in bytes. */
+      std::size_t size_{0};
+  };
+}
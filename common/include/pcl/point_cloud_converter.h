@@ -0,0 +1,461 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/conversions.h>
+#include <pcl/for_each_type.h>
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/PCLPointField.h>
+#include <pcl/point_cloud.h>
+#include <pcl/type_traits.h>
+#include <pcl/console/print.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric> // for accumulate
+#include <vector>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Copy (or cast) one group of fields for a run of points.
+      * \param[in] src the first source field
+      * \param[in] src_step the distance in bytes between two source points
+      * \param[out] dst the first destination field
+      * \param[in] dst_step the distance in bytes between two destination points
+      * \param[in] nr_points the number of points
+      * \param[in] size the number of bytes to copy per point (or the number of elements to cast)
+      */
+    using ConversionKernel = void (*) (const std::uint8_t *src, std::size_t src_step,
+                                       std::uint8_t *dst, std::size_t dst_step,
+                                       std::size_t nr_points, std::size_t size);
+
+    /** \brief One step of a conversion plan. */
+    struct ConversionOp
+    {
+      std::size_t src_offset;
+      std::size_t dst_offset;
+      std::size_t size;
+      ConversionKernel kernel;
+    };
+
+    /** \brief Copy a field group whose size is known at compile time, so that
+      * each point is moved with a few (vector) loads and stores instead of a
+      * call to memcpy.
+      */
+    template <std::size_t Size> void
+    copyFieldGroup (const std::uint8_t *src, std::size_t src_step,
+                    std::uint8_t *dst, std::size_t dst_step,
+                    std::size_t nr_points, std::size_t)
+    {
+      for (std::size_t i = 0; i < nr_points; ++i, src += src_step, dst += dst_step)
+        memcpy (dst, src, Size);
+    }
+
+    /** \brief Copy a field group of any size. */
+    inline void
+    copyFieldGroup (const std::uint8_t *src, std::size_t src_step,
+                    std::uint8_t *dst, std::size_t dst_step,
+                    std::size_t nr_points, std::size_t size)
+    {
+      for (std::size_t i = 0; i < nr_points; ++i, src += src_step, dst += dst_step)
+        memcpy (dst, src, size);
+    }
+
+    /** \brief Cast a field of \a count elements of type SrcT to DstT. */
+    template <typename SrcT, typename DstT> void
+    castFieldGroup (const std::uint8_t *src, std::size_t src_step,
+                    std::uint8_t *dst, std::size_t dst_step,
+                    std::size_t nr_points, std::size_t count)
+    {
+      for (std::size_t i = 0; i < nr_points; ++i, src += src_step, dst += dst_step)
+      {
+        for (std::size_t c = 0; c < count; ++c)
+        {
+          SrcT value;
+          memcpy (&value, src + c * sizeof (SrcT), sizeof (SrcT));
+          const auto cast_value = static_cast<DstT> (value);
+          memcpy (dst + c * sizeof (DstT), &cast_value, sizeof (DstT));
+        }
+      }
+    }
+
+    /** \brief Get the copy kernel for a field group of the given size in bytes. */
+    inline ConversionKernel
+    getCopyKernel (std::size_t size)
+    {
+      switch (size)
+      {
+        case 1:  return (&copyFieldGroup<1>);
+        case 2:  return (&copyFieldGroup<2>);
+        case 4:  return (&copyFieldGroup<4>);
+        case 8:  return (&copyFieldGroup<8>);
+        case 12: return (&copyFieldGroup<12>);
+        case 16: return (&copyFieldGroup<16>);
+        case 20: return (&copyFieldGroup<20>);
+        case 24: return (&copyFieldGroup<24>);
+        case 32: return (&copyFieldGroup<32>);
+        case 48: return (&copyFieldGroup<48>);
+        case 64: return (&copyFieldGroup<64>);
+        default: return (static_cast<ConversionKernel> (&copyFieldGroup));
+      }
+    }
+
+    /** \brief Used together with `pcl::for_each_type`, adds a cast step for every point
+      * field that is stored with a different datatype in the serialized data (see FieldCaster).
+      */
+    template <typename PointT>
+    struct FieldCastPlanner
+    {
+      FieldCastPlanner (const std::vector<pcl::PCLPointField>& fields, std::vector<ConversionOp>& ops)
+        : fields_ (fields), ops_ (ops)
+      {}
+
+      template<typename Tag> void
+      operator () ()
+      {
+        // Fields that match exactly are copied
+        for (const auto& field : fields_)
+        {
+          if (FieldMatches<PointT, Tag>()(field))
+            return;
+        }
+        for (const auto& field : fields_)
+        {
+          if ((field.name == pcl::traits::name<PointT, Tag>::value) &&
+              (field.datatype != pcl::traits::datatype<PointT, Tag>::value) &&
+              ((field.count == pcl::traits::datatype<PointT, Tag>::size) ||
+               (field.count == 0 && pcl::traits::datatype<PointT, Tag>::size == 1)))
+          {
+            using DstT = typename pcl::traits::datatype<PointT, Tag>::decomposed::type;
+            ConversionOp op {field.offset, pcl::traits::offset<PointT, Tag>::value, pcl::traits::datatype<PointT, Tag>::size, nullptr};
+#define PCL_PLAN_CAST_POINT_FIELD(TYPE) case ::pcl::traits::asEnum_v<TYPE>: \
+            PCL_WARN ("Will try to cast field '%s' (original type is " #TYPE "). You may loose precision during casting. Make sure that this is acceptable or choose a different point type.\n", pcl::traits::name<PointT, Tag>::value); \
+            op.kernel = &castFieldGroup<TYPE, DstT>; \
+            break;
+
+            switch (field.datatype)
+            {
+              PCL_PLAN_CAST_POINT_FIELD(bool)
+              PCL_PLAN_CAST_POINT_FIELD(std::int8_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::uint8_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::int16_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::uint16_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::int32_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::uint32_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::int64_t)
+              PCL_PLAN_CAST_POINT_FIELD(std::uint64_t)
+              PCL_PLAN_CAST_POINT_FIELD(float)
+              PCL_PLAN_CAST_POINT_FIELD(double)
+              default:
+                PCL_WARN ("Unknown datatype: %d\n", static_cast<int> (field.datatype));
+                return;
+            }
+#undef PCL_PLAN_CAST_POINT_FIELD
+            ops_.push_back (op);
+            return;
+          }
+        }
+      }
+
+      const std::vector<pcl::PCLPointField>& fields_;
+      std::vector<ConversionOp>& ops_;
+    };
+  } // namespace detail
+
+  /** \brief Converts between pcl::PCLPointCloud2 and pcl::PointCloud<PointT> with a
+    * conversion plan that is computed once per data layout.
+    *
+    * fromPCLPointCloud2 () and toPCLPointCloud2 () look up the fields of the
+    * point type and of the message on every call. A PointCloudConverter does
+    * this once, when the first message with a given layout is converted, and
+    * stores the resulting list of field group copies (and casts). Each copy
+    * uses a kernel specialized for its size. Keep the converter around to
+    * convert a stream of messages with the same layout, e.g. one per frame:
+    *
+    * \code
+    * pcl::PointCloudConverter<pcl::PointXYZI> converter;
+    * converter.setNumberOfThreads (4);
+    * pcl::PointCloud<pcl::PointXYZI> cloud;
+    * for (const auto &msg : messages)
+    *   converter.fromPCLPointCloud2 (msg, cloud);
+    * \endcode
+    *
+    * The results are identical to the ones of the free functions.
+    * \ingroup common
+    */
+  template <typename PointT>
+  class PointCloudConverter
+  {
+    public:
+      PointCloudConverter () = default;
+
+      /** \brief Set the number of threads used to convert the points.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+#ifdef _OPENMP
+        num_threads_ = (nr_threads == 0) ? omp_get_num_procs () : nr_threads;
+        PCL_DEBUG ("[pcl::PointCloudConverter::setNumberOfThreads] Setting number of threads to %u.\n", num_threads_);
+#else
+        num_threads_ = 1;
+        if (nr_threads != 1)
+          PCL_WARN ("[pcl::PointCloudConverter::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+      }
+
+      /** \brief Get the number of threads used to convert the points. */
+      inline unsigned int
+      getNumberOfThreads () const { return (num_threads_); }
+
+      /** \brief Convert a PCLPointCloud2 binary data blob into a pcl::PointCloud<T> object.
+        * \param[in] msg the PCLPointCloud2 binary blob
+        * \param[out] cloud the resultant pcl::PointCloud<T>
+        */
+      inline void
+      fromPCLPointCloud2 (const pcl::PCLPointCloud2 &msg, pcl::PointCloud<PointT> &cloud)
+      {
+        fromPCLPointCloud2 (msg, cloud, msg.data.data ());
+      }
+
+      /** \brief Convert a PCLPointCloud2 binary data blob into a pcl::PointCloud<T> object.
+        * \param[in] msg the PCLPointCloud2 binary blob (note that the binary point data in msg.data will not be used!)
+        * \param[out] cloud the resultant pcl::PointCloud<T>
+        * \param[in] msg_data pointer to binary blob data, used instead of msg.data
+        */
+      void
+      fromPCLPointCloud2 (const pcl::PCLPointCloud2 &msg, pcl::PointCloud<PointT> &cloud, const std::uint8_t *msg_data)
+      {
+        // Copy info fields
+        cloud.header   = msg.header;
+        cloud.width    = msg.width;
+        cloud.height   = msg.height;
+        cloud.is_dense = msg.is_dense == 1;
+
+        // Resize cloud
+        cloud.resize (msg.width * msg.height);
+
+        // check if there is data to copy
+        if (msg.width * msg.height == 0)
+          return;
+
+        if (!from_valid_ || msg.point_step != from_point_step_ || !isSameLayout (msg.fields, from_fields_))
+          compileFromPlan (msg.fields, msg.point_step);
+
+        convert (from_ops_, msg_data, msg.point_step, msg.row_step,
+                 reinterpret_cast<std::uint8_t*> (cloud.data ()), sizeof (PointT), sizeof (PointT) * cloud.width,
+                 cloud.width, cloud.height, num_threads_);
+      }
+
+      /** \brief Convert a pcl::PointCloud<T> object to a PCLPointCloud2 binary data blob.
+        * \param[in] cloud the input pcl::PointCloud<T>
+        * \param[out] msg the resultant PCLPointCloud2 binary blob
+        * \param[in] padding whether to copy the padding of the point type to the
+        * PCLPointCloud2 (see pcl::toPCLPointCloud2)
+        */
+      void
+      toPCLPointCloud2 (const pcl::PointCloud<PointT> &cloud, pcl::PCLPointCloud2 &msg, bool padding = true)
+      {
+        // Ease the user's burden on specifying width/height for unorganized datasets
+        if (cloud.width == 0 && cloud.height == 0)
+        {
+          msg.width  = cloud.size ();
+          msg.height = 1;
+        }
+        else
+        {
+          assert (cloud.size () == cloud.width * cloud.height);
+          msg.height = cloud.height;
+          msg.width  = cloud.width;
+        }
+
+        if (!to_valid_ || padding != to_padding_)
+          compileToPlan (padding);
+
+        msg.fields     = to_fields_;
+        msg.point_step = to_point_step_;
+        msg.row_step   = to_point_step_ * msg.width;
+        msg.data.resize (static_cast<std::size_t> (to_point_step_) * cloud.size ());
+        if (!cloud.empty ())
+          convert (to_ops_, reinterpret_cast<const std::uint8_t*> (cloud.data ()), sizeof (PointT), sizeof (PointT) * msg.width,
+                   msg.data.data (), msg.point_step, msg.row_step, msg.width, msg.height, num_threads_);
+
+        msg.header   = cloud.header;
+        msg.is_dense = cloud.is_dense;
+      }
+
+    protected:
+      /** \brief Check whether two lists of fields describe the same layout. */
+      static bool
+      isSameLayout (const std::vector<pcl::PCLPointField> &a, const std::vector<pcl::PCLPointField> &b)
+      {
+        return (std::equal (a.cbegin (), a.cend (), b.cbegin (), b.cend (),
+                            [] (const pcl::PCLPointField &fa, const pcl::PCLPointField &fb)
+                            {
+                              return (fa.offset == fb.offset && fa.datatype == fb.datatype &&
+                                      fa.count == fb.count && fa.name == fb.name);
+                            }));
+      }
+
+      /** \brief Compute the conversion plan from a message with the given layout. */
+      void
+      compileFromPlan (const std::vector<pcl::PCLPointField> &fields, uindex_t point_step)
+      {
+        MsgFieldMap field_map;
+        createMapping<PointT> (fields, field_map);
+
+        from_ops_.clear ();
+        for (const auto &mapping : field_map)
+          from_ops_.push_back ({mapping.serialized_offset, mapping.struct_offset, mapping.size, detail::getCopyKernel (mapping.size)});
+        // If any fields in msg and cloud have different datatypes but the same name, cast them
+        for_each_type<typename traits::fieldList<PointT>::type> (detail::FieldCastPlanner<PointT> (fields, from_ops_));
+
+        from_fields_ = fields;
+        from_point_step_ = point_step;
+        from_valid_ = true;
+      }
+
+      /** \brief Compute the conversion plan to a message, with or without padding. */
+      void
+      compileToPlan (bool padding)
+      {
+        to_fields_.clear ();
+        std::vector<std::size_t> field_sizes;
+        for_each_type<typename pcl::traits::fieldList<PointT>::type> (pcl::detail::FieldAdderAdvanced<PointT> (to_fields_, field_sizes));
+
+        to_ops_.clear ();
+        // Check if padding should be kept, or if the point type does not contain padding
+        if (padding || std::accumulate (field_sizes.begin (), field_sizes.end (), static_cast<std::size_t> (0)) == sizeof (PointT))
+        {
+          to_point_step_ = sizeof (PointT);
+          to_ops_.push_back ({0, 0, sizeof (PointT), detail::getCopyKernel (sizeof (PointT))});
+        }
+        else
+        {
+          std::size_t point_size = 0;
+          for (std::size_t i = 0; i < to_fields_.size (); ++i)
+          {
+            // Coalesce fields that are adjacent in the point type
+            if (!to_ops_.empty () && to_ops_.back ().src_offset + to_ops_.back ().size == to_fields_[i].offset)
+              to_ops_.back ().size += field_sizes[i];
+            else
+              to_ops_.push_back ({to_fields_[i].offset, point_size, field_sizes[i], nullptr});
+            to_fields_[i].offset = point_size; // Adjust offset when padding is removed
+            point_size += field_sizes[i];
+          }
+          for (auto &op : to_ops_)
+            op.kernel = detail::getCopyKernel (op.size);
+          to_point_step_ = point_size;
+        }
+
+        to_padding_ = padding;
+        to_valid_ = true;
+      }
+
+      /** \brief Run a conversion plan on all points, in blocks of consecutive points of the same row.
+        * \param[in] ops the conversion plan
+        * \param[in] src the source points
+        * \param[in] src_point_step the distance in bytes between two source points
+        * \param[in] src_row_step the distance in bytes between two source rows
+        * \param[out] dst the destination points
+        * \param[in] dst_point_step the distance in bytes between two destination points
+        * \param[in] dst_row_step the distance in bytes between two destination rows
+        * \param[in] width the number of points per row
+        * \param[in] height the number of rows
+        * \param[in] num_threads the number of threads to use
+        */
+      static void
+      convert (const std::vector<detail::ConversionOp> &ops,
+               const std::uint8_t *src, std::size_t src_point_step, std::size_t src_row_step,
+               std::uint8_t *dst, std::size_t dst_point_step, std::size_t dst_row_step,
+               std::size_t width, std::size_t height, unsigned int num_threads)
+      {
+        // Points that are copied as a whole are moved with a single memcpy per block
+        bool whole_points = (ops.size () == 1 && ops[0].src_offset == 0 && ops[0].dst_offset == 0 &&
+                             ops[0].size == src_point_step && ops[0].size == dst_point_step &&
+                             ops[0].kernel == detail::getCopyKernel (ops[0].size));
+        std::size_t block_size = 4096;
+        std::size_t blocks_per_row = (width + block_size - 1) / block_size;
+        auto nr_blocks = static_cast<std::ptrdiff_t> (blocks_per_row * height);
+
+#pragma omp parallel for \
+  default(none) \
+  shared(ops, src, src_point_step, src_row_step, dst, dst_point_step, dst_row_step, width, whole_points, block_size, blocks_per_row, nr_blocks) \
+  num_threads(num_threads)
+        for (std::ptrdiff_t b = 0; b < nr_blocks; ++b)
+        {
+          const std::size_t row = b / blocks_per_row;
+          const std::size_t col = (b % blocks_per_row) * block_size;
+          const std::size_t nr_points = std::min (block_size, width - col);
+          const std::uint8_t *src_block = src + row * src_row_step + col * src_point_step;
+          std::uint8_t *dst_block = dst + row * dst_row_step + col * dst_point_step;
+          if (whole_points)
+          {
+            memcpy (dst_block, src_block, nr_points * src_point_step);
+            continue;
+          }
+          for (const auto &op : ops)
+            op.kernel (src_block + op.src_offset, src_point_step, dst_block + op.dst_offset, dst_point_step, nr_points, op.size);
+        }
+      }
+
+      /** \brief The layout of the last message converted with fromPCLPointCloud2 (). */
+      std::vector<pcl::PCLPointField> from_fields_;
+      uindex_t from_point_step_{0};
+      bool from_valid_{false};
+
+      /** \brief The plan to convert from messages with the layout from_fields_. */
+      std::vector<detail::ConversionOp> from_ops_;
+
+      /** \brief The fields of the messages created by toPCLPointCloud2 (). */
+      std::vector<pcl::PCLPointField> to_fields_;
+      uindex_t to_point_step_{0};
+      bool to_padding_{true};
+      bool to_valid_{false};
+
+      /** \brief The plan to convert to messages with the layout to_fields_. */
+      std::vector<detail::ConversionOp> to_ops_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int num_threads_{1};
+  };
+}
@@ -0,0 +1,84 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/types.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Buffers of the neighbor searches of one thread.
+    *
+    * The searches that are given a context store their results in \a indices and
+    * \a sqr_distances, and their intermediate data in the remaining buffers. The buffers
+    * belong to the caller and are only ever resized. With search::BruteForce, the searches
+    * through a context stop allocating once it has been used for a few queries. Other
+    * search methods may still allocate inside every search, e.g. search::KdTree in the
+    * result sets of FLANN. A context can be used with any search method, but not by two
+    * threads at the same time: give every thread its own one.
+    *
+    * \ingroup common
+    */
+  struct SearchContext
+  {
+    /** \brief The indices of the neighbors found by the last search. */
+    Indices indices;
+
+    /** \brief The squared distances of the neighbors found by the last search. */
+    std::vector<float> sqr_distances;
+
+    /** \brief The query point, as converted by the point representation of the search method. */
+    std::vector<float> query;
+
+    /** \brief Intermediate neighbor indices, in the layout of FLANN's searches. */
+    std::vector<std::vector<std::size_t> > search_indices;
+
+    /** \brief Intermediate neighbor distances, in the layout of FLANN's searches. */
+    std::vector<std::vector<float> > search_sqr_distances;
+
+    /** \brief Size the result buffers for searches for \a max_nn neighbors. */
+    inline void
+    resize (std::size_t max_nn)
+    {
+      indices.resize (max_nn);
+      sqr_distances.resize (max_nn);
+    }
+  };
+} // namespace pcl
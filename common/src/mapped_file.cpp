@@ -0,0 +1,172 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/common/mapped_file.h>
+#include <pcl/console/print.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <io.h>
+# include <windows.h>
+#else
+# include <unistd.h>
+# include <sys/mman.h>
+#endif
+#include <fcntl.h>
+
+namespace
+{
+#ifdef _WIN32
+  inline int
+  openFile (const char *file_name) { return (::_open (file_name, _O_RDONLY | _O_BINARY)); }
+
+  inline int
+  closeFile (int fd) { return (::_close (fd)); }
+
+  inline long long
+  fileSize (int fd) { return (::_lseeki64 (fd, 0, SEEK_END)); }
+#else
+  inline int
+  openFile (const char *file_name) { return (::open (file_name, O_RDONLY)); }
+
+  inline int
+  closeFile (int fd) { return (::close (fd)); }
+
+  inline long long
+  fileSize (int fd) { return (static_cast<long long> (::lseek (fd, 0, SEEK_END))); }
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::MappedFile::MappedFile (MappedFile &&other) noexcept
+  : data_ (std::exchange (other.data_, nullptr))
+  , size_ (std::exchange (other.size_, 0))
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::MappedFile&
+pcl::MappedFile::operator = (MappedFile &&other) noexcept
+{
+  if (this != &other)
+  {
+    close ();
+    data_ = std::exchange (other.data_, nullptr);
+    size_ = std::exchange (other.size_, 0);
+  }
+  return (*this);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::MappedFile::open (const std::string &file_name)
+{
+  close ();
+
+  int fd = openFile (file_name.c_str ());
+  if (fd == -1)
+  {
+    PCL_ERROR ("[pcl::MappedFile::open] Failure to open file %s\n", file_name.c_str ());
+    return (-1);
+  }
+
+  const auto file_size = fileSize (fd);
+  if (file_size <= 0)
+  {
+    closeFile (fd);
+    PCL_ERROR ("[pcl::MappedFile::open] File %s is empty or its size could not be determined.\n", file_name.c_str ());
+    return (-1);
+  }
+
+#ifdef _WIN32
+  HANDLE fm = CreateFileMapping ((HANDLE) _get_osfhandle (fd), NULL, PAGE_READONLY, 0, 0, NULL);
+  if (fm == NULL)
+  {
+    closeFile (fd);
+    PCL_ERROR ("[pcl::MappedFile::open] Error creating file mapping for %s\n", file_name.c_str ());
+    return (-1);
+  }
+  auto *map = static_cast<const unsigned char*> (MapViewOfFile (fm, FILE_MAP_READ, 0, 0, 0));
+  // The view keeps a reference to the mapping object
+  CloseHandle (fm);
+  if (map == NULL)
+  {
+    closeFile (fd);
+    PCL_ERROR ("[pcl::MappedFile::open] Error mapping view of file %s\n", file_name.c_str ());
+    return (-1);
+  }
+#else
+  auto *map = static_cast<const unsigned char*> (::mmap (nullptr, static_cast<std::size_t> (file_size), PROT_READ, MAP_SHARED, fd, 0));
+  if (map == reinterpret_cast<const unsigned char*> (-1))    // MAP_FAILED
+  {
+    closeFile (fd);
+    PCL_ERROR ("[pcl::MappedFile::open] Error preparing mmap for %s: %s\n", file_name.c_str (), strerror (errno));
+    return (-1);
+  }
+#endif
+  // The mapping stays valid after the descriptor has been closed
+  closeFile (fd);
+
+  data_ = map;
+  size_ = static_cast<std::size_t> (file_size);
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::MappedFile::close ()
+{
+  if (!data_)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile (data_);
+#else
+  if (::munmap (const_cast<unsigned char*> (data_), size_) == -1)
+    PCL_ERROR ("[pcl::MappedFile::close] Munmap failure\n");
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
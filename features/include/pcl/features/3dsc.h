@@ -157,6 +157,14 @@ namespace pcl
       inline double
       getPointDensityRadius () { return (point_density_radius_); }
 
+      /** \brief Initialize the scheduler and set the number of threads to use. The default behavior is
+        * single threaded execution. The random X axes are drawn in the order of the points, so the descriptors
+        * do not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
     protected:
       /** \brief Initialize computation by allocating all the intervals and the volume lookup table. */
       bool
@@ -173,6 +181,32 @@ namespace pcl
       bool
       computePoint (std::size_t index, const pcl::PointCloud<PointNT> &normals, float rf[9], std::vector<float> &desc);
 
+      /** \brief Find the nearest neighbor of a point, whose normal is used as the normal of the point.
+        * \param[in] normals a pointer to the set of normals
+        * \param[in] nn_indices the neighbors of the point within search_radius_
+        * \param[in] nn_dists the squared distances to the neighbors
+        * \return the index of the nearest neighbor, or -1 if there is none or if its normal is not finite
+        */
+      index_t
+      findNormalIndex (const pcl::PointCloud<PointNT> &normals,
+                       const pcl::Indices &nn_indices, const std::vector<float> &nn_dists) const;
+
+      /** \brief Accumulate the neighbors of a point in its descriptor.
+        * \param[in] index the index of the point to estimate a descriptor for
+        * \param[in] normal the normal of the point
+        * \param[in] random_axis the random vector the X axis of the reference frame is derived from
+        * \param[in] nn_indices the neighbors of the point
+        * \param[in] nn_dists the squared distances to the neighbors
+        * \param[out] neighbour_indices buffer for the local point density searches
+        * \param[out] neighbour_distances buffer for the local point density searches
+        * \param[out] desc the resultant descriptor, which must be initialized to zero
+        */
+      void
+      computeHistogram (std::size_t index, const Eigen::Vector3f &normal, const Eigen::Vector3f &random_axis,
+                        const pcl::Indices &nn_indices, const std::vector<float> &nn_dists,
+                        pcl::Indices &neighbour_indices, std::vector<float> &neighbour_distances,
+                        std::vector<float> &desc) const;
+
       /** \brief Estimate the actual feature.
         * \param[out] output the resultant feature
         */
@@ -209,6 +243,9 @@ namespace pcl
       /** \brief Descriptor length */
       std::size_t descriptor_length_{};
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
+
       /** \brief Random number generator algorithm. */
       std::mt19937 rng_;
 
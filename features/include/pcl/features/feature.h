@@ -49,6 +49,7 @@
 #include <pcl/pcl_base.h>
 #include <pcl/pcl_macros.h>
 #include <pcl/search/search.h>
+#include <pcl/features/neighborhood_graph.h>
 
 #include <functional>
 
@@ -123,6 +124,8 @@ namespace pcl
 
       using PointCloudOut = pcl::PointCloud<PointOutT>;
 
+      using NeighborhoodGraphConstPtr = typename pcl::NeighborhoodGraph<PointInT>::ConstPtr;
+
       using SearchMethod = std::function<int (std::size_t, double, pcl::Indices &, std::vector<float> &)>;
       using SearchMethodSurface = std::function<int (const PointCloudIn &cloud, std::size_t index, double, pcl::Indices &, std::vector<float> &)>;
 
@@ -132,7 +135,7 @@ namespace pcl
         feature_name_ (), search_method_surface_ (),
         surface_(), tree_(),
         search_parameter_(0), search_radius_(0), k_(0),
-        fake_surface_(false)
+        fake_surface_(false), use_neighborhood_graph_(false)
       {}
 
       /** \brief Provide a pointer to a dataset to add additional information
@@ -207,6 +210,22 @@ namespace pcl
         return (search_radius_);
       }
 
+      /** \brief Provide precomputed neighborhoods to serve the neighbor searches from.
+        * The graph is only used if it was computed on the search surface of this estimator and with the same
+        * kind of search and search parameter. Searches for points of its input cloud are then answered
+        * from memory, all other searches still go to the search method.
+        * \param[in] graph the neighborhood graph (an empty pointer disables it)
+        */
+      inline void
+      setNeighborhoodGraph (const NeighborhoodGraphConstPtr &graph) { neighborhood_graph_ = graph; }
+
+      /** \brief Get the precomputed neighborhoods used by the neighbor searches. */
+      inline NeighborhoodGraphConstPtr
+      getNeighborhoodGraph () const
+      {
+        return (neighborhood_graph_);
+      }
+
       /** \brief Base method for feature estimation for all points given in
         * <setInputCloud (), setIndices ()> using the surface in setSearchSurface ()
         * and the spatial locator in setSearchMethod ()
@@ -239,6 +258,9 @@ namespace pcl
       /** \brief The number of K nearest neighbors to use for each point. */
       int k_;
 
+      /** \brief Optional precomputed neighborhoods of the search surface. */
+      NeighborhoodGraphConstPtr neighborhood_graph_;
+
       /** \brief Get a string representation of the name of this class. */
       inline const std::string&
       getClassName () const { return (feature_name_); }
@@ -289,7 +311,48 @@ namespace pcl
         return (search_method_surface_ (cloud, index, parameter, indices, distances));
       }
 
+      /** \brief Search for k-nearest neighbors using the spatial locator from
+        * \a setSearchmethod, and the given surface from \a setSearchSurface, in the buffers
+        * of a search context.
+        * \param[in] index the index of the query point
+        * \param[in] parameter the search parameter (either k or radius)
+        * \param[in,out] context the search buffers of the calling thread, holding the
+        * neighbors and their squared distances afterwards
+        *
+        * \return the number of neighbors found. If no neighbors are found or an error occurred, return 0.
+        */
+      inline int
+      searchForNeighbors (std::size_t index, double parameter, SearchContext &context) const
+      {
+        return (searchForNeighbors (*input_, index, parameter, context));
+      }
+
+      /** \brief Search for k-nearest neighbors using the spatial locator from
+        * \a setSearchmethod, and the given surface from \a setSearchSurface, in the buffers
+        * of a search context.
+        * \param[in] cloud the query point cloud
+        * \param[in] index the index of the query point in \a cloud
+        * \param[in] parameter the search parameter (either k or radius)
+        * \param[in,out] context the search buffers of the calling thread, holding the
+        * neighbors and their squared distances afterwards
+        *
+        * \return the number of neighbors found. If no neighbors are found or an error occurred, return 0.
+        */
+      inline int
+      searchForNeighbors (const PointCloudIn &cloud, std::size_t index, double parameter,
+                          SearchContext &context) const
+      {
+        if (use_neighborhood_graph_)
+          return (search_method_surface_ (cloud, index, parameter, context.indices, context.sqr_distances));
+        if (search_radius_ != 0.0)
+          return (tree_->radiusSearch (cloud, static_cast<index_t> (index), parameter, context, 0));
+        return (tree_->nearestKSearch (cloud, static_cast<index_t> (index), static_cast<int> (parameter), context));
+      }
+
     private:
+      /** \brief Whether the searches are served from \a neighborhood_graph_ (set by initCompute). */
+      bool use_neighborhood_graph_;
+
       /** \brief Abstract feature estimation method.
         * \param[out] output the resultant features
         */
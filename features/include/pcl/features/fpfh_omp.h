@@ -42,12 +42,17 @@
 
 #include <pcl/features/feature.h>
 #include <pcl/features/fpfh.h>
+#include <pcl/features/simd_lanes.h>
 
 namespace pcl
 {
   /** \brief FPFHEstimationOMP estimates the Fast Point Feature Histogram (FPFH) descriptor for a given point cloud
     * dataset containing points and normals, in parallel, using the OpenMP standard.
     *
+    * The neighborhood of every query point is searched only once and reused for its SPFH signature whenever the
+    * search surface is the input cloud. The pair features of a point and its neighbors are computed for several
+    * neighbors at once, so the signatures are equal to those of FPFHEstimation up to floating point rounding.
+    *
     * \note If you use this code in any academic work, please cite:
     *
     *   - R.B. Rusu, N. Blodow, M. Beetz.
@@ -88,7 +93,9 @@ namespace pcl
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f2_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f3_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::weightPointSPFHSignature;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::d_pi_;
 
+      using PointCloudIn = typename Feature<PointInT, PointOutT>::PointCloudIn;
       using PointCloudOut = typename Feature<PointInT, PointOutT>::PointCloudOut;
 
       /** \brief Initialize the scheduler and set the number of threads to use.
@@ -116,6 +123,36 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output) override;
 
+      /** \brief Search the neighborhoods of a set of points in parallel.
+        * \param[in] cloud the cloud the query indices refer to
+        * \param[in] queries the indices of the query points
+        * \param[out] nn_indices the neighbor indices of every query point (empty if the search failed)
+        * \param[out] nn_dists the squared neighbor distances of every query point
+        */
+      void
+      searchNeighborhoods (const PointCloudIn &cloud, const pcl::Indices &queries,
+                           std::vector<pcl::Indices> &nn_indices, std::vector<std::vector<float> > &nn_dists) const;
+
+      static constexpr std::size_t LANES = detail::float_lanes;
+
+      /** \brief The bin counts of every lane, one column per bin of the three concatenated histograms. */
+      using LaneBinCounts = Eigen::Array<int, LANES, Eigen::Dynamic>;
+
+      /** \brief Compute the SPFH signature of a point of the search surface. The pair features are computed and
+        * binned for LANES neighbors at once. Every lane counts its pairs in its own row of \a bin_counts, which
+        * are summed up into the three consecutive histograms of \a spfh at the end. Like in
+        * FPFHEstimation::computePointSPFHSignature, pairs without valid features are counted with all
+        * their features set to 0.
+        * \param[in] p_idx the index of the point in the search surface
+        * \param[in] nn_indices the neighborhood of the point
+        * \param[out] bin_counts scratch space for the bin counts of every lane
+        * \param[out] spfh the concatenated f1, f2 and f3 histograms, which have to be zeroed
+        * \return the sum of each of the three histograms
+        */
+      double
+      computeSPFHSignatureBatched (pcl::index_t p_idx, const pcl::Indices &nn_indices, LaneBinCounts &bin_counts,
+                                   float *spfh) const;
+
     public:
       /** \brief The number of subdivisions for each angular feature interval. */
       int nr_bins_f1_{11}, nr_bins_f2_{11}, nr_bins_f3_{11};
@@ -128,46 +128,84 @@ pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::initCompute ()
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::ShapeContext3DEstimation::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::ShapeContext3DEstimation::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> bool
 pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::computePoint (
     std::size_t index, const pcl::PointCloud<PointNT> &normals, float rf[9], std::vector<float> &desc)
 {
-  // The RF is formed as this x_axis | y_axis | normal
-  Eigen::Map<Eigen::Vector3f> x_axis (rf);
-  Eigen::Map<Eigen::Vector3f> y_axis (rf + 3);
-  Eigen::Map<Eigen::Vector3f> normal (rf + 6);
-
   // Find every point within specified search_radius_
   pcl::Indices nn_indices;
   std::vector<float> nn_dists;
-  const std::size_t neighb_cnt = searchForNeighbors ((*indices_)[index], search_radius_, nn_indices, nn_dists);
-  if (neighb_cnt == 0)
+  index_t normal_index = -1;
+  if (searchForNeighbors ((*indices_)[index], search_radius_, nn_indices, nn_dists) != 0)
+    normal_index = findNormalIndex (normals, nn_indices, nn_dists);
+  if (normal_index == -1)
   {
     std::fill (desc.begin (), desc.end (), std::numeric_limits<float>::quiet_NaN ());
     std::fill_n (rf, 9, 0.f);
     return (false);
   }
 
+  Eigen::Vector3f random_axis;
+  random_axis[0] = rnd ();
+  random_axis[1] = rnd ();
+  random_axis[2] = rnd ();
+  pcl::Indices neighbour_indices;
+  std::vector<float> neighbour_distances;
+  computeHistogram (index, normals[normal_index].getNormalVector3fMap (), random_axis, nn_indices, nn_dists,
+                    neighbour_indices, neighbour_distances, desc);
+
+  // 3DSC does not define a repeatable local RF, we set it to zero to signal it to the user
+  std::fill_n (rf, 9, 0);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> pcl::index_t
+pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::findNormalIndex (
+    const pcl::PointCloud<PointNT> &normals, const pcl::Indices &nn_indices, const std::vector<float> &nn_dists) const
+{
+  if (nn_indices.empty ())
+    return (-1);
+
   const auto minDistanceIt = std::min_element(nn_dists.begin (), nn_dists.end ());
   const auto minIndex = nn_indices[std::distance (nn_dists.begin (), minDistanceIt)];
 
-  // Get origin point
-  Vector3fMapConst origin = (*input_)[(*indices_)[index]].getVector3fMap ();
-  // Get origin normal
   // Use pre-computed normals
   if (!pcl::isNormalFinite(normals[minIndex]))
-  {
-    std::fill (desc.begin (), desc.end (), std::numeric_limits<float>::quiet_NaN ());
-    std::fill (rf, rf + 9, 0.f);
-    return (false);
-  }
-  normal = normals[minIndex].getNormalVector3fMap ();
+    return (-1);
+  return (minIndex);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::computeHistogram (
+    std::size_t index, const Eigen::Vector3f &normal, const Eigen::Vector3f &random_axis,
+    const pcl::Indices &nn_indices, const std::vector<float> &nn_dists,
+    pcl::Indices &neighbour_indices, std::vector<float> &neighbour_distances, std::vector<float> &desc) const
+{
+  // Get origin point
+  Vector3fMapConst origin = (*input_)[(*indices_)[index]].getVector3fMap ();
 
-  // Compute and store the RF direction
-  x_axis[0] = rnd ();
-  x_axis[1] = rnd ();
-  x_axis[2] = rnd ();
+  // Compute the RF direction
+  Eigen::Vector3f x_axis = random_axis;
   if (!pcl::utils::equal (normal[2], 0.0f))
     x_axis[2] = - (normal[0]*x_axis[0] + normal[1]*x_axis[1]) / normal[2];
   else if (!pcl::utils::equal (normal[1], 0.0f))
@@ -180,11 +218,8 @@ pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::computePoint (
   // Check if the computed x axis is orthogonal to the normal
   assert (pcl::utils::equal (x_axis[0]*normal[0] + x_axis[1]*normal[1] + x_axis[2]*normal[2], 0.0f, 1E-6f));
 
-  // Store the 3rd frame vector
-  y_axis.matrix () = normal.cross (x_axis);
-
   // For each point within radius
-  for (std::size_t ne = 0; ne < neighb_cnt; ne++)
+  for (std::size_t ne = 0; ne < nn_indices.size (); ne++)
   {
     if (pcl::utils::equal (nn_dists[ne], 0.0f))
 		  continue;
@@ -224,8 +259,6 @@ pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::computePoint (
     const auto l = std::distance(phi_divisions_.cbegin (), std::prev(phi_min));
 
     // Local point density = number of points in a sphere of radius "point_density_radius_" around the current neighbour
-    pcl::Indices neighbour_indices;
-    std::vector<float> neighbour_distances;
     int point_density = searchForNeighbors (*surface_, nn_indices[ne], point_density_radius_, neighbour_indices, neighbour_distances);
     // point_density is NOT always bigger than 0 (on error, searchForNeighbors returns 0), so we must check for that
     if (point_density == 0)
@@ -244,10 +277,6 @@ pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::computePoint (
 
     assert (desc[(l*elevation_bins_*radius_bins_) + (k*radius_bins_) + j] >= 0);
   } // end for each neighbour
-
-  // 3DSC does not define a repeatable local RF, we set it to zero to signal it to the user
-  std::fill_n (rf, 9, 0);
-  return (true);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -256,26 +285,71 @@ pcl::ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::computeFeature (Poi
 {
   assert (descriptor_length_ == 1980);
 
+  // Search the neighbors of every point once and find its normal, the descriptor of the points
+  // without one is set to NaN. The neighbors are kept for the histograms, because the random
+  // X axes must be drawn in the order of the points before any histogram can be accumulated
+  std::vector<pcl::Indices> nn_indices (indices_->size ());
+  std::vector<std::vector<float>> nn_dists (indices_->size ());
+  std::vector<index_t> normal_indices (indices_->size (), -1);
+#pragma omp parallel for \
+  default(none) \
+  shared(nn_indices, nn_dists, normal_indices) \
+  num_threads(threads_) \
+  schedule(dynamic, 64)
+  for (std::ptrdiff_t point_index = 0; point_index < static_cast<std::ptrdiff_t> (indices_->size ()); ++point_index)
+  {
+    if (isFinite ((*input_)[(*indices_)[point_index]]) &&
+        searchForNeighbors ((*indices_)[point_index], search_radius_, nn_indices[point_index], nn_dists[point_index]) != 0)
+      normal_indices[point_index] = findNormalIndex (*normals_, nn_indices[point_index], nn_dists[point_index]);
+  }
+
+  // Draw the random X axes in the order of the points, as computePoint would
+  std::vector<Eigen::Vector3f> random_axes (indices_->size ());
   output.is_dense = true;
-  // Iterate over all points and compute the descriptors
-	for (std::size_t point_index = 0; point_index < indices_->size (); point_index++)
+  for (std::size_t point_index = 0; point_index < indices_->size (); ++point_index)
   {
-    //output[point_index].descriptor.resize (descriptor_length_);
+    if (normal_indices[point_index] == -1)
+    {
+      output.is_dense = false;
+      continue;
+    }
+    random_axes[point_index][0] = rnd ();
+    random_axes[point_index][1] = rnd ();
+    random_axes[point_index][2] = rnd ();
+  }
 
-    // If the point is not finite, set the descriptor to NaN and continue
-    if (!isFinite ((*input_)[(*indices_)[point_index]]))
+  // Iterate over all points and compute the descriptors, the buffers are private to each thread
+  std::vector<float> descriptor (descriptor_length_);
+  pcl::Indices neighbour_indices;
+  std::vector<float> neighbour_distances;
+#pragma omp parallel for \
+  default(none) \
+  shared(nn_indices, nn_dists, normal_indices, output, random_axes) \
+  firstprivate(descriptor, neighbour_indices, neighbour_distances) \
+  num_threads(threads_) \
+  schedule(dynamic, 16)
+  for (std::ptrdiff_t point_index = 0; point_index < static_cast<std::ptrdiff_t> (indices_->size ()); ++point_index)
+  {
+    // 3DSC does not define a repeatable local RF, we set it to zero to signal it to the user
+    std::fill_n (output[point_index].rf, 9, 0);
+
+    // If the point is not finite or has no neighbors, set the descriptor to NaN and continue
+    if (normal_indices[point_index] == -1)
     {
       std::fill_n (output[point_index].descriptor, descriptor_length_,
                    std::numeric_limits<float>::quiet_NaN ());
-      std::fill_n (output[point_index].rf, 9, 0);
-      output.is_dense = false;
       continue;
     }
 
-    std::vector<float> descriptor (descriptor_length_);
-    if (!computePoint (point_index, *normals_, output[point_index].rf, descriptor))
-      output.is_dense = false;
+    std::fill (descriptor.begin (), descriptor.end (), 0.0f);
+    computeHistogram (point_index, (*normals_)[normal_indices[point_index]].getNormalVector3fMap (),
+                      random_axes[point_index], nn_indices[point_index], nn_dists[point_index],
+                      neighbour_indices, neighbour_distances, descriptor);
     std::copy (descriptor.cbegin (), descriptor.cend (), output[point_index].descriptor);
+
+    // The neighbors of this point are not needed anymore
+    pcl::Indices ().swap (nn_indices[point_index]);
+    std::vector<float> ().swap (nn_dists[point_index]);
   }
 }
 
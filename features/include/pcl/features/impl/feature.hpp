@@ -181,6 +181,37 @@ Feature<PointInT, PointOutT>::initCompute ()
       return (false);
     }
   }
+
+  // Serve the searches for points of the neighborhood graph's input cloud from memory
+  use_neighborhood_graph_ = false;
+  if (neighborhood_graph_)
+  {
+    if (neighborhood_graph_->getSearchSurface () != surface_ ||
+        neighborhood_graph_->isRadiusSearch () != (search_radius_ != 0.0) ||
+        neighborhood_graph_->getSearchParameter () != search_parameter_)
+    {
+      PCL_WARN ("[pcl::%s::compute] The neighborhood graph was computed for a different search surface or search parameter and is not used.\n", getClassName ().c_str ());
+    }
+    else
+    {
+      const auto *graph = neighborhood_graph_.get ();
+      const auto *graph_cloud = neighborhood_graph_->getInputCloud ().get ();
+      search_method_surface_ = [graph, graph_cloud, search = std::move (search_method_surface_)]
+                               (const PointCloudIn &cloud, std::size_t index, double parameter,
+                                pcl::Indices &k_indices, std::vector<float> &k_distances)
+      {
+        if (&cloud == graph_cloud && parameter == graph->getSearchParameter () && index < graph->size ())
+        {
+          const auto neighbors = graph->getNeighbors (index);
+          k_indices.assign (neighbors.indices, neighbors.indices + neighbors.size);
+          k_distances.assign (neighbors.sqr_distances, neighbors.sqr_distances + neighbors.size);
+          return (static_cast<int> (neighbors.size));
+        }
+        return (search (cloud, index, parameter, k_indices, k_distances));
+      };
+      use_neighborhood_graph_ = true;
+    }
+  }
   return (true);
 }
 
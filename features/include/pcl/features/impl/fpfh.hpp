@@ -45,7 +45,8 @@
 #include <pcl/common/point_tests.h> // for pcl::isFinite
 #include <pcl/features/pfh_tools.h>
 
-#include <set> // for std::set
+#include <algorithm> // for std::count
+#include <numeric> // for std::iota
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> bool
@@ -182,12 +183,12 @@ template <typename PointInT, typename PointNT, typename PointOutT> void
 pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeSPFHSignatures (std::vector<int> &spfh_hist_lookup,
     Eigen::MatrixXf &hist_f1, Eigen::MatrixXf &hist_f2, Eigen::MatrixXf &hist_f3)
 {
-  // Allocate enough space to hold the NN search results
+  // The search buffers, reused by all the points
   // \note This resize is irrelevant for a radiusSearch ().
-  pcl::Indices nn_indices (k_);
-  std::vector<float> nn_dists (k_);
+  SearchContext context;
+  context.resize (k_);
 
-  std::set<int> spfh_indices;
+  pcl::Indices spfh_indices;
   spfh_hist_lookup.resize (surface_->size ());
 
   // Build a list of (unique) indices for which we will need to compute SPFH signatures
@@ -195,19 +196,26 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeSPFHSignatures (std::v
   if (surface_ != input_ ||
       indices_->size () != surface_->size ())
   {
+    // Mark the neighbors in a flat mask rather than a node based set, which would allocate on every insert
+    std::vector<std::uint8_t> is_needed (surface_->size (), 0);
     for (const auto& p_idx: *indices_)
     {
-      if (this->searchForNeighbors (p_idx, search_parameter_, nn_indices, nn_dists) == 0)
+      if (this->searchForNeighbors (p_idx, search_parameter_, context) == 0)
         continue;
 
-      spfh_indices.insert (nn_indices.begin (), nn_indices.end ());
+      for (const auto &nn_index : context.indices)
+        is_needed[nn_index] = 1;
     }
+    spfh_indices.reserve (std::count (is_needed.cbegin (), is_needed.cend (), 1));
+    for (std::size_t idx = 0; idx < is_needed.size (); ++idx)
+      if (is_needed[idx])
+        spfh_indices.push_back (static_cast<pcl::index_t> (idx));
   }
   else
   {
     // Special case: When a feature must be computed at every point, there is no need for a neighborhood search
-    for (std::size_t idx = 0; idx < indices_->size (); ++idx)
-      spfh_indices.insert (static_cast<int> (idx));
+    spfh_indices.resize (indices_->size ());
+    std::iota (spfh_indices.begin (), spfh_indices.end (), static_cast<pcl::index_t> (0));
   }
 
   // Initialize the arrays that will store the SPFH signatures
@@ -221,11 +229,11 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeSPFHSignatures (std::v
   for (const auto& p_idx: spfh_indices)
   {
     // Find the neighborhood around p_idx
-    if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, nn_indices, nn_dists) == 0)
+    if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, context) == 0)
       continue;
 
     // Estimate the SPFH signature around p_idx
-    computePointSPFHSignature (*surface_, *normals_, p_idx, i, nn_indices, hist_f1, hist_f2, hist_f3);
+    computePointSPFHSignature (*surface_, *normals_, p_idx, i, context.indices, hist_f1, hist_f2, hist_f3);
 
     // Populate a lookup table for converting a point index to its corresponding row in the spfh_hist_* matrices
     spfh_hist_lookup[p_idx] = i;
@@ -237,10 +245,10 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeSPFHSignatures (std::v
 template <typename PointInT, typename PointNT, typename PointOutT> void
 pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
 {
-  // Allocate enough space to hold the NN search results
+  // The search buffers, reused by all the points
   // \note This resize is irrelevant for a radiusSearch ().
-  pcl::Indices nn_indices (k_);
-  std::vector<float> nn_dists (k_);
+  SearchContext context;
+  context.resize (k_);
 
   std::vector<int> spfh_hist_lookup;
   computeSPFHSignatures (spfh_hist_lookup, hist_f1_, hist_f2_, hist_f3_);
@@ -252,7 +260,7 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
     // Iterate over the entire index vector
     for (std::size_t idx = 0; idx < indices_->size (); ++idx)
     {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, context) == 0)
       {
         for (Eigen::Index d = 0; d < fpfh_histogram_.size (); ++d)
           output[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
@@ -263,11 +271,11 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
 
       // ... and remap the nn_indices values so that they represent row indices in the spfh_hist_* matrices
       // instead of indices into surface_->points
-      for (auto &nn_index : nn_indices)
+      for (auto &nn_index : context.indices)
         nn_index = spfh_hist_lookup[nn_index];
 
       // Compute the FPFH signature (i.e. compute a weighted combination of local SPFH signatures) ...
-      weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_indices, nn_dists, fpfh_histogram_);
+      weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, context.indices, context.sqr_distances, fpfh_histogram_);
 
       // ...and copy it into the output cloud
       std::copy_n(fpfh_histogram_.data (), fpfh_histogram_.size (), output[idx].histogram);
@@ -279,7 +287,7 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
     for (std::size_t idx = 0; idx < indices_->size (); ++idx)
     {
       if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+          this->searchForNeighbors ((*indices_)[idx], search_parameter_, context) == 0)
       {
         for (Eigen::Index d = 0; d < fpfh_histogram_.size (); ++d)
           output[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
@@ -290,11 +298,11 @@ pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
 
       // ... and remap the nn_indices values so that they represent row indices in the spfh_hist_* matrices
       // instead of indices into surface_->points
-      for (auto &nn_index : nn_indices)
+      for (auto &nn_index : context.indices)
         nn_index = spfh_hist_lookup[nn_index];
 
       // Compute the FPFH signature (i.e. compute a weighted combination of local SPFH signatures) ...
-      weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_indices, nn_dists, fpfh_histogram_);
+      weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, context.indices, context.sqr_distances, fpfh_histogram_);
 
       // ...and copy it into the output cloud
       std::copy_n(fpfh_histogram_.data (), fpfh_histogram_.size (), output[idx].histogram);
@@ -43,7 +43,9 @@
 #include <pcl/features/fpfh_omp.h>
 
 #include <pcl/common/point_tests.h> // for pcl::isFinite
+#include <pcl/features/pfh_tools.h> // for pcl::computePairFeatures
 
+#include <algorithm> // for std::count
 #include <numeric>
 
 
@@ -63,90 +65,251 @@ pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::setNumberOfThreads (unsign
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> void
-pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::searchNeighborhoods (
+    const PointCloudIn &cloud, const pcl::Indices &queries,
+    std::vector<pcl::Indices> &nn_indices, std::vector<std::vector<float> > &nn_dists) const
 {
-  std::vector<int> spfh_indices_vec;
-  std::vector<int> spfh_hist_lookup (surface_->size ());
+  nn_indices.resize (queries.size ());
+  nn_dists.resize (queries.size ());
 
-  // Build a list of (unique) indices for which we will need to compute SPFH signatures
-  // (We need an SPFH signature for every point that is a neighbor of any point in input_[indices_])
-  if (surface_ != input_ ||
-      indices_->size () != surface_->size ())
-  { 
-    pcl::Indices nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-    std::vector<float> nn_dists (k_); 
+  // Every thread searches in its own buffers, the neighborhoods are stored at their exact size
+  SearchContext context;
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, nn_dists, nn_indices, queries) \
+  firstprivate(context) \
+  num_threads(threads_) \
+  schedule(dynamic, 256)
+  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (queries.size ()); ++i)
+  {
+    if (!isFinite (cloud[queries[i]]) ||
+        this->searchForNeighbors (cloud, queries[i], search_parameter_, context) == 0)
+    {
+      nn_indices[i].clear ();
+      nn_dists[i].clear ();
+      continue;
+    }
+    nn_indices[i].assign (context.indices.cbegin (), context.indices.cend ());
+    nn_dists[i].assign (context.sqr_distances.cbegin (), context.sqr_distances.cend ());
+  }
+}
 
-    std::set<int> spfh_indices_set;
-    for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> double
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeSPFHSignatureBatched (
+    pcl::index_t p_idx, const pcl::Indices &nn_indices, LaneBinCounts &bin_counts, float *spfh) const
+{
+  using LaneArray = Eigen::Array<float, LANES, 1>;
+  using LaneArrayd = Eigen::Array<double, LANES, 1>;
+  using LaneArrayi = Eigen::Array<int, LANES, 1>;
+  using detail::blendLanes;
+
+  const PointInT &p = (*surface_)[p_idx];
+  const LaneArray pnx = LaneArray::Constant ((*normals_)[p_idx].normal_x);
+  const LaneArray pny = LaneArray::Constant ((*normals_)[p_idx].normal_y);
+  const LaneArray pnz = LaneArray::Constant ((*normals_)[p_idx].normal_z);
+  const LaneArray zero = LaneArray::Zero ();
+
+  // Factorization constant, see computePointSPFHSignature
+  const float hist_incr = 100.0f / static_cast<float> (nn_indices.size () - 1);
+  const int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
+  bin_counts.setZero (LANES, nr_bins);
+
+  LaneArray qx, qy, qz, qnx, qny, qnz;
+  pcl::index_t q_indices[LANES];
+  std::size_t nr_pairs = 0;
+  auto nn_it = nn_indices.cbegin ();
+  while (true)
+  {
+    // Gather the next pairs into the lanes, padding the last batch with copies of its first pair
+    std::size_t nr_lanes = 0;
+    for (; nn_it != nn_indices.cend () && nr_lanes < LANES; ++nn_it)
     {
-      int p_idx = (*indices_)[idx];
-      if (!isFinite ((*input_)[p_idx]) ||
-          this->searchForNeighbors (p_idx, search_parameter_, nn_indices, nn_dists) == 0)
+      if (*nn_it == p_idx)
         continue;
+      const PointInT &q = (*surface_)[*nn_it];
+      const PointNT &qn = (*normals_)[*nn_it];
+      qx[nr_lanes] = q.x; qy[nr_lanes] = q.y; qz[nr_lanes] = q.z;
+      qnx[nr_lanes] = qn.normal_x; qny[nr_lanes] = qn.normal_y; qnz[nr_lanes] = qn.normal_z;
+      q_indices[nr_lanes] = *nn_it;
+      ++nr_lanes;
+    }
+    if (nr_lanes == 0)
+      break;
+    for (std::size_t lane = nr_lanes; lane < LANES; ++lane)
+    {
+      qx[lane] = qx[0]; qy[lane] = qy[0]; qz[lane] = qz[0];
+      qnx[lane] = qnx[0]; qny[lane] = qny[0]; qnz[lane] = qnz[0];
+    }
 
-      spfh_indices_set.insert (nn_indices.begin (), nn_indices.end ());
+    // pcl::computePairFeatures on all lanes
+    const LaneArray dx = qx - p.x, dy = qy - p.y, dz = qz - p.z;
+    const LaneArray f4 = (dx * dx + dy * dy + dz * dz).sqrt ();
+    const LaneArray angle1 = (pnx * dx + pny * dy + pnz * dz) / f4;
+    const LaneArray angle2 = (qnx * dx + qny * dy + qnz * dz) / f4;
+
+    // Make sure the same point is selected as 1 and 2 for each pair (acos is decreasing on [0, 1])
+    const auto swap = angle1.abs () < angle2.abs ();
+    const LaneArray ux = blendLanes (swap, qnx, pnx), uy = blendLanes (swap, qny, pny), uz = blendLanes (swap, qnz, pnz);
+    const LaneArray mx = blendLanes (swap, pnx, qnx), my = blendLanes (swap, pny, qny), mz = blendLanes (swap, pnz, qnz);
+    const LaneArray sx = blendLanes (swap, -dx, dx), sy = blendLanes (swap, -dy, dy), sz = blendLanes (swap, -dz, dz);
+
+    // Darboux frame u-v-w: u = n1; v = (p_idx - q_idx) x u / || (p_idx - q_idx) x u ||; w = u x v
+    LaneArray vx = sy * uz - sz * uy, vy = sz * ux - sx * uz, vz = sx * uy - sy * ux;
+    const LaneArray v_norm = (vx * vx + vy * vy + vz * vz).sqrt ();
+    vx /= v_norm; vy /= v_norm; vz /= v_norm;
+    const LaneArray wx = uy * vz - uz * vy, wy = uz * vx - ux * vz, wz = ux * vy - uy * vx;
+
+    // Pairs of coincident points or with a normal along the connecting line have no features. Like
+    // pcl::computePairFeatures, their features are set to 0, and they are counted like any other pair.
+    const auto valid = (f4 != 0.0f) && (v_norm != 0.0f);
+    const LaneArray f1_y = wx * mx + wy * my + wz * mz, f1_x = ux * mx + uy * my + uz * mz;
+    const LaneArray f1 = blendLanes (valid, detail::atan2Lanes (f1_y, f1_x), zero);
+    const LaneArray f2 = blendLanes (valid, vx * mx + vy * my + vz * mz, zero);
+    const LaneArray f3 = blendLanes (valid, blendLanes (swap, -angle2, angle1), zero);
+
+    // Normalize the f1, f2, f3 features into their bins. Truncating instead of flooring only differs for
+    // negative values, which are clamped to the first bin anyway.
+    const LaneArrayd b1 = nr_bins_f1_ * ((f1.template cast<double> () + M_PI) * d_pi_);
+    const LaneArrayd b2 = nr_bins_f2_ * ((f2.template cast<double> () + 1.0) * 0.5);
+    const LaneArrayd b3 = nr_bins_f3_ * ((f3.template cast<double> () + 1.0) * 0.5);
+    LaneArrayi h1 = b1.template cast<int> ().max (0).min (nr_bins_f1_ - 1);
+    LaneArrayi h2 = b2.template cast<int> ().max (0).min (nr_bins_f2_ - 1);
+    LaneArrayi h3 = b3.template cast<int> ().max (0).min (nr_bins_f3_ - 1);
+    const LaneArrayd edge_distance =
+        (b1 - b1.round ()).abs ().min ((b2 - b2.round ()).abs ()).min ((b3 - b3.round ()).abs ());
+
+    // Count every pair in the row of its lane
+    for (std::size_t lane = 0; lane < nr_lanes; ++lane)
+    {
+      // Rounding differences to pcl::computePairFeatures can move a feature next to a bin edge into the
+      // neighboring bin, and the approximated atan2 ignores signed zeros. Bin these pairs like
+      // computePointSPFHSignature does.
+      if (edge_distance[lane] < 1e-4 || f1_y[lane] == 0.0f)
+      {
+        float f1_exact, f2_exact, f3_exact, f4_exact;
+        pcl::computePairFeatures (p.getVector4fMap (), (*normals_)[p_idx].getNormalVector4fMap (),
+                                  (*surface_)[q_indices[lane]].getVector4fMap (),
+                                  (*normals_)[q_indices[lane]].getNormalVector4fMap (),
+                                  f1_exact, f2_exact, f3_exact, f4_exact);
+        h1[lane] = std::min (std::max (static_cast<int> (std::floor (nr_bins_f1_ * ((f1_exact + M_PI) * d_pi_))), 0), nr_bins_f1_ - 1);
+        h2[lane] = std::min (std::max (static_cast<int> (std::floor (nr_bins_f2_ * ((f2_exact + 1.0) * 0.5))), 0), nr_bins_f2_ - 1);
+        h3[lane] = std::min (std::max (static_cast<int> (std::floor (nr_bins_f3_ * ((f3_exact + 1.0) * 0.5))), 0), nr_bins_f3_ - 1);
+      }
+      ++bin_counts (lane, h1[lane]);
+      ++bin_counts (lane, nr_bins_f1_ + h2[lane]);
+      ++bin_counts (lane, nr_bins_f1_ + nr_bins_f2_ + h3[lane]);
+      ++nr_pairs;
     }
-    spfh_indices_vec.resize (spfh_indices_set.size ());
-    std::copy (spfh_indices_set.cbegin (), spfh_indices_set.cend (), spfh_indices_vec.begin ());
+  }
+  // Without any pair, hist_incr is infinite and the histograms stay empty
+  if (nr_pairs == 0)
+    return (0.0);
+
+  Eigen::Map<Eigen::ArrayXf> (spfh, nr_bins) = hist_incr * bin_counts.colwise ().sum ().transpose ().template cast<float> ();
+  return (static_cast<double> (nr_pairs) * hist_incr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  // Search the neighborhood of every query point once. The neighborhoods are used to find the points that
+  // need an SPFH signature, to compute the SPFH signatures of query points which are part of the search
+  // surface, and to weight the SPFH signatures into the FPFH signatures.
+  std::vector<pcl::Indices> query_nn_indices;
+  std::vector<std::vector<float> > query_nn_dists;
+  searchNeighborhoods (*input_, *indices_, query_nn_indices, query_nn_dists);
+
+  pcl::Indices spfh_indices;
+  // Build a list of (unique) indices for which we will need to compute SPFH signatures
+  // (We need an SPFH signature for every point that is a neighbor of any point in input_[indices_])
+  if (surface_ != input_ ||
+      indices_->size () != surface_->size ())
+  {
+    // Mark the neighbors in a flat mask rather than a node based set, which would allocate on every insert
+    std::vector<std::uint8_t> is_needed (surface_->size (), 0);
+    for (const auto &nn_indices : query_nn_indices)
+      for (const auto &nn_index : nn_indices)
+        is_needed[nn_index] = 1;
+    spfh_indices.reserve (std::count (is_needed.cbegin (), is_needed.cend (), 1));
+    for (std::size_t idx = 0; idx < is_needed.size (); ++idx)
+      if (is_needed[idx])
+        spfh_indices.push_back (static_cast<pcl::index_t> (idx));
   }
   else
   {
     // Special case: When a feature must be computed at every point, there is no need for a neighborhood search
-    spfh_indices_vec.resize (indices_->size ());
-    std::iota(spfh_indices_vec.begin (), spfh_indices_vec.end (),
-              static_cast<decltype(spfh_indices_vec)::value_type>(0));
+    spfh_indices.resize (indices_->size ());
+    std::iota (spfh_indices.begin (), spfh_indices.end (), static_cast<pcl::index_t> (0));
   }
 
-  // Initialize the arrays that will store the SPFH signatures
-  const auto data_size = spfh_indices_vec.size ();
-  hist_f1_.setZero (data_size, nr_bins_f1_);
-  hist_f2_.setZero (data_size, nr_bins_f2_);
-  hist_f3_.setZero (data_size, nr_bins_f3_);
-
-  pcl::Indices nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-  std::vector<float> nn_dists (k_); 
+  // Reuse the neighborhoods of the query points for their SPFH signatures, and only search the others
+  std::vector<const pcl::Indices*> spfh_nn_indices (spfh_indices.size (), nullptr);
+  pcl::Indices spfh_search_indices;
+  std::vector<std::size_t> spfh_search_rows;
+  if (surface_ == input_)
+  {
+    std::vector<int> query_row (surface_->size (), -1);
+    for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+      if (query_row[(*indices_)[idx]] == -1)
+        query_row[(*indices_)[idx]] = static_cast<int> (idx);
+    for (std::size_t i = 0; i < spfh_indices.size (); ++i)
+      if (query_row[spfh_indices[i]] != -1)
+        spfh_nn_indices[i] = &query_nn_indices[query_row[spfh_indices[i]]];
+  }
+  for (std::size_t i = 0; i < spfh_indices.size (); ++i)
+  {
+    if (spfh_nn_indices[i])
+      continue;
+    spfh_search_indices.push_back (spfh_indices[i]);
+    spfh_search_rows.push_back (i);
+  }
+  std::vector<pcl::Indices> surface_nn_indices;
+  std::vector<std::vector<float> > surface_nn_dists;
+  searchNeighborhoods (*surface_, spfh_search_indices, surface_nn_indices, surface_nn_dists);
+  for (std::size_t i = 0; i < spfh_search_rows.size (); ++i)
+    spfh_nn_indices[spfh_search_rows[i]] = &surface_nn_indices[i];
 
-  // Compute SPFH signatures for every point that needs them
+  // Compute the SPFH signatures, stored row by row so that the weighting below reads contiguous memory,
+  // together with the sum of each of their three histograms
+  const int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
+  Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> spfh_hist;
+  spfh_hist.setZero (spfh_indices.size (), nr_bins);
+  std::vector<double> spfh_hist_sum (spfh_indices.size (), 0.0);
+  std::vector<int> spfh_hist_lookup (surface_->size ());
+  LaneBinCounts bin_counts;
 
 #pragma omp parallel for \
   default(none) \
-  shared(spfh_hist_lookup, spfh_indices_vec) \
-  firstprivate(nn_indices, nn_dists) \
-  num_threads(threads_)
-  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (spfh_indices_vec.size ()); ++i)
+  shared(spfh_hist, spfh_hist_lookup, spfh_hist_sum, spfh_indices, spfh_nn_indices) \
+  firstprivate(bin_counts) \
+  num_threads(threads_) \
+  schedule(dynamic, 256)
+  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (spfh_indices.size ()); ++i)
   {
-    // Get the next point index
-    int p_idx = spfh_indices_vec[i];
-
-    // Find the neighborhood around p_idx
-    if (!isFinite ((*surface_)[p_idx]) ||
-        this->searchForNeighbors (*surface_, p_idx, search_parameter_, nn_indices, nn_dists) == 0)
+    // Populate a lookup table for converting a point index to its corresponding row in the spfh_hist matrix
+    spfh_hist_lookup[spfh_indices[i]] = static_cast<int> (i);
+    if (spfh_nn_indices[i]->empty ())
       continue;
-
-    // Estimate the SPFH signature around p_idx
-    this->computePointSPFHSignature (*surface_, *normals_, p_idx, i, nn_indices, hist_f1_, hist_f2_, hist_f3_);
-
-    // Populate a lookup table for converting a point index to its corresponding row in the spfh_hist_* matrices
-    spfh_hist_lookup[p_idx] = i;
+    spfh_hist_sum[i] = computeSPFHSignatureBatched (spfh_indices[i], *spfh_nn_indices[i], bin_counts,
+                                                   spfh_hist.row (i).data ());
   }
 
-  // Initialize the array that will store the FPFH signature
-  int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
-
-  nn_indices.clear();
-  nn_dists.clear();
+  // Compute the FPFH signatures (i.e. weighted combinations of the SPFH signatures of the neighbors)
+  Eigen::VectorXf fpfh_histogram (nr_bins);
 
-  // Iterate over the entire index vector
 #pragma omp parallel for \
   default(none) \
-  shared(nr_bins, output, spfh_hist_lookup) \
-  firstprivate(nn_dists, nn_indices) \
-  num_threads(threads_)
+  shared(nr_bins, output, query_nn_dists, query_nn_indices, spfh_hist, spfh_hist_lookup, spfh_hist_sum) \
+  firstprivate(fpfh_histogram) \
+  num_threads(threads_) \
+  schedule(dynamic, 256)
   for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
   {
-    // Find the indices of point idx's neighbors...
-    if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+    const pcl::Indices &nn_indices = query_nn_indices[idx];
+    const std::vector<float> &nn_dists = query_nn_dists[idx];
+    if (nn_indices.empty ())
     {
       for (int d = 0; d < nr_bins; ++d)
         output[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
@@ -155,21 +318,27 @@ pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloud
       continue;
     }
 
+    // The three histograms of every SPFH signature have the same sum, see computeSPFHSignatureBatched
+    double sum = 0.0;
+    fpfh_histogram.setZero ();
+    for (std::size_t i = 0; i < nn_indices.size (); ++i)
+    {
+      // Minus the query point itself
+      if (nn_dists[i] == 0)
+        continue;
 
-    // ... and remap the nn_indices values so that they represent row indices in the spfh_hist_* matrices 
-    // instead of indices into surface_->points
-    for (auto &nn_index : nn_indices)
-      nn_index = spfh_hist_lookup[nn_index];
-
-    // Compute the FPFH signature (i.e. compute a weighted combination of local SPFH signatures) ...
-    Eigen::VectorXf fpfh_histogram = Eigen::VectorXf::Zero (nr_bins);
-    weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_indices, nn_dists, fpfh_histogram);
+      // Standard weighting function used
+      const float weight = 1.0f / nn_dists[i];
+      const int row = spfh_hist_lookup[nn_indices[i]];
+      fpfh_histogram += weight * spfh_hist.row (row).transpose ();
+      sum += weight * spfh_hist_sum[row];
+    }
 
-    // ...and copy it into the output cloud
+    // Histogram values sum up to 100
+    const double factor = sum != 0 ? 100.0 / sum : 0.0;
     for (int d = 0; d < nr_bins; ++d)
-      output[idx].histogram[d] = fpfh_histogram[d];
+      output[idx].histogram[d] = static_cast<float> (fpfh_histogram[d] * factor);
   }
-
 }
 
 #define PCL_INSTANTIATE_FPFHEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::FPFHEstimationOMP<T,NT,OutT>;
@@ -41,10 +41,60 @@
 #ifndef PCL_INTEGRAL_IMAGE2D_IMPL_H_
 #define PCL_INTEGRAL_IMAGE2D_IMPL_H_
 
+#include <pcl/console/print.h> // for PCL_WARN
+#include <pcl/pcl_macros.h> // for OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+
+#include <algorithm> // for std::fill_n, std::min
+#include <cmath>
 
 namespace pcl
 {
 
+namespace detail
+{
+/** \brief Complete integral images whose horizontal strips of \a rows_per_strip rows were integrated independently,
+  * by adding the last row of all previous strips to every row. The images have \a row_size scalars per row and
+  * (height + 1) rows, the first one being zero.
+  */
+template <typename Scalar> void
+mergeStrips (Scalar *image, std::size_t row_size, unsigned height, unsigned rows_per_strip, unsigned int nr_threads)
+{
+  const std::ptrdiff_t stride = row_size;
+  const std::ptrdiff_t strip_size = rows_per_strip;
+  const std::ptrdiff_t nr_rows = height;
+
+  // The last rows of the strips depend on each other
+  for (std::ptrdiff_t last_row = 2 * strip_size; last_row < nr_rows + strip_size; last_row += strip_size)
+  {
+    Scalar *current_row = image + std::min (last_row, nr_rows) * stride;
+    const Scalar *offset_row = image + (last_row - strip_size) * stride;
+    for (std::ptrdiff_t col = 0; col < stride; ++col)
+      current_row [col] += offset_row [col];
+  }
+
+#if OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+#pragma omp parallel for \
+  default(none) \
+  shared(image) \
+  num_threads(nr_threads)
+#else
+#pragma omp parallel for \
+  default(none) \
+  shared(image, nr_rows, stride, strip_size) \
+  num_threads(nr_threads)
+#endif
+  for (std::ptrdiff_t row = strip_size + 1; row < nr_rows; ++row)
+  {
+    if (row % strip_size == 0)
+      continue;
+    Scalar *current_row = image + row * stride;
+    const Scalar *offset_row = image + ((row - 1) / strip_size) * strip_size * stride;
+    for (std::ptrdiff_t col = 0; col < stride; ++col)
+      current_row [col] += offset_row [col];
+  }
+}
+} // namespace detail
+
 template <typename DataType, unsigned Dimension> void
 IntegralImage2D<DataType, Dimension>::setSecondOrderComputation (bool compute_second_order_integral_images)
 {
@@ -52,6 +102,22 @@ IntegralImage2D<DataType, Dimension>::setSecondOrderComputation (bool compute_se
 }
 
 
+template <typename DataType, unsigned Dimension> void
+IntegralImage2D<DataType, Dimension>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::IntegralImage2D::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
+
 template <typename DataType, unsigned Dimension> void
 IntegralImage2D<DataType, Dimension>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
@@ -157,69 +223,121 @@ template <typename DataType, unsigned Dimension> void
 IntegralImage2D<DataType, Dimension>::computeIntegralImages (
     const DataType *data, unsigned row_stride, unsigned element_stride)
 {
-  ElementType* previous_row = first_order_integral_image_.data();
-  ElementType* current_row  = previous_row + (width_ + 1);
+  ElementType* first_order = first_order_integral_image_.data();
+  unsigned* count = finite_values_integral_image_.data();
+  SecondOrderType* second_order = compute_second_order_integral_images_ ? second_order_integral_image_.data() : nullptr;
   for (unsigned int i = 0; i < (width_ + 1); ++i)
-    previous_row[i].setZero();
-
-  unsigned* count_previous_row = finite_values_integral_image_.data();
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  std::fill_n(count_previous_row, width_ + 1, 0);
+  {
+    first_order[i].setZero();
+    count[i] = 0;
+    if (second_order)
+      second_order[i].setZero();
+  }
 
-  if (!compute_second_order_integral_images_)
+  // Every thread integrates a horizontal strip of the images, as if it was at the top of the images
+  const unsigned rows_per_strip = (height_ + threads_ - 1) / threads_;
+
+#if OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+#pragma omp parallel for \
+  default(none) \
+  shared(count, data, element_stride, first_order, row_stride, second_order) \
+  num_threads(threads_)
+#else
+#pragma omp parallel for \
+  default(none) \
+  shared(count, data, element_stride, first_order, row_stride, rows_per_strip, second_order) \
+  num_threads(threads_)
+#endif
+  for (std::ptrdiff_t strip = 0; strip < static_cast<std::ptrdiff_t> (threads_); ++strip)
   {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
+    const unsigned begin = std::min<unsigned> (strip * rows_per_strip, height_);
+    const unsigned end = std::min<unsigned> (begin + rows_per_strip, height_);
+    const DataType* row_data = data + static_cast<std::size_t> (begin) * row_stride;
+
+    // The first row of the images is zero
+    const ElementType* previous_row = first_order;
+    ElementType* current_row  = first_order + (begin + 1) * (width_ + 1);
+    const unsigned* count_previous_row = count;
+    unsigned* count_current_row  = count + (begin + 1) * (width_ + 1);
+
+    if (!second_order)
     {
-      current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      for (unsigned rowIdx = begin; rowIdx < end; ++rowIdx, row_data += row_stride,
+                                                  previous_row = current_row, current_row += (width_ + 1),
+                                                  count_previous_row = count_current_row, count_current_row += (width_ + 1))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        const auto* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (std::isfinite (element->sum ()))
+        current_row [0].setZero ();
+        count_current_row [0] = 0;
+        for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
         {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
+          current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
+          count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
+          const auto* element = reinterpret_cast <const InputType*> (&row_data [valIdx]);
+          if (std::isfinite (element->sum ()))
+          {
+            current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
+            ++(count_current_row [colIdx + 1]);
+          }
         }
       }
     }
-  }
-  else
-  {
-    SecondOrderType* so_previous_row = second_order_integral_image_.data();
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    for (unsigned int i = 0; i < (width_ + 1); ++i)
-      so_previous_row[i].setZero();
-
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    else
     {
-      current_row [0].setZero ();
-      so_current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
-      {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
+      const SecondOrderType* so_previous_row = second_order;
+      SecondOrderType* so_current_row  = second_order + (begin + 1) * (width_ + 1);
 
-        const auto* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (std::isfinite (element->sum ()))
+      for (unsigned rowIdx = begin; rowIdx < end; ++rowIdx, row_data += row_stride,
+                                                  previous_row = current_row, current_row += (width_ + 1),
+                                                  count_previous_row = count_current_row, count_current_row += (width_ + 1),
+                                                  so_previous_row = so_current_row, so_current_row += (width_ + 1))
+      {
+        current_row [0].setZero ();
+        so_current_row [0].setZero ();
+        count_current_row [0] = 0;
+        for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
         {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
-          for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
-            for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
-              so_current_row [colIdx + 1][elIdx] += (*element)[myIdx] * (*element)[mxIdx];
+          current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
+          so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
+          count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
+
+          const auto* element = reinterpret_cast <const InputType*> (&row_data [valIdx]);
+          if (std::isfinite (element->sum ()))
+          {
+            current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
+            ++(count_current_row [colIdx + 1]);
+            for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
+              for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
+                so_current_row [colIdx + 1][elIdx] += (*element)[myIdx] * (*element)[mxIdx];
+          }
         }
       }
     }
   }
+
+  if (threads_ > 1)
+  {
+    // Add up the strips, on the coefficients of the elements
+    detail::mergeStrips (first_order->data (), (width_ + 1) * Dimension, height_, rows_per_strip, threads_);
+    detail::mergeStrips (count, width_ + 1, height_, rows_per_strip, threads_);
+    if (second_order)
+      detail::mergeStrips (second_order->data (), (width_ + 1) * second_order_size, height_, rows_per_strip, threads_);
+  }
+}
+
+
+template <typename DataType> void
+IntegralImage2D<DataType, 1>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::IntegralImage2D::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
 }
 
 
@@ -328,62 +446,97 @@ template <typename DataType> void
 IntegralImage2D<DataType, 1>::computeIntegralImages (
     const DataType *data, unsigned row_stride, unsigned element_stride)
 {
-  ElementType* previous_row = first_order_integral_image_.data();
-  ElementType* current_row  = previous_row + (width_ + 1);
-  std::fill_n(previous_row, width_ + 1, 0);
+  ElementType* first_order = first_order_integral_image_.data();
+  unsigned* count = finite_values_integral_image_.data();
+  SecondOrderType* second_order = compute_second_order_integral_images_ ? second_order_integral_image_.data() : nullptr;
+  std::fill_n(first_order, width_ + 1, 0);
+  std::fill_n(count, width_ + 1, 0);
+  if (second_order)
+    std::fill_n(second_order, width_ + 1, 0);
+
+  // Every thread integrates a horizontal strip of the images, as if it was at the top of the images
+  const unsigned rows_per_strip = (height_ + threads_ - 1) / threads_;
+
+#if OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+#pragma omp parallel for \
+  default(none) \
+  shared(count, data, element_stride, first_order, row_stride, second_order) \
+  num_threads(threads_)
+#else
+#pragma omp parallel for \
+  default(none) \
+  shared(count, data, element_stride, first_order, row_stride, rows_per_strip, second_order) \
+  num_threads(threads_)
+#endif
+  for (std::ptrdiff_t strip = 0; strip < static_cast<std::ptrdiff_t> (threads_); ++strip)
+  {
+    const unsigned begin = std::min<unsigned> (strip * rows_per_strip, height_);
+    const unsigned end = std::min<unsigned> (begin + rows_per_strip, height_);
+    const DataType* row_data = data + static_cast<std::size_t> (begin) * row_stride;
 
-  unsigned* count_previous_row = finite_values_integral_image_.data();
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  std::fill_n(count_previous_row, width_ + 1, 0);
+    // The first row of the images is zero
+    const ElementType* previous_row = first_order;
+    ElementType* current_row  = first_order + (begin + 1) * (width_ + 1);
+    const unsigned* count_previous_row = count;
+    unsigned* count_current_row  = count + (begin + 1) * (width_ + 1);
 
-  if (!compute_second_order_integral_images_)
-  {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
+    if (!second_order)
     {
-      current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      for (unsigned rowIdx = begin; rowIdx < end; ++rowIdx, row_data += row_stride,
+                                                  previous_row = current_row, current_row += (width_ + 1),
+                                                  count_previous_row = count_current_row, count_current_row += (width_ + 1))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (std::isfinite (data [valIdx]))
+        current_row [0] = 0.0;
+        count_current_row [0] = 0;
+        for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
         {
-          current_row [colIdx + 1] += data [valIdx];
-          ++(count_current_row [colIdx + 1]);
+          current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
+          count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
+          if (std::isfinite (row_data [valIdx]))
+          {
+            current_row [colIdx + 1] += row_data [valIdx];
+            ++(count_current_row [colIdx + 1]);
+          }
         }
       }
     }
-  }
-  else
-  {
-    SecondOrderType* so_previous_row = second_order_integral_image_.data();
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    std::fill_n(so_previous_row, width_ + 1, 0);
-
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    else
     {
-      current_row [0] = 0.0;
-      so_current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      const SecondOrderType* so_previous_row = second_order;
+      SecondOrderType* so_current_row  = second_order + (begin + 1) * (width_ + 1);
+
+      for (unsigned rowIdx = begin; rowIdx < end; ++rowIdx, row_data += row_stride,
+                                                  previous_row = current_row, current_row += (width_ + 1),
+                                                  count_previous_row = count_current_row, count_current_row += (width_ + 1),
+                                                  so_previous_row = so_current_row, so_current_row += (width_ + 1))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (std::isfinite (data[valIdx]))
+        current_row [0] = 0.0;
+        so_current_row [0] = 0.0;
+        count_current_row [0] = 0;
+        for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
         {
-          current_row [colIdx + 1] += data[valIdx];
-          so_current_row [colIdx + 1] += data[valIdx] * data[valIdx];
-          ++(count_current_row [colIdx + 1]);
+          current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
+          so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
+          count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
+          if (std::isfinite (row_data[valIdx]))
+          {
+            current_row [colIdx + 1] += row_data[valIdx];
+            so_current_row [colIdx + 1] += row_data[valIdx] * row_data[valIdx];
+            ++(count_current_row [colIdx + 1]);
+          }
         }
       }
     }
   }
+
+  if (threads_ > 1)
+  {
+    // Add up the strips
+    detail::mergeStrips (first_order, width_ + 1, height_, rows_per_strip, threads_);
+    detail::mergeStrips (count, width_ + 1, height_, rows_per_strip, threads_);
+    if (second_order)
+      detail::mergeStrips (second_order, width_ + 1, height_, rows_per_strip, threads_);
+  }
 }
 
 } // namespace pcl
@@ -100,6 +100,41 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::setRectSize (const int
   rect_height_4_   = height/4;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::IntegralImageNormalEstimation::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::IntegralImageNormalEstimation::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+  integral_image_DX_.setNumberOfThreads (threads_);
+  integral_image_DY_.setNumberOfThreads (threads_);
+  integral_image_depth_.setNumberOfThreads (threads_);
+  integral_image_XYZ_.setNumberOfThreads (threads_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initMethodData ()
+{
+  if (normal_estimation_method_ == COVARIANCE_MATRIX && !init_covariance_matrix_)
+    initCovarianceMatrixMethod ();
+  else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT && !init_average_3d_gradient_)
+    initAverage3DGradientMethod ();
+  else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE && !init_depth_change_)
+    initAverageDepthChangeMethod ();
+  else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT && !init_simple_3d_gradient_)
+    initSimple3DGradientMethod ();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initSimple3DGradientMethod ()
@@ -149,23 +184,26 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverage3DGradientMe
   // x u x
   // l x r
   // x d x
-  const PointInT* point_up = &(input_->points [1]);
-  const PointInT* point_dn = point_up + (input_->width << 1);//&(input_->points [1 + (input_->width << 1)]);
-  const PointInT* point_lf = &(input_->points [input_->width]);
-  const PointInT* point_rg = point_lf + 2; //&(input_->points [input_->width + 2]);
-  float* diff_x_ptr = diff_x_ + ((input_->width + 1) << 2);
-  float* diff_y_ptr = diff_y_ + ((input_->width + 1) << 2);
-  unsigned diff_skip = 8; // skip last element in row and the first in the next row
-
-  for (std::size_t ri = 1; ri < input_->height - 1; ++ri
-                                             , point_up += input_->width
-                                             , point_dn += input_->width
-                                             , point_lf += input_->width
-                                             , point_rg += input_->width
-                                             , diff_x_ptr += diff_skip
-                                             , diff_y_ptr += diff_skip)
+  const std::ptrdiff_t width = input_->width;
+#if OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+#pragma omp parallel for \
+  default(none) \
+  num_threads(threads_)
+#else
+#pragma omp parallel for \
+  default(none) \
+  shared(width) \
+  num_threads(threads_)
+#endif
+  for (std::ptrdiff_t ri = 1; ri < static_cast<std::ptrdiff_t> (input_->height) - 1; ++ri)
   {
-    for (std::size_t ci = 0; ci < input_->width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
+    const PointInT* point_up = &(*input_)[(ri - 1) * width + 1];
+    const PointInT* point_dn = &(*input_)[(ri + 1) * width + 1];
+    const PointInT* point_lf = &(*input_)[ri * width];
+    const PointInT* point_rg = point_lf + 2;
+    float* diff_x_ptr = diff_x_ + ((ri * width + 1) << 2);
+    float* diff_y_ptr = diff_y_ + ((ri * width + 1) << 2);
+    for (std::ptrdiff_t ci = 0; ci < width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
     {
       diff_x_ptr[0] = point_rg[ci].x - point_lf[ci].x;
       diff_x_ptr[1] = point_rg[ci].y - point_lf[ci].y;
@@ -206,14 +244,23 @@ template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
     const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
 {
+  initMethodData ();
+  computePointNormalInRect (pos_x, pos_y, point_index, rect_width_, rect_height_, normal);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalInRect (
+    const int pos_x, const int pos_y, const unsigned point_index,
+    const int rect_width, const int rect_height, PointOutT &normal) const
+{
+  const int rect_width_2 = rect_width / 2, rect_width_4 = rect_width / 4;
+  const int rect_height_2 = rect_height / 2, rect_height_4 = rect_height / 4;
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
   if (normal_estimation_method_ == COVARIANCE_MATRIX)
   {
-    if (!init_covariance_matrix_)
-      initCovarianceMatrixMethod ();
-
-    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - (rect_width_2_), pos_y - (rect_height_2_), rect_width_, rect_height_);
+    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     // no valid points within the rectangular region?
     if (count == 0)
@@ -225,8 +272,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
     EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
     Eigen::Vector3f center;
     typename IntegralImage2D<float, 3>::SecondOrderType so_elements;
-    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_).template cast<float> ();
-    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height).template cast<float> ();
+    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     covariance_matrix.coeffRef (0) = static_cast<float> (so_elements [0]);
     covariance_matrix.coeffRef (1) = covariance_matrix.coeffRef (3) = static_cast<float> (so_elements [1]);
@@ -251,18 +298,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   if (normal_estimation_method_ == AVERAGE_3D_GRADIENT)
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
     if (count_x == 0 || count_y == 0)
     {
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = bad_point;
       return;
     }
-    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
@@ -289,14 +333,11 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE)
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
     // width and height are at least 3 x 3
-    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_);
-    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_);
+    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2);
+    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2);
 
     if (count_L_z == 0 || count_R_z == 0 || count_U_z == 0 || count_D_z == 0)
     {
@@ -304,15 +345,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
       return;
     }
 
-    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_L_z);
-    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_R_z);
-    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_) / count_U_z);
-    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_) / count_D_z);
+    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2) / count_L_z);
+    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2) / count_R_z);
+    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2) / count_U_z);
+    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2) / count_D_z);
 
-    PointInT pointL = (*input_)[point_index - rect_width_4_ - 1];
-    PointInT pointR = (*input_)[point_index + rect_width_4_ + 1];
-    PointInT pointU = (*input_)[point_index - rect_height_4_ * input_->width - 1];
-    PointInT pointD = (*input_)[point_index + rect_height_4_ * input_->width + 1];
+    PointInT pointL = (*input_)[point_index - rect_width_4 - 1];
+    PointInT pointR = (*input_)[point_index + rect_width_4 + 1];
+    PointInT pointU = (*input_)[point_index - rect_height_4 * input_->width - 1];
+    PointInT pointD = (*input_)[point_index + rect_height_4 * input_->width + 1];
 
     const float mean_x_z = mean_R_z - mean_L_z;
     const float mean_y_z = mean_D_z - mean_U_z;
@@ -348,15 +389,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   if (normal_estimation_method_ == SIMPLE_3D_GRADIENT)
   {
-    if (!init_simple_3d_gradient_)
-      initSimple3DGradientMethod ();
-
     // this method does not work if lots of NaNs are in the neighborhood of the point
-    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2_, pos_y - rect_height_2_, 1, rect_height_) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, 1, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2, pos_y - rect_height_2, 1, rect_height) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, 1, rect_height);
 
-    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y + rect_height_2_, rect_width_, 1) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, 1);
+    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y + rect_height_2, rect_width, 1) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, 1);
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
     if (normal_length == 0.0f)
@@ -461,6 +499,18 @@ template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirror (
     const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
 {
+  initMethodData ();
+  computePointNormalMirrorInRect (pos_x, pos_y, point_index, rect_width_, rect_height_, normal);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirrorInRect (
+    const int pos_x, const int pos_y, const unsigned point_index,
+    const int rect_width, const int rect_height, PointOutT &normal) const
+{
+  const int rect_width_2 = rect_width / 2, rect_width_4 = rect_width / 4;
+  const int rect_height_2 = rect_height / 2, rect_height_4 = rect_height / 4;
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
   const int width = input_->width;
@@ -469,13 +519,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   // ==============================================================
   if (normal_estimation_method_ == COVARIANCE_MATRIX) 
   {
-    if (!init_covariance_matrix_)
-      initCovarianceMatrixMethod ();
-
-    const int start_x = pos_x - rect_width_2_;
-    const int start_y = pos_y - rect_height_2_;
-    const int end_x = start_x + rect_width_;
-    const int end_y = start_y + rect_height_;
+    const int start_x = pos_x - rect_width_2;
+    const int start_y = pos_y - rect_height_2;
+    const int end_x = start_x + rect_width;
+    const int end_y = start_y + rect_height;
 
     unsigned count = 0;
     auto cb_xyz_fecse = [this] (unsigned p1, unsigned p2, unsigned p3, unsigned p4) { return integral_image_XYZ_.getFiniteElementsCountSE (p1, p2, p3, p4); };
@@ -539,13 +586,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   // =======================================================
   if (normal_estimation_method_ == AVERAGE_3D_GRADIENT) 
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    const int start_x = pos_x - rect_width_2_;
-    const int start_y = pos_y - rect_height_2_;
-    const int end_x = start_x + rect_width_;
-    const int end_y = start_y + rect_height_;
+    const int start_x = pos_x - rect_width_2;
+    const int start_y = pos_y - rect_height_2;
+    const int end_x = start_x + rect_width;
+    const int end_y = start_y + rect_height;
 
     unsigned count_x = 0;
     unsigned count_y = 0;
@@ -596,17 +640,14 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   // ======================================================
   if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE) 
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
-    int point_index_L_x = pos_x - rect_width_4_ - 1;
+    int point_index_L_x = pos_x - rect_width_4 - 1;
     int point_index_L_y = pos_y;
-    int point_index_R_x = pos_x + rect_width_4_ + 1;
+    int point_index_R_x = pos_x + rect_width_4 + 1;
     int point_index_R_y = pos_y;
     int point_index_U_x = pos_x - 1;
-    int point_index_U_y = pos_y - rect_height_4_;
+    int point_index_U_y = pos_y - rect_height_4;
     int point_index_D_x = pos_x + 1;
-    int point_index_D_y = pos_y + rect_height_4_;
+    int point_index_D_y = pos_y + rect_height_4;
 
     if (point_index_L_x < 0)
       point_index_L_x = -point_index_L_x;
@@ -622,25 +663,25 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     if (point_index_D_y >= height)
       point_index_D_y = height-(point_index_D_y-(height-1));
 
-    const int start_x_L = pos_x - rect_width_2_;
-    const int start_y_L = pos_y - rect_height_4_;
-    const int end_x_L = start_x_L + rect_width_2_;
-    const int end_y_L = start_y_L + rect_height_2_;
+    const int start_x_L = pos_x - rect_width_2;
+    const int start_y_L = pos_y - rect_height_4;
+    const int end_x_L = start_x_L + rect_width_2;
+    const int end_y_L = start_y_L + rect_height_2;
 
     const int start_x_R = pos_x + 1;
-    const int start_y_R = pos_y - rect_height_4_;
-    const int end_x_R = start_x_R + rect_width_2_;
-    const int end_y_R = start_y_R + rect_height_2_;
+    const int start_y_R = pos_y - rect_height_4;
+    const int end_x_R = start_x_R + rect_width_2;
+    const int end_y_R = start_y_R + rect_height_2;
 
-    const int start_x_U = pos_x - rect_width_4_;
-    const int start_y_U = pos_y - rect_height_2_;
-    const int end_x_U = start_x_U + rect_width_2_;
-    const int end_y_U = start_y_U + rect_height_2_;
+    const int start_x_U = pos_x - rect_width_4;
+    const int start_y_U = pos_y - rect_height_2;
+    const int end_x_U = start_x_U + rect_width_2;
+    const int end_y_U = start_y_U + rect_height_2;
 
-    const int start_x_D = pos_x - rect_width_4_;
+    const int start_x_D = pos_x - rect_width_4;
     const int start_y_D = pos_y + 1;
-    const int end_x_D = start_x_D + rect_width_2_;
-    const int end_y_D = start_y_D + rect_height_2_;
+    const int end_x_D = start_x_D + rect_width_2;
+    const int end_y_D = start_y_D + rect_height_2;
 
     unsigned count_L_z = 0;
     unsigned count_R_z = 0;
@@ -730,7 +771,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
 {
   output.sensor_origin_ = input_->sensor_origin_;
   output.sensor_orientation_ = input_->sensor_orientation_;
-  
+
+  // The normals are computed in parallel, so the method data must be ready and errors be raised beforehand
+  initMethodData ();
+  if (border_policy_ == BORDER_POLICY_MIRROR && normal_estimation_method_ == SIMPLE_3D_GRADIENT)
+    PCL_THROW_EXCEPTION (PCLException, "BORDER_POLICY_MIRROR not supported for normal estimation method SIMPLE_3D_GRADIENT");
+
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
   // compute depth-change map
@@ -831,20 +877,192 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
   delete[] depthChangeMap;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalSmoothed (const float *distance_map,
+                                                                                     const unsigned pos_x,
+                                                                                     const unsigned pos_y,
+                                                                                     const unsigned point_index,
+                                                                                     PointOutT &normal,
+                                                                                     PixelBatch &batch) const
+{
+  const float bad_point = std::numeric_limits<float>::quiet_NaN ();
+
+  const float depth = (*input_)[point_index].z;
+  if (!std::isfinite (depth))
+  {
+    normal.getNormalVector3fMap ().setConstant (bad_point);
+    normal.curvature = bad_point;
+    return;
+  }
+
+  float smoothing = normal_smoothing_size_;
+  if (use_depth_dependent_smoothing_)
+    smoothing += depth / 10.0f;
+  smoothing = (std::min)(distance_map[point_index], smoothing);
+  if (smoothing <= 2.0f)
+  {
+    normal.getNormalVector3fMap ().setConstant (bad_point);
+    normal.curvature = bad_point;
+    return;
+  }
+  const int rect_size = static_cast<int> (smoothing);
+
+  if (border_policy_ == BORDER_POLICY_MIRROR)
+  {
+    computePointNormalMirrorInRect (pos_x, pos_y, point_index, rect_size, rect_size, normal);
+    return;
+  }
+
+  // Since depth can be anything, we have no guarantee that the border is sufficient, so we need to check
+  const unsigned rect_size_2 = rect_size / 2;
+  if (pos_x <= rect_size_2 || pos_y <= rect_size_2 || pos_x + rect_size_2 >= input_->width || pos_y + rect_size_2 >= input_->height)
+  {
+    normal.getNormalVector3fMap ().setConstant (bad_point);
+    normal.curvature = bad_point;
+    return;
+  }
+
+  if (normal_estimation_method_ != COVARIANCE_MATRIX && normal_estimation_method_ != AVERAGE_3D_GRADIENT)
+  {
+    computePointNormalInRect (pos_x, pos_y, point_index, rect_size, rect_size, normal);
+    return;
+  }
+
+  batch.pos_x[batch.size] = pos_x;
+  batch.pos_y[batch.size] = pos_y;
+  batch.rect_size[batch.size] = rect_size;
+  batch.point_index[batch.size] = point_index;
+  batch.normal[batch.size] = &normal;
+  if (++batch.size == NormalBatch::LANES)
+    computePointNormalsBatch (batch);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalsBatch (PixelBatch &batch) const
+{
+  using LaneArray = Eigen::Array<double, NormalBatch::LANES, 1>;
+  const float bad_point = std::numeric_limits<float>::quiet_NaN ();
+
+  if (normal_estimation_method_ == COVARIANCE_MATRIX)
+  {
+    // Accumulate the covariance matrices as computePointNormal does, and solve them all at once
+    NormalBatch &solver = batch.solver;
+    for (std::size_t i = 0; i < batch.size; ++i)
+    {
+      const int start_x = batch.pos_x[i] - batch.rect_size[i] / 2;
+      const int start_y = batch.pos_y[i] - batch.rect_size[i] / 2;
+      const unsigned count = integral_image_XYZ_.getFiniteElementsCount (start_x, start_y, batch.rect_size[i], batch.rect_size[i]);
+      if (count == 0)
+      {
+        batch.normal[i]->normal_x = batch.normal[i]->normal_y = batch.normal[i]->normal_z = batch.normal[i]->curvature = bad_point;
+        continue;
+      }
+
+      const Eigen::Vector3f center = integral_image_XYZ_.getFirstOrderSum (start_x, start_y, batch.rect_size[i], batch.rect_size[i]).template cast<float> ();
+      const typename IntegralImage2D<float, 3>::SecondOrderType so_elements = integral_image_XYZ_.getSecondOrderSum (start_x, start_y, batch.rect_size[i], batch.rect_size[i]);
+
+      Eigen::Matrix3f covariance_matrix;
+      covariance_matrix.coeffRef (0) = static_cast<float> (so_elements [0]);
+      covariance_matrix.coeffRef (1) = covariance_matrix.coeffRef (3) = static_cast<float> (so_elements [1]);
+      covariance_matrix.coeffRef (2) = covariance_matrix.coeffRef (6) = static_cast<float> (so_elements [2]);
+      covariance_matrix.coeffRef (4) = static_cast<float> (so_elements [3]);
+      covariance_matrix.coeffRef (5) = covariance_matrix.coeffRef (7) = static_cast<float> (so_elements [4]);
+      covariance_matrix.coeffRef (8) = static_cast<float> (so_elements [5]);
+      covariance_matrix -= (center * center.transpose ()) / static_cast<float> (count);
+      solver.addCovarianceMatrix (covariance_matrix, static_cast<index_t> (i));
+    }
+
+    solver.compute ();
+    for (std::size_t lane = 0; lane < solver.size (); ++lane)
+    {
+      const std::size_t i = solver.getId (lane);
+      PointOutT &normal = *batch.normal[i];
+      float nx, ny, nz;
+      solver.getNormal (lane, nx, ny, nz, normal.curvature);
+      flipNormalTowardsViewpoint ((*input_)[batch.point_index[i]], vpx_, vpy_, vpz_, nx, ny, nz);
+      normal.normal_x = nx;
+      normal.normal_y = ny;
+      normal.normal_z = nz;
+    }
+    solver.clear ();
+  }
+  else
+  {
+    // Gather the smoothed gradients of all pixels, the unused lanes are left zero
+    LaneArray gxx = LaneArray::Zero (), gxy = LaneArray::Zero (), gxz = LaneArray::Zero ();
+    LaneArray gyx = LaneArray::Zero (), gyy = LaneArray::Zero (), gyz = LaneArray::Zero ();
+    bool valid[NormalBatch::LANES] = {};
+    for (std::size_t i = 0; i < batch.size; ++i)
+    {
+      const int start_x = batch.pos_x[i] - batch.rect_size[i] / 2;
+      const int start_y = batch.pos_y[i] - batch.rect_size[i] / 2;
+      if (integral_image_DX_.getFiniteElementsCount (start_x, start_y, batch.rect_size[i], batch.rect_size[i]) == 0 ||
+          integral_image_DY_.getFiniteElementsCount (start_x, start_y, batch.rect_size[i], batch.rect_size[i]) == 0)
+        continue;
+      valid[i] = true;
+
+      const Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (start_x, start_y, batch.rect_size[i], batch.rect_size[i]);
+      const Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (start_x, start_y, batch.rect_size[i], batch.rect_size[i]);
+      gxx[i] = gradient_x[0]; gxy[i] = gradient_x[1]; gxz[i] = gradient_x[2];
+      gyx[i] = gradient_y[0]; gyy[i] = gradient_y[1]; gyz[i] = gradient_y[2];
+    }
+
+    // normal = gradient_y x gradient_x, normalized
+    LaneArray nx = gyy * gxz - gyz * gxy;
+    LaneArray ny = gyz * gxx - gyx * gxz;
+    LaneArray nz = gyx * gxy - gyy * gxx;
+    const LaneArray normal_length = nx * nx + ny * ny + nz * nz;
+    const LaneArray norm = (normal_length == 0.0).select (LaneArray::Ones (), normal_length.sqrt ());
+    nx /= norm;
+    ny /= norm;
+    nz /= norm;
+
+    for (std::size_t i = 0; i < batch.size; ++i)
+    {
+      PointOutT &normal = *batch.normal[i];
+      if (!valid[i])
+      {
+        normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = bad_point;
+        continue;
+      }
+      if (normal_length[i] == 0.0)
+      {
+        normal.getNormalVector3fMap ().setConstant (bad_point);
+        normal.curvature = bad_point;
+        continue;
+      }
+
+      float normal_x = static_cast<float> (nx[i]);
+      float normal_y = static_cast<float> (ny[i]);
+      float normal_z = static_cast<float> (nz[i]);
+      flipNormalTowardsViewpoint ((*input_)[batch.point_index[i]], vpx_, vpy_, vpz_, normal_x, normal_y, normal_z);
+      normal.normal_x = normal_x;
+      normal.normal_y = normal_y;
+      normal.normal_z = normal_z;
+      normal.curvature = bad_point;
+    }
+  }
+  batch.size = 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeatureFull (const float *distanceMap,
                                                                              const float &bad_point,
                                                                              PointCloudOut &output)
 {
-  unsigned index = 0;
+  std::ptrdiff_t begin_row = 0, end_row = input_->height;
+  unsigned begin_col = 0, end_col = input_->width;
+
+  // That sets the output density to false!
+  output.is_dense = false;
 
   if (border_policy_ == BORDER_POLICY_IGNORE)
   {
     // Set all normals that we do not touch to NaN
     // top and bottom borders
-    // That sets the output density to false!
-    output.is_dense = false;
     const auto border = static_cast<unsigned>(normal_smoothing_size_);
     PointOutT* vec1 = &output [0];
     PointOutT* vec2 = vec1 + input_->width * (input_->height - border);
@@ -872,151 +1090,29 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeatureFull (con
       }
     }
 
-    if (use_depth_dependent_smoothing_)
-    {
-      index = border + input_->width * border;
-      unsigned skip = (border << 1);
-      for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-      {
-        for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
-        {
-          index = ri * input_->width + ci;
-
-          const float depth = (*input_)[index].z;
-          if (!std::isfinite (depth))
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            // Since depth can be anything, we have no guarantee that the border is sufficient, so we need to check
-            if(ci>static_cast<unsigned>(rect_width_2_) && ri>static_cast<unsigned>(rect_height_2_) && (ci+rect_width_2_)<input_->width && (ri+rect_height_2_)<input_->height) {
-              computePointNormal (ci, ri, index, output [index]);
-            } else {
-              output[index].getNormalVector3fMap ().setConstant (bad_point);
-              output[index].curvature = bad_point;
-            }
-          }
-          else
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-          }
-        }
-      }
-    }
-    else
-    {
-      index = border + input_->width * border;
-      unsigned skip = (border << 1);
-      for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-      {
-        for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
-        {
-          index = ri * input_->width + ci;
-
-          if (!std::isfinite ((*input_)[index].z))
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormal (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-          }
-        }
-      }
-    }
+    begin_row = begin_col = border;
+    end_row = static_cast<std::ptrdiff_t> (input_->height) - border;
+    end_col = input_->width > border ? input_->width - border : 0;
   }
-  else if (border_policy_ == BORDER_POLICY_MIRROR)
-  {
-    output.is_dense = false;
 
-    if (use_depth_dependent_smoothing_)
-    {
-      //index = 0;
-      //unsigned skip = 0;
-      //for (unsigned ri = 0; ri < input_->height; ++ri, index += skip)
-      for (unsigned ri = 0; ri < input_->height; ++ri)
-      {
-        //for (unsigned ci = 0; ci < input_->width; ++ci, ++index)
-        for (unsigned ci = 0; ci < input_->width; ++ci)
-        {
-          index = ri * input_->width + ci;
-
-          const float depth = (*input_)[index].z;
-          if (!std::isfinite (depth))
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormalMirror (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-          }
-        }
-      }
-    }
-    else
+  // Every row is independent, the batches of the threads are flushed at the end
+#pragma omp parallel \
+  default(none) \
+  shared(begin_col, begin_row, distanceMap, end_col, end_row, output) \
+  num_threads(threads_)
+  {
+    PixelBatch batch;
+#pragma omp for schedule(dynamic, 4)
+    for (std::ptrdiff_t ri = begin_row; ri < end_row; ++ri)
     {
-      //index = border + input_->width * border;
-      //unsigned skip = (border << 1);
-      //for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-      for (unsigned ri = 0; ri < input_->height; ++ri)
+      for (unsigned ci = begin_col; ci < end_col; ++ci)
       {
-        //for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
-        for (unsigned ci = 0; ci < input_->width; ++ci)
-        {
-          index = ri * input_->width + ci;
-
-          if (!std::isfinite ((*input_)[index].z))
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormalMirror (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-          }
-        }
+        const unsigned index = static_cast<unsigned> (ri) * input_->width + ci;
+        computePointNormalSmoothed (distanceMap, ci, static_cast<unsigned> (ri), index, output [index], batch);
       }
     }
+    if (batch.size != 0)
+      computePointNormalsBatch (batch);
   }
 }
 
@@ -1026,163 +1122,43 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeaturePart (con
                                                                              const float &bad_point,
                                                                              PointCloudOut &output)
 {
-  if (border_policy_ == BORDER_POLICY_IGNORE)
+  output.is_dense = false;
+  const auto border = static_cast<unsigned>(normal_smoothing_size_);
+  const unsigned bottom = input_->height > border ? input_->height - border : 0;
+  const unsigned right = input_->width > border ? input_->width - border : 0;
+
+#if OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+#pragma omp parallel \
+  default(none) \
+  shared(bad_point, distanceMap, output) \
+  num_threads(threads_)
+#else
+#pragma omp parallel \
+  default(none) \
+  shared(bad_point, border, bottom, distanceMap, output, right) \
+  num_threads(threads_)
+#endif
   {
-    output.is_dense = false;
-    const auto border = static_cast<unsigned>(normal_smoothing_size_);
-    const unsigned bottom = input_->height > border ? input_->height - border : 0;
-    const unsigned right = input_->width > border ? input_->width - border : 0;
-    if (use_depth_dependent_smoothing_)
+    PixelBatch batch;
+#pragma omp for schedule(dynamic, 256)
+    for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
     {
-      // Iterating over the entire index vector
-      for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+      unsigned pt_index = (*indices_)[idx];
+      unsigned u = pt_index % input_->width;
+      unsigned v = pt_index / input_->width;
+      if (border_policy_ == BORDER_POLICY_IGNORE &&
+          (v < border || v > bottom || u < border || u > right))
       {
-        unsigned pt_index = (*indices_)[idx];
-        unsigned u = pt_index % input_->width;
-        unsigned v = pt_index / input_->width;
-        if (v < border || v > bottom)
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-          continue;
-        }
-
-        if (u < border || u > right)
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-          continue;
-        }
-
-        const float depth = (*input_)[pt_index].z;
-        if (!std::isfinite (depth))
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-          continue;
-        }
-
-        float smoothing = (std::min)(distanceMap[pt_index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-        if (smoothing > 2.0f)
-        {
-          setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-          computePointNormal (u, v, pt_index, output [idx]);
-        }
-        else
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-        }
+        output[idx].getNormalVector3fMap ().setConstant (bad_point);
+        output[idx].curvature = bad_point;
+        continue;
       }
-    }
-    else
-    {
-      // Iterating over the entire index vector
-      for (std::size_t idx = 0; idx < indices_->size (); ++idx)
-      {
-        unsigned pt_index = (*indices_)[idx];
-        unsigned u = pt_index % input_->width;
-        unsigned v = pt_index / input_->width;
-        if (v < border || v > bottom)
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-          continue;
-        }
-
-        if (u < border || u > right)
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-          continue;
-        }
-
-        if (!std::isfinite ((*input_)[pt_index].z))
-        {
-          output [idx].getNormalVector3fMap ().setConstant (bad_point);
-          output [idx].curvature = bad_point;
-          continue;
-        }
-
-        float smoothing = (std::min)(distanceMap[pt_index], normal_smoothing_size_);
-
-        if (smoothing > 2.0f)
-        {
-          setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-          computePointNormal (u, v, pt_index, output [idx]);
-        }
-        else
-        {
-          output [idx].getNormalVector3fMap ().setConstant (bad_point);
-          output [idx].curvature = bad_point;
-        }
-      }
-    }
-  }// border_policy_ == BORDER_POLICY_IGNORE
-  else if (border_policy_ == BORDER_POLICY_MIRROR)
-  {
-    output.is_dense = false;
 
-    if (use_depth_dependent_smoothing_)
-    {
-      for (std::size_t idx = 0; idx < indices_->size (); ++idx)
-      {
-        unsigned pt_index = (*indices_)[idx];
-        unsigned u = pt_index % input_->width;
-        unsigned v = pt_index / input_->width;
-
-        const float depth = (*input_)[pt_index].z;
-        if (!std::isfinite (depth))
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-          continue;
-        }
-
-        float smoothing = (std::min)(distanceMap[pt_index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-
-        if (smoothing > 2.0f)
-        {
-          setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-          computePointNormalMirror (u, v, pt_index, output [idx]);
-        }
-        else
-        {
-          output[idx].getNormalVector3fMap ().setConstant (bad_point);
-          output[idx].curvature = bad_point;
-        }
-      }
-    }
-    else
-    {
-      for (std::size_t idx = 0; idx < indices_->size (); ++idx)
-      {
-        unsigned pt_index = (*indices_)[idx];
-        unsigned u = pt_index % input_->width;
-        unsigned v = pt_index / input_->width;
-
-        if (!std::isfinite ((*input_)[pt_index].z))
-        {
-          output [idx].getNormalVector3fMap ().setConstant (bad_point);
-          output [idx].curvature = bad_point;
-          continue;
-        }
-
-        float smoothing = (std::min)(distanceMap[pt_index], normal_smoothing_size_);
-
-        if (smoothing > 2.0f)
-        {
-          setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-          computePointNormalMirror (u, v, pt_index, output [idx]);
-        }
-        else
-        {
-          output [idx].getNormalVector3fMap ().setConstant (bad_point);
-          output [idx].curvature = bad_point;
-        }
-      }
+      computePointNormalSmoothed (distanceMap, u, v, pt_index, output [idx], batch);
     }
-  } // border_policy_ == BORDER_POLICY_MIRROR
+    if (batch.size != 0)
+      computePointNormalsBatch (batch);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,134 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_NEIGHBORHOOD_GRAPH_H_
+#define PCL_FEATURES_IMPL_NEIGHBORHOOD_GRAPH_H_
+
+#include <pcl/features/neighborhood_graph.h>
+#include <pcl/common/point_tests.h> // for pcl::isFinite
+#include <pcl/console/print.h>
+
+#include <numeric>
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::NeighborhoodGraph<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::NeighborhoodGraph::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::NeighborhoodGraph::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::NeighborhoodGraph<PointT>::computeRadiusNeighborhoods (const PointCloudConstPtr &cloud,
+                                                           const SearchPtr &search, double radius)
+{
+  return (compute (cloud, search, radius, true));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::NeighborhoodGraph<PointT>::computeKNeighborhoods (const PointCloudConstPtr &cloud,
+                                                      const SearchPtr &search, int k)
+{
+  return (compute (cloud, search, k, false));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::NeighborhoodGraph<PointT>::compute (const PointCloudConstPtr &cloud, const SearchPtr &search,
+                                         double parameter, bool radius_search)
+{
+  if (!cloud || !search || !search->getInputCloud ())
+  {
+    PCL_ERROR ("[pcl::NeighborhoodGraph::compute] No input cloud or no search object with a search surface given!\n");
+    return (false);
+  }
+
+  input_ = cloud;
+  surface_ = search->getInputCloud ();
+  search_parameter_ = parameter;
+  radius_search_ = radius_search;
+
+  // Only the finite points are searched, the others get empty neighborhoods. An empty list
+  // of queries searches all points.
+  const std::size_t nr_points = cloud->size ();
+  pcl::Indices queries;
+  if (!cloud->is_dense)
+  {
+    queries.reserve (nr_points);
+    for (std::size_t idx = 0; idx < nr_points; ++idx)
+      if (isFinite ((*cloud)[idx]))
+        queries.push_back (static_cast<index_t> (idx));
+    if (queries.size () == nr_points)
+      pcl::Indices ().swap (queries);
+  }
+
+  neighborhoods_.clear ();
+  if (cloud->is_dense || !queries.empty ())
+  {
+    const unsigned int search_threads = search->getNumberOfThreads ();
+    search->setNumberOfThreads (threads_);
+    if (radius_search)
+      search->radiusSearch (*cloud, queries, parameter, neighborhoods_);
+    else
+      search->nearestKSearch (*cloud, queries, static_cast<int> (parameter), neighborhoods_);
+    search->setNumberOfThreads (search_threads);
+  }
+
+  // Spread the offsets of the searched points over all points, the neighbors stay in place
+  if (neighborhoods_.size () != nr_points)
+  {
+    std::vector<std::size_t> offsets (nr_points + 1, 0);
+    for (std::size_t query = 0; query < queries.size (); ++query)
+      offsets[queries[query] + 1] = neighborhoods_.getNumberOfNeighbors (query);
+    std::partial_sum (offsets.begin (), offsets.end (), offsets.begin ());
+    neighborhoods_.offsets.swap (offsets);
+  }
+  return (true);
+}
+
+#endif    // PCL_FEATURES_IMPL_NEIGHBORHOOD_GRAPH_H_
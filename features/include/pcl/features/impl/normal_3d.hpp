@@ -47,10 +47,12 @@
 template <typename PointInT, typename PointOutT> void
 pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
 {
-  // Allocate enough space to hold the results
+  // The search buffers, reused by all the points
   // \note This resize is irrelevant for a radiusSearch ().
-  pcl::Indices nn_indices (k_);
-  std::vector<float> nn_dists (k_);
+  SearchContext context;
+  context.resize (k_);
+  // Neighborhoods are gathered and solved in batches
+  pcl::detail::NormalEstimationBatch<PointInT> batch;
 
   output.is_dense = true;
   // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
@@ -59,8 +61,8 @@ pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &outpu
     // Iterating over the entire index vector
     for (std::size_t idx = 0; idx < indices_->size (); ++idx)
     {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
-          !computePointNormal (*surface_, nn_indices, output[idx].normal[0], output[idx].normal[1], output[idx].normal[2], output[idx].curvature))
+      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, context) == 0 ||
+          !batch.add (*surface_, context.indices, static_cast<index_t> (idx)))
       {
         output[idx].normal[0] = output[idx].normal[1] = output[idx].normal[2] = output[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
 
@@ -68,9 +70,8 @@ pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &outpu
         continue;
       }
 
-      flipNormalTowardsViewpoint ((*input_)[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output[idx].normal[0], output[idx].normal[1], output[idx].normal[2]);
-
+      if (batch.full ())
+        computeBatch (batch, output);
     }
   }
   else
@@ -79,8 +80,8 @@ pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &outpu
     for (std::size_t idx = 0; idx < indices_->size (); ++idx)
     {
       if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
-          !computePointNormal (*surface_, nn_indices, output[idx].normal[0], output[idx].normal[1], output[idx].normal[2], output[idx].curvature))
+          this->searchForNeighbors ((*indices_)[idx], search_parameter_, context) == 0 ||
+          !batch.add (*surface_, context.indices, static_cast<index_t> (idx)))
       {
         output[idx].normal[0] = output[idx].normal[1] = output[idx].normal[2] = output[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
 
@@ -88,11 +89,28 @@ pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &outpu
         continue;
       }
 
-      flipNormalTowardsViewpoint ((*input_)[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output[idx].normal[0], output[idx].normal[1], output[idx].normal[2]);
-
+      if (batch.full ())
+        computeBatch (batch, output);
     }
   }
+  computeBatch (batch, output);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::NormalEstimation<PointInT, PointOutT>::computeBatch (pcl::detail::NormalEstimationBatch<PointInT> &batch,
+                                                          PointCloudOut &output) const
+{
+  batch.compute ();
+  for (std::size_t lane = 0; lane < batch.size (); ++lane)
+  {
+    const index_t idx = batch.getId (lane);
+    batch.getNormal (lane, output[idx].normal[0], output[idx].normal[1], output[idx].normal[2], output[idx].curvature);
+
+    flipNormalTowardsViewpoint ((*input_)[(*indices_)[idx]], vpx_, vpy_, vpz_,
+                                output[idx].normal[0], output[idx].normal[1], output[idx].normal[2]);
+  }
+  batch.clear ();
 }
 
 #define PCL_INSTANTIATE_NormalEstimation(T,NT) template class PCL_EXPORTS pcl::NormalEstimation<T,NT>;
@@ -0,0 +1,240 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_NORMAL_3D_BATCH_H_
+#define PCL_FEATURES_IMPL_NORMAL_3D_BATCH_H_
+
+#include <pcl/features/normal_3d_batch.h>
+#include <pcl/features/feature.h> // for solvePlaneParameters
+#include <pcl/common/point_tests.h> // for pcl::isFinite
+
+#include <cmath>
+#include <limits>
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::detail::NormalEstimationBatch<PointT>::add (const pcl::PointCloud<PointT> &cloud,
+                                                 const pcl::Indices &indices,
+                                                 index_t id)
+{
+  if (indices.size () < 3)
+    return (false);
+
+  // Shift the data by the first finite point, as computeMeanAndCovarianceMatrix does
+  float kx = 0.0f, ky = 0.0f, kz = 0.0f;
+  for (const auto &index : indices)
+    if (isFinite (cloud[index]))
+    {
+      kx = cloud[index].x; ky = cloud[index].y; kz = cloud[index].z;
+      break;
+    }
+
+  // Gather the neighborhood into the structure-of-arrays buffers
+  x_.resize (indices.size ());
+  y_.resize (indices.size ());
+  z_.resize (indices.size ());
+  std::size_t nr_points = 0;
+  for (const auto &index : indices)
+  {
+    const PointT &point = cloud[index];
+    if (!cloud.is_dense && !isFinite (point))
+      continue;
+    x_[nr_points] = point.x - kx;
+    y_[nr_points] = point.y - ky;
+    z_[nr_points] = point.z - kz;
+    ++nr_points;
+  }
+  if (nr_points == 0)
+    return (false);
+
+  const float *x = x_.data (), *y = y_.data (), *z = z_.data ();
+  float xx = 0.0f, xy = 0.0f, xz = 0.0f, yy = 0.0f, yz = 0.0f, zz = 0.0f;
+  float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+#pragma omp simd reduction(+:xx, xy, xz, yy, yz, zz, sx, sy, sz)
+  for (std::size_t i = 0; i < nr_points; ++i)
+  {
+    xx += x[i] * x[i];
+    xy += x[i] * y[i];
+    xz += x[i] * z[i];
+    yy += y[i] * y[i];
+    yz += y[i] * z[i];
+    zz += z[i] * z[i];
+    sx += x[i];
+    sy += y[i];
+    sz += z[i];
+  }
+
+  const std::size_t lane = size_++;
+  moments_[0][lane] = xx;
+  moments_[1][lane] = xy;
+  moments_[2][lane] = xz;
+  moments_[3][lane] = yy;
+  moments_[4][lane] = yz;
+  moments_[5][lane] = zz;
+  moments_[6][lane] = sx;
+  moments_[7][lane] = sy;
+  moments_[8][lane] = sz;
+  count_[lane] = static_cast<float> (nr_points);
+  ids_[lane] = id;
+  return (true);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::detail::NormalEstimationBatch<PointT>::addCovarianceMatrix (const Eigen::Matrix3f &covariance_matrix,
+                                                                 index_t id)
+{
+  // A single point at the origin whose second order moments are the covariance matrix
+  const std::size_t lane = size_++;
+  moments_[0][lane] = covariance_matrix.coeff (0, 0);
+  moments_[1][lane] = covariance_matrix.coeff (0, 1);
+  moments_[2][lane] = covariance_matrix.coeff (0, 2);
+  moments_[3][lane] = covariance_matrix.coeff (1, 1);
+  moments_[4][lane] = covariance_matrix.coeff (1, 2);
+  moments_[5][lane] = covariance_matrix.coeff (2, 2);
+  moments_[6][lane] = moments_[7][lane] = moments_[8][lane] = 0.0f;
+  count_[lane] = 1.0f;
+  ids_[lane] = id;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::detail::NormalEstimationBatch<PointT>::compute ()
+{
+  constexpr float epsilon = std::numeric_limits<float>::epsilon ();
+  constexpr float s_inv3 = 1.0f / 3.0f;
+  const float s_sqrt3 = std::sqrt (3.0f);
+
+  // Pad the unused lanes with an empty neighborhood
+  for (std::size_t lane = size_; lane < LANES; ++lane)
+  {
+    for (auto &moment : moments_)
+      moment[lane] = 0.0f;
+    count_[lane] = 1.0f;
+  }
+
+  // Covariance matrices, see pcl::computeMeanAndCovarianceMatrix
+  const LaneArray mx = moments_[6] / count_;
+  const LaneArray my = moments_[7] / count_;
+  const LaneArray mz = moments_[8] / count_;
+  const LaneArray cxx = moments_[0] / count_ - mx * mx;
+  const LaneArray cxy = moments_[1] / count_ - mx * my;
+  const LaneArray cxz = moments_[2] / count_ - mx * mz;
+  const LaneArray cyy = moments_[3] / count_ - my * my;
+  const LaneArray cyz = moments_[4] / count_ - my * mz;
+  const LaneArray czz = moments_[5] / count_ - mz * mz;
+  const LaneArray trace = cxx + cyy + czz;
+
+  // Scale the matrices so their entries are in [-1,1], see pcl::eigen33
+  LaneArray scale = cxx.abs ().max (cxy.abs ()).max (cxz.abs ()).max (cyy.abs ()).max (cyz.abs ()).max (czz.abs ());
+  scale = (scale <= std::numeric_limits<float>::min ()).select (LaneArray::Ones (), scale);
+  const LaneArray m00 = cxx / scale, m01 = cxy / scale, m02 = cxz / scale;
+  const LaneArray m11 = cyy / scale, m12 = cyz / scale, m22 = czz / scale;
+
+  // The characteristic equation is x^3 - c2*x^2 + c1*x - c0 = 0, see pcl::computeRoots
+  const LaneArray c0 = m00 * m11 * m22
+                     + 2.0f * m01 * m02 * m12
+                     - m00 * m12 * m12
+                     - m11 * m02 * m02
+                     - m22 * m01 * m01;
+  const LaneArray c1 = m00 * m11 - m01 * m01 + m00 * m22 - m02 * m02 + m11 * m22 - m12 * m12;
+  const LaneArray c2 = m00 + m11 + m22;
+
+  const LaneArray c2_over_3 = c2 * s_inv3;
+  const LaneArray a_over_3 = ((c1 - c2 * c2_over_3) * s_inv3).min (0.0f);
+  const LaneArray half_b = 0.5f * (c0 + c2_over_3 * (2.0f * c2_over_3 * c2_over_3 - c1));
+  const LaneArray q = (half_b * half_b + a_over_3 * a_over_3 * a_over_3).min (0.0f);
+  const LaneArray rho = (-a_over_3).sqrt ();
+  const LaneArray sqrt_q = (-q).sqrt ();
+
+  // The trigonometric part of the closed form is evaluated lane by lane
+  LaneArray cos_theta, sin_theta;
+  for (std::size_t lane = 0; lane < size_; ++lane)
+  {
+    const float theta = std::atan2 (sqrt_q[lane], half_b[lane]) * s_inv3;
+    cos_theta[lane] = std::cos (theta);
+    sin_theta[lane] = std::sin (theta);
+  }
+  for (std::size_t lane = size_; lane < LANES; ++lane)
+    cos_theta[lane] = sin_theta[lane] = 0.0f;
+
+  // Roots of the cubic, sorted in increasing order
+  const LaneArray r0 = c2_over_3 + 2.0f * rho * cos_theta;
+  const LaneArray r1 = c2_over_3 - rho * (cos_theta + s_sqrt3 * sin_theta);
+  const LaneArray r2 = c2_over_3 - rho * (cos_theta - s_sqrt3 * sin_theta);
+  const LaneArray t0 = r0.min (r1), t1 = r0.max (r1);
+  const LaneArray t2 = t1.min (r2);
+  const LaneArray root0 = t0.min (t2), root1 = t0.max (t2);
+
+  // One root is 0 (or negative due to rounding): fall back to the quadratic equation
+  const LaneArray sd = (c2 * c2 - 4.0f * c1).max (0.0f).sqrt ();
+  const LaneMask quadratic = (c0.abs () < epsilon) || (root0 <= 0.0f);
+  const LaneArray e0 = quadratic.select (LaneArray::Zero (), root0);
+  const LaneArray e1 = quadratic.select (0.5f * (c2 - sd), root1);
+
+  // The eigenvector of e0 is the largest cross product of the rows of (M - e0 * I)
+  const LaneArray s00 = m00 - e0, s11 = m11 - e0, s22 = m22 - e0;
+  const LaneArray v0x = m01 * m12 - m02 * s11, v0y = m02 * m01 - s00 * m12, v0z = s00 * s11 - m01 * m01;
+  const LaneArray v1x = m01 * s22 - m02 * m12, v1y = m02 * m02 - s00 * s22, v1z = s00 * m12 - m01 * m02;
+  const LaneArray v2x = s11 * s22 - m12 * m12, v2y = m12 * m02 - m01 * s22, v2z = m01 * m12 - s11 * m02;
+  const LaneArray n0 = v0x * v0x + v0y * v0y + v0z * v0z;
+  const LaneArray n1 = v1x * v1x + v1y * v1y + v1z * v1z;
+  const LaneArray n2 = v2x * v2x + v2y * v2y + v2z * v2z;
+  const LaneMask pick1 = n1 > n0;
+  const LaneArray n01 = pick1.select (n1, n0);
+  const LaneMask pick2 = n2 > n01;
+  const LaneArray length = pick2.select (n2, n01).sqrt ();
+  nx_ = pick2.select (v2x, pick1.select (v1x, v0x)) / length;
+  ny_ = pick2.select (v2y, pick1.select (v1y, v0y)) / length;
+  nz_ = pick2.select (v2z, pick1.select (v1z, v0z)) / length;
+  curvature_ = (trace != 0.0f).select ((e0 * scale / trace).abs (), LaneArray::Zero ());
+
+  // Lanes with a repeated smallest eigenvalue are rare, solve them one by one
+  const LaneMask distinct = (e1 - e0) > epsilon;
+  for (std::size_t lane = 0; lane < size_; ++lane)
+  {
+    if (distinct[lane])
+      continue;
+    Eigen::Matrix3f covariance_matrix;
+    covariance_matrix << cxx[lane], cxy[lane], cxz[lane],
+                         cxy[lane], cyy[lane], cyz[lane],
+                         cxz[lane], cyz[lane], czz[lane];
+    solvePlaneParameters (covariance_matrix, nx_[lane], ny_[lane], nz_[lane], curvature_[lane]);
+  }
+}
+
+#endif    // PCL_FEATURES_IMPL_NORMAL_3D_BATCH_H_
@@ -64,72 +64,70 @@ pcl::NormalEstimationOMP<PointInT, PointOutT>::setNumberOfThreads (unsigned int
 template <typename PointInT, typename PointOutT> void
 pcl::NormalEstimationOMP<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
 {
-  // Allocate enough space to hold the results
+  // The search buffers, copied into every thread
   // \note This resize is irrelevant for a radiusSearch ().
-  pcl::Indices nn_indices (k_);
-  std::vector<float> nn_dists (k_);
+  SearchContext context;
+  context.resize (k_);
 
   output.is_dense = true;
   // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
   if (input_->is_dense)
   {
-#pragma omp parallel for \
+#pragma omp parallel \
   default(none) \
   shared(output) \
-  firstprivate(nn_indices, nn_dists) \
-  num_threads(threads_) \
-  schedule(dynamic, chunk_size_)
-    // Iterating over the entire index vector
-    for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
+  firstprivate(context) \
+  num_threads(threads_)
     {
-      Eigen::Vector4f n;
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
-          !pcl::computePointNormal (*surface_, nn_indices, n, output[idx].curvature))
+      // Each thread gathers and solves its neighborhoods in its own batches
+      pcl::detail::NormalEstimationBatch<PointInT> batch;
+#pragma omp for schedule(dynamic, chunk_size_)
+      // Iterating over the entire index vector
+      for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
       {
-        output[idx].normal[0] = output[idx].normal[1] = output[idx].normal[2] = output[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
+        if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, context) == 0 ||
+            !batch.add (*surface_, context.indices, static_cast<index_t> (idx)))
+        {
+          output[idx].normal[0] = output[idx].normal[1] = output[idx].normal[2] = output[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
 
-        output.is_dense = false;
-        continue;
-      }
-
-      output[idx].normal_x = n[0];
-      output[idx].normal_y = n[1];
-      output[idx].normal_z = n[2];
-
-      flipNormalTowardsViewpoint ((*input_)[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output[idx].normal[0], output[idx].normal[1], output[idx].normal[2]);
+          output.is_dense = false;
+          continue;
+        }
 
+        if (batch.full ())
+          computeBatch (batch, output);
+      }
+      computeBatch (batch, output);
     }
   }
   else
   {
-#pragma omp parallel for \
+#pragma omp parallel \
   default(none) \
   shared(output) \
-  firstprivate(nn_indices, nn_dists) \
-  num_threads(threads_) \
-  schedule(dynamic, chunk_size_)
-    // Iterating over the entire index vector
-    for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
+  firstprivate(context) \
+  num_threads(threads_)
     {
-      Eigen::Vector4f n;
-      if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
-          !pcl::computePointNormal (*surface_, nn_indices, n, output[idx].curvature))
+      // Each thread gathers and solves its neighborhoods in its own batches
+      pcl::detail::NormalEstimationBatch<PointInT> batch;
+#pragma omp for schedule(dynamic, chunk_size_)
+      // Iterating over the entire index vector
+      for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
       {
-        output[idx].normal[0] = output[idx].normal[1] = output[idx].normal[2] = output[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
-
-        output.is_dense = false;
-        continue;
+        if (!isFinite ((*input_)[(*indices_)[idx]]) ||
+            this->searchForNeighbors ((*indices_)[idx], search_parameter_, context) == 0 ||
+            !batch.add (*surface_, context.indices, static_cast<index_t> (idx)))
+        {
+          output[idx].normal[0] = output[idx].normal[1] = output[idx].normal[2] = output[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
+
+          output.is_dense = false;
+          continue;
+        }
+
+        if (batch.full ())
+          computeBatch (batch, output);
       }
-
-      output[idx].normal_x = n[0];
-      output[idx].normal_y = n[1];
-      output[idx].normal_z = n[2];
-
-      flipNormalTowardsViewpoint ((*input_)[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output[idx].normal[0], output[idx].normal[1], output[idx].normal[2]);
-
+      computeBatch (batch, output);
     }
   }
 }
@@ -44,6 +44,23 @@
 #include <pcl/common/point_tests.h> // for pcl::isFinite
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimation<PointInT, PointNT, PointOutT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::PFHEstimation::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::PFHEstimation::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> bool
 pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePairFeatures (
@@ -62,6 +79,12 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
       const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
       const pcl::Indices &indices, int nr_split, Eigen::VectorXf &pfh_histogram)
 {
+  if (!use_cache_)
+  {
+    computePointPFHSignatureNoCache (cloud, normals, indices, nr_split, pfh_histogram);
+    return;
+  }
+
   int h_index, h_p;
 
   // Clear the resultant point histogram
@@ -162,6 +185,53 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignatureNoCache (
+      const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
+      const pcl::Indices &indices, int nr_split, Eigen::VectorXf &pfh_histogram) const
+{
+  // Clear the resultant point histogram
+  pfh_histogram.setZero ();
+
+  // Factorization constant
+  float hist_incr = 100.0f / static_cast<float> (indices.size () * (indices.size () - 1) / 2);
+
+  Eigen::Vector4f pfh_tuple;
+  int f_index[3];
+
+  // Iterate over all the points in the neighborhood
+  for (std::size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
+  {
+    for (std::size_t j_idx = 0; j_idx < i_idx; ++j_idx)
+    {
+      // If the 3D points are invalid, don't bother estimating, just continue
+      if (!isFinite (cloud[indices[i_idx]]) || !isFinite (cloud[indices[j_idx]]))
+        continue;
+
+      pcl::computePairFeatures (cloud[indices[i_idx]].getVector4fMap (), normals[indices[i_idx]].getNormalVector4fMap (),
+                                cloud[indices[j_idx]].getVector4fMap (), normals[indices[j_idx]].getNormalVector4fMap (),
+                                pfh_tuple[0], pfh_tuple[1], pfh_tuple[2], pfh_tuple[3]);
+
+      // Normalize the f1, f2, f3 features and push them in the histogram
+      f_index[0] = static_cast<int> (std::floor (nr_split * ((pfh_tuple[0] + M_PI) * d_pi_)));
+      if (f_index[0] < 0)         f_index[0] = 0;
+      if (f_index[0] >= nr_split) f_index[0] = nr_split - 1;
+
+      f_index[1] = static_cast<int> (std::floor (nr_split * ((pfh_tuple[1] + 1.0) * 0.5)));
+      if (f_index[1] < 0)         f_index[1] = 0;
+      if (f_index[1] >= nr_split) f_index[1] = nr_split - 1;
+
+      f_index[2] = static_cast<int> (std::floor (nr_split * ((pfh_tuple[2] + 1.0) * 0.5)));
+      if (f_index[2] < 0)         f_index[2] = 0;
+      if (f_index[2] >= nr_split) f_index[2] = nr_split - 1;
+
+      // Copy into the histogram
+      pfh_histogram[f_index[0] + nr_split * (f_index[1] + nr_split * f_index[2])] += hist_incr;
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> void
 pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
@@ -177,17 +247,25 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
   // \note This resize is irrelevant for a radiusSearch ().
   pcl::Indices nn_indices (k_);
   std::vector<float> nn_dists (k_);
+  Eigen::VectorXf pfh_histogram = pfh_histogram_;
 
+  // The internal cache is shared by all the points, so it is only used single-threaded
   output.is_dense = true;
   // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
   if (input_->is_dense)
   {
+#pragma omp parallel for \
+  default(none) \
+  shared(output) \
+  firstprivate(nn_indices, nn_dists, pfh_histogram) \
+  num_threads(use_cache_ ? 1 : threads_) \
+  schedule(dynamic, 64)
     // Iterating over the entire index vector
-    for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+    for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
     {
       if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
       {
-        for (Eigen::Index d = 0; d < pfh_histogram_.size (); ++d)
+        for (Eigen::Index d = 0; d < pfh_histogram.size (); ++d)
           output[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
 
         output.is_dense = false;
@@ -195,22 +273,28 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
       }
 
       // Estimate the PFH signature at each patch
-      computePointPFHSignature (*surface_, *normals_, nn_indices, nr_subdiv_, pfh_histogram_);
+      computePointPFHSignature (*surface_, *normals_, nn_indices, nr_subdiv_, pfh_histogram);
 
       // Copy into the resultant cloud
-      for (Eigen::Index d = 0; d < pfh_histogram_.size (); ++d)
-        output[idx].histogram[d] = pfh_histogram_[d];
+      for (Eigen::Index d = 0; d < pfh_histogram.size (); ++d)
+        output[idx].histogram[d] = pfh_histogram[d];
     }
   }
   else
   {
+#pragma omp parallel for \
+  default(none) \
+  shared(output) \
+  firstprivate(nn_indices, nn_dists, pfh_histogram) \
+  num_threads(use_cache_ ? 1 : threads_) \
+  schedule(dynamic, 64)
     // Iterating over the entire index vector
-    for (std::size_t idx = 0; idx < indices_->size (); ++idx)
+    for (std::ptrdiff_t idx = 0; idx < static_cast<std::ptrdiff_t> (indices_->size ()); ++idx)
     {
       if (!isFinite ((*input_)[(*indices_)[idx]]) ||
           this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
       {
-        for (Eigen::Index d = 0; d < pfh_histogram_.size (); ++d)
+        for (Eigen::Index d = 0; d < pfh_histogram.size (); ++d)
           output[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
 
         output.is_dense = false;
@@ -218,11 +302,11 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
       }
 
       // Estimate the PFH signature at each patch
-      computePointPFHSignature (*surface_, *normals_, nn_indices, nr_subdiv_, pfh_histogram_);
+      computePointPFHSignature (*surface_, *normals_, nn_indices, nr_subdiv_, pfh_histogram);
 
       // Copy into the resultant cloud
-      for (Eigen::Index d = 0; d < pfh_histogram_.size (); ++d)
-        output[idx].histogram[d] = pfh_histogram_[d];
+      for (Eigen::Index d = 0; d < pfh_histogram.size (); ++d)
+        output[idx].histogram[d] = pfh_histogram[d];
     }
   }
 }
@@ -42,6 +42,8 @@
 
 #include <pcl/features/rops_estimation.h>
 
+#include <pcl/pcl_macros.h> // for OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+
 #include <array>
 #include <numeric> // for accumulate
 #include <Eigen/Eigenvalues> // for EigenSolver
@@ -114,6 +116,23 @@ pcl::ROPSEstimation <PointInT, PointOutT>::getSupportRadius () const
   return (support_radius_);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::ROPSEstimation <PointInT, PointOutT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::ROPSEstimation::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::ROPSEstimation::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::ROPSEstimation <PointInT, PointOutT>::setTriangles (const std::vector <pcl::Vertices>& triangles)
@@ -141,69 +160,89 @@ pcl::ROPSEstimation <PointInT, PointOutT>::computeFeature (PointCloudOut &output
   buildListOfPointsTriangles ();
 
   //feature size = number_of_rotations * number_of_axis_to_rotate_around * number_of_projections * number_of_central_moments
-  unsigned int feature_size = number_of_rotations_ * 3 * 3 * 5;
+  const unsigned int feature_size = number_of_rotations_ * 3 * 3 * 5;
   const auto number_of_points = indices_->size ();
   output.clear ();
-  output.reserve (number_of_points);
-
-  for (const auto& idx: *indices_)
+  output.resize (number_of_points);
+
+  std::array<PointInT, 3> axes;
+  axes[0].x = 1.0f; axes[0].y = 0.0f; axes[0].z = 0.0f;
+  axes[1].x = 0.0f; axes[1].y = 1.0f; axes[1].z = 0.0f;
+  axes[2].x = 0.0f; axes[2].y = 0.0f; axes[2].z = 1.0f;
+
+#if OPENMP_LEGACY_CONST_DATA_SHARING_RULE
+#pragma omp parallel \
+  default(none) \
+  shared(axes, output) \
+  num_threads(threads_)
+#else
+#pragma omp parallel \
+  default(none) \
+  shared(axes, feature_size, number_of_points, output) \
+  num_threads(threads_)
+#endif
   {
+    // Scratch buffers of the thread, reused for all its points
     std::set <unsigned int> local_triangles;
     pcl::Indices local_points;
-    getLocalSurface ((*input_)[idx], local_triangles, local_points);
-
-    Eigen::Matrix3f lrf_matrix;
-    computeLRF ((*input_)[idx], local_triangles, lrf_matrix);
-
     PointCloudIn transformed_cloud;
-    transformCloud ((*input_)[idx], lrf_matrix, local_points, transformed_cloud);
-
-    std::array<PointInT, 3> axes;
-    axes[0].x = 1.0f; axes[0].y = 0.0f; axes[0].z = 0.0f;
-    axes[1].x = 0.0f; axes[1].y = 1.0f; axes[1].z = 0.0f;
-    axes[2].x = 0.0f; axes[2].y = 0.0f; axes[2].z = 1.0f;
+    PointCloudIn rotated_cloud;
+    Eigen::MatrixXf distribution_matrix (number_of_bins_, number_of_bins_);
+    std::vector <float> moments;
     std::vector <float> feature;
-    for (const auto &axis : axes)
+
+#pragma omp for schedule(dynamic, 16)
+    for (std::ptrdiff_t i_point = 0; i_point < static_cast<std::ptrdiff_t> (number_of_points); i_point++)
     {
-      float theta = step_;
-      do
-      {
-        //rotate local surface and get bounding box
-        PointCloudIn rotated_cloud;
-        Eigen::Vector3f min, max;
-        rotateCloud (axis, theta, transformed_cloud, rotated_cloud, min, max);
+      const PointInT& point = (*input_)[(*indices_)[i_point]];
 
-        //for each projection (XY, XZ and YZ) compute distribution matrix and central moments
-        for (unsigned int i_proj = 0; i_proj < 3; i_proj++)
-        {
-          Eigen::MatrixXf distribution_matrix;
-          distribution_matrix.resize (number_of_bins_, number_of_bins_);
-          getDistributionMatrix (i_proj, min, max, rotated_cloud, distribution_matrix);
+      local_triangles.clear ();
+      getLocalSurface (point, local_triangles, local_points);
 
-          // TODO remove this needless copy due to API design
-          std::vector <float> moments;
-          computeCentralMoments (distribution_matrix, moments);
+      Eigen::Matrix3f lrf_matrix;
+      computeLRF (point, local_triangles, lrf_matrix);
 
-          feature.insert (feature.end (), moments.begin (), moments.end ());
-        }
+      transformCloud (point, lrf_matrix, local_points, transformed_cloud);
 
-        theta += step_;
-      } while (theta < 90.0f);
+      feature.clear ();
+      for (const auto &axis : axes)
+      {
+        float theta = step_;
+        do
+        {
+          //rotate local surface and get bounding box
+          Eigen::Vector3f min, max;
+          rotateCloud (axis, theta, transformed_cloud, rotated_cloud, min, max);
+
+          //for each projection (XY, XZ and YZ) compute distribution matrix and central moments
+          for (unsigned int i_proj = 0; i_proj < 3; i_proj++)
+          {
+            getDistributionMatrix (i_proj, min, max, rotated_cloud, distribution_matrix);
+
+            // TODO remove this needless copy due to API design
+            moments.clear ();
+            computeCentralMoments (distribution_matrix, moments);
+
+            feature.insert (feature.end (), moments.begin (), moments.end ());
+          }
+
+          theta += step_;
+        } while (theta < 90.0f);
+      }
+
+      const float norm = std::accumulate(
+          feature.cbegin(), feature.cend(), 0.f, [](const auto& sum, const auto& val) {
+            return sum + std::abs(val);
+          });
+      float invert_norm;
+      if (norm < std::numeric_limits <float>::epsilon ())
+        invert_norm = 1.0f;
+      else
+        invert_norm = 1.0f / norm;
+
+      for (std::size_t i_dim = 0; i_dim < feature_size; i_dim++)
+        output[i_point].histogram[i_dim] = feature[i_dim] * invert_norm;
     }
-
-    const float norm = std::accumulate(
-        feature.cbegin(), feature.cend(), 0.f, [](const auto& sum, const auto& val) {
-          return sum + std::abs(val);
-        });
-    float invert_norm;
-    if (norm < std::numeric_limits <float>::epsilon ())
-      invert_norm = 1.0f;
-    else
-      invert_norm = 1.0f / norm;
-
-    output.emplace_back ();
-    for (std::size_t i_dim = 0; i_dim < feature_size; i_dim++)
-      output.back().histogram[i_dim] = feature[i_dim] * invert_norm;
   }
 }
 
@@ -46,6 +46,7 @@
 #include <pcl/exceptions.h>
 #include <pcl/features/spin_image.h>
 #include <cmath>
+#include <exception> // for std::exception_ptr
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT>
@@ -64,9 +65,41 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::SpinImageEstimation (
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::SpinImageEstimation::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::SpinImageEstimation::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> Eigen::ArrayXXd 
 pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int index) const
+{
+  pcl::Indices nn_indices;
+  std::vector<float> nn_sqr_dists;
+  Eigen::ArrayXXd m_matrix, m_averAngles;
+  computeSiForPoint (index, nn_indices, nn_sqr_dists, m_matrix, m_averAngles);
+  return m_matrix;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (
+  int index, pcl::Indices &nn_indices, std::vector<float> &nn_sqr_dists,
+  Eigen::ArrayXXd &m_matrix, Eigen::ArrayXXd &m_averAngles) const
 {
   assert (image_width_ > 0);
   assert (support_angle_cos_ <= 1.0 && support_angle_cos_ >= 0.0); // may be permit negative cosine?
@@ -85,8 +118,9 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int i
       (*rotation_axes_cloud_)[index].getNormalVector3fMap () :
       origin_normal;  
 
-  Eigen::ArrayXXd m_matrix (Eigen::ArrayXXd::Zero (image_width_+1, 2*image_width_+1));
-  Eigen::ArrayXXd m_averAngles (Eigen::ArrayXXd::Zero (image_width_+1, 2*image_width_+1));
+  m_matrix.setZero (image_width_+1, 2*image_width_+1);
+  if (is_angular_)
+    m_averAngles.setZero (image_width_+1, 2*image_width_+1);
 
   // OK, we are interested in the points of the cylinder of height 2*r and
   // base radius r, where r = m_dBinSize * in_iImageWidth
@@ -99,8 +133,6 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int i
   else
     bin_size = search_radius_ / image_width_ / sqrt(2.0);
 
-  pcl::Indices nn_indices;
-  std::vector<float> nn_sqr_dists;
   const int neighb_cnt = this->searchForNeighbors (index, search_radius_, nn_indices, nn_sqr_dists);
   if (neighb_cnt < static_cast<int> (min_pts_neighb_))
   {
@@ -229,8 +261,6 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int i
     // normalization
     m_matrix /= m_matrix.sum();
   }
-
-  return m_matrix;
 }
 
 
@@ -323,9 +353,32 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::initCompute ()
 template <typename PointInT, typename PointNT, typename PointOutT> void 
 pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
 { 
-  for (std::size_t i_input = 0; i_input < indices_->size (); ++i_input)
+  pcl::Indices nn_indices;
+  std::vector<float> nn_sqr_dists;
+  Eigen::ArrayXXd res, aver_angles;
+
+  // Exceptions must not escape the parallel loop, so the first one is rethrown after it
+  std::exception_ptr exception;
+
+#pragma omp parallel for \
+  default(none) \
+  shared(exception, output) \
+  firstprivate(aver_angles, nn_indices, nn_sqr_dists, res) \
+  num_threads(threads_) \
+  schedule(dynamic, 64)
+  for (std::ptrdiff_t i_input = 0; i_input < static_cast<std::ptrdiff_t> (indices_->size ()); ++i_input)
   {
-    Eigen::ArrayXXd res = computeSiForPoint (indices_->at (i_input));
+    try
+    {
+      computeSiForPoint ((*indices_)[i_input], nn_indices, nn_sqr_dists, res, aver_angles);
+    }
+    catch (...)
+    {
+#pragma omp critical
+      if (!exception)
+        exception = std::current_exception ();
+      continue;
+    }
 
     // Copy into the resultant cloud
     for (Eigen::Index iRow = 0; iRow < res.rows () ; iRow++)
@@ -336,6 +389,9 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointClo
       }
     }   
   } 
+
+  if (exception)
+    std::rethrow_exception (exception);
 }
 
 #define PCL_INSTANTIATE_SpinImageEstimation(T,NT,OutT) template class PCL_EXPORTS pcl::SpinImageEstimation<T,NT,OutT>;
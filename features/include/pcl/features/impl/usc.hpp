@@ -42,13 +42,30 @@
 
 #include <numeric> // for partial_sum
 #include <pcl/features/usc.h>
-#include <pcl/features/shot_lrf.h>
+#include <pcl/features/shot_lrf_omp.h>
 #include <pcl/common/angles.h>
 #include <pcl/common/geometry.h>
 #include <pcl/common/point_tests.h> // for pcl::isFinite
 #include <pcl/common/utils.h>
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT, typename PointRFT> void
+pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    threads_ = omp_get_num_procs();
+  else
+    threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::UniqueShapeContext::setNumberOfThreads] Setting number of threads to %u.\n", threads_);
+#else
+  threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::UniqueShapeContext::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT, typename PointRFT> bool
 pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::initCompute ()
@@ -60,7 +77,8 @@ pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::initCompute ()
   }
 
   // Default LRF estimation alg: SHOTLocalReferenceFrameEstimation
-  typename SHOTLocalReferenceFrameEstimation<PointInT, PointRFT>::Ptr lrf_estimator(new SHOTLocalReferenceFrameEstimation<PointInT, PointRFT>());
+  typename SHOTLocalReferenceFrameEstimationOMP<PointInT, PointRFT>::Ptr lrf_estimator(new SHOTLocalReferenceFrameEstimationOMP<PointInT, PointRFT>());
+  lrf_estimator->setNumberOfThreads (threads_);
   lrf_estimator->setRadiusSearch (local_radius_);
   lrf_estimator->setInputCloud (input_);
   lrf_estimator->setIndices (indices_);
@@ -143,7 +161,18 @@ pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::initCompute ()
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT, typename PointRFT> void
-pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computePointDescriptor (std::size_t index, /*float rf[9],*/ std::vector<float> &desc)
+pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computePointDescriptor (std::size_t index, /*float rf[9],*/ std::vector<float> &desc) const
+{
+  pcl::Indices nn_indices, neighbour_indices;
+  std::vector<float> nn_dists, neighbour_distances;
+  computePointDescriptor (index, nn_indices, nn_dists, neighbour_indices, neighbour_distances, desc);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT, typename PointRFT> void
+pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computePointDescriptor (
+    std::size_t index, pcl::Indices &nn_indices, std::vector<float> &nn_dists,
+    pcl::Indices &neighbour_indices, std::vector<float> &neighbour_distances, std::vector<float> &desc) const
 {
   pcl::Vector3fMapConst origin = (*input_)[(*indices_)[index]].getVector3fMap ();
 
@@ -156,8 +185,6 @@ pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computePointDescriptor (
                                 (*frames_)[index].z_axis[2]);
 
   // Find every point within specified search_radius_
-  pcl::Indices nn_indices;
-  std::vector<float> nn_dists;
   const std::size_t neighb_cnt = searchForNeighbors ((*indices_)[index], search_radius_, nn_indices, nn_dists);
   // For each point within radius
   for (std::size_t ne = 0; ne < neighb_cnt; ne++)
@@ -201,9 +228,7 @@ pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computePointDescriptor (
     const auto l = std::distance(phi_divisions_.cbegin (), std::prev(phi_min));
 
     /// Local point density = number of points in a sphere of radius "point_density_radius_" around the current neighbour
-    pcl::Indices neighbour_indices;
-    std::vector<float> neighbour_didtances;
-    float point_density = static_cast<float> (searchForNeighbors (*surface_, nn_indices[ne], point_density_radius_, neighbour_indices, neighbour_didtances));
+    float point_density = static_cast<float> (searchForNeighbors (*surface_, nn_indices[ne], point_density_radius_, neighbour_indices, neighbour_distances));
     /// point_density is always bigger than 0 because FindPointsWithinRadius returns at least the point itself
     float w = (1.0f / point_density) * volume_lut_[(l*elevation_bins_*radius_bins_) +
                                                    (k*radius_bins_) +
@@ -229,7 +254,17 @@ pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computeFeature (PointClo
 
   output.is_dense = true;
 
-  for (std::size_t point_index = 0; point_index < indices_->size (); ++point_index)
+  // The buffers are private to each thread
+  std::vector<float> descriptor (descriptor_length_);
+  pcl::Indices nn_indices, neighbour_indices;
+  std::vector<float> nn_dists, neighbour_distances;
+#pragma omp parallel for \
+  default(none) \
+  shared(output) \
+  firstprivate(descriptor, nn_indices, nn_dists, neighbour_indices, neighbour_distances) \
+  num_threads(threads_) \
+  schedule(dynamic, 16)
+  for (std::ptrdiff_t point_index = 0; point_index < static_cast<std::ptrdiff_t> (indices_->size ()); ++point_index)
   {
     //output[point_index].descriptor.resize (descriptor_length_);
 
@@ -254,8 +289,8 @@ pcl::UniqueShapeContext<PointInT, PointOutT, PointRFT>::computeFeature (PointClo
       output[point_index].rf[6 + d] = current_frame.z_axis[d];
     }
 
-    std::vector<float> descriptor (descriptor_length_);
-    computePointDescriptor (point_index, descriptor);
+    std::fill (descriptor.begin (), descriptor.end (), 0.0f);
+    computePointDescriptor (point_index, nn_indices, nn_dists, neighbour_indices, neighbour_distances, descriptor);
     std::copy (descriptor.cbegin (), descriptor.cend (), output[point_index].descriptor);
   }
 }
@@ -136,6 +136,12 @@ namespace pcl
       void 
       setSecondOrderComputation (bool compute_second_order_integral_images);
 
+      /** \brief Set the number of threads used to compute the integral images.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to the number of processors)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -204,7 +210,8 @@ namespace pcl
     private:
       using InputType = Eigen::Matrix<typename IntegralImageTypeTraits<DataType>::Type, Dimension, 1>;
 
-      /** \brief Compute the actual integral image data
+      /** \brief Compute the actual integral image data. With several threads, horizontal strips of the images
+        * are integrated in parallel and then added up.
         * \param[in] data the input data
         * \param[in] element_stride the element stride of the data
         * \param[in] row_stride the row stride of the data
@@ -223,6 +230,9 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
    };
 
    /**
@@ -255,6 +265,12 @@ namespace pcl
       virtual
       ~IntegralImage2D () = default;
 
+      /** \brief Set the number of threads used to compute the integral images.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to the number of processors)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -323,7 +339,8 @@ namespace pcl
   private:
     //  using InputType = typename IntegralImageTypeTraits<DataType>::Type;
 
-      /** \brief Compute the actual integral image data
+      /** \brief Compute the actual integral image data. With several threads, horizontal strips of the images
+        * are integrated in parallel and then added up.
         * \param[in] data the input data
         * \param[in] element_stride the element stride of the data
         * \param[in] row_stride the row stride of the data
@@ -342,6 +359,9 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
    };
  }
 
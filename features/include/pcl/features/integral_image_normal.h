@@ -43,6 +43,7 @@
 #include <pcl/point_cloud.h>
 #include <pcl/features/feature.h>
 #include <pcl/features/integral_image2D.h>
+#include <pcl/features/normal_3d_batch.h>
 
 namespace pcl
 {
@@ -128,6 +129,13 @@ namespace pcl
       void
       setRectSize (const int width, const int height);
 
+      /** \brief Set the number of threads used to compute the integral images and the normals.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to the number of processors)
+        * \note The integral images are computed by setInputCloud, so call this method first.
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
       /** \brief Sets the policy for handling borders.
         * \param[in] border_policy the border policy.
         */
@@ -323,6 +331,76 @@ namespace pcl
       initData ();
 
     private:
+      using NormalBatch = pcl::detail::NormalEstimationBatch<PointInT>;
+
+      /** \brief Pixels whose normals are computed together by computePointNormalsBatch. */
+      struct PixelBatch
+      {
+        int pos_x[NormalBatch::LANES];
+        int pos_y[NormalBatch::LANES];
+        int rect_size[NormalBatch::LANES];
+        unsigned point_index[NormalBatch::LANES];
+        PointOutT *normal[NormalBatch::LANES];
+        std::size_t size{0};
+
+        /** \brief Solves the covariance matrices of the COVARIANCE_MATRIX method. */
+        NormalBatch solver;
+
+        PCL_MAKE_ALIGNED_OPERATOR_NEW
+      };
+
+      /** \brief Initialize the data structures of the normal estimation method chosen, unless this was already
+        * done for the current input.
+        */
+      void
+      initMethodData ();
+
+      /** \brief Computes the normal at the specified position for a given size of the neighborhood region.
+        * Unlike computePointNormal, this does not modify the estimator, so it can be called from several threads.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] point_index the position index of the point
+        * \param[in] rect_width the width of the neighborhood region
+        * \param[in] rect_height the height of the neighborhood region
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormalInRect (const int pos_x, const int pos_y, const unsigned point_index,
+                                const int rect_width, const int rect_height, PointOutT &normal) const;
+
+      /** \brief Computes the normal at the specified position with mirroring for border handling, for a given
+        * size of the neighborhood region. Unlike computePointNormalMirror, this does not modify the estimator.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] point_index the position index of the point
+        * \param[in] rect_width the width of the neighborhood region
+        * \param[in] rect_height the height of the neighborhood region
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormalMirrorInRect (const int pos_x, const int pos_y, const unsigned point_index,
+                                      const int rect_width, const int rect_height, PointOutT &normal) const;
+
+      /** \brief Computes the normal of a point with the neighborhood size given by the distance map and the
+        * smoothing parameters. With BORDER_POLICY_IGNORE, the COVARIANCE_MATRIX and AVERAGE_3D_GRADIENT normals
+        * are gathered in \a batch and computed once it is full.
+        * \param[in] distance_map distance map
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] point_index the position index of the point
+        * \param[out] normal the output estimated normal
+        * \param[in,out] batch the pending pixels of the calling thread
+        */
+      void
+      computePointNormalSmoothed (const float *distance_map, const unsigned pos_x, const unsigned pos_y,
+                                  const unsigned point_index, PointOutT &normal, PixelBatch &batch) const;
+
+      /** \brief Computes the normals of the pixels of a batch with the COVARIANCE_MATRIX or AVERAGE_3D_GRADIENT
+        * method, solving all of them together on Eigen arrays, and empties the batch.
+        * \param[in,out] batch the pixels to compute the normals for
+        */
+      void
+      computePointNormalsBatch (PixelBatch &batch) const;
 
       /** \brief Flip (in place) the estimated normal of a point towards a given viewpoint
         * \param point a given point
@@ -337,7 +415,7 @@ namespace pcl
       inline void
       flipNormalTowardsViewpoint (const PointInT &point, 
                                   float vp_x, float vp_y, float vp_z,
-                                  float &nx, float &ny, float &nz)
+                                  float &nx, float &ny, float &nz) const
       {
         // See if we need to flip any plane normals
         vp_x -= point.x;
@@ -426,6 +504,9 @@ namespace pcl
 
       /** whether the sensor origin of the input cloud or a user given viewpoint should be used.*/
       bool use_sensor_origin_{true};
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
       
       /** \brief This method should get called before starting the actual computation. */
       bool
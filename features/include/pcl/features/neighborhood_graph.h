@@ -0,0 +1,206 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/memory.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/types.h>
+#include <pcl/search/search.h>
+
+#include <vector>
+
+namespace pcl
+{
+  /** \brief NeighborhoodGraph stores the neighborhoods of all points of a cloud in a compact
+    * compressed sparse row (CSR) layout (see \ref pcl::search::Neighborhoods): one offset per
+    * point into shared index and squared distance arrays.
+    *
+    * The graph is computed once with the batched searches of a given search object, and
+    * either a radius or a number of nearest neighbors. It can then be handed to any number of \ref pcl::Feature
+    * estimators (see \ref pcl::Feature::setNeighborhoodGraph) that search the same surface with
+    * the same parameter, which then read the neighborhoods from memory instead of repeating
+    * the search.
+    *
+    * \code
+    * pcl::NeighborhoodGraph<pcl::PointXYZ>::Ptr graph (new pcl::NeighborhoodGraph<pcl::PointXYZ>);
+    * graph->computeRadiusNeighborhoods (cloud, tree, 0.03);
+    * pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> ne;
+    * ne.setInputCloud (cloud);
+    * ne.setSearchMethod (tree);
+    * ne.setRadiusSearch (0.03);
+    * ne.setNeighborhoodGraph (graph);
+    * \endcode
+    * \note Neighborhoods are returned in the order the search object produced them.
+    * \ingroup features
+    */
+  template <typename PointT>
+  class NeighborhoodGraph
+  {
+    public:
+      using Ptr = shared_ptr<NeighborhoodGraph<PointT> >;
+      using ConstPtr = shared_ptr<const NeighborhoodGraph<PointT> >;
+
+      using PointCloud = pcl::PointCloud<PointT>;
+      using PointCloudConstPtr = typename PointCloud::ConstPtr;
+      using SearchPtr = typename pcl::search::Search<PointT>::Ptr;
+
+      /** \brief The neighbors of one point, pointing into the storage of the graph. */
+      struct Neighbors
+      {
+        /** \brief The indices of the neighbors in the search surface. */
+        const index_t *indices;
+        /** \brief The squared distances from the query point to the neighbors. */
+        const float *sqr_distances;
+        /** \brief The number of neighbors. */
+        std::size_t size;
+      };
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      NeighborhoodGraph (unsigned int nr_threads = 0)
+      {
+        setNumberOfThreads (nr_threads);
+      }
+
+      /** \brief Set the number of threads used to compute the graph. The batched searches of the
+        * search object run with this number of threads, see \ref pcl::search::Search::setNumberOfThreads.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Compute the neighbors within a radius of every point of a cloud.
+        * \param[in] cloud the query point cloud
+        * \param[in] search the search object, set up with the surface to search in
+        * \param[in] radius the sphere radius used as the maximum distance to consider a point a neighbor
+        * \return false if the search object has no input cloud
+        */
+      bool
+      computeRadiusNeighborhoods (const PointCloudConstPtr &cloud, const SearchPtr &search, double radius);
+
+      /** \brief Compute the k nearest neighbors of every point of a cloud.
+        * \param[in] cloud the query point cloud
+        * \param[in] search the search object, set up with the surface to search in
+        * \param[in] k the number of nearest neighbors
+        * \return false if the search object has no input cloud
+        */
+      bool
+      computeKNeighborhoods (const PointCloudConstPtr &cloud, const SearchPtr &search, int k);
+
+      /** \brief Get the neighborhood of a point, without copying it. The view is valid until the
+        * graph is computed again or destroyed.
+        * \param[in] index the index of the query point in the input cloud
+        */
+      inline Neighbors
+      getNeighbors (std::size_t index) const
+      {
+        const std::size_t begin = neighborhoods_.offsets[index];
+        return {neighborhoods_.indices.data () + begin, neighborhoods_.sqr_distances.data () + begin,
+                neighborhoods_.getNumberOfNeighbors (index)};
+      }
+
+      /** \brief Get the number of neighbors of a point.
+        * \param[in] index the index of the query point in the input cloud
+        */
+      inline std::size_t
+      getNumberOfNeighbors (std::size_t index) const
+      {
+        return (neighborhoods_.getNumberOfNeighbors (index));
+      }
+
+      /** \brief Get the neighborhoods of all points of the input cloud. */
+      inline const pcl::search::Neighborhoods&
+      getNeighborhoods () const { return (neighborhoods_); }
+
+      /** \brief Get the query point cloud the graph was computed for. */
+      inline PointCloudConstPtr
+      getInputCloud () const { return (input_); }
+
+      /** \brief Get the point cloud the neighbors were searched in. */
+      inline PointCloudConstPtr
+      getSearchSurface () const { return (surface_); }
+
+      /** \brief Get the search parameter (either the radius or k). */
+      inline double
+      getSearchParameter () const { return (search_parameter_); }
+
+      /** \brief Check whether the graph holds radius neighborhoods (true) or k nearest neighbors (false). */
+      inline bool
+      isRadiusSearch () const { return (radius_search_); }
+
+      /** \brief Get the number of points in the graph. */
+      inline std::size_t
+      size () const { return (neighborhoods_.size ()); }
+
+      /** \brief Get the total number of stored neighbors. */
+      inline std::size_t
+      getNumberOfEdges () const { return (neighborhoods_.indices.size ()); }
+
+    protected:
+      /** \brief Run the batched searches and store the results in CSR layout.
+        * \param[in] cloud the query point cloud
+        * \param[in] search the search object
+        * \param[in] parameter the search parameter (either the radius or k)
+        * \param[in] radius_search whether to search within a radius or for the k nearest neighbors
+        */
+      bool
+      compute (const PointCloudConstPtr &cloud, const SearchPtr &search, double parameter, bool radius_search);
+
+      /** \brief The query point cloud. */
+      PointCloudConstPtr input_;
+
+      /** \brief The point cloud the neighbors were searched in. */
+      PointCloudConstPtr surface_;
+
+      /** \brief The search parameter (either the radius or k). */
+      double search_parameter_{0.0};
+
+      /** \brief Whether the neighborhoods are radius neighborhoods or k nearest neighbors. */
+      bool radius_search_{true};
+
+      /** \brief The neighborhoods of all points of the input cloud. */
+      pcl::search::Neighborhoods neighborhoods_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
+  };
+}
+
+#include <pcl/features/impl/neighborhood_graph.hpp>
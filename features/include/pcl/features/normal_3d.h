@@ -43,6 +43,7 @@
 #include <pcl/memory.h>
 #include <pcl/pcl_macros.h>
 #include <pcl/features/feature.h>
+#include <pcl/features/normal_3d_batch.h>
 #include <pcl/common/centroid.h>
 
 namespace pcl
@@ -397,6 +398,14 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output) override;
 
+      /** \brief Solve all neighborhoods gathered in a batch, store the flipped normals and curvatures at the
+        * output indices recorded with them, and release the batch.
+        * \param batch the batch of neighborhoods
+        * \param output the resultant point cloud model dataset that contains surface normals and curvatures
+        */
+      void
+      computeBatch (pcl::detail::NormalEstimationBatch<PointInT> &batch, PointCloudOut &output) const;
+
       /** \brief Values describing the viewpoint ("pinhole" camera model assumed). For per point viewpoints, inherit
         * from NormalEstimation and provide your own computeFeature (). By default, the viewpoint is set to 0,0,0. */
       float vpx_{0.0f}, vpy_{0.0f}, vpz_{0.0f};
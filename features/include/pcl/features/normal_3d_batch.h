@@ -0,0 +1,149 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/features/simd_lanes.h>
+#include <pcl/memory.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/types.h>
+
+#include <Eigen/Core>
+
+#include <cstddef>
+#include <vector>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief NormalEstimationBatch gathers up to \ref NormalEstimationBatch::LANES neighborhoods
+      * and computes their covariance matrices, smallest eigenvalues and normals together.
+      *
+      * Each neighborhood is copied into structure-of-arrays coordinate buffers, so that the
+      * moment accumulation runs over contiguous floats. The nine moments of every neighborhood
+      * are stored lane-wise, and the closed-form 3x3 eigen-decomposition used by
+      * \ref pcl::eigen33 is then evaluated on Eigen arrays holding one value per lane, see
+      * \ref detail::float_lanes. Lanes whose two smallest eigenvalues coincide are handed to
+      * \ref pcl::eigen33.
+      *
+      * The results match \ref pcl::NormalEstimation::computePointNormal up to floating point
+      * rounding.
+      * \ingroup features
+      */
+    template <typename PointT>
+    class NormalEstimationBatch
+    {
+      public:
+        static constexpr std::size_t LANES = float_lanes;
+        using LaneArray = Eigen::Array<float, LANES, 1>;
+        using LaneMask = Eigen::Array<bool, LANES, 1>;
+
+        /** \brief Gather a neighborhood into the next free lane.
+          * \param[in] cloud the cloud the neighborhood indices refer to
+          * \param[in] indices the neighborhood indices
+          * \param[in] id a user identifier (usually the output index) stored with the lane
+          * \return false if the neighborhood is too small to define a plane, in which case no
+          * lane is used
+          */
+        bool
+        add (const pcl::PointCloud<PointT> &cloud, const pcl::Indices &indices, index_t id);
+
+        /** \brief Put an already accumulated covariance matrix into the next free lane.
+          * \param[in] covariance_matrix the (possibly unnormalized) covariance matrix
+          * \param[in] id a user identifier stored with the lane
+          */
+        void
+        addCovarianceMatrix (const Eigen::Matrix3f &covariance_matrix, index_t id);
+
+        /** \brief Compute the normals and curvatures of all occupied lanes. */
+        void
+        compute ();
+
+        /** \brief Get the normal and curvature of a lane, valid after \ref compute. */
+        inline void
+        getNormal (std::size_t lane, float &nx, float &ny, float &nz, float &curvature) const
+        {
+          nx = nx_[lane];
+          ny = ny_[lane];
+          nz = nz_[lane];
+          curvature = curvature_[lane];
+        }
+
+        /** \brief Get the identifier passed to \ref add for a lane. */
+        inline index_t
+        getId (std::size_t lane) const { return (ids_[lane]); }
+
+        /** \brief Get the number of occupied lanes. */
+        inline std::size_t
+        size () const { return (size_); }
+
+        /** \brief Check whether all lanes are occupied. */
+        inline bool
+        full () const { return (size_ == LANES); }
+
+        /** \brief Release all lanes. */
+        inline void
+        clear () { size_ = 0; }
+
+      private:
+        /** \brief Structure-of-arrays buffers for the shifted coordinates of one neighborhood. */
+        std::vector<float> x_, y_, z_;
+
+        /** \brief The accumulated moments of each lane: xx, xy, xz, yy, yz, zz, x, y, z. */
+        LaneArray moments_[9];
+
+        /** \brief The number of finite points of each lane. */
+        LaneArray count_;
+
+        /** \brief The results of each lane. */
+        LaneArray nx_, ny_, nz_, curvature_;
+
+        /** \brief The identifiers of each lane. */
+        index_t ids_[LANES];
+
+        /** \brief The number of occupied lanes. */
+        std::size_t size_{0};
+
+      public:
+        PCL_MAKE_ALIGNED_OPERATOR_NEW
+    };
+  }
+}
+
+#include <pcl/features/impl/normal_3d_batch.hpp>
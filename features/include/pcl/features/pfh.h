@@ -71,8 +71,9 @@ namespace pcl
     *     doesn't have finite 3D coordinates. Therefore, any point that contains
     *     NaN data on x, y, or z, will have its PFH feature property set to NaN.
     *
-    * \note The code is stateful as we do not expect this class to be multicore parallelized. Please look at
-    * \ref FPFHEstimationOMP for examples on parallel implementations of the FPFH (Fast Point Feature Histogram).
+    * \note The internal cache is stateful, so the descriptors are only estimated in parallel (see
+    * \ref setNumberOfThreads) when the cache is not used. Please look at \ref FPFHEstimationOMP for a parallel
+    * implementation of the FPFH (Fast Point Feature Histogram).
     *
     * \author Radu B. Rusu
     * \ingroup features
@@ -148,6 +149,14 @@ namespace pcl
         return (use_cache_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use. The default behavior is
+        * single threaded execution. The internal cache can not be shared between threads, so the descriptors
+        * are estimated by a single thread when it is used.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
       /** \brief Compute the 4-tuple representation containing the three angles and one distance between two points
         * represented by Cartesian coordinates and normals.
         * \note For explanations about the features, please see the literature mentioned above (the order of the
@@ -179,6 +188,13 @@ namespace pcl
                                 const pcl::Indices &indices, int nr_split, Eigen::VectorXf &pfh_histogram);
 
     protected:
+      /** \brief Estimate the PFH signature of a point without the internal cache, so that it can be called
+        * concurrently. See \ref computePointPFHSignature for the parameters.
+        */
+      void
+      computePointPFHSignatureNoCache (const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
+                                       const pcl::Indices &indices, int nr_split, Eigen::VectorXf &pfh_histogram) const;
+
       /** \brief Estimate the Point Feature Histograms (PFH) descriptors at a set of points given by
         * <setInputCloud (), setIndices ()> using the surface in setSearchSurface () and the spatial locator in
         * setSearchMethod ()
@@ -213,6 +229,9 @@ namespace pcl
 
       /** \brief Set to true to use the internal cache for removing redundant computations. */
       bool use_cache_{false};
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
   };
 }
 
@@ -104,6 +104,13 @@ namespace pcl
       float
       getSupportRadius () const;
 
+      /** \brief Initialize the scheduler and set the number of threads to use. The default behavior is
+        * single threaded execution.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
       /** \brief This method sets the triangles of the mesh.
         * \param[in] triangles list of triangles of the mesh
         */
@@ -222,6 +229,9 @@ namespace pcl
       /** \brief Stores the set of triangles for each point. Its purpose is to improve performance. */
       std::vector <std::vector <unsigned int> > triangles_of_the_point_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
+
     public:
       PCL_MAKE_ALIGNED_OPERATOR_NEW
   };
@@ -0,0 +1,96 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief The number of floats the batched feature kernels process together: one AVX register, or two
+      * SSE or NEON registers. It is part of the layout of public types, so it must not depend on the
+      * instruction set a translation unit is compiled for.
+      */
+    constexpr std::size_t float_lanes = 8;
+
+    /** \brief Per lane \a mask ? \a a : \a b. Eigen's select is evaluated coefficient by coefficient, whereas
+      * this loop over already evaluated lanes is compiled to vector blends.
+      * \param[in] mask the lanes to take from \a a
+      * \param[in] a the lanes to take where \a mask is set, evaluated first if it is an expression
+      * \param[in] b the lanes to take elsewhere
+      */
+    template <typename Mask, typename Array> inline Array
+    blendLanes (const Mask &mask, const std::common_type_t<Array> &a, const Array &b)
+    {
+      Array result;
+      for (Eigen::Index lane = 0; lane < b.size (); ++lane)
+        result[lane] = mask[lane] ? a[lane] : b[lane];
+      return (result);
+    }
+
+    /** \brief Per lane std::atan2 (y, x) in single precision, with the atanf polynomial of the Cephes library.
+      * It is accurate to a few ulps, but ignores the sign of zero arguments, e.g. atan2 (-0, -1) gives pi.
+      * \param[in] y the sine components
+      * \param[in] x the cosine components
+      */
+    template <typename Array> Array
+    atan2Lanes (const Array &y, const Array &x)
+    {
+      using Scalar = typename Array::Scalar;
+      const Array ay = y.abs (), ax = x.abs ();
+      // atan (t) for t in [0, 1], on (t - 1) / (t + 1) above tan (pi / 8)
+      const Array t = ay.min (ax) / ay.max (ax).max (std::numeric_limits<Scalar>::min ());
+      const auto above_pi_8 = t > static_cast<Scalar> (0.4142135623730950);
+      const Array r = blendLanes (above_pi_8, (t - Scalar (1)) / (t + Scalar (1)), t);
+      const Array z = r * r;
+      Array a = (((static_cast<Scalar> (8.05374449538e-2) * z - static_cast<Scalar> (1.38776856032e-1)) * z +
+                  static_cast<Scalar> (1.99777106478e-1)) * z - static_cast<Scalar> (3.33329491539e-1)) * z * r + r;
+      a = blendLanes (above_pi_8, a + static_cast<Scalar> (M_PI / 4), a);
+      // Back to the quadrant of (x, y)
+      a = blendLanes (ay > ax, static_cast<Scalar> (M_PI / 2) - a, a);
+      a = blendLanes (x < Scalar (0), static_cast<Scalar> (M_PI) - a, a);
+      return (blendLanes (y < Scalar (0), -a, a));
+    }
+  }
+}
@@ -261,6 +261,13 @@ namespace pcl
       void 
       setRadialStructure (bool is_radial = true) { is_radial_ = is_radial; }
 
+      /** \brief Initialize the scheduler and set the number of threads to use. The default behavior is
+        * single threaded execution.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
     protected:
       /** \brief Estimate the Spin Image descriptors at a set of points given by
         * setInputWithNormals() using the surface in setSearchSurfaceWithNormals() and the spatial locator 
@@ -283,6 +290,17 @@ namespace pcl
       Eigen::ArrayXXd 
       computeSiForPoint (int index) const;
 
+      /** \brief Computes a spin-image for the point of the scan, in the given buffers.
+        * \param[in] index the index of the reference point in the input cloud
+        * \param[out] nn_indices buffer for the neighbors of the point
+        * \param[out] nn_sqr_dists buffer for the squared distances to the neighbors
+        * \param[out] spin_image estimated spin-image (or its variant) as a matrix
+        * \param[out] average_angles buffer for the sums of the angles of the angular domain
+        */
+      void
+      computeSiForPoint (int index, pcl::Indices &nn_indices, std::vector<float> &nn_sqr_dists,
+                         Eigen::ArrayXXd &spin_image, Eigen::ArrayXXd &average_angles) const;
+
     private:
       PointCloudNConstPtr input_normals_;
       PointCloudNConstPtr rotation_axes_cloud_;
@@ -298,6 +316,9 @@ namespace pcl
       unsigned int image_width_;
       double support_angle_cos_;
       unsigned int min_pts_neighb_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
   };
 }
 
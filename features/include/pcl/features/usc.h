@@ -134,13 +134,33 @@ namespace pcl
       inline double
       getLocalRadius () const { return (local_radius_); }
 
+      /** \brief Initialize the scheduler and set the number of threads to use, for the descriptors and for the
+        * default local reference frames. The default behavior is single threaded execution.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads);
+
     protected:
       /** Compute 3D shape context feature descriptor
         * \param[in] index point index in input_
         * \param[out] desc descriptor to compute
         */
       void
-      computePointDescriptor (std::size_t index, std::vector<float> &desc);
+      computePointDescriptor (std::size_t index, std::vector<float> &desc) const;
+
+      /** Compute 3D shape context feature descriptor, using the given buffers for the neighbor searches
+        * \param[in] index point index in input_
+        * \param[out] nn_indices buffer for the neighbors of the point
+        * \param[out] nn_dists buffer for the squared distances to the neighbors of the point
+        * \param[out] neighbour_indices buffer for the local point density searches
+        * \param[out] neighbour_distances buffer for the local point density searches
+        * \param[out] desc descriptor to compute
+        */
+      void
+      computePointDescriptor (std::size_t index, pcl::Indices &nn_indices, std::vector<float> &nn_dists,
+                              pcl::Indices &neighbour_indices, std::vector<float> &neighbour_distances,
+                              std::vector<float> &desc) const;
 
       /** \brief Initialize computation by allocating all the intervals and the volume lookup table. */
       bool
@@ -184,6 +204,9 @@ namespace pcl
 
       /** \brief Radius to compute local RF. */
       double local_radius_{2.0};
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_{1};
   };
 }
 
@@ -76,9 +76,9 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilterIndices (Indices &indices)
   const int mean_k = min_pts_radius_ + 1;
   const double nn_dists_max = search_radius_ * search_radius_;
 
-  // The arrays to be used
-  Indices nn_indices (mean_k);
-  std::vector<float> nn_dists(mean_k);
+  // The search buffers, copied into every thread
+  SearchContext context;
+  context.resize (mean_k);
   // Set to keep all points and in the filtering set those we don't want to keep, assuming
   // we want to keep the majority of the points.
   // 0 = remove, 1 = keep
@@ -92,23 +92,23 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilterIndices (Indices &indices)
   {
     #pragma omp parallel for \
     schedule(dynamic,64) \
-    firstprivate(nn_indices, nn_dists)                                                 \
+    firstprivate(context) \
     shared(to_keep) \
     num_threads(num_threads_)
     for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(indices_->size()); i++)
     {
       const auto& index = (*indices_)[i];
       // Perform the nearest-k search
-      const int k = searcher_->nearestKSearch (index, mean_k, nn_indices, nn_dists);
+      const int k = searcher_->nearestKSearch (index, mean_k, context);
 
       // Check the number of neighbors
-      // Note: nn_dists is sorted, so check the last item
+      // Note: the distances are sorted, so check the last item
       if (k == mean_k)
       {
           // if negative_ is false and a neighbor is further away than max distance, remove the point
           // or
           // if negative is true and a neighbor is closer than max distance, remove the point
-          if ((!negative_ && nn_dists_max < nn_dists[k-1]) || (negative_ && nn_dists_max >= nn_dists[k - 1]))
+          if ((!negative_ && nn_dists_max < context.sqr_distances[k - 1]) || (negative_ && nn_dists_max >= context.sqr_distances[k - 1]))
           {
             to_keep[i] = 0;
             continue;
@@ -130,7 +130,7 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilterIndices (Indices &indices)
   {
     #pragma omp parallel for \
     schedule(dynamic, 64) \
-    firstprivate(nn_indices, nn_dists) \
+    firstprivate(context) \
     shared(to_keep) \
     num_threads(num_threads_)
     for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(indices_->size()); i++)
@@ -145,7 +145,7 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilterIndices (Indices &indices)
       // Perform the radius search
       // Note: k includes the query point, so is always at least 1
       // last parameter (max_nn) is the maximum number of neighbors returned. If enough neighbors are found so that point can not be an outlier, we stop searching.
-      const int k = searcher_->radiusSearch (index, search_radius_, nn_indices, nn_dists, min_pts_radius_ + 1);
+      const int k = searcher_->radiusSearch (index, search_radius_, context, min_pts_radius_ + 1);
 
       // Points having too few neighbors are removed
       // or if negative_ is true, then if it has too many neighbors
@@ -0,0 +1,186 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_FILTERS_IMPL_STREAMING_VOXEL_GRID_H_
+#define PCL_FILTERS_IMPL_STREAMING_VOXEL_GRID_H_
+
+#include <pcl/common/point_tests.h> // for isXYZFinite
+#include <pcl/filters/streaming_voxel_grid.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::reserve (std::size_t nr_voxels)
+{
+  leaves_.reserve (nr_voxels);
+  if (downsample_all_data_)
+    centroids_.reserve (nr_voxels);
+
+  // Keep the load factor of the table at or below 0.5
+  std::size_t nr_slots = 16;
+  while (nr_slots < 2 * nr_voxels)
+    nr_slots *= 2;
+  if (nr_slots > table_.size ())
+    rehash (nr_slots);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::clear ()
+{
+  leaves_.clear ();
+  centroids_.clear ();
+  std::fill (table_.begin (), table_.end (), empty_slot_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::rehash (std::size_t nr_slots)
+{
+  table_.assign (nr_slots, empty_slot_);
+  for (std::size_t i = 0; i < leaves_.size (); ++i)
+  {
+    std::size_t slot = hash (leaves_[i].ijk);
+    while (table_[slot] != empty_slot_)
+      slot = (slot + 1) & (nr_slots - 1);
+    table_[slot] = static_cast<std::uint32_t> (i);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> std::size_t
+pcl::StreamingVoxelGrid<PointT>::findOrInsertLeaf (const Eigen::Vector3i &ijk)
+{
+  // Grow the table before it gets more than half full, to keep the probe sequences short
+  if (2 * (leaves_.size () + 1) > table_.size ())
+    rehash (std::max<std::size_t> (16, 2 * table_.size ()));
+
+  const std::size_t mask = table_.size () - 1;
+  std::size_t slot = hash (ijk);
+  while (table_[slot] != empty_slot_)
+  {
+    if (leaves_[table_[slot]].ijk == ijk)
+      return (table_[slot]);
+    slot = (slot + 1) & mask;
+  }
+
+  table_[slot] = static_cast<std::uint32_t> (leaves_.size ());
+  leaves_.emplace_back (ijk);
+  if (downsample_all_data_)
+    centroids_.emplace_back ();
+  return (leaves_.size () - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::addPoint (const PointT &point)
+{
+  if (!isXYZFinite (point))
+    return;
+
+  const Eigen::Vector3i ijk (static_cast<int> (std::floor (point.x * inverse_leaf_size_[0])),
+                             static_cast<int> (std::floor (point.y * inverse_leaf_size_[1])),
+                             static_cast<int> (std::floor (point.z * inverse_leaf_size_[2])));
+  const std::size_t leaf_idx = findOrInsertLeaf (ijk);
+
+  Leaf &leaf = leaves_[leaf_idx];
+  ++leaf.nr_points;
+  leaf.xyz += point.getVector3fMap ();
+  if (downsample_all_data_)
+    centroids_[leaf_idx].add (point);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::addPointCloud (const PointCloud &cloud)
+{
+  for (const auto &point : cloud)
+    addPoint (point);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::addPointCloud (const PointCloud &cloud, const Indices &indices)
+{
+  for (const auto &index : indices)
+    addPoint (cloud[index]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::getCentroids (PointCloud &output) const
+{
+  output.clear ();
+  output.reserve (leaves_.size ());
+  for (std::size_t i = 0; i < leaves_.size (); ++i)
+  {
+    const Leaf &leaf = leaves_[i];
+    if (leaf.nr_points < min_points_per_voxel_)
+      continue;
+
+    PointT centroid;
+    if (downsample_all_data_)
+      centroids_[i].get (centroid);
+    else
+      centroid.getVector3fMap () = leaf.xyz / static_cast<float> (leaf.nr_points);
+    output.push_back (centroid);
+  }
+  output.width = output.size ();
+  output.height = 1;                    // downsampling breaks the organized structure
+  output.is_dense = true;               // we filter out invalid points
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::StreamingVoxelGrid<PointT>::applyFilter (PointCloud &output)
+{
+  // Has the input dataset been set already?
+  if (!input_)
+  {
+    PCL_WARN ("[pcl::%s::applyFilter] No input dataset given!\n", getClassName ().c_str ());
+    output.width = output.height = 0;
+    output.clear ();
+    return;
+  }
+
+  clear ();
+  addPointCloud (*input_, *indices_);
+  getCentroids (output);
+}
+
+#define PCL_INSTANTIATE_StreamingVoxelGrid(T) template class PCL_EXPORTS pcl::StreamingVoxelGrid<T>;
+
+#endif    // PCL_FILTERS_IMPL_STREAMING_VOXEL_GRID_H_
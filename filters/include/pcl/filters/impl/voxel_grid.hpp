@@ -44,7 +44,6 @@
 #include <pcl/common/common.h>
 #include <pcl/common/io.h>
 #include <pcl/filters/voxel_grid.h>
-#include  <boost/sort/spreadsort/integer_sort.hpp>
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -211,6 +210,23 @@ pcl::getMinMax3D (const typename pcl::PointCloud<PointT>::ConstPtr &cloud,
   max_pt = max_p;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGrid<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    num_threads_ = omp_get_num_procs ();
+  else
+    num_threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::VoxelGrid::setNumberOfThreads] Setting number of threads to %u.\n", num_threads_);
+#else
+  num_threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::VoxelGrid::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
@@ -264,9 +280,9 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
 
   // Storage for mapping leaf and pointcloud indexes
   std::vector<internal::cloud_point_index_idx> index_vector;
-  index_vector.reserve (indices_->size ());
 
   // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  std::size_t field_offset = 0;
   if (!filter_field_name_.empty ())
   {
     // Get the distance field index
@@ -276,18 +292,20 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
       PCL_ERROR ("[pcl::%s::applyFilter] Invalid filter field name (%s).\n", getClassName ().c_str (), filter_field_name_.c_str());
       return;
     }
-    const auto field_offset = fields[distance_idx].offset;
+    field_offset = fields[distance_idx].offset;
+  }
 
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (const auto& index : (*indices_))
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!isXYZFinite ((*input_)[index]))
-          continue;
+  // Compute the centroid leaf index of a point, returns false if the point is invalid
+  // or lies outside of the filter limits
+  auto computeLeafIndex = [this, field_offset] (const index_t index, unsigned int &idx)
+  {
+    if (!input_->is_dense)
+      // Check if the point is invalid
+      if (!isXYZFinite ((*input_)[index]))
+        return (false);
 
+    if (!filter_field_name_.empty ())
+    {
       // Get the distance value
       const auto* pt_data = reinterpret_cast<const std::uint8_t*> (&(*input_)[index]);
       float distance_value = 0;
@@ -297,52 +315,79 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
       {
         // Use a threshold for cutting out points which inside the interval
         if ((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_))
-          continue;
+          return (false);
       }
       else
       {
         // Use a threshold for cutting out points which are too close/far away
         if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
-          continue;
+          return (false);
       }
-      
-      int ijk0 = static_cast<int> (std::floor ((*input_)[index].x * inverse_leaf_size_[0]) - static_cast<float> (min_b_[0]));
-      int ijk1 = static_cast<int> (std::floor ((*input_)[index].y * inverse_leaf_size_[1]) - static_cast<float> (min_b_[1]));
-      int ijk2 = static_cast<int> (std::floor ((*input_)[index].z * inverse_leaf_size_[2]) - static_cast<float> (min_b_[2]));
-
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.emplace_back(static_cast<unsigned int> (idx), index);
+    }
+
+    int ijk0 = static_cast<int> (std::floor ((*input_)[index].x * inverse_leaf_size_[0]) - static_cast<float> (min_b_[0]));
+    int ijk1 = static_cast<int> (std::floor ((*input_)[index].y * inverse_leaf_size_[1]) - static_cast<float> (min_b_[1]));
+    int ijk2 = static_cast<int> (std::floor ((*input_)[index].z * inverse_leaf_size_[2]) - static_cast<float> (min_b_[2]));
+
+    // Compute the centroid leaf index
+    idx = static_cast<unsigned int> (ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2]);
+    return (true);
+  };
+
+  // First pass: go over all points and insert them into the index_vector vector
+  // with calculated idx. Points with the same idx value will contribute to the
+  // same point of resulting CloudPoint
+  if (num_threads_ <= 1)
+  {
+    index_vector.reserve (indices_->size ());
+    for (const auto& index : (*indices_))
+    {
+      unsigned int idx;
+      if (computeLeafIndex (index, idx))
+        index_vector.emplace_back (idx, index);
     }
   }
-  // No distance filtering, process all data
   else
   {
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (const auto& index : (*indices_))
+    // Every thread processes one contiguous block of indices, the blocks are then
+    // concatenated in order so that index_vector is the same as in the serial case
+    std::vector<std::vector<internal::cloud_point_index_idx> > per_thread_index_vector (num_threads_);
+    std::size_t block_size = (indices_->size () + num_threads_ - 1) / num_threads_;
+#pragma omp parallel for \
+  default(none) \
+  shared(per_thread_index_vector, block_size, computeLeafIndex) \
+  num_threads(num_threads_) \
+  schedule(static, 1)
+    for (int thread = 0; thread < static_cast<int> (num_threads_); ++thread)
     {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!isXYZFinite ((*input_)[index]))
-          continue;
-
-      int ijk0 = static_cast<int> (std::floor ((*input_)[index].x * inverse_leaf_size_[0]) - static_cast<float> (min_b_[0]));
-      int ijk1 = static_cast<int> (std::floor ((*input_)[index].y * inverse_leaf_size_[1]) - static_cast<float> (min_b_[1]));
-      int ijk2 = static_cast<int> (std::floor ((*input_)[index].z * inverse_leaf_size_[2]) - static_cast<float> (min_b_[2]));
-
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.emplace_back(static_cast<unsigned int> (idx), index);
+      auto &local_index_vector = per_thread_index_vector[thread];
+      const std::size_t begin = std::min (indices_->size (), thread * block_size);
+      const std::size_t end = std::min (indices_->size (), begin + block_size);
+      local_index_vector.reserve (end - begin);
+      for (std::size_t i = begin; i < end; ++i)
+      {
+        unsigned int idx;
+        if (computeLeafIndex ((*indices_)[i], idx))
+          local_index_vector.emplace_back (idx, (*indices_)[i]);
+      }
     }
+
+    std::size_t nr_valid = 0;
+    for (const auto &local_index_vector : per_thread_index_vector)
+      nr_valid += local_index_vector.size ();
+    index_vector.reserve (nr_valid);
+    for (const auto &local_index_vector : per_thread_index_vector)
+      index_vector.insert (index_vector.end (), local_index_vector.begin (), local_index_vector.end ());
   }
 
   // Second pass: sort the index_vector vector using value representing target cell as index
-  // in effect all points belonging to the same output cell will be next to each other
-  auto rightshift_func = [](const internal::cloud_point_index_idx &x, const unsigned offset) { return x.idx >> offset; };
-  boost::sort::spreadsort::integer_sort(index_vector.begin(), index_vector.end(), rightshift_func);
-  
+  // in effect all points belonging to the same output cell will be next to each other.
+  // The sort is stable, so the points of a cell are accumulated in input order
+  const std::uint64_t nr_leaves = static_cast<std::uint64_t> (div_b_[0]) * div_b_[1] * div_b_[2];
+  internal::sortByLeafIndex (index_vector,
+                             static_cast<unsigned int> (std::min<std::uint64_t> (nr_leaves - 1, std::numeric_limits<unsigned int>::max ())),
+                             num_threads_);
+
   // Third pass: count output cells
   // we need to skip all the same, adjacent idx values
   unsigned int total = 0;
@@ -394,16 +439,19 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
     }
   }
   
-  index = 0;
-  for (const auto &cp : first_and_last_indices_vector)
+#pragma omp parallel for \
+  default(none) \
+  shared(output, index_vector, first_and_last_indices_vector) \
+  num_threads(num_threads_)
+  for (std::ptrdiff_t cp = 0; cp < static_cast<std::ptrdiff_t> (first_and_last_indices_vector.size ()); ++cp)
   {
     // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
-  	unsigned int first_index = cp.first;
-  	unsigned int last_index = cp.second;
+    const unsigned int first_index = first_and_last_indices_vector[cp].first;
+    const unsigned int last_index = first_and_last_indices_vector[cp].second;
 
-    // index is centroid final position in resulting PointCloud
+    // cp is centroid final position in resulting PointCloud
     if (save_leaf_layout_)
-      leaf_layout_[index_vector[first_index].idx] = index;
+      leaf_layout_[index_vector[first_index].idx] = static_cast<int> (cp);
 
     //Limit downsampling to coords
     if (!downsample_all_data_)
@@ -414,7 +462,7 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         centroid += (*input_)[index_vector[li].cloud_point_index].getVector4fMap ();
 
       centroid /= static_cast<float> (last_index - first_index);
-      output[index].getVector4fMap () = centroid;
+      output[cp].getVector4fMap () = centroid;
     }
     else
     {
@@ -424,10 +472,8 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
       for (unsigned int li = first_index; li < last_index; ++li)
         centroid.add ((*input_)[index_vector[li].cloud_point_index]);  
 
-      centroid.get (output[index]);
+      centroid.get (output[cp]);
     }
-     
-    ++index;
   }
   output.width = output.size ();
 }
@@ -53,6 +53,7 @@ template<typename PointT> void
 pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
 {
   voxel_centroids_leaf_indices_.clear ();
+  valid_leaves_.clear ();
 
   // Has the input dataset been set already?
   if (!input_)
@@ -363,9 +364,30 @@ pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
     }
   }
 
+  // Hash the usable leaves by their index for the neighborhood lookups
+  indexValidLeaves ();
+
   output.width = output.size ();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::indexValidLeaves ()
+{
+  valid_leaves_.clear ();
+  valid_leaves_.reserve (leaves_.size ());
+  for (auto &leaf : leaves_)
+  {
+    if (leaf.second.nr_points >= min_points_per_voxel_)
+    {
+      leaf.second.valid_index_ = static_cast<int> (valid_leaves_.size ());
+      valid_leaves_.emplace (leaf.first, &leaf.second);
+    }
+    else
+      leaf.second.valid_index_ = -1;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const Eigen::Matrix<int, 3, Eigen::Dynamic>& relative_coordinates, const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
@@ -386,12 +408,9 @@ pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const Eigen::Matrix<in
     // Checking if the specified cell is in the grid
     if ((diff2min <= displacement.array ()).all () && (diff2max >= displacement.array ()).all ())
     {
-      const auto leaf_iter = leaves_.find (((ijk + displacement - min_b_).dot (divb_mul_)));
-      if (leaf_iter != leaves_.end () && leaf_iter->second.nr_points >= min_points_per_voxel_)
-      {
-        LeafConstPtr leaf = &(leaf_iter->second);
-        neighbors.push_back (leaf);
-      }
+      const auto leaf_iter = valid_leaves_.find (static_cast<std::size_t> ((ijk + displacement - min_b_).dot (divb_mul_)));
+      if (leaf_iter != valid_leaves_.end ())
+        neighbors.push_back (leaf_iter->second);
     }
   }
 
@@ -402,7 +421,7 @@ pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const Eigen::Matrix<in
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
 {
-  Eigen::MatrixXi relative_coordinates = pcl::getAllNeighborCellIndices();
+  static const Eigen::Matrix<int, 3, Eigen::Dynamic> relative_coordinates = pcl::getAllNeighborCellIndices();
   return getNeighborhoodAtPoint(relative_coordinates, reference_point, neighbors);
 }
 
@@ -410,21 +429,26 @@ pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const PointT& referenc
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getVoxelAtPoint(const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
 {
-  return getNeighborhoodAtPoint(Eigen::Matrix<int, 3, Eigen::Dynamic>::Zero(3,1), reference_point, neighbors);
+  static const Eigen::Matrix<int, 3, Eigen::Dynamic> relative_coordinates = Eigen::Matrix<int, 3, Eigen::Dynamic>::Zero(3,1);
+  return getNeighborhoodAtPoint(relative_coordinates, reference_point, neighbors);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getFaceNeighborsAtPoint(const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
 {
-  Eigen::Matrix<int, 3, Eigen::Dynamic> relative_coordinates(3, 7);
-  relative_coordinates.setZero();
-  relative_coordinates(0, 1) = 1;
-  relative_coordinates(0, 2) = -1;
-  relative_coordinates(1, 3) = 1;
-  relative_coordinates(1, 4) = -1;
-  relative_coordinates(2, 5) = 1;
-  relative_coordinates(2, 6) = -1;
+  static const Eigen::Matrix<int, 3, Eigen::Dynamic> relative_coordinates = []
+  {
+    Eigen::Matrix<int, 3, Eigen::Dynamic> coordinates(3, 7);
+    coordinates.setZero();
+    coordinates(0, 1) = 1;
+    coordinates(0, 2) = -1;
+    coordinates(1, 3) = 1;
+    coordinates(1, 4) = -1;
+    coordinates(2, 5) = 1;
+    coordinates(2, 6) = -1;
+    return coordinates;
+  } ();
 
   return getNeighborhoodAtPoint(relative_coordinates, reference_point, neighbors);
 }
@@ -433,9 +457,13 @@ pcl::VoxelGridCovariance<PointT>::getFaceNeighborsAtPoint(const PointT& referenc
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getAllNeighborsAtPoint(const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
 {
-  Eigen::Matrix<int, 3, Eigen::Dynamic> relative_coordinates(3, 27);
-  relative_coordinates.col(0).setZero();
-  relative_coordinates.rightCols(26) = pcl::getAllNeighborCellIndices();
+  static const Eigen::Matrix<int, 3, Eigen::Dynamic> relative_coordinates = []
+  {
+    Eigen::Matrix<int, 3, Eigen::Dynamic> coordinates(3, 27);
+    coordinates.col(0).setZero();
+    coordinates.rightCols(26) = pcl::getAllNeighborCellIndices();
+    return coordinates;
+  } ();
 
   return getNeighborhoodAtPoint(relative_coordinates, reference_point, neighbors);
 }
@@ -0,0 +1,268 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/common/centroid.h> // for CentroidPoint
+#include <pcl/filters/filter.h>
+
+#include <limits>
+
+namespace pcl
+{
+  /** \brief StreamingVoxelGrid downsamples point clouds with a voxelized grid, like
+    * \ref VoxelGrid, but accumulates the points in a hash table keyed by the voxel
+    * coordinates instead of sorting the whole cloud.
+    *
+    * Every voxel stores the running sums of its points (in a \ref CentroidPoint if all
+    * fields are downsampled), so memory is proportional to the number of occupied
+    * voxels and not to the number of input points. Points can be added in several
+    * chunks with \ref addPointCloud, for example once per scan coming from a grabber,
+    * before retrieving the centroids with \ref getCentroids:
+    *
+    * \code
+    * pcl::StreamingVoxelGrid<pcl::PointXYZI> grid;
+    * grid.setLeafSize (0.1f, 0.1f, 0.1f);
+    * // for every scan
+    * grid.addPointCloud (*scan);
+    * // once the whole sweep has been added
+    * pcl::PointCloud<pcl::PointXYZI> downsampled;
+    * grid.getCentroids (downsampled);
+    * grid.clear ();
+    * \endcode
+    *
+    * Calling \ref filter on an input cloud produces the same centroids as \ref VoxelGrid
+    * without any distance field filtering, but ordered by the first point falling into
+    * each voxel instead of by voxel index.
+    *
+    * \sa VoxelGrid, ApproximateVoxelGrid
+    * \ingroup filters
+    */
+  template <typename PointT>
+  class StreamingVoxelGrid: public Filter<PointT>
+  {
+    protected:
+      using Filter<PointT>::filter_name_;
+      using Filter<PointT>::getClassName;
+      using Filter<PointT>::input_;
+      using Filter<PointT>::indices_;
+
+      using PointCloud = typename Filter<PointT>::PointCloud;
+      using PointCloudPtr = typename PointCloud::Ptr;
+      using PointCloudConstPtr = typename PointCloud::ConstPtr;
+
+    public:
+
+      using Ptr = shared_ptr<StreamingVoxelGrid<PointT> >;
+      using ConstPtr = shared_ptr<const StreamingVoxelGrid<PointT> >;
+
+      /** \brief Empty constructor. */
+      StreamingVoxelGrid () :
+        leaf_size_ (Eigen::Vector3f::Zero ()),
+        inverse_leaf_size_ (Eigen::Array3f::Zero ())
+      {
+        filter_name_ = "StreamingVoxelGrid";
+      }
+
+      /** \brief Destructor. */
+      ~StreamingVoxelGrid () override = default;
+
+      /** \brief Set the voxel grid leaf size. This discards the points accumulated so far.
+        * \param[in] leaf_size the voxel grid leaf size
+        */
+      inline void
+      setLeafSize (const Eigen::Vector3f &leaf_size)
+      {
+        leaf_size_ = leaf_size;
+        inverse_leaf_size_ = Eigen::Array3f::Ones () / leaf_size_.array ();
+        clear ();
+      }
+
+      /** \brief Set the voxel grid leaf size. This discards the points accumulated so far.
+        * \param[in] lx the leaf size for X
+        * \param[in] ly the leaf size for Y
+        * \param[in] lz the leaf size for Z
+        */
+      inline void
+      setLeafSize (float lx, float ly, float lz)
+      {
+        setLeafSize (Eigen::Vector3f (lx, ly, lz));
+      }
+
+      /** \brief Get the voxel grid leaf size. */
+      inline Eigen::Vector3f
+      getLeafSize () const { return (leaf_size_); }
+
+      /** \brief Set to true if all fields need to be downsampled, or false if just XYZ.
+        * This discards the points accumulated so far.
+        * \param[in] downsample the new value (true/false)
+        */
+      inline void
+      setDownsampleAllData (bool downsample)
+      {
+        downsample_all_data_ = downsample;
+        clear ();
+      }
+
+      /** \brief Get the state of the internal downsampling parameter (true if
+        * all fields need to be downsampled, false if just XYZ).
+        */
+      inline bool
+      getDownsampleAllData () const { return (downsample_all_data_); }
+
+      /** \brief Set the minimum number of points required for a voxel to be used.
+        * \param[in] min_points_per_voxel the minimum number of points for required for a voxel to be used
+        */
+      inline void
+      setMinimumPointsNumberPerVoxel (unsigned int min_points_per_voxel) { min_points_per_voxel_ = min_points_per_voxel; }
+
+      /** \brief Return the minimum number of points required for a voxel to be used. */
+      inline unsigned int
+      getMinimumPointsNumberPerVoxel () const { return (min_points_per_voxel_); }
+
+      /** \brief Reserve memory for the given number of occupied voxels. */
+      void
+      reserve (std::size_t nr_voxels);
+
+      /** \brief Add a single point to the voxel grid. Points with non finite
+        * coordinates are ignored.
+        * \param[in] point the point to add
+        */
+      void
+      addPoint (const PointT &point);
+
+      /** \brief Add all points of a cloud to the voxel grid.
+        * \param[in] cloud the cloud (or chunk of a cloud) to add
+        */
+      void
+      addPointCloud (const PointCloud &cloud);
+
+      /** \brief Add a subset of the points of a cloud to the voxel grid.
+        * \param[in] cloud the cloud (or chunk of a cloud) to add
+        * \param[in] indices the indices of the points to add
+        */
+      void
+      addPointCloud (const PointCloud &cloud, const Indices &indices);
+
+      /** \brief Get the centroids of all voxels with at least
+        * \ref getMinimumPointsNumberPerVoxel points accumulated so far.
+        * \param[out] output the downsampled cloud, ordered by the first point added to each voxel
+        */
+      void
+      getCentroids (PointCloud &output) const;
+
+      /** \brief Get the number of occupied voxels. */
+      inline std::size_t
+      getNumberOfVoxels () const { return (leaves_.size ()); }
+
+      /** \brief Discard all accumulated points, keeping the allocated memory. */
+      void
+      clear ();
+
+    protected:
+      /** \brief The accumulated data of an occupied voxel. */
+      struct Leaf
+      {
+        Leaf (const Eigen::Vector3i &ijk_) : ijk (ijk_) {}
+
+        /** \brief The integer coordinates of the voxel. */
+        Eigen::Vector3i ijk;
+
+        /** \brief The number of points in the voxel. */
+        unsigned int nr_points{0};
+
+        /** \brief The sum of the XYZ coordinates of the points in the voxel. */
+        Eigen::Vector3f xyz{Eigen::Vector3f::Zero ()};
+      };
+
+      /** \brief Find the leaf with the given coordinates, inserting it if it does not exist yet.
+        * \return the index of the leaf in \a leaves_
+        */
+      std::size_t
+      findOrInsertLeaf (const Eigen::Vector3i &ijk);
+
+      /** \brief Rebuild the hash table with the given number of slots (a power of two). */
+      void
+      rehash (std::size_t nr_slots);
+
+      /** \brief Hash the voxel coordinates into a slot of the table. */
+      inline std::size_t
+      hash (const Eigen::Vector3i &ijk) const
+      {
+        const std::uint64_t key = (static_cast<std::uint64_t> (static_cast<std::uint32_t> (ijk[0])) * 73856093u) ^
+                                  (static_cast<std::uint64_t> (static_cast<std::uint32_t> (ijk[1])) * 19349669u) ^
+                                  (static_cast<std::uint64_t> (static_cast<std::uint32_t> (ijk[2])) * 83492791u);
+        // Fibonacci hashing spreads the key over the whole table
+        return (static_cast<std::size_t> ((key * 0x9E3779B97F4A7C15ull) >> 32) & (table_.size () - 1));
+      }
+
+      /** \brief Downsample a Point Cloud using a hashed voxel grid. This discards
+        * the points accumulated so far.
+        * \param[out] output the resultant point cloud
+        */
+      void
+      applyFilter (PointCloud &output) override;
+
+      /** \brief The size of a leaf. */
+      Eigen::Vector3f leaf_size_;
+
+      /** \brief Internal leaf sizes stored as 1/leaf_size_ for efficiency reasons. */
+      Eigen::Array3f inverse_leaf_size_;
+
+      /** \brief Set to true if all fields need to be downsampled, or false if just XYZ. */
+      bool downsample_all_data_{true};
+
+      /** \brief Minimum number of points per voxel for the centroid to be computed */
+      unsigned int min_points_per_voxel_{0};
+
+      /** \brief The occupied voxels, in the order they were first encountered. */
+      std::vector<Leaf> leaves_;
+
+      /** \brief The centroid accumulators of the occupied voxels, only used if all fields are downsampled. */
+      std::vector<CentroidPoint<PointT>, Eigen::aligned_allocator<CentroidPoint<PointT> > > centroids_;
+
+      /** \brief Open addressing hash table with linear probing, holding indices into \a leaves_. */
+      std::vector<std::uint32_t> table_;
+
+      /** \brief Marker of an empty slot in \a table_. */
+      static constexpr std::uint32_t empty_slot_ = std::numeric_limits<std::uint32_t>::max ();
+  };
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/filters/impl/streaming_voxel_grid.hpp>
+#endif
@@ -307,6 +307,17 @@ namespace pcl
       inline bool
       getSaveLeafLayout () const { return (save_leaf_layout_); }
 
+      /** \brief Set the number of threads to use for computing the leaf indices, sorting
+        * them and computing the centroids. The result does not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used by the filter. */
+      inline unsigned int
+      getNumberOfThreads () const { return (num_threads_); }
+
       /** \brief Get the minimum coordinates of the bounding box (after
         * filtering is performed).
         */
@@ -512,6 +523,9 @@ namespace pcl
       /** \brief Minimum number of points per voxel for the centroid to be computed */
       unsigned int min_points_per_voxel_{0};
 
+      /** \brief The number of threads the filter should use. */
+      unsigned int num_threads_{1};
+
       using FieldList = typename pcl::traits::fieldList<PointT>::type;
 
       /** \brief Downsample a Point Cloud using a voxelized grid approach
@@ -880,6 +894,18 @@ namespace pcl
       cloud_point_index_idx (unsigned int idx_, unsigned int cloud_point_index_) : idx (idx_), cloud_point_index (cloud_point_index_) {}
       bool operator < (const cloud_point_index_idx &p) const { return (idx < p.idx); }
     };
+
+    /** \brief Sort leaf/point index pairs by their leaf index with a stable LSD radix sort.
+      * \details Each pass histograms contiguous blocks of the vector in parallel and
+      * scatters them to their final position, so points belonging to the same leaf
+      * keep their input order regardless of the number of threads.
+      * \param[in,out] index_vector the pairs to sort
+      * \param[in] max_idx an upper bound for the leaf indices, used to skip empty passes
+      * \param[in] nr_threads the number of threads to use
+      */
+    PCL_EXPORTS void
+    sortByLeafIndex (std::vector<cloud_point_index_idx> &index_vector, unsigned int max_idx,
+                     unsigned int nr_threads = 1);
   }
 }
 
@@ -39,6 +39,7 @@
 
 #include <pcl/filters/voxel_grid.h>
 #include <map>
+#include <unordered_map>
 #include <pcl/point_types.h>
 #include <pcl/kdtree/kdtree_flann.h>
 
@@ -181,6 +182,11 @@ namespace pcl
         /** \brief Eigen values of voxel covariance matrix */
         Eigen::Vector3d evals_;
 
+        /** \brief Position of the voxel among the voxels containing a sufficient number of
+          * points, in the order of \ref leaves_ (-1 if it contains too few points)
+          */
+        int valid_index_{-1};
+
       };
 
       /** \brief Pointer to VoxelGridCovariance leaf structure */
@@ -207,6 +213,51 @@ namespace pcl
         filter_name_ = "VoxelGridCovariance";
       }
 
+      /** \brief Copy constructor. The hash map of the usable leaves points into
+        * \ref leaves_, so it is rebuilt for the copied leaves.
+        */
+      VoxelGridCovariance (const VoxelGridCovariance &src) :
+        VoxelGrid<PointT> (src),
+        searchable_ (src.searchable_),
+        min_points_per_voxel_ (src.min_points_per_voxel_),
+        min_covar_eigvalue_mult_ (src.min_covar_eigvalue_mult_),
+        leaves_ (src.leaves_),
+        voxel_centroids_ (src.voxel_centroids_),
+        voxel_centroids_leaf_indices_ (src.voxel_centroids_leaf_indices_),
+        kdtree_ (src.kdtree_)
+      {
+        indexValidLeaves ();
+      }
+
+      /** \brief Copy assignment operator. The hash map of the usable leaves is rebuilt
+        * for the copied leaves.
+        */
+      VoxelGridCovariance&
+      operator= (const VoxelGridCovariance &src)
+      {
+        if (this == &src)
+          return (*this);
+        VoxelGrid<PointT>::operator= (src);
+        searchable_ = src.searchable_;
+        min_points_per_voxel_ = src.min_points_per_voxel_;
+        min_covar_eigvalue_mult_ = src.min_covar_eigvalue_mult_;
+        leaves_ = src.leaves_;
+        voxel_centroids_ = src.voxel_centroids_;
+        voxel_centroids_leaf_indices_ = src.voxel_centroids_leaf_indices_;
+        kdtree_ = src.kdtree_;
+        indexValidLeaves ();
+        return (*this);
+      }
+
+      /** \brief Move constructor. Moving \ref leaves_ keeps its nodes, so the hash map of
+        * the usable leaves stays valid.
+        */
+      VoxelGridCovariance (VoxelGridCovariance &&) = default;
+
+      /** \brief Move assignment operator. */
+      VoxelGridCovariance&
+      operator= (VoxelGridCovariance &&) = default;
+
       /** \brief Set the minimum number of points required for a cell to be used (must be 3 or greater for covariance calculation).
         * \param[in] min_points_per_voxel the minimum number of points for required for a voxel to be used
         */
@@ -368,6 +419,9 @@ namespace pcl
 
       /** \brief Get the voxels surrounding point p designated by \p relative_coordinates.
        * \note Only voxels containing a sufficient number of points are used.
+       * \note The voxels are looked up in a hash map, so the cost does not depend on the
+       * number of voxels. This is an alternative to \ref radiusSearch which does not
+       * need the kd-tree of the voxel centroids.
        * \param[in] relative_coordinates 3xN matrix that represents relative coordinates of N neighboring voxels with respect to the center voxel
        * \param[in] reference_point the point to get the leaf structure at
        * \param[out] neighbors
@@ -564,6 +618,12 @@ namespace pcl
        */
       void applyFilter (PointCloud &output) override;
 
+      /** \brief Rebuild \ref valid_leaves_ from the voxels in \ref leaves_ which contain a
+        * sufficient number of points, and number them in Leaf::valid_index_.
+        */
+      void
+      indexValidLeaves ();
+
       /** \brief Flag to determine if voxel structure is searchable. */
       bool searchable_{true};
 
@@ -582,6 +642,9 @@ namespace pcl
       /** \brief Indices of leaf structures associated with each point in \ref voxel_centroids_ (used for searching). */
       std::vector<int> voxel_centroids_leaf_indices_;
 
+      /** \brief Voxels containing a sufficient number of points, hashed by leaf index (used for the neighborhood lookups). */
+      std::unordered_map<std::size_t, LeafConstPtr> valid_leaves_;
+
       /** \brief KdTree generated using \ref voxel_centroids_ (used for searching). */
       KdTreeFLANN<PointT> kdtree_;
   };
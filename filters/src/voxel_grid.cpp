@@ -347,6 +347,76 @@ pcl::getMinMax3D (const pcl::PCLPointCloud2ConstPtr &cloud, const pcl::Indices &
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::internal::sortByLeafIndex (std::vector<cloud_point_index_idx> &index_vector, unsigned int max_idx,
+                                unsigned int nr_threads)
+{
+  constexpr unsigned int radix_bits = 11;
+  constexpr std::size_t radix_size = std::size_t (1) << radix_bits;
+  constexpr unsigned int radix_mask = radix_size - 1;
+
+  std::size_t nr_points = index_vector.size ();
+  if (nr_points < 2)
+    return;
+  nr_threads = std::max (1u, nr_threads);
+
+  // Only the bits that can be set in a leaf index need to be sorted
+  unsigned int nr_bits = 0;
+  while (nr_bits < 32 && (max_idx >> nr_bits) != 0)
+    ++nr_bits;
+
+  std::vector<cloud_point_index_idx> buffer (nr_points);
+  // histograms[thread * radix_size + digit] counts, and later offsets, the digits of each block
+  std::vector<std::size_t> histograms (nr_threads * radix_size);
+  std::size_t block_size = (nr_points + nr_threads - 1) / nr_threads;
+
+  for (unsigned int shift = 0; shift < nr_bits; shift += radix_bits)
+  {
+    std::fill (histograms.begin (), histograms.end (), 0);
+
+#pragma omp parallel for \
+  default(none) \
+  shared(index_vector, histograms, block_size, nr_points, nr_threads, shift) \
+  num_threads(nr_threads) \
+  schedule(static, 1)
+    for (int thread = 0; thread < static_cast<int> (nr_threads); ++thread)
+    {
+      std::size_t* histogram = &histograms[thread * radix_size];
+      const std::size_t end = std::min (nr_points, (thread + 1) * block_size);
+      for (std::size_t i = thread * block_size; i < end; ++i)
+        ++histogram[(index_vector[i].idx >> shift) & radix_mask];
+    }
+
+    // Turn the counts into output offsets, ordered by digit first and block second to keep the sort stable
+    std::size_t offset = 0;
+    for (std::size_t digit = 0; digit < radix_size; ++digit)
+    {
+      for (std::size_t thread = 0; thread < nr_threads; ++thread)
+      {
+        const std::size_t count = histograms[thread * radix_size + digit];
+        histograms[thread * radix_size + digit] = offset;
+        offset += count;
+      }
+    }
+
+#pragma omp parallel for \
+  default(none) \
+  shared(index_vector, buffer, histograms, block_size, nr_points, nr_threads, shift) \
+  num_threads(nr_threads) \
+  schedule(static, 1)
+    for (int thread = 0; thread < static_cast<int> (nr_threads); ++thread)
+    {
+      std::size_t* offsets = &histograms[thread * radix_size];
+      const std::size_t end = std::min (nr_points, (thread + 1) * block_size);
+      for (std::size_t i = thread * block_size; i < end; ++i)
+        buffer[offsets[(index_vector[i].idx >> shift) & radix_mask]++] = index_vector[i];
+    }
+
+    index_vector.swap (buffer);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl::VoxelGrid<pcl::PCLPointCloud2>::applyFilter (PCLPointCloud2 &output)
@@ -0,0 +1,245 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_IO_PCD_MAPPED_CLOUD_IMPL_H_
+#define PCL_IO_PCD_MAPPED_CLOUD_IMPL_H_
+
+#include <pcl/io/pcd_mapped_cloud.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/console/print.h>
+#include <pcl/conversions.h> // for createMapping, fromPCLPointCloud2
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace pcl
+{
+  namespace detail
+  {
+    // Checks that every field of PointT is serialized at its struct offset.
+    template <typename PointT>
+    struct FieldLayoutMatcher
+    {
+      FieldLayoutMatcher (const std::vector<pcl::PCLPointField> &fields, bool &matches)
+        : fields_ (fields), matches_ (matches)
+      {
+      }
+
+      template <typename Tag> void
+      operator () ()
+      {
+        for (const auto &field : fields_)
+        {
+          if (FieldMatches<PointT, Tag> () (field) &&
+              field.offset == pcl::traits::offset<PointT, Tag>::value)
+            return;
+        }
+        matches_ = false;
+      }
+
+      const std::vector<pcl::PCLPointField> &fields_;
+      bool &matches_;
+    };
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::PCDMappedCloud<PointT>::read (const std::string &file_name, const int offset)
+{
+  clear ();
+
+  std::ifstream fs (file_name.c_str (), std::ios::binary);
+  if (!fs.is_open () || fs.fail ())
+  {
+    PCL_ERROR ("[pcl::PCDMappedCloud::read] Could not open file '%s'.\n", file_name.c_str ());
+    return (-1);
+  }
+  fs.seekg (offset, std::ios::beg);
+
+  // Only parse the header: the point data is not allocated
+  pcl::PCDReader reader;
+  pcl::PCLPointCloud2 msg;
+  int pcd_version, data_type;
+  unsigned int data_idx;
+  if (reader.parseHeader (fs, msg, sensor_origin_, sensor_orientation_, pcd_version, data_type, data_idx) < 0)
+    return (-1);
+  fs.close ();
+
+  // ASCII and compressed bodies must be decoded anyway
+  if (data_type != 1)
+  {
+    if (reader.read (file_name, cloud_, offset) < 0)
+      return (-1);
+    width_ = cloud_.width;
+    height_ = cloud_.height;
+    is_dense_ = cloud_.is_dense ? 1 : 0;
+    points_ = cloud_.data ();
+    return (0);
+  }
+
+  MappedFile file;
+  if (file.open (file_name) < 0)
+    return (-1);
+
+  const std::size_t body_offset = static_cast<std::size_t> (offset) + data_idx;
+  const std::size_t body_size = static_cast<std::size_t> (msg.width) * msg.height * msg.point_step;
+  if (body_offset + body_size > file.size ())
+  {
+    PCL_ERROR ("[pcl::PCDMappedCloud::read] Corrupted PCD file. The file is smaller than expected!\n");
+    return (-1);
+  }
+  const std::uint8_t *body = file.data () + body_offset;
+
+  width_ = msg.width;
+  height_ = msg.height;
+
+  if (isMemoryLayout (msg) && reinterpret_cast<std::uintptr_t> (body) % alignof (PointT) == 0)
+  {
+    // Checking for Inf/NaN values would load every page, so it is deferred to isDense ()
+    fields_ = msg.fields;
+    is_dense_ = -1;
+    points_ = reinterpret_cast<const PointT*> (body);
+    mapped_ = std::move (file);
+    PCL_DEBUG ("[pcl::PCDMappedCloud::read] Mapped %s in place with %u points.\n", file_name.c_str (), msg.width * msg.height);
+    return (0);
+  }
+
+  // Fields need to be reordered: convert straight from the mapped body, the mapping is released on return
+  msg.is_dense = isDenseData (msg.fields, msg.point_step, static_cast<std::size_t> (msg.width) * msg.height, body);
+  is_dense_ = msg.is_dense ? 1 : 0;
+  MsgFieldMap field_map;
+  createMapping<PointT> (msg.fields, field_map);
+  fromPCLPointCloud2 (msg, cloud_, field_map, body);
+  points_ = cloud_.data ();
+  PCL_DEBUG ("[pcl::PCDMappedCloud::read] Converted %s with %u points, the file layout does not match the point type.\n",
+             file_name.c_str (), msg.width * msg.height);
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PCDMappedCloud<PointT>::clear ()
+{
+  mapped_.close ();
+  cloud_.clear ();
+  points_ = nullptr;
+  width_ = height_ = 0;
+  fields_.clear ();
+  is_dense_ = 1;
+  sensor_origin_ = Eigen::Vector4f::Zero ();
+  sensor_orientation_ = Eigen::Quaternionf::Identity ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PCDMappedCloud<PointT>::copyTo (pcl::PointCloud<PointT> &cloud) const
+{
+  cloud.assign (begin (), end ());
+  cloud.width = width_;
+  cloud.height = height_;
+  cloud.is_dense = isDense ();
+  cloud.sensor_origin_ = sensor_origin_;
+  cloud.sensor_orientation_ = sensor_orientation_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::PCDMappedCloud<PointT>::isDense () const
+{
+  int is_dense = is_dense_.load (std::memory_order_relaxed);
+  if (is_dense < 0)
+  {
+    // Concurrent first calls compute the same value, so a relaxed store is enough
+    is_dense = isDenseData (fields_, sizeof (PointT), size (), reinterpret_cast<const std::uint8_t*> (points_)) ? 1 : 0;
+    is_dense_.store (is_dense, std::memory_order_relaxed);
+  }
+  return (is_dense == 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::PCDMappedCloud<PointT>::isMemoryLayout (const pcl::PCLPointCloud2 &msg)
+{
+  if (msg.point_step != sizeof (PointT))
+    return (false);
+  bool matches = true;
+  pcl::for_each_type<typename pcl::traits::fieldList<PointT>::type> (detail::FieldLayoutMatcher<PointT> (msg.fields, matches));
+  return (matches);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::PCDMappedCloud<PointT>::isDenseData (const std::vector<pcl::PCLPointField> &fields, std::uint32_t point_step,
+                                          std::size_t nr_points, const std::uint8_t *data)
+{
+  // Integer fields are always finite, only the floating point ones need to be checked
+  for (const auto &field : fields)
+  {
+    if (field.datatype != pcl::PCLPointField::FLOAT32 && field.datatype != pcl::PCLPointField::FLOAT64)
+      continue;
+    const std::size_t field_size = pcl::getFieldSize (field.datatype);
+    const std::size_t count = (field.count == 0) ? 1 : field.count;
+    for (std::size_t i = 0; i < nr_points; ++i)
+    {
+      const std::uint8_t *value = data + i * point_step + field.offset;
+      for (std::size_t c = 0; c < count; ++c, value += field_size)
+      {
+        if (field.datatype == pcl::PCLPointField::FLOAT32)
+        {
+          float v;
+          std::memcpy (&v, value, sizeof (float));
+          if (!std::isfinite (v))
+            return (false);
+        }
+        else
+        {
+          double v;
+          std::memcpy (&v, value, sizeof (double));
+          if (!std::isfinite (v))
+            return (false);
+        }
+      }
+    }
+  }
+  return (true);
+}
+
+#endif  //#ifndef PCL_IO_PCD_MAPPED_CLOUD_IMPL_H_
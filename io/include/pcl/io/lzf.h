@@ -39,6 +39,9 @@
 
 #include <pcl/pcl_macros.h>
 
+#include <cstddef>
+#include <vector>
+
 namespace pcl
 {
   /** \brief Compress in_len bytes stored at the memory block starting at
@@ -85,4 +88,69 @@ namespace pcl
   PCL_EXPORTS unsigned int 
   lzfDecompress (const void *const in_data,  unsigned int in_len,
                  void             *out_data, unsigned int out_len);
+
+  /** \brief Incremental decompression of data compressed with the \a lzfCompress function.
+    *
+    * Unlike \a lzfDecompress, the decompressed data is produced piece by piece
+    * and only the last 8 KB of output (the maximum distance of an LZF back
+    * reference) are kept in memory. Copying the object saves the current
+    * position in the stream, which makes it possible to decompress several
+    * regions of the output concurrently.
+    *
+    * \note The input buffer must remain valid while the object is used.
+    */
+  class PCL_EXPORTS LZFStreamDecompressor
+  {
+    public:
+      /** \brief Constructor.
+        * \param[in] in_data the input compressed buffer
+        * \param[in] in_len the length of the input buffer
+        */
+      LZFStreamDecompressor (const void *in_data, std::size_t in_len);
+
+      /** \brief Decompress the next \a out_len bytes of the stream.
+        * \param[out] out_data the output buffer, or nullptr to skip the bytes
+        * \param[in] out_len the number of bytes to produce
+        * \return the number of bytes produced, which is smaller than \a out_len
+        * if the end of the input was reached or the input is corrupted (see hasError)
+        */
+      std::size_t
+      decompress (void *out_data, std::size_t out_len);
+
+      /** \brief Get the number of bytes decompressed so far. */
+      inline std::size_t
+      getOutputPosition () const { return (out_pos_); }
+
+      /** \brief Whether an error in the compressed data was detected. */
+      inline bool
+      hasError () const { return (error_); }
+
+    private:
+      /** \brief The input compressed buffer. */
+      const unsigned char *in_data_;
+
+      /** \brief The length of the input buffer. */
+      std::size_t in_len_;
+
+      /** \brief The position of the next control byte in the input buffer. */
+      std::size_t in_pos_{0};
+
+      /** \brief The number of bytes decompressed so far. */
+      std::size_t out_pos_{0};
+
+      /** \brief Ring buffer holding the last decompressed bytes. */
+      std::vector<unsigned char> window_;
+
+      /** \brief The number of bytes left in the current literal run. */
+      unsigned int literal_left_{0};
+
+      /** \brief The number of bytes left in the current back reference. */
+      unsigned int reference_left_{0};
+
+      /** \brief The distance of the current back reference. */
+      unsigned int reference_distance_{0};
+
+      /** \brief Set when an error in the compressed data is detected. */
+      bool error_{false};
+  };
 }
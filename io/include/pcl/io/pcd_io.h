@@ -70,7 +70,7 @@ namespace pcl
         *   - WIDTH ...
         *   - HEIGHT ...
         *   - POINTS ...
-        *   - DATA ascii/binary
+        *   - DATA ascii/binary/binary_compressed/binary_compressed_chunked
         *
         * Everything that follows \b DATA is interpreted as data points and
         * will be read accordingly.
@@ -102,7 +102,7 @@ namespace pcl
         * \param[out] origin the sensor acquisition origin (only for > PCD_V7 - null if not present)
         * \param[out] orientation the sensor acquisition orientation (only for > PCD_V7 - identity if not present)
         * \param[out] pcd_version the PCD version of the file (i.e., PCD_V6, PCD_V7)
-        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed)
+        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed, 3 = Binary compressed chunked)
         * \param[out] data_idx the offset of cloud data within the file
         *
         * \return
@@ -114,6 +114,31 @@ namespace pcl
                   Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, int &pcd_version,
                   int &data_type, unsigned int &data_idx);
 
+      /** \brief Read a point cloud data header from a PCD-formatted stream, without allocating the point data.
+        *
+        * Same as readHeader (std::istream&, ...), except that cloud.data is left
+        * empty. Useful when the body is accessed in place, e.g. through a memory
+        * mapping of the file (see PCDMappedCloud).
+        *
+        * \param[in] binary_istream a std::istream with openmode set to std::ios::binary.
+        * \param[out] cloud the resultant point cloud dataset (only these
+        *             members will be filled: width, height, point_step,
+        *             row_step, fields[])
+        * \param[out] origin the sensor acquisition origin (only for > PCD_V7 - null if not present)
+        * \param[out] orientation the sensor acquisition orientation (only for > PCD_V7 - identity if not present)
+        * \param[out] pcd_version the PCD version of the file (i.e., PCD_V6, PCD_V7)
+        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed, 3 = Binary compressed chunked)
+        * \param[out] data_idx the offset of cloud data within the file
+        *
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      parseHeader (std::istream &binary_istream, pcl::PCLPointCloud2 &cloud,
+                   Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, int &pcd_version,
+                   int &data_type, unsigned int &data_idx);
+
       /** \brief Read a point cloud data header from a PCD file.
         *
         * Load only the meta information (number of points, their types, etc),
@@ -130,7 +155,7 @@ namespace pcl
         * \param[out] origin the sensor acquisition origin (only for > PCD_V7 - null if not present)
         * \param[out] orientation the sensor acquisition orientation (only for > PCD_V7 - identity if not present)
         * \param[out] pcd_version the PCD version of the file (i.e., PCD_V6, PCD_V7)
-        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed)
+        * \param[out] data_type the type of data (0 = ASCII, 1 = Binary, 2 = Binary compressed, 3 = Binary compressed chunked)
         * \param[out] data_idx the offset of cloud data within the file
         * \param[in] offset the offset of where to expect the PCD Header in the
         * file (optional parameter). One usage example for setting the offset
@@ -215,6 +240,64 @@ namespace pcl
       readBodyBinary (const unsigned char *data, pcl::PCLPointCloud2 &cloud,
                        int pcd_version, bool compressed, unsigned int data_idx);
 
+      /** \brief Read the point cloud data (body) of a BINARY_COMPRESSED_CHUNKED PCD file from a block of memory.
+        *
+        * For use after readHeader(), when the resulting data_type == 3. The
+        * body is made of independently compressed chunks of points, preceded by
+        * a table of their sizes, so the chunks are decompressed in parallel
+        * (see setNumberOfThreads ()) and only the chunks that overlap the
+        * requested range of points are decompressed.
+        *
+        * \param[in] data the memory location from which to read the body.
+        * \param[in] data_size the number of bytes available at \a data
+        * \param[in,out] cloud the resultant point cloud dataset to be filled, as returned by readHeader ()
+        * \param[in] data_idx the offset of the body, as reported by readHeader().
+        * \param[in] first_point the index of the first point to read
+        * \param[in] nr_points the number of points to read (clamped to the number of points in the file).
+        * If less than all the points are read, the resultant cloud is unorganized.
+        *
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      readBodyBinaryChunked (const unsigned char *data, std::size_t data_size, pcl::PCLPointCloud2 &cloud,
+                             unsigned int data_idx, uindex_t first_point = 0,
+                             uindex_t nr_points = std::numeric_limits<uindex_t>::max ());
+
+      /** \brief Read a range of points from a PCD file and store it into a pcl/PCLPointCloud2.
+        *
+        * For BINARY files only the requested points are copied, and for
+        * BINARY_COMPRESSED_CHUNKED files only the chunks overlapping the range
+        * are decompressed. ASCII and BINARY_COMPRESSED files are read entirely.
+        *
+        * \param[in] file_name the name of the file containing the actual PointCloud data
+        * \param[out] cloud the resultant (unorganized, unless all the points are read) cloud
+        * \param[in] first_point the index of the first point to read
+        * \param[in] nr_points the number of points to read (clamped to the number of points in the file)
+        * \param[in] offset the offset of where to expect the PCD Header in the file (see read ())
+        *
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      readRange (const std::string &file_name, pcl::PCLPointCloud2 &cloud,
+                 uindex_t first_point, uindex_t nr_points, const int offset = 0);
+
+      /** \brief Set the number of threads used to decompress BINARY_COMPRESSED_CHUNKED files.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used to decompress BINARY_COMPRESSED_CHUNKED files. */
+      unsigned int
+      getNumberOfThreads () const
+      {
+        return (num_threads_);
+      }
+
       /** \brief Read a point cloud data from a PCD file and store it into a pcl/PCLPointCloud2.
         * \param[in] file_name the name of the file containing the actual PointCloud data
         * \param[out] cloud the resultant PointCloud message read from disk
@@ -289,6 +372,10 @@ namespace pcl
       }
 
       PCL_MAKE_ALIGNED_OPERATOR_NEW
+
+    private:
+      /** \brief The number of threads used to decompress chunked files. */
+      unsigned int num_threads_{1};
   };
 
   /** \brief Point Cloud Data (PCD) file format writer.
@@ -315,6 +402,27 @@ namespace pcl
         map_synchronization_ = sync;
       }
 
+      /** \brief Set the alignment (in bytes) of the point data in files written by writeBinary (PCLPointCloud2).
+        * The header is padded with a comment line so that the body starts at a
+        * multiple of \a alignment. Together with a point_step equal to
+        * sizeof (PointT) (as produced by toPCLPointCloud2), this allows
+        * PCDMappedCloud to use the file contents in place, without any copy.
+        * Default: 1 (no padding)
+        * \param[in] alignment the requested alignment, e.g. 16 for SSE aligned point types
+        */
+      void
+      setBinaryDataAlignment (unsigned int alignment)
+      {
+        data_alignment_ = (alignment == 0) ? 1 : alignment;
+      }
+
+      /** \brief Get the alignment (in bytes) of the point data in files written by writeBinary (PCLPointCloud2). */
+      unsigned int
+      getBinaryDataAlignment () const
+      {
+        return (data_alignment_);
+      }
+
       /** \brief Generate the header of a PCD file format
         * \param[in] cloud the point cloud data message
         * \param[in] origin the sensor acquisition origin
@@ -444,6 +552,70 @@ namespace pcl
                              const Eigen::Vector4f &origin = Eigen::Vector4f::Zero (),
                              const Eigen::Quaternionf &orientation = Eigen::Quaternionf::Identity ());
 
+      /** \brief Save point cloud data to a PCD file containing n-D points, in BINARY_COMPRESSED_CHUNKED format
+        *
+        * The points are split into chunks of getChunkSize () points, which are
+        * transposed and LZF compressed independently (in parallel, see
+        * setNumberOfThreads ()). The body starts with a table of the chunk sizes,
+        * which lets readers decompress in parallel and seek to a subset of points.
+        * Unlike BINARY_COMPRESSED, the size of the cloud is not limited to 4 GB.
+        * \param[in] file_name the output file name
+        * \param[in] cloud the point cloud data message
+        * \param[in] origin the sensor acquisition origin
+        * \param[in] orientation the sensor acquisition orientation
+        * \return
+        * (-1) for a general error
+        * 0 on success
+        */
+      int
+      writeBinaryCompressedChunked (const std::string &file_name, const pcl::PCLPointCloud2 &cloud,
+                                    const Eigen::Vector4f &origin = Eigen::Vector4f::Zero (),
+                                    const Eigen::Quaternionf &orientation = Eigen::Quaternionf::Identity ());
+
+      /** \brief Save point cloud data to a std::ostream containing n-D points, in BINARY_COMPRESSED_CHUNKED format
+        * \param[out] os the stream into which to write the data
+        * \param[in] cloud the point cloud data message
+        * \param[in] origin the sensor acquisition origin
+        * \param[in] orientation the sensor acquisition orientation
+        * \return
+        * (-1) for a general error
+        * 0 on success
+        */
+      int
+      writeBinaryCompressedChunked (std::ostream &os, const pcl::PCLPointCloud2 &cloud,
+                                    const Eigen::Vector4f &origin = Eigen::Vector4f::Zero (),
+                                    const Eigen::Quaternionf &orientation = Eigen::Quaternionf::Identity ());
+
+      /** \brief Set the number of points per chunk written by writeBinaryCompressedChunked ().
+        * Default: 65536
+        * \param[in] nr_points the number of points per chunk
+        */
+      void
+      setChunkSize (unsigned int nr_points)
+      {
+        chunk_size_ = (nr_points == 0) ? 1 : nr_points;
+      }
+
+      /** \brief Get the number of points per chunk written by writeBinaryCompressedChunked (). */
+      unsigned int
+      getChunkSize () const
+      {
+        return (chunk_size_);
+      }
+
+      /** \brief Set the number of threads used to compress chunks in writeBinaryCompressedChunked ().
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used to compress chunks in writeBinaryCompressedChunked (). */
+      unsigned int
+      getNumberOfThreads () const
+      {
+        return (num_threads_);
+      }
+
       /** \brief Save point cloud data to a PCD file containing n-D points
         * \param[in] file_name the output file name
         * \param[in] cloud the point cloud data message
@@ -516,6 +688,22 @@ namespace pcl
       writeBinaryCompressed (const std::string &file_name,
                              const pcl::PointCloud<PointT> &cloud);
 
+      /** \brief Save point cloud data to a PCD file containing n-D points, in BINARY_COMPRESSED_CHUNKED format
+        * \param[in] file_name the output file name
+        * \param[in] cloud the point cloud data message
+        * \return
+        * (-1) for a general error
+        * 0 on success
+        */
+      template <typename PointT> int
+      writeBinaryCompressedChunked (const std::string &file_name,
+                                    const pcl::PointCloud<PointT> &cloud)
+      {
+        pcl::PCLPointCloud2 blob;
+        pcl::toPCLPointCloud2 (cloud, blob);
+        return (writeBinaryCompressedChunked (file_name, blob, cloud.sensor_origin_, cloud.sensor_orientation_));
+      }
+
       /** \brief Save point cloud data to a PCD file containing n-D points, in BINARY format
         * \param[in] file_name the output file name
         * \param[in] cloud the point cloud data message
@@ -613,9 +801,25 @@ namespace pcl
       resetLockingPermissions (const std::string &file_name,
                                boost::interprocess::file_lock &lock);
 
+      /** \brief Generate a header comment line that pads a header of \a header_size bytes
+        * to the requested binary data alignment.
+        * \param[in] header_size the size of the header, including the DATA line
+        */
+      std::string
+      generateAlignmentPadding (std::size_t header_size) const;
+
     private:
       /** \brief Set to true if msync() should be called before munmap(). Prevents data loss on NFS systems. */
       bool map_synchronization_{false};
+
+      /** \brief Alignment (in bytes) of the point data written by writeBinary (PCLPointCloud2). */
+      unsigned int data_alignment_{1};
+
+      /** \brief Number of points per chunk written by writeBinaryCompressedChunked (). */
+      unsigned int chunk_size_{65536};
+
+      /** \brief The number of threads used to compress chunks. */
+      unsigned int num_threads_{1};
   };
 
   namespace io
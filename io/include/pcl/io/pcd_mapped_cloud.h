@@ -0,0 +1,219 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/memory.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/common/mapped_file.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Read-only view of the points stored in a PCD file.
+    *
+    * For binary PCD files whose on-disk point layout is identical to the memory
+    * layout of \a PointT (same point_step, every field of \a PointT present at
+    * its struct offset, padding stored as "_" fields) and whose point data is
+    * suitably aligned, the points are used in place from a read-only memory
+    * mapping of the file: no copy is made, and pages are loaded on first access.
+    * Such files are produced by PCDWriter::writeBinary (PCLPointCloud2) from the
+    * output of toPCLPointCloud2 when PCDWriter::setBinaryDataAlignment is set to
+    * alignof (PointT).
+    *
+    * Otherwise the points are converted into an owned PointCloud<PointT>: for
+    * binary files directly from the mapped body (so that, unlike
+    * PCDReader::read, no intermediate PCLPointCloud2 copy of the data is made),
+    * and through PCDReader::read for ASCII and compressed files.
+    *
+    * \code
+    * pcl::PCDMappedCloud<pcl::PointXYZ> tile;
+    * if (tile.read ("tile.pcd") == 0)
+    *   for (const auto &p : tile)
+    *     ...
+    * \endcode
+    *
+    * \note The data returned by data () / begin () is only valid until the
+    * object is destroyed, or read () or clear () are called.
+    * \ingroup io
+    */
+  template <typename PointT>
+  class PCDMappedCloud
+  {
+    public:
+      using Ptr = shared_ptr<PCDMappedCloud<PointT> >;
+      using ConstPtr = shared_ptr<const PCDMappedCloud<PointT> >;
+      using const_iterator = const PointT*;
+
+      PCDMappedCloud () = default;
+      PCDMappedCloud (const PCDMappedCloud&) = delete;
+      PCDMappedCloud&
+      operator = (const PCDMappedCloud&) = delete;
+
+      /** \brief Open a PCD file and make its points available.
+        * \param[in] file_name the name of the file to read
+        * \param[in] offset the offset of where to expect the PCD header in the file
+        * (see PCDReader::read)
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      read (const std::string &file_name, const int offset = 0);
+
+      /** \brief Release the file mapping or the copied points. */
+      void
+      clear ();
+
+      /** \brief Whether the points are used in place from the mapped file (true), or were copied (false). */
+      inline bool
+      isZeroCopy () const { return (mapped_.isOpen ()); }
+
+      /** \brief Get a pointer to the first point. */
+      inline const PointT*
+      data () const { return (points_); }
+
+      inline const_iterator
+      begin () const { return (points_); }
+
+      inline const_iterator
+      end () const { return (points_ + size ()); }
+
+      /** \brief Get the number of points. */
+      inline std::size_t
+      size () const { return (static_cast<std::size_t> (width_) * height_); }
+
+      inline bool
+      empty () const { return (size () == 0); }
+
+      inline const PointT&
+      operator[] (std::size_t n) const { return (points_[n]); }
+
+      /** \brief Obtain the point given by the (column, row) coordinates. Only works on organized datasets.
+        * \param[in] column the column coordinate
+        * \param[in] row the row coordinate
+        */
+      inline const PointT&
+      at (int column, int row) const { return (points_[row * width_ + column]); }
+
+      /** \brief Get the width of the cloud (number of points per row). */
+      inline std::uint32_t
+      getWidth () const { return (width_); }
+
+      /** \brief Get the height of the cloud (number of rows). */
+      inline std::uint32_t
+      getHeight () const { return (height_); }
+
+      /** \brief Whether the cloud is organized (height > 1). */
+      inline bool
+      isOrganized () const { return (height_ > 1); }
+
+      /** \brief True if no point contains Inf/NaN values.
+        * \note PCD files do not store this flag. When the points are used in place,
+        * they are only checked the first time this is called, so that read () does
+        * not have to load every page of the file.
+        */
+      bool
+      isDense () const;
+
+      /** \brief Get the sensor acquisition origin stored in the file. */
+      inline const Eigen::Vector4f&
+      getSensorOrigin () const { return (sensor_origin_); }
+
+      /** \brief Get the sensor acquisition orientation stored in the file. */
+      inline const Eigen::Quaternionf&
+      getSensorOrientation () const { return (sensor_orientation_); }
+
+      /** \brief Copy the points into an owning point cloud.
+        * \param[out] cloud the resultant point cloud
+        */
+      void
+      copyTo (pcl::PointCloud<PointT> &cloud) const;
+
+    protected:
+      /** \brief Check whether the serialized point layout is the memory layout of PointT.
+        * \param[in] msg the header of the file
+        */
+      static bool
+      isMemoryLayout (const pcl::PCLPointCloud2 &msg);
+
+      /** \brief Check the floating point fields of serialized points for Inf/NaN values.
+        * \param[in] fields the fields of the serialized points
+        * \param[in] point_step the size of a serialized point in bytes
+        * \param[in] nr_points the number of serialized points
+        * \param[in] data the serialized point data
+        */
+      static bool
+      isDenseData (const std::vector<pcl::PCLPointField> &fields, std::uint32_t point_step,
+                   std::size_t nr_points, const std::uint8_t *data);
+
+    private:
+      /** \brief The file mapping, only kept open when the points are used in place. */
+      MappedFile mapped_;
+
+      /** \brief The points, when they could not be used in place. */
+      pcl::PointCloud<PointT> cloud_;
+
+      /** \brief The first point, either in the mapped file or in cloud_. */
+      const PointT *points_{nullptr};
+
+      std::uint32_t width_{0};
+      std::uint32_t height_{0};
+
+      /** \brief The fields of the mapped points, used to check them for Inf/NaN values. */
+      std::vector<pcl::PCLPointField> fields_;
+
+      /** \brief Whether the points are dense: 1 if they are, 0 if not, -1 if the mapped
+        * points were not checked yet.
+        */
+      mutable std::atomic<int> is_dense_{1};
+
+      Eigen::Vector4f sensor_origin_{Eigen::Vector4f::Zero ()};
+      Eigen::Quaternionf sensor_orientation_{Eigen::Quaternionf::Identity ()};
+
+    public:
+      PCL_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}
+
+#include <pcl/io/impl/pcd_mapped_cloud.hpp>
@@ -0,0 +1,266 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/conversions.h>
+#include <pcl/io/lzf.h>
+#include <pcl/common/mapped_file.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/memory.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/PCLPointCloud2.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Read a PCD file as a sequence of batches with a fixed number of points.
+    *
+    * Only one batch is held in memory at a time, which makes it possible to
+    * process files larger than the available memory, e.g. by feeding each
+    * batch to a PassThrough or CropBox filter, or to a StreamingVoxelGrid:
+    *
+    * \code
+    * pcl::PCDStreamReader reader;
+    * reader.setBatchSize (1000000);
+    * if (reader.open ("huge.pcd") < 0)
+    *   return (-1);
+    *
+    * pcl::StreamingVoxelGrid<pcl::PointXYZ> grid;
+    * grid.setLeafSize (0.1f, 0.1f, 0.1f);
+    * pcl::PointCloud<pcl::PointXYZ> batch;
+    * while (!reader.eof ())
+    * {
+    *   if (reader.read (batch) < 0)
+    *     return (-1);
+    *   grid.addPointCloud (batch);
+    * }
+    * \endcode
+    *
+    * All PCD data types are supported. Binary bodies are read with large
+    * sequential reads. The single LZF stream of a binary_compressed body is
+    * decompressed incrementally, with one decompressor per field plane. The
+    * decompressors are positioned by the first call to read (), which skips
+    * through the stream without keeping the skipped data. The chunks of a
+    * binary_compressed_chunked body are decompressed on demand, and a chunk
+    * shared by two consecutive batches is only decompressed once.
+    *
+    * \note Batches are always unorganized (height = 1). The dimensions of the
+    * cloud stored in the file are available through getHeader ().
+    * \ingroup io
+    */
+  class PCL_EXPORTS PCDStreamReader
+  {
+    public:
+      PCDStreamReader () = default;
+      PCDStreamReader (const PCDStreamReader&) = delete;
+      PCDStreamReader&
+      operator = (const PCDStreamReader&) = delete;
+
+      /** \brief Open a PCD file and read its header.
+        * \param[in] file_name the name of the file to read
+        * \param[in] offset the offset of the header within the file (e.g. inside a TAR archive)
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      open (const std::string &file_name, const int offset = 0);
+
+      /** \brief Close the file and release all buffers. */
+      void
+      close ();
+
+      /** \brief Whether a file is currently open. */
+      inline bool
+      isOpen () const { return (data_type_ >= 0); }
+
+      /** \brief Whether all points of the file have been read. */
+      inline bool
+      eof () const { return (points_read_ >= getNumberOfPoints ()); }
+
+      /** \brief Read the next batch of points.
+        * \param[out] batch the next getBatchSize () points of the file (or the
+        * remaining points, if there are fewer). Empty if the end of the file was reached.
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      int
+      read (pcl::PCLPointCloud2 &batch);
+
+      /** \brief Read the next batch of points.
+        * \param[out] batch the next getBatchSize () points of the file (or the
+        * remaining points, if there are fewer). Empty if the end of the file was reached.
+        * \return
+        *  * < 0 (-1) on error
+        *  * == 0 on success
+        */
+      template <typename PointT> int
+      read (pcl::PointCloud<PointT> &batch)
+      {
+        if (read (blob_) < 0)
+          return (-1);
+        pcl::fromPCLPointCloud2 (blob_, batch);
+        batch.sensor_origin_ = origin_;
+        batch.sensor_orientation_ = orientation_;
+        return (0);
+      }
+
+      /** \brief Set the (maximum) number of points returned by each call to read (). */
+      inline void
+      setBatchSize (uindex_t nr_points) { batch_size_ = (nr_points == 0) ? 1 : nr_points; }
+
+      /** \brief Get the (maximum) number of points returned by each call to read (). */
+      inline uindex_t
+      getBatchSize () const { return (batch_size_); }
+
+      /** \brief Set the number of threads used to decompress binary_compressed_chunked files.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { reader_.setNumberOfThreads (nr_threads); }
+
+      /** \brief Get the header of the file: fields, width, height and point_step. The data is left empty. */
+      inline const pcl::PCLPointCloud2&
+      getHeader () const { return (header_); }
+
+      /** \brief Get the total number of points stored in the file. */
+      inline std::size_t
+      getNumberOfPoints () const { return (static_cast<std::size_t> (header_.width) * header_.height); }
+
+      /** \brief Get the number of points read so far. */
+      inline std::size_t
+      getNumberOfPointsRead () const { return (points_read_); }
+
+      /** \brief Get the sensor acquisition origin stored in the file. */
+      inline const Eigen::Vector4f&
+      getSensorOrigin () const { return (origin_); }
+
+      /** \brief Get the sensor acquisition orientation stored in the file. */
+      inline const Eigen::Quaternionf&
+      getSensorOrientation () const { return (orientation_); }
+
+    private:
+      /** \brief Decompress the next batch of a binary_compressed body into buffer_. */
+      int
+      readCompressedBatch (uindex_t nr_points);
+
+      /** \brief Decompress the chunks overlapping the next batch of a binary_compressed_chunked body into buffer_. */
+      int
+      readChunkedBatch (uindex_t nr_points);
+
+      /** \brief The reader used to parse the header and decode the batches. */
+      PCDReader reader_;
+
+      /** \brief The header of the file. */
+      pcl::PCLPointCloud2 header_;
+
+      /** \brief The sensor acquisition origin. */
+      Eigen::Vector4f origin_{Eigen::Vector4f::Zero ()};
+
+      /** \brief The sensor acquisition orientation. */
+      Eigen::Quaternionf orientation_{Eigen::Quaternionf::Identity ()};
+
+      /** \brief The PCD version of the file. */
+      int pcd_version_{0};
+
+      /** \brief The data type of the file (0 = ASCII, 1 = Binary, 2 = Binary compressed,
+        * 3 = Binary compressed chunked), -1 if no file is open.
+        */
+      int data_type_{-1};
+
+      /** \brief The offset of the body within the file. */
+      unsigned int data_idx_{0};
+
+      /** \brief The number of points returned by each call to read (). */
+      uindex_t batch_size_{65536};
+
+      /** \brief The number of points read so far. */
+      std::size_t points_read_{0};
+
+      /** \brief The file stream, for ASCII and binary files. */
+      std::ifstream fs_;
+
+      /** \brief The memory mapped file, for compressed files. */
+      pcl::MappedFile file_;
+
+      /** \brief The fields stored in a binary_compressed body (all but padding). */
+      std::vector<pcl::PCLPointField> compressed_fields_;
+
+      /** \brief The size of the LZF stream of a binary_compressed body. */
+      unsigned int compressed_size_{0};
+
+      /** \brief One decompressor per field plane of a binary_compressed body, empty until the first read (). */
+      std::vector<pcl::LZFStreamDecompressor> planes_;
+
+      /** \brief The number of points per chunk of a binary_compressed_chunked body. */
+      std::uint32_t chunk_size_{0};
+
+      /** \brief The compressed and uncompressed size of every chunk (0 compressed bytes for a raw chunk). */
+      std::vector<std::uint32_t> chunk_sizes_;
+
+      /** \brief The offset of every chunk within the file, followed by the end of the last chunk. */
+      std::vector<std::size_t> chunk_offsets_;
+
+      /** \brief The chunk held in chunk_cache_, -1 if none. */
+      std::ptrdiff_t cached_chunk_{-1};
+
+      /** \brief The decompressed chunk which the last batch ended in. */
+      std::vector<unsigned char> chunk_cache_;
+
+      /** \brief The chunk which the current batch ends in, swapped with chunk_cache_ once the batch is read. */
+      std::vector<unsigned char> next_chunk_cache_;
+
+      /** \brief Raw point data of the current batch. */
+      std::vector<unsigned char> buffer_;
+
+      /** \brief Decompressed field plane of the current batch. */
+      std::vector<unsigned char> plane_buffer_;
+
+      /** \brief Temporary batch used by the templated read (). */
+      pcl::PCLPointCloud2 blob_;
+
+    public:
+      PCL_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}
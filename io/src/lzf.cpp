@@ -371,3 +371,98 @@ pcl::lzfDecompress (const void *const in_data,  unsigned int in_len,
   return (static_cast<unsigned int> (op - static_cast<unsigned char*> (out_data)));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+  /** \brief Maximum distance of an LZF back reference. */
+  constexpr std::size_t lzf_window_size = 1 << 13;
+}
+
+pcl::LZFStreamDecompressor::LZFStreamDecompressor (const void *in_data, std::size_t in_len)
+  : in_data_ (static_cast<const unsigned char *> (in_data))
+  , in_len_ (in_len)
+  , window_ (lzf_window_size)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t
+pcl::LZFStreamDecompressor::decompress (void *out_data, std::size_t out_len)
+{
+  auto *op = static_cast<unsigned char *> (out_data);
+  const std::size_t mask = lzf_window_size - 1;
+  std::size_t produced = 0;
+
+  while (produced < out_len && !error_)
+  {
+    // Literal run
+    if (literal_left_ > 0)
+    {
+      auto len = static_cast<unsigned int> (std::min<std::size_t> (literal_left_, out_len - produced));
+      for (unsigned int i = 0; i < len; ++i, ++out_pos_)
+      {
+        const unsigned char c = in_data_[in_pos_++];
+        window_[out_pos_ & mask] = c;
+        if (op)
+          *op++ = c;
+      }
+      literal_left_ -= len;
+      produced += len;
+      continue;
+    }
+
+    // Back reference, byte by byte since it may overlap the bytes it produces
+    if (reference_left_ > 0)
+    {
+      auto len = static_cast<unsigned int> (std::min<std::size_t> (reference_left_, out_len - produced));
+      for (unsigned int i = 0; i < len; ++i, ++out_pos_)
+      {
+        const unsigned char c = window_[(out_pos_ - reference_distance_) & mask];
+        window_[out_pos_ & mask] = c;
+        if (op)
+          *op++ = c;
+      }
+      reference_left_ -= len;
+      produced += len;
+      continue;
+    }
+
+    if (in_pos_ >= in_len_)
+      break;
+
+    unsigned int ctrl = in_data_[in_pos_++];
+    if (ctrl < (1 << 5))
+    {
+      literal_left_ = ctrl + 1;
+      // Check for overflow
+      if (in_pos_ + literal_left_ > in_len_)
+        error_ = true;
+    }
+    else
+    {
+      unsigned int len = ctrl >> 5;
+      // Check for overflow
+      if (in_pos_ >= in_len_)
+      {
+        error_ = true;
+        break;
+      }
+      if (len == 7)
+      {
+        len += in_data_[in_pos_++];
+        // Check for overflow
+        if (in_pos_ >= in_len_)
+        {
+          error_ = true;
+          break;
+        }
+      }
+      reference_distance_ = ((ctrl & 0x1f) << 8) + 1 + in_data_[in_pos_++];
+      reference_left_ = len + 2;
+      if (reference_distance_ > out_pos_)
+        error_ = true;
+    }
+  }
+
+  return (produced);
+}
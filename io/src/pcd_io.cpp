@@ -46,6 +46,7 @@
 #include <pcl/common/pcl_filesystem.h>
 #include <pcl/io/low_level_io.h>
 #include <pcl/io/lzf.h>
+#include <pcl/common/mapped_file.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/io/split.h>
 #include <pcl/console/time.h>
@@ -115,6 +116,21 @@ int
 pcl::PCDReader::readHeader (std::istream &fs, pcl::PCLPointCloud2 &cloud,
                             Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, 
                             int &pcd_version, int &data_type, unsigned int &data_idx)
+{
+  const int res = parseHeader (fs, cloud, origin, orientation, pcd_version, data_type, data_idx);
+  if (res < 0)
+    return (res);
+
+  // Need to allocate: N * point_step
+  cloud.data.resize (static_cast<std::size_t> (cloud.width) * cloud.height * cloud.point_step);
+  return (0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDReader::parseHeader (std::istream &fs, pcl::PCLPointCloud2 &cloud,
+                             Eigen::Vector4f &origin, Eigen::Quaternionf &orientation, 
+                             int &pcd_version, int &data_type, unsigned int &data_idx)
 {
   // Default values
   data_idx = 0;
@@ -317,15 +333,15 @@ pcl::PCDReader::readHeader (std::istream &fs, pcl::PCLPointCloud2 &cloud,
         if (!cloud.point_step)
           throw "Number of POINTS specified before COUNT in header!";
         sstream >> nr_points;
-        // Need to allocate: N * point_step
-        cloud.data.resize (nr_points * cloud.point_step);
         continue;
       }
 
       // Read the header + comments line by line until we get to <DATA>
       if (line_type.substr (0, 4) == "DATA")
       {
-        if (st.at (1).substr (0, 17) == "binary_compressed")
+        if (st.at (1).substr (0, 25) == "binary_compressed_chunked")
+          data_type = 3;
+        else if (st.at (1).substr (0, 17) == "binary_compressed")
           data_type = 2;
         else if (st.at (1).substr (0, 6) == "binary")
           data_type = 1;
@@ -556,6 +572,48 @@ pcl::PCDReader::readBodyASCII (std::istream &fs, pcl::PCLPointCloud2 &cloud, int
   return (0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+  /** \brief Go over each field of a binary blob and check whether it contains NaN/Inf values. */
+  bool
+  isBinaryDataDense (const pcl::PCLPointCloud2 &cloud)
+  {
+    int point_size = (cloud.width * cloud.height == 0) ? 0 : static_cast<int> (cloud.data.size () / (cloud.height * cloud.width));
+    for (pcl::uindex_t i = 0; i < cloud.width * cloud.height; ++i)
+    {
+      for (unsigned int d = 0; d < static_cast<unsigned int> (cloud.fields.size ()); ++d)
+      {
+        for (pcl::uindex_t c = 0; c < cloud.fields[d].count; ++c)
+        {
+#define SET_CLOUD_DENSE(CASE_LABEL)                                                      \
+  case CASE_LABEL: {                                                                     \
+    if (!pcl::isValueFinite<pcl::traits::asType_t<(CASE_LABEL)>>(cloud, i, point_size, d, c)) \
+      return (false);                                                                    \
+    break;                                                                               \
+  }
+          switch (cloud.fields[d].datatype)
+          {
+            SET_CLOUD_DENSE(pcl::PCLPointField::BOOL)
+            SET_CLOUD_DENSE(pcl::PCLPointField::INT8)
+            SET_CLOUD_DENSE(pcl::PCLPointField::UINT8)
+            SET_CLOUD_DENSE(pcl::PCLPointField::INT16)
+            SET_CLOUD_DENSE(pcl::PCLPointField::UINT16)
+            SET_CLOUD_DENSE(pcl::PCLPointField::INT32)
+            SET_CLOUD_DENSE(pcl::PCLPointField::UINT32)
+            SET_CLOUD_DENSE(pcl::PCLPointField::INT64)
+            SET_CLOUD_DENSE(pcl::PCLPointField::UINT64)
+            SET_CLOUD_DENSE(pcl::PCLPointField::FLOAT32)
+            SET_CLOUD_DENSE(pcl::PCLPointField::FLOAT64)
+          }
+#undef SET_CLOUD_DENSE
+        }
+      }
+    }
+    return (true);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 int
 pcl::PCDReader::readBodyBinary (const unsigned char *map, pcl::PCLPointCloud2 &cloud,
@@ -636,42 +694,232 @@ pcl::PCDReader::readBodyBinary (const unsigned char *map, pcl::PCLPointCloud2 &c
     memcpy ((cloud.data).data(), &map[0] + data_idx, cloud.data.size ());
 
   // Extra checks (not needed for ASCII)
-  int point_size = (cloud.width * cloud.height == 0) ? 0 : static_cast<int> (cloud.data.size () / (cloud.height * cloud.width));
-  // Once copied, we need to go over each field and check if it has NaN/Inf values and assign cloud.is_dense to true or false
-  for (uindex_t i = 0; i < cloud.width * cloud.height; ++i)
+  cloud.is_dense = isBinaryDataDense (cloud);
+
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDReader::readBodyBinaryChunked (const unsigned char *map, std::size_t map_size, pcl::PCLPointCloud2 &cloud,
+                                       unsigned int data_idx, uindex_t first_point, uindex_t nr_points)
+{
+  // Setting the is_dense property to true by default
+  cloud.is_dense = true;
+
+  const std::size_t total_points = static_cast<std::size_t> (cloud.width) * cloud.height;
+
+  // The body starts with the number of points per chunk and the number of chunks...
+  std::size_t pos = data_idx;
+  std::uint32_t chunk_size = 0, nr_chunks = 0;
+  if (pos + 8 > map_size)
   {
-    for (unsigned int d = 0; d < static_cast<unsigned int> (cloud.fields.size ()); ++d)
+    PCL_ERROR ("[pcl::PCDReader::readBodyBinaryChunked] Corrupted PCD file. The file is smaller than expected!\n");
+    return (-1);
+  }
+  memcpy (&chunk_size, &map[pos + 0], 4);
+  memcpy (&nr_chunks, &map[pos + 4], 4);
+  pos += 8;
+  if ((chunk_size == 0 && total_points != 0) ||
+      (chunk_size != 0 && nr_chunks != (total_points + chunk_size - 1) / chunk_size))
+  {
+    PCL_ERROR ("[pcl::PCDReader::readBodyBinaryChunked] The chunk table (%u chunks of %u points) does not match the number of points (%zu)! Data corruption?\n",
+               nr_chunks, chunk_size, total_points);
+    return (-1);
+  }
+
+  // ...followed by the compressed and uncompressed size of every chunk
+  if (pos + 8 * static_cast<std::size_t> (nr_chunks) > map_size)
+  {
+    PCL_ERROR ("[pcl::PCDReader::readBodyBinaryChunked] Corrupted PCD file. The file is smaller than expected!\n");
+    return (-1);
+  }
+  std::vector<std::uint32_t> chunk_sizes (2 * static_cast<std::size_t> (nr_chunks));
+  if (!chunk_sizes.empty ())
+    memcpy (chunk_sizes.data (), &map[pos], chunk_sizes.size () * 4);
+  pos += chunk_sizes.size () * 4;
+
+  // Incompressible chunks are stored as they are, with a compressed size of 0
+  std::vector<std::size_t> chunk_offsets (nr_chunks + 1, pos);
+  for (std::size_t c = 0; c < nr_chunks; ++c)
+    chunk_offsets[c + 1] = chunk_offsets[c] + (chunk_sizes[2 * c] != 0 ? chunk_sizes[2 * c] : chunk_sizes[2 * c + 1]);
+  if (chunk_offsets.back () > map_size)
+  {
+    PCL_ERROR ("[pcl::PCDReader::readBodyBinaryChunked] Corrupted PCD file. The file is smaller than expected!\n");
+    return (-1);
+  }
+
+  // Get the fields sizes
+  std::vector<pcl::PCLPointField> fields;
+  std::vector<std::size_t> fields_sizes;
+  std::size_t fsize = 0;
+  for (const auto &field : cloud.fields)
+  {
+    if (field.name == "_")
+      continue;
+    fields_sizes.push_back (field.count * pcl::getFieldSize (field.datatype));
+    fsize += fields_sizes.back ();
+    fields.push_back (field);
+  }
+
+  // Clamp the requested range of points
+  std::size_t range_begin = std::min<std::size_t> (first_point, total_points);
+  std::size_t range_end = range_begin + std::min<std::size_t> (nr_points, total_points - range_begin);
+  if (range_end - range_begin != total_points)
+  {
+    cloud.width = static_cast<uindex_t> (range_end - range_begin);
+    cloud.height = 1;
+    cloud.row_step = cloud.point_step * cloud.width;
+  }
+  cloud.data.resize ((range_end - range_begin) * cloud.point_step);
+  if (range_end == range_begin)
+    return (0);
+
+  // Only decompress the chunks that overlap the requested range
+  std::ptrdiff_t first_chunk = range_begin / chunk_size;
+  std::ptrdiff_t last_chunk = (range_end + chunk_size - 1) / chunk_size;
+  int nr_failed_chunks = 0;
+#pragma omp parallel for \
+  default(none) \
+  shared(map, cloud, chunk_sizes, chunk_offsets, fields, fields_sizes, fsize, chunk_size, total_points, range_begin, range_end, first_chunk, last_chunk) \
+  reduction(+:nr_failed_chunks) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 1)
+  for (std::ptrdiff_t c = first_chunk; c < last_chunk; ++c)
+  {
+    const std::size_t chunk_begin = c * static_cast<std::size_t> (chunk_size);
+    const std::size_t chunk_end = std::min<std::size_t> (chunk_begin + chunk_size, total_points);
+    const std::size_t nr_chunk_points = chunk_end - chunk_begin;
+    const unsigned int compressed_size = chunk_sizes[2 * c], uncompressed_size = chunk_sizes[2 * c + 1];
+    if (uncompressed_size != nr_chunk_points * fsize)
     {
-      for (uindex_t c = 0; c < cloud.fields[d].count; ++c)
+      ++nr_failed_chunks;
+      continue;
+    }
+
+    const auto *chunk_data = reinterpret_cast<const char*> (&map[chunk_offsets[c]]);
+    std::vector<char> buf;
+    if (compressed_size != 0)
+    {
+      buf.resize (uncompressed_size);
+      if (pcl::lzfDecompress (chunk_data, compressed_size, buf.data (), uncompressed_size) != uncompressed_size)
       {
-#define SET_CLOUD_DENSE(CASE_LABEL)                                                      \
-  case CASE_LABEL: {                                                                     \
-    if (!isValueFinite<pcl::traits::asType_t<(CASE_LABEL)>>(cloud, i, point_size, d, c)) \
-      cloud.is_dense = false;                                                            \
-    break;                                                                               \
-  }
-        switch (cloud.fields[d].datatype)
-        {
-          SET_CLOUD_DENSE(pcl::PCLPointField::BOOL)
-          SET_CLOUD_DENSE(pcl::PCLPointField::INT8)
-          SET_CLOUD_DENSE(pcl::PCLPointField::UINT8)
-          SET_CLOUD_DENSE(pcl::PCLPointField::INT16)
-          SET_CLOUD_DENSE(pcl::PCLPointField::UINT16)
-          SET_CLOUD_DENSE(pcl::PCLPointField::INT32)
-          SET_CLOUD_DENSE(pcl::PCLPointField::UINT32)
-          SET_CLOUD_DENSE(pcl::PCLPointField::INT64)
-          SET_CLOUD_DENSE(pcl::PCLPointField::UINT64)
-          SET_CLOUD_DENSE(pcl::PCLPointField::FLOAT32)
-          SET_CLOUD_DENSE(pcl::PCLPointField::FLOAT64)
-        }
-#undef SET_CLOUD_DENSE
+        ++nr_failed_chunks;
+        continue;
       }
+      chunk_data = buf.data ();
     }
+
+    // Unpack the xxyyzz planes of the chunk to xyz, only for the points inside the range
+    const std::size_t copy_begin = std::max (chunk_begin, range_begin);
+    const std::size_t copy_end = std::min (chunk_end, range_end);
+    std::size_t plane_offset = 0;
+    for (std::size_t j = 0; j < fields.size (); ++j)
+    {
+      const char *src = chunk_data + plane_offset + (copy_begin - chunk_begin) * fields_sizes[j];
+      for (std::size_t i = copy_begin; i < copy_end; ++i, src += fields_sizes[j])
+        memcpy (&cloud.data[(i - range_begin) * cloud.point_step + fields[j].offset], src, fields_sizes[j]);
+      plane_offset += nr_chunk_points * fields_sizes[j];
+    }
+  }
+
+  if (nr_failed_chunks != 0)
+  {
+    PCL_ERROR ("[pcl::PCDReader::readBodyBinaryChunked] Failed to decompress %d chunk(s). Data corruption?\n", nr_failed_chunks);
+    return (-1);
   }
 
+  // Extra checks (not needed for ASCII)
+  cloud.is_dense = isBinaryDataDense (cloud);
   return (0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDReader::readRange (const std::string &file_name, pcl::PCLPointCloud2 &cloud,
+                           uindex_t first_point, uindex_t nr_points, const int offset)
+{
+  std::ifstream fs;
+  fs.open (file_name.c_str (), std::ios::binary);
+  if (!fs.is_open () || fs.fail ())
+  {
+    PCL_ERROR ("[pcl::PCDReader::readRange] Could not open file '%s'.\n", file_name.c_str ());
+    return (-1);
+  }
+  fs.seekg (offset, std::ios::beg);
+
+  Eigen::Vector4f origin;
+  Eigen::Quaternionf orientation;
+  int pcd_version, data_type;
+  unsigned int data_idx;
+  if (parseHeader (fs, cloud, origin, orientation, pcd_version, data_type, data_idx) < 0)
+    return (-1);
+  fs.close ();
+
+  const std::size_t total_points = static_cast<std::size_t> (cloud.width) * cloud.height;
+  const std::size_t range_begin = std::min<std::size_t> (first_point, total_points);
+  const std::size_t range_size = std::min<std::size_t> (nr_points, total_points - range_begin);
+
+  // ASCII and BINARY_COMPRESSED bodies can only be decoded as a whole
+  if (data_type == 0 || data_type == 2)
+  {
+    if (read (file_name, cloud, offset) < 0)
+      return (-1);
+    if (range_size != total_points)
+    {
+      cloud.data.erase (cloud.data.begin () + (range_begin + range_size) * cloud.point_step, cloud.data.end ());
+      cloud.data.erase (cloud.data.begin (), cloud.data.begin () + range_begin * cloud.point_step);
+      cloud.width = static_cast<uindex_t> (range_size);
+      cloud.height = 1;
+      cloud.row_step = cloud.point_step * cloud.width;
+      cloud.is_dense = isBinaryDataDense (cloud);
+    }
+    return (0);
+  }
+
+  pcl::MappedFile file;
+  if (file.open (file_name) < 0)
+    return (-1);
+
+  if (data_type == 3)
+    return (readBodyBinaryChunked (file.data (), file.size (), cloud, offset + data_idx, first_point, nr_points));
+
+  const std::size_t body_offset = static_cast<std::size_t> (offset) + data_idx;
+  if (body_offset + total_points * cloud.point_step > file.size ())
+  {
+    PCL_ERROR ("[pcl::PCDReader::readRange] Corrupted PCD file. The file is smaller than expected!\n");
+    return (-1);
+  }
+  if (range_size != total_points)
+  {
+    cloud.width = static_cast<uindex_t> (range_size);
+    cloud.height = 1;
+    cloud.row_step = cloud.point_step * cloud.width;
+  }
+  cloud.data.resize (range_size * cloud.point_step);
+  if (!cloud.data.empty ())
+    memcpy (cloud.data.data (), file.data () + body_offset + range_begin * cloud.point_step, cloud.data.size ());
+  cloud.is_dense = isBinaryDataDense (cloud);
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PCDReader::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    num_threads_ = omp_get_num_procs ();
+  else
+    num_threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::PCDReader::setNumberOfThreads] Setting number of threads to %u.\n", num_threads_);
+#else
+  num_threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::PCDReader::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 int
 pcl::PCDReader::read (const std::string &file_name, pcl::PCLPointCloud2 &cloud,
@@ -767,6 +1015,11 @@ pcl::PCDReader::read (const std::string &file_name, pcl::PCLPointCloud2 &cloud,
       // Reset position
       io::raw_lseek (fd, 0, SEEK_SET);
     }
+    else if (data_type == 3)
+    {
+      // The chunk table is validated against the size of the map while decoding
+      mmap_size = file_size;
+    }
     else
     {
       mmap_size += cloud.data.size ();
@@ -804,7 +1057,10 @@ pcl::PCDReader::read (const std::string &file_name, pcl::PCLPointCloud2 &cloud,
     }
 #endif
 
-    res = readBodyBinary (map, cloud, pcd_version, data_type == 2, offset + data_idx);
+    if (data_type == 3)
+      res = readBodyBinaryChunked (map, mmap_size, cloud, offset + data_idx);
+    else
+      res = readBodyBinary (map, cloud, pcd_version, data_type == 2, offset + data_idx);
 
     // Unmap the pages of memory
 #ifdef _WIN32
@@ -1040,6 +1296,19 @@ pcl::PCDWriter::generateHeaderBinary (const pcl::PCLPointCloud2 &cloud,
   return (oss.str ());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+std::string
+pcl::PCDWriter::generateAlignmentPadding (std::size_t header_size) const
+{
+  std::size_t padding = (data_alignment_ - header_size % data_alignment_) % data_alignment_;
+  if (padding == 0)
+    return ("");
+  // A comment line needs at least two bytes: '#' and '\n'
+  if (padding == 1)
+    padding += data_alignment_;
+  return ("#" + std::string (padding - 2, ' ') + "\n");
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 int
 pcl::PCDWriter::generateHeaderBinaryCompressed (std::ostream &os,
@@ -1230,7 +1499,8 @@ pcl::PCDWriter::writeBinary (std::ostream &os, const pcl::PCLPointCloud2 &cloud,
   }
 
   os.imbue (std::locale::classic ());
-  os << generateHeaderBinary (cloud, origin, orientation) << "DATA binary\n";
+  const std::string header = generateHeaderBinary (cloud, origin, orientation);
+  os << header << generateAlignmentPadding (header.size () + 12) << "DATA binary\n";
   std::copy (cloud.data.cbegin(), cloud.data.cend(), std::ostream_iterator<char> (os));
   os.flush ();
 
@@ -1255,7 +1525,8 @@ pcl::PCDWriter::writeBinary (const std::string &file_name, const pcl::PCLPointCl
   std::ostringstream oss;
   oss.imbue (std::locale::classic ());
 
-  oss << generateHeaderBinary (cloud, origin, orientation) << "DATA binary\n";
+  const std::string header = generateHeaderBinary (cloud, origin, orientation);
+  oss << header << generateAlignmentPadding (header.size () + 12) << "DATA binary\n";
   oss.flush();
   const auto data_idx = static_cast<unsigned int> (oss.tellp ());
 
@@ -1468,6 +1739,144 @@ pcl::PCDWriter::writeBinaryCompressed (std::ostream &os, const pcl::PCLPointClou
   return (os ? 0 : -1);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDWriter::writeBinaryCompressedChunked (std::ostream &os, const pcl::PCLPointCloud2 &cloud,
+                                              const Eigen::Vector4f &origin, const Eigen::Quaternionf &orientation)
+{
+  if (cloud.data.empty ())
+  {
+    PCL_WARN ("[pcl::PCDWriter::writeBinaryCompressedChunked] Input point cloud has no data!\n");
+  }
+  if (cloud.fields.empty())
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryCompressedChunked] Input point cloud has no field data!\n");
+    return (-1);
+  }
+
+  if (generateHeaderBinaryCompressed (os, cloud, origin, orientation))
+  {
+    return (-1);
+  }
+
+  // Compute the total size of the fields
+  std::vector<pcl::PCLPointField> fields;
+  std::vector<std::size_t> fields_sizes;
+  std::size_t fsize = 0;
+  for (const auto &field : cloud.fields)
+  {
+    if (field.name == "_")
+      continue;
+    fields_sizes.push_back (field.count * pcl::getFieldSize (field.datatype));
+    fsize += fields_sizes.back ();
+    fields.push_back (field);
+  }
+
+  std::size_t nr_points = static_cast<std::size_t> (cloud.width) * cloud.height;
+  std::size_t chunk_size = chunk_size_;
+  // The sizes of each chunk are stored as 32 bit integers
+  if (chunk_size * fsize > std::numeric_limits<std::uint32_t>::max () / 2)
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryCompressedChunked] The chunk size (%zu points of %zu bytes) is too large!\n", chunk_size, fsize);
+    return (-1);
+  }
+  std::size_t nr_chunks = (nr_points + chunk_size - 1) / chunk_size;
+
+  std::vector<std::vector<char> > chunks (nr_chunks);
+  std::vector<std::uint32_t> chunk_sizes (2 * nr_chunks);
+
+  // Transpose and compress each chunk independently
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, chunks, chunk_sizes, fields, fields_sizes, fsize, nr_points, chunk_size, nr_chunks) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 1)
+  for (std::ptrdiff_t c = 0; c < static_cast<std::ptrdiff_t> (nr_chunks); ++c)
+  {
+    const std::size_t chunk_begin = c * chunk_size;
+    const std::size_t chunk_end = std::min (chunk_begin + chunk_size, nr_points);
+    const auto uncompressed_size = static_cast<unsigned int> ((chunk_end - chunk_begin) * fsize);
+
+    // Convert the XYZRGBXYZRGB structure to XXYYZZRGBRGB to aid compression
+    std::vector<char> only_valid_data (uncompressed_size);
+    char *dst = only_valid_data.data ();
+    for (std::size_t j = 0; j < fields.size (); ++j)
+    {
+      for (std::size_t i = chunk_begin; i < chunk_end; ++i, dst += fields_sizes[j])
+        memcpy (dst, &cloud.data[i * cloud.point_step + fields[j].offset], fields_sizes[j]);
+    }
+
+    // LZF expands incompressible data by less than 4%
+    std::vector<char> &compressed = chunks[c];
+    compressed.resize (uncompressed_size + uncompressed_size / 16 + 64);
+    unsigned int compressed_size = pcl::lzfCompress (only_valid_data.data (), uncompressed_size,
+                                                     compressed.data (), static_cast<unsigned int> (compressed.size ()));
+    if (compressed_size == 0 || compressed_size >= uncompressed_size)
+    {
+      // Store incompressible chunks as they are
+      compressed.swap (only_valid_data);
+      compressed_size = 0;
+    }
+    else
+      compressed.resize (compressed_size);
+    chunk_sizes[2 * c] = compressed_size;
+    chunk_sizes[2 * c + 1] = uncompressed_size;
+  }
+
+  os.imbue (std::locale::classic ());
+  os << "DATA binary_compressed_chunked\n";
+  const auto chunk_size_u32 = static_cast<std::uint32_t> (chunk_size);
+  const auto nr_chunks_u32 = static_cast<std::uint32_t> (nr_chunks);
+  os.write (reinterpret_cast<const char*> (&chunk_size_u32), 4);
+  os.write (reinterpret_cast<const char*> (&nr_chunks_u32), 4);
+  os.write (reinterpret_cast<const char*> (chunk_sizes.data ()), chunk_sizes.size () * 4);
+  for (const auto &chunk : chunks)
+    os.write (chunk.data (), chunk.size ());
+  os.flush ();
+
+  return (os ? 0 : -1);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDWriter::writeBinaryCompressedChunked (const std::string &file_name, const pcl::PCLPointCloud2 &cloud,
+                                              const Eigen::Vector4f &origin, const Eigen::Quaternionf &orientation)
+{
+  std::ofstream fs;
+  fs.open (file_name.c_str (), std::ios::binary);      // Open file
+  if (!fs.is_open () || fs.fail ())
+  {
+    PCL_ERROR ("[pcl::PCDWriter::writeBinaryCompressedChunked] Could not open file '%s' for writing! Error : %s\n", file_name.c_str (), strerror (errno));
+    return (-1);
+  }
+  // Mandatory lock file
+  boost::interprocess::file_lock file_lock;
+  setLockingPermissions (file_name, file_lock);
+
+  int res = writeBinaryCompressedChunked (fs, cloud, origin, orientation);
+
+  fs.close ();              // Close file
+  resetLockingPermissions (file_name, file_lock);
+  return (res);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PCDWriter::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    num_threads_ = omp_get_num_procs ();
+  else
+    num_threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::PCDWriter::setNumberOfThreads] Setting number of threads to %u.\n", num_threads_);
+#else
+  num_threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::PCDWriter::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 int
 pcl::PCDWriter::writeBinaryCompressed (const std::string &file_name, const pcl::PCLPointCloud2 &cloud,
@@ -0,0 +1,381 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/io/pcd_stream_reader.h>
+#include <pcl/console/print.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDStreamReader::open (const std::string &file_name, const int offset)
+{
+  close ();
+
+  // Open file in binary mode to avoid problem of
+  // std::getline() corrupting the result of ifstream::tellg()
+  fs_.open (file_name.c_str (), std::ios::binary);
+  if (!fs_.is_open () || fs_.fail ())
+  {
+    PCL_ERROR ("[pcl::PCDStreamReader::open] Could not open file '%s'! Error : %s\n", file_name.c_str (), strerror (errno));
+    close ();
+    return (-1);
+  }
+  fs_.seekg (offset, std::ios::beg);
+
+  int data_type = 0;
+  if (reader_.parseHeader (fs_, header_, origin_, orientation_, pcd_version_, data_type, data_idx_) < 0)
+  {
+    close ();
+    return (-1);
+  }
+
+  // ASCII and binary bodies are read sequentially from the stream
+  if (data_type == 0 || data_type == 1)
+  {
+    fs_.clear ();
+    fs_.seekg (data_idx_, std::ios::beg);
+    data_type_ = data_type;
+    return (0);
+  }
+
+  // Compressed bodies are accessed through a memory map, so that pages are
+  // only loaded when they are decompressed
+  fs_.close ();
+  if (file_.open (file_name) < 0)
+  {
+    close ();
+    return (-1);
+  }
+
+  // Both compressed bodies store one plane per field (xxyyzz), without padding
+  std::size_t fsize = 0;
+  for (const auto &field : header_.fields)
+  {
+    if (field.name == "_")
+      continue;
+    compressed_fields_.push_back (field);
+    fsize += field.count * pcl::getFieldSize (field.datatype);
+  }
+
+  if (data_type == 2)
+  {
+    unsigned int uncompressed_size = 0;
+    if (static_cast<std::size_t> (data_idx_) + 8 <= file_.size ())
+    {
+      memcpy (&compressed_size_, &file_.data ()[data_idx_ + 0], 4);
+      memcpy (&uncompressed_size, &file_.data ()[data_idx_ + 4], 4);
+    }
+    if (static_cast<std::size_t> (data_idx_) + 8 + compressed_size_ > file_.size ())
+    {
+      PCL_ERROR ("[pcl::PCDStreamReader::open] Corrupted PCD file. The file is smaller than expected!\n");
+      close ();
+      return (-1);
+    }
+    if (uncompressed_size != getNumberOfPoints () * fsize)
+    {
+      PCL_ERROR ("[pcl::PCDStreamReader::open] The saved uncompressed size (%u) does not match the number of points (%zu)! Data corruption?\n",
+                 uncompressed_size, getNumberOfPoints ());
+      close ();
+      return (-1);
+    }
+    // The decompressors of the planes are positioned by the first read
+  }
+  else
+  {
+    // The chunk size and the number of chunks, followed by the compressed and
+    // uncompressed size of every chunk
+    std::uint32_t nr_chunks = 0;
+    if (static_cast<std::size_t> (data_idx_) + 8 <= file_.size ())
+    {
+      memcpy (&chunk_size_, &file_.data ()[data_idx_ + 0], 4);
+      memcpy (&nr_chunks, &file_.data ()[data_idx_ + 4], 4);
+    }
+    const std::size_t nr_points = getNumberOfPoints ();
+    if ((chunk_size_ == 0 && nr_points != 0) ||
+        (chunk_size_ != 0 && nr_chunks != (nr_points + chunk_size_ - 1) / chunk_size_))
+    {
+      PCL_ERROR ("[pcl::PCDStreamReader::open] The chunk table (%u chunks of %u points) does not match the number of points (%zu)! Data corruption?\n",
+                 nr_chunks, chunk_size_, nr_points);
+      close ();
+      return (-1);
+    }
+    const std::size_t table_begin = static_cast<std::size_t> (data_idx_) + 8;
+    if (table_begin + 8 * static_cast<std::size_t> (nr_chunks) > file_.size ())
+    {
+      PCL_ERROR ("[pcl::PCDStreamReader::open] Corrupted PCD file. The file is smaller than expected!\n");
+      close ();
+      return (-1);
+    }
+    chunk_sizes_.resize (2 * static_cast<std::size_t> (nr_chunks));
+    if (!chunk_sizes_.empty ())
+      memcpy (chunk_sizes_.data (), &file_.data ()[table_begin], chunk_sizes_.size () * 4);
+
+    // Incompressible chunks are stored as they are, with a compressed size of 0
+    chunk_offsets_.assign (nr_chunks + 1, table_begin + chunk_sizes_.size () * 4);
+    for (std::size_t c = 0; c < nr_chunks; ++c)
+    {
+      const std::size_t chunk_points = std::min<std::size_t> (chunk_size_, nr_points - c * chunk_size_);
+      if (chunk_sizes_[2 * c + 1] != chunk_points * fsize)
+      {
+        PCL_ERROR ("[pcl::PCDStreamReader::open] The uncompressed size of chunk %zu (%u) does not match its number of points (%zu)! Data corruption?\n",
+                   c, chunk_sizes_[2 * c + 1], chunk_points);
+        close ();
+        return (-1);
+      }
+      chunk_offsets_[c + 1] = chunk_offsets_[c] + (chunk_sizes_[2 * c] != 0 ? chunk_sizes_[2 * c] : chunk_sizes_[2 * c + 1]);
+    }
+    if (chunk_offsets_.back () > file_.size ())
+    {
+      PCL_ERROR ("[pcl::PCDStreamReader::open] Corrupted PCD file. The file is smaller than expected!\n");
+      close ();
+      return (-1);
+    }
+  }
+
+  data_type_ = data_type;
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PCDStreamReader::close ()
+{
+  fs_.close ();
+  fs_.clear ();
+  file_.close ();
+  header_ = pcl::PCLPointCloud2 ();
+  data_type_ = -1;
+  points_read_ = 0;
+  compressed_fields_.clear ();
+  compressed_size_ = 0;
+  planes_.clear ();
+  chunk_size_ = 0;
+  std::vector<std::uint32_t> ().swap (chunk_sizes_);
+  std::vector<std::size_t> ().swap (chunk_offsets_);
+  cached_chunk_ = -1;
+  std::vector<unsigned char> ().swap (chunk_cache_);
+  std::vector<unsigned char> ().swap (next_chunk_cache_);
+  std::vector<unsigned char> ().swap (buffer_);
+  std::vector<unsigned char> ().swap (plane_buffer_);
+  blob_ = pcl::PCLPointCloud2 ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDStreamReader::read (pcl::PCLPointCloud2 &batch)
+{
+  if (!isOpen ())
+  {
+    PCL_ERROR ("[pcl::PCDStreamReader::read] No file is open!\n");
+    return (-1);
+  }
+
+  const auto nr_points = static_cast<uindex_t> (std::min<std::size_t> (batch_size_, getNumberOfPoints () - points_read_));
+
+  batch.header = header_.header;
+  batch.fields = header_.fields;
+  batch.is_bigendian = header_.is_bigendian;
+  batch.point_step = header_.point_step;
+  batch.width = nr_points;
+  batch.height = 1;
+  batch.row_step = batch.point_step * batch.width;
+  batch.is_dense = true;
+  batch.data.resize (static_cast<std::size_t> (nr_points) * batch.point_step);
+  if (nr_points == 0)
+    return (0);
+
+  int res = 0;
+  switch (data_type_)
+  {
+    case 0:
+    {
+      res = reader_.readBodyASCII (fs_, batch, pcd_version_);
+      break;
+    }
+    case 1:
+    {
+      buffer_.resize (batch.data.size ());
+      if (!fs_.read (reinterpret_cast<char*> (buffer_.data ()), buffer_.size ()))
+      {
+        PCL_ERROR ("[pcl::PCDStreamReader::read] Corrupted PCD file. The file is smaller than expected!\n");
+        return (-1);
+      }
+      res = reader_.readBodyBinary (buffer_.data (), batch, pcd_version_, false, 0);
+      break;
+    }
+    case 2:
+    {
+      res = readCompressedBatch (nr_points);
+      if (res == 0)
+        res = reader_.readBodyBinary (buffer_.data (), batch, pcd_version_, false, 0);
+      break;
+    }
+    case 3:
+    {
+      res = readChunkedBatch (nr_points);
+      if (res == 0)
+        res = reader_.readBodyBinary (buffer_.data (), batch, pcd_version_, false, 0);
+      break;
+    }
+  }
+  if (res < 0)
+    return (-1);
+
+  points_read_ += nr_points;
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDStreamReader::readCompressedBatch (uindex_t nr_points)
+{
+  buffer_.resize (static_cast<std::size_t> (nr_points) * header_.point_step);
+
+  // The first read positions the decompressor of every plane: the stream is decompressed
+  // up to the end of the first batch of a plane, then copied to continue the next plane
+  // after skipping the rest of this one
+  const bool position_planes = planes_.empty ();
+  if (position_planes)
+    planes_.emplace_back (&file_.data ()[data_idx_ + 8], compressed_size_);
+
+  // Unpack the next part of each xxyyzz plane to xyz
+  for (std::size_t j = 0; j < compressed_fields_.size (); ++j)
+  {
+    const std::size_t field_size = compressed_fields_[j].count * pcl::getFieldSize (compressed_fields_[j].datatype);
+    plane_buffer_.resize (nr_points * field_size);
+    if (planes_[j].decompress (plane_buffer_.data (), plane_buffer_.size ()) != plane_buffer_.size ())
+    {
+      PCL_ERROR ("[pcl::PCDStreamReader::read] Failed to decompress the field '%s'. Data corruption?\n", compressed_fields_[j].name.c_str ());
+      if (position_planes)
+        planes_.clear ();
+      return (-1);
+    }
+    for (uindex_t i = 0; i < nr_points; ++i)
+      memcpy (&buffer_[static_cast<std::size_t> (i) * header_.point_step + compressed_fields_[j].offset], &plane_buffer_[i * field_size], field_size);
+
+    if (position_planes && j + 1 < compressed_fields_.size ())
+    {
+      planes_.push_back (planes_[j]);
+      const std::size_t rest = (getNumberOfPoints () - nr_points) * field_size;
+      if (planes_.back ().decompress (nullptr, rest) != rest)
+      {
+        PCL_ERROR ("[pcl::PCDStreamReader::read] Failed to decompress the field '%s'. Data corruption?\n", compressed_fields_[j].name.c_str ());
+        planes_.clear ();
+        return (-1);
+      }
+    }
+  }
+  return (0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl::PCDStreamReader::readChunkedBatch (uindex_t nr_points)
+{
+  buffer_.resize (static_cast<std::size_t> (nr_points) * header_.point_step);
+
+  const std::size_t total_points = getNumberOfPoints ();
+  const std::size_t range_begin = points_read_;
+  const std::size_t range_end = points_read_ + nr_points;
+  const auto first_chunk = static_cast<std::ptrdiff_t> (range_begin / chunk_size_);
+  const auto last_chunk = static_cast<std::ptrdiff_t> ((range_end - 1) / chunk_size_);
+
+  // A batch which ends inside a compressed chunk keeps it decompressed, so that the next
+  // batch starts from the cache instead of decompressing the chunk again
+  const bool cache_last_chunk = last_chunk != cached_chunk_ && chunk_sizes_[2 * last_chunk] != 0 &&
+      range_end < std::min<std::size_t> ((last_chunk + 1) * static_cast<std::size_t> (chunk_size_), total_points);
+
+  int nr_failed_chunks = 0;
+#pragma omp parallel for \
+  default(none) \
+  shared(cache_last_chunk, first_chunk, last_chunk, range_begin, range_end, total_points) \
+  reduction(+:nr_failed_chunks) \
+  num_threads(reader_.getNumberOfThreads ()) \
+  schedule(dynamic, 1)
+  for (std::ptrdiff_t c = first_chunk; c <= last_chunk; ++c)
+  {
+    const std::size_t chunk_begin = c * static_cast<std::size_t> (chunk_size_);
+    const std::size_t nr_chunk_points = std::min<std::size_t> (chunk_size_, total_points - chunk_begin);
+    const std::uint32_t compressed_size = chunk_sizes_[2 * c], uncompressed_size = chunk_sizes_[2 * c + 1];
+
+    const unsigned char *chunk_data = &file_.data ()[chunk_offsets_[c]];
+    std::vector<unsigned char> buf;
+    if (c == cached_chunk_)
+      chunk_data = chunk_cache_.data ();
+    else if (compressed_size != 0)
+    {
+      std::vector<unsigned char> &out = (cache_last_chunk && c == last_chunk) ? next_chunk_cache_ : buf;
+      out.resize (uncompressed_size);
+      if (pcl::lzfDecompress (chunk_data, compressed_size, out.data (), uncompressed_size) != uncompressed_size)
+      {
+        ++nr_failed_chunks;
+        continue;
+      }
+      chunk_data = out.data ();
+    }
+
+    // Unpack the xxyyzz planes of the chunk to xyz, only for the points of the batch
+    const std::size_t copy_begin = std::max (chunk_begin, range_begin);
+    const std::size_t copy_end = std::min (chunk_begin + nr_chunk_points, range_end);
+    std::size_t plane_offset = 0;
+    for (const auto &field : compressed_fields_)
+    {
+      const std::size_t field_size = field.count * pcl::getFieldSize (field.datatype);
+      const unsigned char *src = chunk_data + plane_offset + (copy_begin - chunk_begin) * field_size;
+      for (std::size_t i = copy_begin; i < copy_end; ++i, src += field_size)
+        memcpy (&buffer_[(i - range_begin) * header_.point_step + field.offset], src, field_size);
+      plane_offset += nr_chunk_points * field_size;
+    }
+  }
+
+  if (nr_failed_chunks != 0)
+  {
+    PCL_ERROR ("[pcl::PCDStreamReader::read] Failed to decompress %d chunk(s). Data corruption?\n", nr_failed_chunks);
+    cached_chunk_ = -1;
+    return (-1);
+  }
+
+  if (cache_last_chunk)
+  {
+    chunk_cache_.swap (next_chunk_cache_);
+    cached_chunk_ = last_chunk;
+  }
+  return (0);
+}
@@ -154,6 +154,25 @@ knn_search(A& index, B& query, C& k_indices, D& dists, unsigned int k, F& params
   return index.knnSearch(query, k_indices_mat, dists, k, params);
 }
 
+template <class IndexT,
+          class A,
+          class B,
+          class C,
+          class D,
+          class F,
+          CompatWithFlann<IndexT> = true>
+int
+knn_search(A& index,
+           B& query,
+           C& k_indices,
+           D& dists,
+           unsigned int k,
+           F& params,
+           std::vector<std::size_t>& /*buffer*/)
+{
+  return knn_search<IndexT>(index, query, k_indices, dists, k, params);
+}
+
 template <class IndexT,
           class A,
           class B,
@@ -162,21 +181,41 @@ template <class IndexT,
           class F,
           NotCompatWithFlann<IndexT> = true>
 int
-knn_search(A& index, B& query, C& k_indices, D& dists, unsigned int k, F& params)
+knn_search(A& index,
+           B& query,
+           C& k_indices,
+           D& dists,
+           unsigned int k,
+           F& params,
+           std::vector<std::size_t>& buffer)
 {
-  std::vector<std::size_t> indices(k);
+  buffer.resize(k);
   k_indices.resize(k);
   // Wrap indices vector (no data allocation)
-  ::flann::Matrix<std::size_t> indices_mat(indices.data(), 1, k);
+  ::flann::Matrix<std::size_t> indices_mat(buffer.data(), 1, k);
   auto ret = index.knnSearch(query, indices_mat, dists, k, params);
   // cast appropriately
-  std::transform(indices.cbegin(),
-                 indices.cend(),
+  std::transform(buffer.cbegin(),
+                 buffer.cbegin() + k,
                  k_indices.begin(),
                  [](const auto& x) { return static_cast<pcl::index_t>(x); });
   return ret;
 }
 
+template <class IndexT,
+          class A,
+          class B,
+          class C,
+          class D,
+          class F,
+          NotCompatWithFlann<IndexT> = true>
+int
+knn_search(A& index, B& query, C& k_indices, D& dists, unsigned int k, F& params)
+{
+  std::vector<std::size_t> indices;
+  return knn_search<IndexT>(index, query, k_indices, dists, k, params, indices);
+}
+
 template <class IndexT, class A, class B, class F, CompatWithFlann<IndexT> = true>
 int
 knn_search(A& index,
@@ -235,6 +274,30 @@ template <typename PointT, typename Dist> int
 pcl::KdTreeFLANN<PointT, Dist>::nearestKSearch (const PointT &point, unsigned int k,
                                                 Indices &k_indices,
                                                 std::vector<float> &k_distances) const
+{
+  std::vector<float> query;
+  std::vector<std::size_t> index_buffer;
+  return (searchNearestK (point, k, k_indices, k_distances, query, index_buffer));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int
+pcl::KdTreeFLANN<PointT, Dist>::nearestKSearch (const PointT &point, unsigned int k,
+                                                SearchContext &context) const
+{
+  if (context.search_indices.empty ())
+    context.search_indices.resize (1);
+  return (searchNearestK (point, k, context.indices, context.sqr_distances,
+                          context.query, context.search_indices[0]));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int
+pcl::KdTreeFLANN<PointT, Dist>::searchNearestK (const PointT &point, unsigned int k,
+                                                Indices &k_indices,
+                                                std::vector<float> &k_distances,
+                                                std::vector<float> &query,
+                                                std::vector<std::size_t> &index_buffer) const
 {
   assert (point_representation_->isValid (point) && "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
 
@@ -247,18 +310,21 @@ pcl::KdTreeFLANN<PointT, Dist>::nearestKSearch (const PointT &point, unsigned in
   if (k==0)
     return 0;
 
-  std::vector<float> query (dim_);
-  point_representation_->vectorize (static_cast<PointT> (point), query);
+  query.resize (dim_);
+  point_representation_->vectorize (point, query);
 
   // Wrap the k_distances vector (no data copy)
   ::flann::Matrix<float> k_distances_mat (k_distances.data(), 1, k);
 
-  knn_search(*flann_index_,
-             ::flann::Matrix<float>(query.data(), 1, dim_),
-             k_indices,
-             k_distances_mat,
-             k,
-             param_k_);
+  auto query_mat = ::flann::Matrix<float>(query.data(), 1, dim_);
+
+  detail::knn_search<pcl::index_t>(*flann_index_,
+                                   query_mat,
+                                   k_indices,
+                                   k_distances_mat,
+                                   k,
+                                   param_k_,
+                                   index_buffer);
 
   // Do mapping to original point cloud
   if (!identity_mapping_)
@@ -285,11 +351,19 @@ template <class IndexT,
           class F,
           CompatWithFlann<IndexT> = true>
 int
-radius_search(A& index, B& query, C& k_indices, D& dists, float radius, F& params)
+radius_search(A& index,
+              B& query,
+              C& k_indices,
+              D& dists,
+              float radius,
+              F& params,
+              std::vector<std::vector<std::size_t>>& buffer)
 {
-  std::vector<pcl::Indices> indices(1);
-  int neighbors_in_radius = index.radiusSearch(query, indices, dists, radius, params);
-  k_indices = std::move(indices[0]);
+  // Lend the caller's buffer to flann so that its capacity is reused across calls
+  buffer.resize(1);
+  buffer[0].swap(k_indices);
+  int neighbors_in_radius = index.radiusSearch(query, buffer, dists, radius, params);
+  k_indices.swap(buffer[0]);
   return neighbors_in_radius;
 }
 
@@ -301,19 +375,33 @@ template <class IndexT,
           class F,
           NotCompatWithFlann<IndexT> = true>
 int
-radius_search(A& index, B& query, C& k_indices, D& dists, float radius, F& params)
+radius_search(A& index,
+              B& query,
+              C& k_indices,
+              D& dists,
+              float radius,
+              F& params,
+              std::vector<std::vector<std::size_t>>& buffer)
 {
-  std::vector<std::vector<std::size_t>> indices(1);
-  int neighbors_in_radius = index.radiusSearch(query, indices, dists, radius, params);
-  k_indices.resize(indices[0].size());
+  buffer.resize(1);
+  int neighbors_in_radius = index.radiusSearch(query, buffer, dists, radius, params);
+  k_indices.resize(buffer[0].size());
   // cast appropriately
-  std::transform(indices[0].cbegin(),
-                 indices[0].cend(),
+  std::transform(buffer[0].cbegin(),
+                 buffer[0].cend(),
                  k_indices.begin(),
                  [](const auto& x) { return static_cast<pcl::index_t>(x); });
   return neighbors_in_radius;
 }
 
+template <class IndexT, class A, class B, class C, class D, class F>
+int
+radius_search(A& index, B& query, C& k_indices, D& dists, float radius, F& params)
+{
+  std::vector<std::vector<std::size_t>> indices(1);
+  return radius_search<IndexT>(index, query, k_indices, dists, radius, params, indices);
+}
+
 template <class IndexT, class A, class B, class F, CompatWithFlann<IndexT> = true>
 int
 radius_search(A& index,
@@ -372,17 +460,43 @@ radius_search(const FlannIndex& index,
 template <typename PointT, typename Dist> int
 pcl::KdTreeFLANN<PointT, Dist>::radiusSearch (const PointT &point, double radius, Indices &k_indices,
                                               std::vector<float> &k_sqr_dists, unsigned int max_nn) const
+{
+  std::vector<float> query;
+  std::vector<std::vector<std::size_t> > search_indices;
+  std::vector<std::vector<float> > search_sqr_dists;
+  return (searchRadius (point, radius, k_indices, k_sqr_dists, max_nn,
+                        query, search_indices, search_sqr_dists));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int
+pcl::KdTreeFLANN<PointT, Dist>::radiusSearch (const PointT &point, double radius,
+                                              SearchContext &context, unsigned int max_nn) const
+{
+  return (searchRadius (point, radius, context.indices, context.sqr_distances, max_nn,
+                        context.query, context.search_indices, context.search_sqr_distances));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int
+pcl::KdTreeFLANN<PointT, Dist>::searchRadius (const PointT &point, double radius, Indices &k_indices,
+                                              std::vector<float> &k_sqr_dists, unsigned int max_nn,
+                                              std::vector<float> &query,
+                                              std::vector<std::vector<std::size_t> > &search_indices,
+                                              std::vector<std::vector<float> > &search_sqr_dists) const
 {
   assert (point_representation_->isValid (point) && "Invalid (NaN, Inf) point coordinates given to radiusSearch!");
 
-  std::vector<float> query (dim_);
-  point_representation_->vectorize (static_cast<PointT> (point), query);
+  query.resize (dim_);
+  point_representation_->vectorize (point, query);
 
   // Has max_nn been set properly?
   if (max_nn == 0 || max_nn > total_nr_points_)
     max_nn = total_nr_points_;
 
-  std::vector<std::vector<float> > dists(1);
+  // Lend the caller's distance buffer to flann instead of copying the result back
+  search_sqr_dists.resize (1);
+  search_sqr_dists[0].swap (k_sqr_dists);
 
   ::flann::SearchParams params (param_radius_);
   if (max_nn == total_nr_points_)
@@ -391,14 +505,15 @@ pcl::KdTreeFLANN<PointT, Dist>::radiusSearch (const PointT &point, double radius
     params.max_neighbors = max_nn;
 
   auto query_mat = ::flann::Matrix<float>(query.data(), 1, dim_);
-  int neighbors_in_radius = radius_search(*flann_index_,
-                                          query_mat,
-                                          k_indices,
-                                          dists,
-                                          static_cast<float>(radius * radius),
-                                          params);
-
-  k_sqr_dists = dists[0];
+  int neighbors_in_radius = detail::radius_search<pcl::index_t>(*flann_index_,
+                                                                query_mat,
+                                                                k_indices,
+                                                                search_sqr_dists,
+                                                                static_cast<float>(radius * radius),
+                                                                params,
+                                                                search_indices);
+
+  k_sqr_dists.swap (search_sqr_dists[0]);
 
   // Do mapping to original point cloud
   if (!identity_mapping_)
@@ -41,6 +41,7 @@
 #pragma once
 
 #include <pcl/kdtree/kdtree.h>
+#include <pcl/search_context.h>
 #include <flann/util/params.h>
 
 #include <memory>
@@ -259,7 +260,63 @@ public:
                std::vector<float>& k_sqr_distances,
                unsigned int max_nn = 0) const override;
 
+  /** \brief Search for k-nearest neighbors for the given query point, using the buffers
+   * of a search context. The results are stored in \a context.indices and
+   * \a context.sqr_distances.
+   *
+   * The query point and the indices found by FLANN go to the buffers of the context, so
+   * that the only allocations left are the ones of the result sets inside FLANN.
+   *
+   * \param[in] point a given \a valid (i.e., finite) query point
+   * \param[in] k the number of neighbors to search for
+   * \param[in,out] context the buffers of the calling thread
+   * \return number of neighbors found
+   */
+  int
+  nearestKSearch(const PointT& point, unsigned int k, SearchContext& context) const;
+
+  /** \brief Search for all the nearest neighbors of the query point in a given radius,
+   * using the buffers of a search context. The results are stored in
+   * \a context.indices and \a context.sqr_distances.
+   *
+   * The query point and the indices found by FLANN go to the buffers of the context, so
+   * that the only allocations left are the ones of the result sets inside FLANN.
+   *
+   * \param[in] point a given \a valid (i.e., finite) query point
+   * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+   * \param[in,out] context the buffers of the calling thread
+   * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+   * \return number of neighbors found in radius
+   */
+  int
+  radiusSearch(const PointT& point,
+               double radius,
+               SearchContext& context,
+               unsigned int max_nn = 0) const;
+
 private:
+  /** \brief Search for k-nearest neighbors, with the buffers for the query point and
+   * the indices found by FLANN given by the caller. */
+  int
+  searchNearestK(const PointT& point,
+                 unsigned int k,
+                 Indices& k_indices,
+                 std::vector<float>& k_sqr_distances,
+                 std::vector<float>& query,
+                 std::vector<std::size_t>& index_buffer) const;
+
+  /** \brief Search for the neighbors in a radius, with the buffers for the query point
+   * and the results of FLANN given by the caller. */
+  int
+  searchRadius(const PointT& point,
+               double radius,
+               Indices& k_indices,
+               std::vector<float>& k_sqr_distances,
+               unsigned int max_nn,
+               std::vector<float>& query,
+               std::vector<std::vector<std::size_t>>& search_indices,
+               std::vector<std::vector<float>>& search_sqr_distances) const;
+
   /** \brief Internal cleanup method. */
   void
   cleanup();
@@ -234,6 +234,7 @@ protected:
   using CorrespondenceEstimationBase<PointSource, PointTarget, Scalar>::
       tree_reciprocal_;
   using CorrespondenceEstimationBase<PointSource, PointTarget, Scalar>::target_;
+  using CorrespondenceEstimationBase<PointSource, PointTarget, Scalar>::num_threads_;
 
   /** \brief Internal computation initialization. */
   bool
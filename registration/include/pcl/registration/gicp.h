@@ -41,6 +41,7 @@
 #pragma once
 
 #include <pcl/registration/bfgs.h>
+#include <pcl/registration/gicp_covariances.h>
 #include <pcl/registration/icp.h>
 
 namespace pcl {
@@ -113,6 +114,11 @@ public:
   using MatricesVectorPtr = shared_ptr<MatricesVector>;
   using MatricesVectorConstPtr = shared_ptr<const MatricesVector>;
 
+  using SourceCovariances = pcl::registration::GICPCovariances<PointSource>;
+  using SourceCovariancesConstPtr = typename SourceCovariances::ConstPtr;
+  using TargetCovariances = pcl::registration::GICPCovariances<PointTarget>;
+  using TargetCovariancesConstPtr = typename TargetCovariances::ConstPtr;
+
   using InputKdTree = typename Registration<PointSource, PointTarget, Scalar>::KdTree;
   using InputKdTreePtr =
       typename Registration<PointSource, PointTarget, Scalar>::KdTreePtr;
@@ -172,6 +178,8 @@ public:
 
     pcl::IterativeClosestPoint<PointSource, PointTarget, Scalar>::setInputSource(cloud);
     input_covariances_.reset();
+    if (source_covariance_cache_ && source_covariance_cache_->getInputCloud() != cloud)
+      source_covariance_cache_.reset();
   }
 
   /** \brief Provide a pointer to the covariances of the input source (if computed
@@ -186,6 +194,17 @@ public:
     input_covariances_ = covariances;
   }
 
+  /** \brief Provide the precomputed covariances of the input source, e.g. the ones
+   * computed for the same cloud when it was the target of the previous registration.
+   * They are only used if they were computed for the cloud given to setInputSource.
+   * \param[in] covariances the input source covariances
+   */
+  inline void
+  setSourceCovarianceCache(const SourceCovariancesConstPtr& covariances)
+  {
+    source_covariance_cache_ = covariances;
+  }
+
   /** \brief Provide a pointer to the input target (e.g., the point cloud that we want
    * to align the input source to) \param[in] target the input point cloud target
    */
@@ -195,6 +214,8 @@ public:
     pcl::IterativeClosestPoint<PointSource, PointTarget, Scalar>::setInputTarget(
         target);
     target_covariances_.reset();
+    if (target_covariance_cache_ && target_covariance_cache_->getInputCloud() != target)
+      target_covariance_cache_.reset();
   }
 
   /** \brief Provide a pointer to the covariances of the input target (if computed
@@ -209,6 +230,17 @@ public:
     target_covariances_ = covariances;
   }
 
+  /** \brief Provide the precomputed covariances of the input target, e.g. the ones
+   * computed for the same cloud when it was the source of a previous registration.
+   * They are only used if they were computed for the cloud given to setInputTarget.
+   * \param[in] covariances the input target covariances
+   */
+  inline void
+  setTargetCovarianceCache(const TargetCovariancesConstPtr& covariances)
+  {
+    target_covariance_cache_ = covariances;
+  }
+
   /** \brief Estimate a rigid rotation transformation between a source and a target
    * point cloud using an iterative non-linear BFGS approach.
    * \param[in] cloud_src the source point cloud dataset
@@ -379,6 +411,14 @@ public:
   void
   setNumberOfThreads(unsigned int nr_threads = 0);
 
+  /** \brief Get the number of threads used for the covariances, the correspondences
+   * and the Newton optimization. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return threads_;
+  }
+
 protected:
   /** \brief The number of neighbors used for covariances computation.
    * default: 20
@@ -418,6 +458,14 @@ protected:
   /** \brief Target cloud points covariances. */
   MatricesVectorPtr target_covariances_;
 
+  /** \brief Precomputed input cloud points covariances, used instead of \ref
+   * input_covariances_ if set. */
+  SourceCovariancesConstPtr source_covariance_cache_;
+
+  /** \brief Precomputed target cloud points covariances, used instead of \ref
+   * target_covariances_ if set. */
+  TargetCovariancesConstPtr target_covariance_cache_;
+
   /** \brief Mahalanobis matrices holder. */
   std::vector<Eigen::Matrix3d> mahalanobis_;
 
@@ -442,6 +490,28 @@ protected:
                      const typename pcl::search::KdTree<PointT>::Ptr tree,
                      MatricesVector& cloud_covariances);
 
+  /** \brief Check the precomputed covariances, and drop the ones which do not belong
+   * to the current input source or target, or which were computed with another number
+   * of neighbors or epsilon. */
+  void
+  checkCovarianceCaches();
+
+  /** \brief Get the covariance of a point of the input source. */
+  inline Eigen::Matrix3d
+  getSourceCovariance(std::size_t index) const
+  {
+    return source_covariance_cache_ ? source_covariance_cache_->getCovariance(index)
+                                    : (*input_covariances_)[index];
+  }
+
+  /** \brief Get the covariance of a point of the input target. */
+  inline Eigen::Matrix3d
+  getTargetCovariance(std::size_t index) const
+  {
+    return target_covariance_cache_ ? target_covariance_cache_->getCovariance(index)
+                                    : (*target_covariances_)[index];
+  }
+
   /** \return trace of mat1 . mat2
    * \param mat1 matrix of dimension nxm
    * \param mat2 matrix of dimension mxp
@@ -0,0 +1,255 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/search/kdtree.h>
+#include <pcl/memory.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/types.h>
+
+#include <vector>
+
+namespace pcl {
+namespace registration {
+/** \brief Compute the regularized covariance GeneralizedIterativeClosestPoint uses for
+ * a point: the covariance of its neighbors keeps its principal directions, but its
+ * eigenvalues are replaced by (1, 1, epsilon), so that it describes the local plane.
+ * The smallest eigenvector is found with the closed form solver pcl::eigen33.
+ * \param[in] cloud the point cloud
+ * \param[in] point the query point, the neighbors are taken relative to it to avoid
+ * inaccuracies far away from the origin
+ * \param[in] nn_indices the indices of the neighbors of the query point in \a cloud
+ * \param[in] epsilon the eigenvalue in the direction of the plane normal
+ * \param[out] covariance the regularized covariance
+ * \ingroup registration
+ */
+template <typename PointT>
+void
+computeGICPCovariance(const pcl::PointCloud<PointT>& cloud,
+                      const PointT& point,
+                      const pcl::Indices& nn_indices,
+                      double epsilon,
+                      Eigen::Matrix3d& covariance);
+
+/** \brief GICPCovariances holds the regularized covariances of all points of a cloud,
+ * as used by GeneralizedIterativeClosestPoint.
+ *
+ * The covariances only depend on the cloud, so in scan to scan odometry they can be
+ * computed once per cloud and used first when the cloud is the target and then
+ * when it is the source of the next registration:
+ * \code
+ * auto covariances = pcl::make_shared<pcl::registration::GICPCovariances<PointT>>();
+ * covariances->setInputCloud(cloud);
+ * covariances->compute();
+ * gicp.setInputSource(previous_cloud);
+ * gicp.setSourceCovarianceCache(previous_covariances);
+ * gicp.setInputTarget(cloud);
+ * gicp.setTargetCovarianceCache(covariances);
+ * \endcode
+ *
+ * Each covariance is stored as the 6 floats of its upper triangle, in the order xx,
+ * xy, xz, yy, yz, zz, instead of an Eigen::Matrix3d.
+ *
+ * \ingroup registration
+ */
+template <typename PointT>
+class GICPCovariances {
+public:
+  using PointCloud = pcl::PointCloud<PointT>;
+  using PointCloudConstPtr = typename PointCloud::ConstPtr;
+
+  using KdTree = pcl::search::KdTree<PointT>;
+  using KdTreePtr = typename KdTree::Ptr;
+
+  using MatricesVector =
+      std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d>>;
+
+  using Ptr = shared_ptr<GICPCovariances<PointT>>;
+  using ConstPtr = shared_ptr<const GICPCovariances<PointT>>;
+
+  /** \brief Empty constructor. */
+  GICPCovariances() = default;
+
+  /** \brief Provide a pointer to the cloud, discarding any computed covariances.
+   * \param[in] cloud the input point cloud
+   */
+  inline void
+  setInputCloud(const PointCloudConstPtr& cloud)
+  {
+    cloud_ = cloud;
+    covariances_.clear();
+  }
+
+  /** \brief Get a pointer to the cloud. */
+  inline const PointCloudConstPtr&
+  getInputCloud() const
+  {
+    return cloud_;
+  }
+
+  /** \brief Provide a search object to find the neighbors of the points, e.g. one
+   * that already holds the cloud. A new one is created otherwise.
+   * \param[in] tree the search object
+   */
+  inline void
+  setSearchMethod(const KdTreePtr& tree)
+  {
+    tree_ = tree;
+  }
+
+  /** \brief Set the number of neighbors used for the covariance of a point.
+   * \param[in] k the number of neighbors, 20 by default
+   */
+  inline void
+  setKSearch(int k)
+  {
+    k_ = k;
+  }
+
+  /** \brief Get the number of neighbors used for the covariance of a point. */
+  inline int
+  getKSearch() const
+  {
+    return k_;
+  }
+
+  /** \brief Set the eigenvalue of the covariances in the direction of the normal.
+   * \param[in] epsilon the eigenvalue, 0.001 by default as in
+   * GeneralizedIterativeClosestPoint
+   */
+  inline void
+  setEpsilon(double epsilon)
+  {
+    epsilon_ = epsilon;
+  }
+
+  /** \brief Get the eigenvalue of the covariances in the direction of the normal. */
+  inline double
+  getEpsilon() const
+  {
+    return epsilon_;
+  }
+
+  /** \brief Set the number of threads to use.
+   * \param nr_threads the number of hardware threads to use (0 sets the value back to
+   * automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads = 0)
+  {
+#ifdef _OPENMP
+    num_threads_ = nr_threads != 0 ? nr_threads : omp_get_num_procs();
+#else
+    if (nr_threads != 1) {
+      PCL_WARN("OpenMP is not available. Keeping number of threads unchanged at 1\n");
+    }
+    num_threads_ = 1;
+#endif
+  }
+
+  /** \brief Compute the covariances of all points of the cloud.
+   * \return true on success, false if there is no cloud or it has less than
+   * getKSearch() points
+   */
+  bool
+  compute();
+
+  /** \brief Get the number of covariances, 0 before compute() was called. */
+  inline std::size_t
+  size() const
+  {
+    return covariances_.size() / 6;
+  }
+
+  /** \brief Whether no covariances were computed. */
+  inline bool
+  empty() const
+  {
+    return covariances_.empty();
+  }
+
+  /** \brief Get the covariance of a point.
+   * \param[in] index the index of the point in the cloud
+   */
+  inline Eigen::Matrix3d
+  getCovariance(std::size_t index) const
+  {
+    const float* c = &covariances_[6 * index];
+    Eigen::Matrix3d covariance;
+    covariance << c[0], c[1], c[2], c[1], c[3], c[4], c[2], c[4], c[5];
+    return covariance;
+  }
+
+  /** \brief Get the compact covariances, 6 floats per point in the order xx, xy, xz,
+   * yy, yz, zz. */
+  inline const float*
+  data() const
+  {
+    return covariances_.data();
+  }
+
+  /** \brief Expand the covariances into full matrices.
+   * \param[out] covariances the covariance of each point
+   */
+  void
+  getMatrices(MatricesVector& covariances) const;
+
+protected:
+  /** \brief The cloud the covariances belong to. */
+  PointCloudConstPtr cloud_;
+
+  /** \brief The search object used to find the neighbors. */
+  KdTreePtr tree_;
+
+  /** \brief The number of neighbors used for the covariance of a point. */
+  int k_{20};
+
+  /** \brief The eigenvalue of the covariances in the direction of the normal. */
+  double epsilon_{0.001};
+
+  /** \brief The number of threads the scheduler should use. */
+  unsigned int num_threads_{1};
+
+  /** \brief The compact covariances, 6 floats per point. */
+  std::vector<float> covariances_;
+};
+} // namespace registration
+} // namespace pcl
+
+#include <pcl/registration/impl/gicp_covariances.hpp>
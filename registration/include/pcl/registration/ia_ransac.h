@@ -44,6 +44,8 @@
 #include <pcl/registration/transformation_estimation_svd.h>
 #include <pcl/memory.h>
 
+#include <random>
+
 namespace pcl {
 /** \brief @b SampleConsensusInitialAlignment is an implementation of the initial
  * alignment algorithm described in section IV of "Fast Point Feature Histograms (FPFH)
@@ -67,6 +69,8 @@ public:
   using Registration<PointSource, PointTarget>::converged_;
   using Registration<PointSource, PointTarget>::getClassName;
 
+  using Matrix4 = typename Registration<PointSource, PointTarget>::Matrix4;
+
   using PointCloudSource =
       typename Registration<PointSource, PointTarget>::PointCloudSource;
   using PointCloudSourcePtr = typename PointCloudSource::Ptr;
@@ -254,7 +258,69 @@ public:
     return (error_functor_);
   }
 
+  /** \brief Set the number of threads used to generate and score the pose hypotheses.
+   * Every hypothesis draws its samples from its own random stream, seeded from the
+   * seed given in setSeed and the number of the hypothesis, so the result is the same
+   * for a given seed and any number of threads, including one. A hypothesis is no
+   * longer scored once its error exceeds the lowest error found by any thread.
+   * \note The transformation estimation must support concurrent calls, as the default
+   * TransformationEstimationSVD does.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value back
+   * to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads)
+  {
+#ifdef _OPENMP
+    num_threads_ = nr_threads != 0 ? nr_threads : omp_get_num_procs();
+#else
+    if (nr_threads != 1) {
+      PCL_WARN("OpenMP is not available. Keeping number of threads unchanged at 1\n");
+    }
+    num_threads_ = 1;
+#endif
+  }
+
+  /** \brief Get the number of threads used to generate and score the pose hypotheses.
+   */
+  unsigned int
+  getNumberOfThreads() const
+  {
+    return (num_threads_);
+  }
+
+  /** \brief Set the seed of the random streams of the pose hypotheses.
+   * \param[in] seed the seed
+   */
+  void
+  setSeed(unsigned int seed)
+  {
+    seed_ = seed;
+  }
+
+  /** \brief Get the seed of the random streams of the pose hypotheses. */
+  unsigned int
+  getSeed() const
+  {
+    return (seed_);
+  }
+
 protected:
+  /** \brief The random number generator of a single pose hypothesis. */
+  using HypothesisGenerator = std::minstd_rand;
+
+  /** \brief Choose a random index between 0 and n-1
+   * \param n the number of possible indices to choose from
+   * \param generator the random number generator of the current hypothesis
+   */
+  static inline pcl::index_t
+  getRandomIndex(int n, HypothesisGenerator& generator)
+  {
+    return (static_cast<pcl::index_t>(
+        n * (static_cast<double>(generator() - HypothesisGenerator::min()) /
+             (HypothesisGenerator::max() - HypothesisGenerator::min() + 1.0))));
+  };
+
   /** \brief Choose a random index between 0 and n-1
    * \param n the number of possible indices to choose from
    */
@@ -295,6 +361,50 @@ protected:
   float
   computeErrorMetric(const PointCloudSource& cloud, float threshold);
 
+  /** \brief Select \a nr_samples sample points from cloud for a single hypothesis,
+   * like selectSamples. If no valid sample can be found, the minimum distance is only
+   * relaxed for this hypothesis. \param cloud the input point cloud \param nr_samples
+   * the number of samples to select \param min_sample_distance the minimum distance
+   * between any two samples, relaxed on return if needed \param sample_indices the
+   * resulting sample indices \param generator the random number generator of the
+   * hypothesis
+   */
+  void
+  selectSamples(const PointCloudSource& cloud,
+                unsigned int nr_samples,
+                float& min_sample_distance,
+                pcl::Indices& sample_indices,
+                HypothesisGenerator& generator) const;
+
+  /** \brief Find the corresponding points of the samples of a single hypothesis, like
+   * findSimilarFeatures. \param input_features a cloud of feature descriptors \param
+   * sample_indices the indices of each sample point \param corresponding_indices the
+   * resulting indices of each sample's corresponding point in the target cloud \param
+   * generator the random number generator of the hypothesis
+   */
+  void
+  findSimilarFeatures(const FeatureCloud& input_features,
+                      const pcl::Indices& sample_indices,
+                      pcl::Indices& corresponding_indices,
+                      HypothesisGenerator& generator) const;
+
+  /** \brief Compute the error metric of the input cloud transformed by a pose
+   * hypothesis, stopping as soon as the error exceeds \a max_error.
+   * \param transformation the pose hypothesis
+   * \param max_error the error above which the hypothesis is not of interest anymore
+   * \return the error, or std::numeric_limits<float>::max () if it exceeds \a max_error
+   */
+  float
+  computeHypothesisError(const Matrix4& transformation, float max_error) const;
+
+  /** \brief Generate and score the pose hypotheses with num_threads_ threads (one or
+   * more).
+   * \param first_iteration the number of the first hypothesis to generate
+   * \param lowest_error the error of the best hypothesis so far, updated on return
+   */
+  void
+  computeHypotheses(int first_iteration, float& lowest_error);
+
   /** \brief Rigid transformation computation method.
    * \param output the transformed input point cloud dataset using the rigid
    * transformation found \param guess The computed transforamtion
@@ -324,6 +434,12 @@ protected:
 
   ErrorFunctorPtr error_functor_;
 
+  /** \brief The number of threads the scheduler should use. */
+  unsigned int num_threads_{1};
+
+  /** \brief The seed of the random streams of the pose hypotheses. */
+  unsigned int seed_{12345u};
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
 };
@@ -264,11 +264,14 @@ public:
   /** \brief Set the number of threads to use.
    * \param nr_threads the number of hardware threads to use (0 sets the value back to
    * automatic)
+   * \note The setting is passed on to the correspondence estimation and to the
+   * transformation estimation currently in use; call it again after replacing either.
    */
   void
   setNumberOfThreads(unsigned int nr_threads)
   {
     correspondence_estimation_->setNumberOfThreads(nr_threads);
+    transformation_estimation_->setNumberOfThreads(nr_threads);
   }
 
 protected:
@@ -140,6 +140,40 @@ pointCopyOrRef(typename pcl::PointCloud<PointSource>::ConstPtr& input, const Ind
   return pt;
 }
 
+/** \brief Merge the correspondences found by each thread into \a correspondences.
+ * Each thread only appends to its own vector, so no locking is needed while searching.
+ * With more than one thread the result is ordered by the query index.
+ */
+inline void
+mergeCorrespondences(std::vector<pcl::Correspondences>& per_thread_correspondences,
+                     pcl::Correspondences& correspondences)
+{
+  if (per_thread_correspondences.size() == 1) {
+    correspondences = std::move(per_thread_correspondences.front());
+    return;
+  }
+
+  const unsigned int nr_correspondences = std::accumulate(
+      per_thread_correspondences.begin(),
+      per_thread_correspondences.end(),
+      static_cast<unsigned int>(0),
+      [](const auto sum, const auto& corr) { return sum + corr.size(); });
+  correspondences.resize(nr_correspondences);
+
+  // Merge per-thread correspondences while keeping them ordered
+  auto insert_loc = correspondences.begin();
+  for (const auto& corrs : per_thread_correspondences) {
+    const auto new_insert_loc = std::move(corrs.begin(), corrs.end(), insert_loc);
+    std::inplace_merge(correspondences.begin(),
+                       insert_loc,
+                       insert_loc + corrs.size(),
+                       [](const auto& lhs, const auto& rhs) {
+                         return lhs.index_query < rhs.index_query;
+                       });
+    insert_loc = new_insert_loc;
+  }
+}
+
 } // namespace detail
 
 template <typename PointSource, typename PointTarget, typename Scalar>
@@ -190,30 +224,7 @@ CorrespondenceEstimation<PointSource, PointTarget, Scalar>::determineCorresponde
     per_thread_correspondences[thread_num].emplace_back(corr);
   }
 
-  if (num_threads_ == 1) {
-    correspondences = std::move(per_thread_correspondences.front());
-  }
-  else {
-    const unsigned int nr_correspondences = std::accumulate(
-        per_thread_correspondences.begin(),
-        per_thread_correspondences.end(),
-        static_cast<unsigned int>(0),
-        [](const auto sum, const auto& corr) { return sum + corr.size(); });
-    correspondences.resize(nr_correspondences);
-
-    // Merge per-thread correspondences while keeping them ordered
-    auto insert_loc = correspondences.begin();
-    for (const auto& corrs : per_thread_correspondences) {
-      const auto new_insert_loc = std::move(corrs.begin(), corrs.end(), insert_loc);
-      std::inplace_merge(correspondences.begin(),
-                         insert_loc,
-                         insert_loc + corrs.size(),
-                         [](const auto& lhs, const auto& rhs) {
-                           return lhs.index_query < rhs.index_query;
-                         });
-      insert_loc = new_insert_loc;
-    }
-  }
+  detail::mergeCorrespondences(per_thread_correspondences, correspondences);
   deinitCompute();
 }
 
@@ -282,30 +293,7 @@ CorrespondenceEstimation<PointSource, PointTarget, Scalar>::
     per_thread_correspondences[thread_num].emplace_back(corr);
   }
 
-  if (num_threads_ == 1) {
-    correspondences = std::move(per_thread_correspondences.front());
-  }
-  else {
-    const unsigned int nr_correspondences = std::accumulate(
-        per_thread_correspondences.begin(),
-        per_thread_correspondences.end(),
-        static_cast<unsigned int>(0),
-        [](const auto sum, const auto& corr) { return sum + corr.size(); });
-    correspondences.resize(nr_correspondences);
-
-    // Merge per-thread correspondences while keeping them ordered
-    auto insert_loc = correspondences.begin();
-    for (const auto& corrs : per_thread_correspondences) {
-      const auto new_insert_loc = std::move(corrs.begin(), corrs.end(), insert_loc);
-      std::inplace_merge(correspondences.begin(),
-                         insert_loc,
-                         insert_loc + corrs.size(),
-                         [](const auto& lhs, const auto& rhs) {
-                           return lhs.index_query < rhs.index_query;
-                         });
-      insert_loc = new_insert_loc;
-    }
-  }
+  detail::mergeCorrespondences(per_thread_correspondences, correspondences);
 
   deinitCompute();
 }
@@ -71,24 +71,26 @@ CorrespondenceEstimationBackProjection<PointSource, PointTarget, NormalT, Scalar
   if (!initCompute())
     return;
 
-  correspondences.resize(indices_->size());
-
   pcl::Indices nn_indices(k_);
   std::vector<float> nn_dists(k_);
+  std::vector<pcl::Correspondences> per_thread_correspondences(num_threads_);
+  for (auto& corrs : per_thread_correspondences) {
+    corrs.reserve(2 * indices_->size() / num_threads_);
+  }
 
-  int min_index = 0;
-
-  pcl::Correspondence corr;
-  unsigned int nr_valid_correspondences = 0;
-
+#pragma omp parallel for default(none)                                                 \
+    shared(max_distance, per_thread_correspondences) firstprivate(nn_indices, nn_dists) \
+        num_threads(num_threads_)
   // Iterate over the input set of source indices
-  for (const auto& idx_i : (*indices_)) {
+  for (int i = 0; i < static_cast<int>(indices_->size()); i++) {
+    const auto& idx_i = (*indices_)[i];
     const auto& pt = detail::pointCopyOrRef<PointTarget, PointSource>(input_, idx_i);
     tree_->nearestKSearch(pt, k_, nn_indices, nn_dists);
 
     // Among the K nearest neighbours find the one with minimum perpendicular distance
     // to the normal
     float min_dist = std::numeric_limits<float>::max();
+    int min_index = 0;
 
     // Find the best correspondence
     for (std::size_t j = 0; j < nn_indices.size(); j++) {
@@ -108,12 +110,21 @@ CorrespondenceEstimationBackProjection<PointSource, PointTarget, NormalT, Scalar
     if (min_dist > max_distance)
       continue;
 
+    pcl::Correspondence corr;
     corr.index_query = idx_i;
     corr.index_match = nn_indices[min_index];
     corr.distance = nn_dists[min_index]; // min_dist;
-    correspondences[nr_valid_correspondences++] = corr;
+
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+
+    per_thread_correspondences[thread_num].emplace_back(corr);
   }
-  correspondences.resize(nr_valid_correspondences);
+
+  detail::mergeCorrespondences(per_thread_correspondences, correspondences);
   deinitCompute();
 }
 
@@ -130,21 +141,22 @@ CorrespondenceEstimationBackProjection<PointSource, PointTarget, NormalT, Scalar
   if (!initComputeReciprocal())
     return;
 
-  correspondences.resize(indices_->size());
-
   pcl::Indices nn_indices(k_);
   std::vector<float> nn_dists(k_);
   pcl::Indices index_reciprocal(1);
   std::vector<float> distance_reciprocal(1);
+  std::vector<pcl::Correspondences> per_thread_correspondences(num_threads_);
+  for (auto& corrs : per_thread_correspondences) {
+    corrs.reserve(2 * indices_->size() / num_threads_);
+  }
 
-  int min_index = 0;
-
-  pcl::Correspondence corr;
-  unsigned int nr_valid_correspondences = 0;
-  int target_idx = 0;
-
+#pragma omp parallel for default(none)                                                 \
+    shared(max_distance, per_thread_correspondences)                                   \
+        firstprivate(nn_indices, nn_dists, index_reciprocal, distance_reciprocal)      \
+            num_threads(num_threads_)
   // Iterate over the input set of source indices
-  for (const auto& idx_i : (*indices_)) {
+  for (int i = 0; i < static_cast<int>(indices_->size()); i++) {
+    const auto& idx_i = (*indices_)[i];
     // Check if the template types are the same. If true, avoid a copy.
     // Both point types MUST be registered using the POINT_CLOUD_REGISTER_POINT_STRUCT
     // macro!
@@ -157,6 +169,7 @@ CorrespondenceEstimationBackProjection<PointSource, PointTarget, NormalT, Scalar
     // Among the K nearest neighbours find the one with minimum perpendicular distance
     // to the normal
     float min_dist = std::numeric_limits<float>::max();
+    int min_index = 0;
 
     // Find the best correspondence
     for (std::size_t j = 0; j < nn_indices.size(); j++) {
@@ -177,7 +190,7 @@ CorrespondenceEstimationBackProjection<PointSource, PointTarget, NormalT, Scalar
       continue;
 
     // Check if the correspondence is reciprocal
-    target_idx = nn_indices[min_index];
+    const auto target_idx = nn_indices[min_index];
     tree_reciprocal_->nearestKSearch(
         detail::pointCopyOrRef<PointSource, PointTarget>(target_, target_idx),
         1,
@@ -187,12 +200,21 @@ CorrespondenceEstimationBackProjection<PointSource, PointTarget, NormalT, Scalar
     if (idx_i != index_reciprocal[0])
       continue;
 
+    pcl::Correspondence corr;
     corr.index_query = idx_i;
     corr.index_match = nn_indices[min_index];
     corr.distance = nn_dists[min_index]; // min_dist;
-    correspondences[nr_valid_correspondences++] = corr;
+
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+
+    per_thread_correspondences[thread_num].emplace_back(corr);
   }
-  correspondences.resize(nr_valid_correspondences);
+
+  detail::mergeCorrespondences(per_thread_correspondences, correspondences);
   deinitCompute();
 }
 
@@ -71,19 +71,19 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
   if (!initCompute())
     return;
 
-  correspondences.resize(indices_->size());
-
   pcl::Indices nn_indices(k_);
   std::vector<float> nn_dists(k_);
+  std::vector<pcl::Correspondences> per_thread_correspondences(num_threads_);
+  for (auto& corrs : per_thread_correspondences) {
+    corrs.reserve(2 * indices_->size() / num_threads_);
+  }
 
-  int min_index = 0;
-
-  pcl::Correspondence corr;
-  unsigned int nr_valid_correspondences = 0;
-
-  PointTarget pt;
+#pragma omp parallel for default(none)                                                 \
+    shared(max_distance, per_thread_correspondences) firstprivate(nn_indices, nn_dists) \
+        num_threads(num_threads_)
   // Iterate over the input set of source indices
-  for (const auto& idx_i : (*indices_)) {
+  for (int i = 0; i < static_cast<int>(indices_->size()); i++) {
+    const auto& idx_i = (*indices_)[i];
     // Check if the template types are the same. If true, avoid a copy.
     // Both point types MUST be registered using the POINT_CLOUD_REGISTER_POINT_STRUCT
     // macro!
@@ -96,19 +96,19 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
     // Among the K nearest neighbours find the one with minimum perpendicular distance
     // to the normal
     double min_dist = std::numeric_limits<double>::max();
+    int min_index = 0;
+
+    const NormalT& normal = (*source_normals_)[idx_i];
+    const Eigen::Vector3d N(normal.normal_x, normal.normal_y, normal.normal_z);
 
     // Find the best correspondence
     for (std::size_t j = 0; j < nn_indices.size(); j++) {
       // computing the distance between a point and a line in 3d.
       // Reference - http://mathworld.wolfram.com/Point-LineDistance3-Dimensional.html
-      pt.x = (*target_)[nn_indices[j]].x - (*input_)[idx_i].x;
-      pt.y = (*target_)[nn_indices[j]].y - (*input_)[idx_i].y;
-      pt.z = (*target_)[nn_indices[j]].z - (*input_)[idx_i].z;
-
-      const NormalT& normal = (*source_normals_)[idx_i];
-      Eigen::Vector3d N(normal.normal_x, normal.normal_y, normal.normal_z);
-      Eigen::Vector3d V(pt.x, pt.y, pt.z);
-      Eigen::Vector3d C = N.cross(V);
+      const Eigen::Vector3d V((*target_)[nn_indices[j]].x - (*input_)[idx_i].x,
+                              (*target_)[nn_indices[j]].y - (*input_)[idx_i].y,
+                              (*target_)[nn_indices[j]].z - (*input_)[idx_i].z);
+      const Eigen::Vector3d C = N.cross(V);
 
       // Check if we have a better correspondence
       double dist = C.dot(C);
@@ -120,12 +120,21 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
     if (min_dist > max_distance)
       continue;
 
+    pcl::Correspondence corr;
     corr.index_query = idx_i;
     corr.index_match = nn_indices[min_index];
     corr.distance = nn_dists[min_index]; // min_dist;
-    correspondences[nr_valid_correspondences++] = corr;
+
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+
+    per_thread_correspondences[thread_num].emplace_back(corr);
   }
-  correspondences.resize(nr_valid_correspondences);
+
+  detail::mergeCorrespondences(per_thread_correspondences, correspondences);
   deinitCompute();
 }
 
@@ -143,22 +152,22 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
   if (!initComputeReciprocal())
     return;
 
-  correspondences.resize(indices_->size());
-
   pcl::Indices nn_indices(k_);
   std::vector<float> nn_dists(k_);
   pcl::Indices index_reciprocal(1);
   std::vector<float> distance_reciprocal(1);
+  std::vector<pcl::Correspondences> per_thread_correspondences(num_threads_);
+  for (auto& corrs : per_thread_correspondences) {
+    corrs.reserve(2 * indices_->size() / num_threads_);
+  }
 
-  int min_index = 0;
-
-  pcl::Correspondence corr;
-  unsigned int nr_valid_correspondences = 0;
-  int target_idx = 0;
-
-  PointTarget pt;
+#pragma omp parallel for default(none)                                                 \
+    shared(max_distance, per_thread_correspondences)                                   \
+        firstprivate(nn_indices, nn_dists, index_reciprocal, distance_reciprocal)      \
+            num_threads(num_threads_)
   // Iterate over the input set of source indices
-  for (const auto& idx_i : (*indices_)) {
+  for (int i = 0; i < static_cast<int>(indices_->size()); i++) {
+    const auto& idx_i = (*indices_)[i];
     // Check if the template types are the same. If true, avoid a copy.
     // Both point types MUST be registered using the POINT_CLOUD_REGISTER_POINT_STRUCT
     // macro!
@@ -171,19 +180,19 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
     // Among the K nearest neighbours find the one with minimum perpendicular distance
     // to the normal
     double min_dist = std::numeric_limits<double>::max();
+    int min_index = 0;
+
+    const NormalT& normal = (*source_normals_)[idx_i];
+    const Eigen::Vector3d N(normal.normal_x, normal.normal_y, normal.normal_z);
 
     // Find the best correspondence
     for (std::size_t j = 0; j < nn_indices.size(); j++) {
       // computing the distance between a point and a line in 3d.
       // Reference - http://mathworld.wolfram.com/Point-LineDistance3-Dimensional.html
-      pt.x = (*target_)[nn_indices[j]].x - (*input_)[idx_i].x;
-      pt.y = (*target_)[nn_indices[j]].y - (*input_)[idx_i].y;
-      pt.z = (*target_)[nn_indices[j]].z - (*input_)[idx_i].z;
-
-      const NormalT& normal = (*source_normals_)[idx_i];
-      Eigen::Vector3d N(normal.normal_x, normal.normal_y, normal.normal_z);
-      Eigen::Vector3d V(pt.x, pt.y, pt.z);
-      Eigen::Vector3d C = N.cross(V);
+      const Eigen::Vector3d V((*target_)[nn_indices[j]].x - (*input_)[idx_i].x,
+                              (*target_)[nn_indices[j]].y - (*input_)[idx_i].y,
+                              (*target_)[nn_indices[j]].z - (*input_)[idx_i].z);
+      const Eigen::Vector3d C = N.cross(V);
 
       // Check if we have a better correspondence
       double dist = C.dot(C);
@@ -196,7 +205,7 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
       continue;
 
     // Check if the correspondence is reciprocal
-    target_idx = nn_indices[min_index];
+    const auto target_idx = nn_indices[min_index];
     tree_reciprocal_->nearestKSearch(
         detail::pointCopyOrRef<PointSource, PointTarget>(target_, target_idx),
         1,
@@ -207,12 +216,21 @@ CorrespondenceEstimationNormalShooting<PointSource, PointTarget, NormalT, Scalar
       continue;
 
     // Correspondence IS reciprocal, save it and continue
+    pcl::Correspondence corr;
     corr.index_query = idx_i;
     corr.index_match = nn_indices[min_index];
     corr.distance = nn_dists[min_index]; // min_dist;
-    correspondences[nr_valid_correspondences++] = corr;
+
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+
+    per_thread_correspondences[thread_num].emplace_back(corr);
   }
-  correspondences.resize(nr_valid_correspondences);
+
+  detail::mergeCorrespondences(per_thread_correspondences, correspondences);
   deinitCompute();
 }
 
@@ -83,7 +83,6 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::computeCovar
     return;
   }
 
-  Eigen::Vector3d mean;
   Eigen::Matrix3d cov;
   pcl::Indices nn_indices(k_correspondences_);
   std::vector<float> nn_dist_sq(k_correspondences_);
@@ -93,63 +92,59 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::computeCovar
     cloud_covariances.resize(cloud->size());
 
 #pragma omp parallel for num_threads(threads_) schedule(dynamic, 32)                   \
-    shared(cloud, cloud_covariances) firstprivate(mean, cov, nn_indices, nn_dist_sq)
+    shared(cloud, cloud_covariances) firstprivate(cov, nn_indices, nn_dist_sq)
   for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(cloud->size()); ++i) {
     const PointT& query_point = (*cloud)[i];
-    // Zero out the cov and mean
-    cov.setZero();
-    mean.setZero();
 
     // Search for the K nearest neighbours
     kdtree->nearestKSearch(query_point, k_correspondences_, nn_indices, nn_dist_sq);
 
-    // Find the covariance matrix
-    for (int j = 0; j < k_correspondences_; j++) {
-      // de-mean neighbourhood to avoid inaccuracies when far away from origin
-      const double ptx = (*cloud)[nn_indices[j]].x - query_point.x,
-                   pty = (*cloud)[nn_indices[j]].y - query_point.y,
-                   ptz = (*cloud)[nn_indices[j]].z - query_point.z;
-
-      mean[0] += ptx;
-      mean[1] += pty;
-      mean[2] += ptz;
-
-      cov(0, 0) += ptx * ptx;
-
-      cov(1, 0) += pty * ptx;
-      cov(1, 1) += pty * pty;
-
-      cov(2, 0) += ptz * ptx;
-      cov(2, 1) += ptz * pty;
-      cov(2, 2) += ptz * ptz;
-    }
-
-    mean /= static_cast<double>(k_correspondences_);
-    // Get the actual covariance
-    for (int k = 0; k < 3; k++)
-      for (int l = 0; l <= k; l++) {
-        cov(k, l) /= static_cast<double>(k_correspondences_);
-        cov(k, l) -= mean[k] * mean[l];
-        cov(l, k) = cov(k, l);
-      }
-
-    // Compute the SVD (covariance matrix is symmetric so U = V')
-    Eigen::JacobiSVD<Eigen::Matrix3d> svd(cov, Eigen::ComputeFullU);
-    cov.setZero();
-    Eigen::Matrix3d U = svd.matrixU();
-    // Reconstitute the covariance matrix with modified singular values using the column
-    // // vectors in V.
-    for (int k = 0; k < 3; k++) {
-      Eigen::Vector3d col = U.col(k);
-      double v = 1.; // biggest 2 singular values replaced by 1
-      if (k == 2)    // smallest singular value replaced by gicp_epsilon
-        v = gicp_epsilon_;
-      cov.noalias() += v * col * col.transpose();
-    }
+    // Find the covariance matrix, with the eigenvalues replaced by (1, 1, epsilon)
+    pcl::registration::computeGICPCovariance(
+        *cloud, query_point, nn_indices, gicp_epsilon_, cov);
     cloud_covariances[i] = cov;
   }
 }
 
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+    checkCovarianceCaches()
+{
+  if (source_covariance_cache_ &&
+      (source_covariance_cache_->getInputCloud() != input_ ||
+       source_covariance_cache_->size() != input_->size())) {
+    PCL_WARN("[pcl::%s::computeTransformation] The source covariances were not "
+             "computed for the input source, ignoring them!\n",
+             getClassName().c_str());
+    source_covariance_cache_.reset();
+  }
+  else if (source_covariance_cache_ &&
+           (source_covariance_cache_->getKSearch() != k_correspondences_ ||
+            source_covariance_cache_->getEpsilon() != gicp_epsilon_)) {
+    PCL_WARN("[pcl::%s::computeTransformation] The source covariances were computed "
+             "with another number of neighbors or epsilon, ignoring them!\n",
+             getClassName().c_str());
+    source_covariance_cache_.reset();
+  }
+  if (target_covariance_cache_ &&
+      (target_covariance_cache_->getInputCloud() != target_ ||
+       target_covariance_cache_->size() != target_->size())) {
+    PCL_WARN("[pcl::%s::computeTransformation] The target covariances were not "
+             "computed for the input target, ignoring them!\n",
+             getClassName().c_str());
+    target_covariance_cache_.reset();
+  }
+  else if (target_covariance_cache_ &&
+           (target_covariance_cache_->getKSearch() != k_correspondences_ ||
+            target_covariance_cache_->getEpsilon() != gicp_epsilon_)) {
+    PCL_WARN("[pcl::%s::computeTransformation] The target covariances were computed "
+             "with another number of neighbors or epsilon, ignoring them!\n",
+             getClassName().c_str());
+    target_covariance_cache_.reset();
+  }
+}
+
 template <typename PointSource, typename PointTarget, typename Scalar>
 void
 GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::getRDerivatives(
@@ -484,16 +479,27 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
 {
   Matrix4 transformation_matrix = gicp_->base_transformation_;
   gicp_->applyState(transformation_matrix, x);
-  double f = 0;
-  int m = static_cast<int>(gicp_->tmp_idx_src_->size());
+  const Eigen::Matrix4f transformation_matrix_float =
+      transformation_matrix.template cast<float>();
+  // Per thread sums, added up in thread order afterwards so that the result does not
+  // depend on the scheduling
+  std::vector<double> thread_f(gicp_->threads_, 0.0);
+  const int m = static_cast<int>(gicp_->tmp_idx_src_->size());
+#pragma omp parallel for num_threads(gicp_->threads_) schedule(static)                 \
+    shared(thread_f, transformation_matrix_float)
   for (int i = 0; i < m; ++i) {
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
     // The last coordinate, p_src[3] is guaranteed to be set to 1.0 in registration.hpp
     Vector4fMapConst p_src =
         (*gicp_->tmp_src_)[(*gicp_->tmp_idx_src_)[i]].getVector4fMap();
     // The last coordinate, p_tgt[3] is guaranteed to be set to 1.0 in registration.hpp
     Vector4fMapConst p_tgt =
         (*gicp_->tmp_tgt_)[(*gicp_->tmp_idx_tgt_)[i]].getVector4fMap();
-    Eigen::Vector4f p_trans_src(transformation_matrix.template cast<float>() * p_src);
+    Eigen::Vector4f p_trans_src(transformation_matrix_float * p_src);
     // Estimate the distance (cost function)
     // The last coordinate is still guaranteed to be set to 1.0
     // The d here is the negative of the d in the paper
@@ -503,8 +509,11 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
     Eigen::Vector3d Md(gicp_->mahalanobis((*gicp_->tmp_idx_src_)[i]) * d);
     // increment= d'*Md/num_matches = d'*M*d/num_matches (we postpone
     // 1/num_matches after the loop closes)
-    f += static_cast<double>(d.transpose() * Md);
+    thread_f[thread_num] += static_cast<double>(d.transpose() * Md);
   }
+  double f = 0;
+  for (const auto partial_f : thread_f)
+    f += partial_f;
   return f / m;
 }
 
@@ -643,8 +652,29 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
   Eigen::Matrix3d hessian_rot_psi = Eigen::Matrix3d::Zero();
   Eigen::Matrix<double, 9, 6> hessian_rot_tmp = Eigen::Matrix<double, 9, 6>::Zero();
 
-  int m = static_cast<int>(gicp_->tmp_idx_src_->size());
+  // Per thread sums of the terms above, added up in thread order afterwards so that
+  // the result does not depend on the scheduling
+  struct PartialSums {
+    Eigen::Vector3d gradient = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d hessian = Eigen::Matrix3d::Zero();
+    Eigen::Matrix3d dCost_dR_T = Eigen::Matrix3d::Zero();
+    Eigen::Matrix3d dCost_dR_T1b = Eigen::Matrix3d::Zero();
+    Eigen::Matrix3d dCost_dR_T2b = Eigen::Matrix3d::Zero();
+    Eigen::Matrix3d dCost_dR_T3b = Eigen::Matrix3d::Zero();
+    Eigen::Matrix<double, 9, 6> hessian_rot_tmp = Eigen::Matrix<double, 9, 6>::Zero();
+  };
+  std::vector<PartialSums, Eigen::aligned_allocator<PartialSums>> thread_sums(
+      gicp_->threads_);
+
+  const int m = static_cast<int>(gicp_->tmp_idx_src_->size());
+#pragma omp parallel for num_threads(gicp_->threads_) schedule(static)                 \
+    shared(thread_sums, transformation_matrix_float, base_transformation_float)
   for (int i = 0; i < m; ++i) {
+#ifdef _OPENMP
+    PartialSums& sums = thread_sums[omp_get_thread_num()];
+#else
+    PartialSums& sums = thread_sums[0];
+#endif
     // The last coordinate, p_src[3] is guaranteed to be set to 1.0 in registration.hpp
     const auto& src_idx = (*gicp_->tmp_idx_src_)[i];
     Vector4fMapConst p_src = (*gicp_->tmp_src_)[src_idx].getVector4fMap();
@@ -658,16 +688,16 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
                             p_trans_src[1] - p_tgt[1],
                             p_trans_src[2] - p_tgt[2]);
     const Eigen::Matrix3d& M = gicp_->mahalanobis(src_idx);
-    const Eigen::Vector3d Md(M * d);    // Md = M*d
-    gradient.head<3>() += Md;           // translation gradient
-    hessian.topLeftCorner<3, 3>() += M; // translation-translation hessian
+    const Eigen::Vector3d Md(M * d); // Md = M*d
+    sums.gradient += Md;             // translation gradient
+    sums.hessian += M;               // translation-translation hessian
     p_trans_src.noalias() = base_transformation_float * p_src;
     const Eigen::Vector3d p_base_src(p_trans_src[0], p_trans_src[1], p_trans_src[2]);
-    dCost_dR_T.noalias() += p_base_src * Md.transpose();
-    dCost_dR_T1b += p_base_src[0] * M;
-    dCost_dR_T2b += p_base_src[1] * M;
-    dCost_dR_T3b += p_base_src[2] * M;
-    hessian_rot_tmp.noalias() +=
+    sums.dCost_dR_T.noalias() += p_base_src * Md.transpose();
+    sums.dCost_dR_T1b += p_base_src[0] * M;
+    sums.dCost_dR_T2b += p_base_src[1] * M;
+    sums.dCost_dR_T3b += p_base_src[2] * M;
+    sums.hessian_rot_tmp.noalias() +=
         Eigen::Map<const Eigen::Matrix<double, 9, 1>>{M.data()} *
         (Eigen::Matrix<double, 1, 6>() << p_base_src[0] * p_base_src[0],
          p_base_src[0] * p_base_src[1],
@@ -677,6 +707,15 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
          p_base_src[2] * p_base_src[2])
             .finished();
   }
+  for (const auto& sums : thread_sums) {
+    gradient.head<3>() += sums.gradient;
+    hessian.topLeftCorner<3, 3>() += sums.hessian;
+    dCost_dR_T += sums.dCost_dR_T;
+    dCost_dR_T1b += sums.dCost_dR_T1b;
+    dCost_dR_T2b += sums.dCost_dR_T2b;
+    dCost_dR_T3b += sums.dCost_dR_T3b;
+    hessian_rot_tmp += sums.hessian_rot_tmp;
+  }
   gradient.head<3>() *= 2.0 / m; // translation gradient
   dCost_dR_T *= 2.0 / m;
   gicp_->computeRDerivative(x, dCost_dR_T, gradient); // rotation gradient
@@ -776,13 +815,16 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
   const std::size_t N = indices_->size();
   // Set the mahalanobis matrices to identity
   mahalanobis_.resize(N, Eigen::Matrix3d::Identity());
+  checkCovarianceCaches();
   // Compute target cloud covariance matrices
-  if ((!target_covariances_) || (target_covariances_->empty())) {
+  if (!target_covariance_cache_ &&
+      ((!target_covariances_) || (target_covariances_->empty()))) {
     target_covariances_.reset(new MatricesVector);
     computeCovariances<PointTarget>(target_, tree_, *target_covariances_);
   }
   // Compute input cloud covariance matrices
-  if ((!input_covariances_) || (input_covariances_->empty())) {
+  if (!source_covariance_cache_ &&
+      ((!input_covariances_) || (input_covariances_->empty()))) {
     input_covariances_.reset(new MatricesVector);
     computeCovariances<PointSource>(input_, tree_reciprocal_, *input_covariances_);
   }
@@ -828,8 +870,8 @@ GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
     for (const auto& corr : correspondences) {
       source_indices[cnt] = corr.index_query;
       target_indices[cnt] = corr.index_match;
-      const Eigen::Matrix3d& C1 = (*input_covariances_)[corr.index_query];
-      const Eigen::Matrix3d& C2 = (*target_covariances_)[corr.index_match];
+      const Eigen::Matrix3d C1 = getSourceCovariance(corr.index_query);
+      const Eigen::Matrix3d C2 = getTargetCovariance(corr.index_match);
       pcl::invert3x3SymMatrix<Eigen::Matrix3d>(R * C1 * R.transpose() + C2,
                                                mahalanobis_[corr.index_query]);
       ++cnt;
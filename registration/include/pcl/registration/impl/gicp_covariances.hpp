@@ -0,0 +1,154 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_GICP_COVARIANCES_HPP_
+#define PCL_REGISTRATION_IMPL_GICP_COVARIANCES_HPP_
+
+#include <pcl/common/eigen.h> // for eigen33
+
+namespace pcl {
+namespace registration {
+
+template <typename PointT>
+void
+computeGICPCovariance(const pcl::PointCloud<PointT>& cloud,
+                      const PointT& point,
+                      const pcl::Indices& nn_indices,
+                      double epsilon,
+                      Eigen::Matrix3d& covariance)
+{
+  Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+  for (const auto& nn_index : nn_indices) {
+    // de-mean neighbourhood to avoid inaccuracies when far away from origin
+    const double ptx = cloud[nn_index].x - point.x,
+                 pty = cloud[nn_index].y - point.y,
+                 ptz = cloud[nn_index].z - point.z;
+
+    mean[0] += ptx;
+    mean[1] += pty;
+    mean[2] += ptz;
+
+    cov(0, 0) += ptx * ptx;
+
+    cov(1, 0) += pty * ptx;
+    cov(1, 1) += pty * pty;
+
+    cov(2, 0) += ptz * ptx;
+    cov(2, 1) += ptz * pty;
+    cov(2, 2) += ptz * ptz;
+  }
+
+  const double nr_neighbors = static_cast<double>(nn_indices.size());
+  mean /= nr_neighbors;
+  // Get the actual covariance
+  for (int k = 0; k < 3; k++)
+    for (int l = 0; l <= k; l++) {
+      cov(k, l) /= nr_neighbors;
+      cov(k, l) -= mean[k] * mean[l];
+      cov(l, k) = cov(k, l);
+    }
+
+  // Replacing the two largest eigenvalues by 1 and the smallest one by epsilon gives
+  // I - (1 - epsilon) * n * n', with n the eigenvector of the smallest eigenvalue
+  double eigenvalue;
+  Eigen::Vector3d normal;
+  pcl::eigen33(cov, eigenvalue, normal);
+  covariance.setIdentity();
+  covariance.noalias() -= (1.0 - epsilon) * normal * normal.transpose();
+}
+
+template <typename PointT>
+bool
+GICPCovariances<PointT>::compute()
+{
+  covariances_.clear();
+  if (!cloud_) {
+    PCL_ERROR("[pcl::registration::GICPCovariances::compute] No input cloud was "
+              "given!\n");
+    return false;
+  }
+  if (k_ > static_cast<int>(cloud_->size())) {
+    PCL_ERROR("[pcl::registration::GICPCovariances::compute] Number of points in "
+              "cloud (%zu) is less than k (%d)!\n",
+              static_cast<std::size_t>(cloud_->size()),
+              k_);
+    return false;
+  }
+
+  if (!tree_)
+    tree_.reset(new KdTree);
+  if (tree_->getInputCloud() != cloud_)
+    tree_->setInputCloud(cloud_);
+
+  covariances_.resize(6 * cloud_->size());
+#pragma omp parallel num_threads(num_threads_)
+  {
+    pcl::Indices nn_indices(k_);
+    std::vector<float> nn_dist_sq(k_);
+    Eigen::Matrix3d cov;
+#pragma omp for schedule(dynamic, 256)
+    for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(cloud_->size()); ++i) {
+      const PointT& query_point = (*cloud_)[i];
+      tree_->nearestKSearch(query_point, k_, nn_indices, nn_dist_sq);
+      computeGICPCovariance(*cloud_, query_point, nn_indices, epsilon_, cov);
+
+      float* c = &covariances_[6 * i];
+      c[0] = static_cast<float>(cov(0, 0));
+      c[1] = static_cast<float>(cov(0, 1));
+      c[2] = static_cast<float>(cov(0, 2));
+      c[3] = static_cast<float>(cov(1, 1));
+      c[4] = static_cast<float>(cov(1, 2));
+      c[5] = static_cast<float>(cov(2, 2));
+    }
+  }
+  return true;
+}
+
+template <typename PointT>
+void
+GICPCovariances<PointT>::getMatrices(MatricesVector& covariances) const
+{
+  covariances.resize(size());
+  for (std::size_t i = 0; i < covariances.size(); ++i)
+    covariances[i] = getCovariance(i);
+}
+
+} // namespace registration
+} // namespace pcl
+
+#endif // PCL_REGISTRATION_IMPL_GICP_COVARIANCES_HPP_
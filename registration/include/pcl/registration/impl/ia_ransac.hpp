@@ -42,6 +42,7 @@
 #define IA_RANSAC_HPP_
 
 #include <pcl/common/distances.h>
+#include <pcl/common/transforms.h>
 
 namespace pcl {
 
@@ -183,6 +184,191 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::computeErro
   return (error);
 }
 
+template <typename PointSource, typename PointTarget, typename FeatureT>
+void
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::selectSamples(
+    const PointCloudSource& cloud,
+    unsigned int nr_samples,
+    float& min_sample_distance,
+    pcl::Indices& sample_indices,
+    HypothesisGenerator& generator) const
+{
+  // Iteratively draw random samples until nr_samples is reached
+  std::size_t iterations_without_a_sample = 0;
+  const auto max_iterations_without_a_sample = 3 * cloud.size();
+  sample_indices.clear();
+  while (sample_indices.size() < nr_samples) {
+    // Choose a sample at random
+    const auto sample_index = getRandomIndex(static_cast<int>(cloud.size()), generator);
+
+    // Check to see if the sample is 1) unique and 2) far away from the other samples
+    bool valid_sample = true;
+    for (const auto& sample_idx : sample_indices) {
+      if (sample_index == sample_idx ||
+          euclideanDistance(cloud[sample_index], cloud[sample_idx]) <
+              min_sample_distance) {
+        valid_sample = false;
+        break;
+      }
+    }
+
+    // If the sample is valid, add it to the output
+    if (valid_sample) {
+      sample_indices.push_back(sample_index);
+      iterations_without_a_sample = 0;
+    }
+    else
+      ++iterations_without_a_sample;
+
+    // If no valid samples can be found, relax the inter-sample distance requirements
+    if (iterations_without_a_sample >= max_iterations_without_a_sample) {
+      min_sample_distance *= 0.5f;
+      iterations_without_a_sample = 0;
+    }
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+void
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
+    findSimilarFeatures(const FeatureCloud& input_features,
+                        const pcl::Indices& sample_indices,
+                        pcl::Indices& corresponding_indices,
+                        HypothesisGenerator& generator) const
+{
+  pcl::Indices nn_indices(k_correspondences_);
+  std::vector<float> nn_distances(k_correspondences_);
+
+  corresponding_indices.resize(sample_indices.size());
+  for (std::size_t i = 0; i < sample_indices.size(); ++i) {
+    // Find the k features nearest to input_features[sample_indices[i]]
+    feature_tree_->nearestKSearch(input_features,
+                                  sample_indices[i],
+                                  k_correspondences_,
+                                  nn_indices,
+                                  nn_distances);
+
+    // Select one at random and add it to corresponding_indices
+    corresponding_indices[i] =
+        nn_indices[getRandomIndex(k_correspondences_, generator)];
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+float
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
+    computeHypothesisError(const Matrix4& transformation, float max_error) const
+{
+  pcl::Indices nn_index(1);
+  std::vector<float> nn_distance(1);
+
+  const ErrorFunctor& compute_error = *error_functor_;
+  const Eigen::Affine3f transform(transformation);
+  float error = 0;
+
+  for (const auto& point : *input_) {
+    // Find the distance between the transformed point and its nearest neighbor in the
+    // target point cloud
+    tree_->nearestKSearch(
+        pcl::transformPoint(point, transform), 1, nn_index, nn_distance);
+
+    // Compute the error, and stop once the hypothesis can not be the best one anymore
+    error += compute_error(nn_distance[0]);
+    if (error > max_error)
+      return (std::numeric_limits<float>::max());
+  }
+  return (error);
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+void
+SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
+    computeHypotheses(int first_iteration, float& lowest_error)
+{
+  // The best hypothesis of each thread as its error and number (-1 for none), and its
+  // transformation. The hypotheses are compared by error first and number second, so
+  // the result does not depend on how they are distributed over the threads.
+  std::vector<std::pair<float, int>> best_hypotheses(num_threads_,
+                                                     std::make_pair(lowest_error, -1));
+  std::vector<Matrix4, Eigen::aligned_allocator<Matrix4>> best_transformations(
+      num_threads_, Matrix4::Identity());
+  // The lowest error found by any thread, used to stop scoring worse hypotheses early
+  float shared_lowest_error = lowest_error;
+  unsigned int nr_relaxed = 0;
+
+#pragma omp parallel num_threads(num_threads_) reduction(+ : nr_relaxed)
+  {
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+    pcl::Indices sample_indices(nr_samples_);
+    pcl::Indices corresponding_indices(nr_samples_);
+    Matrix4 transformation;
+
+#pragma omp for schedule(dynamic)
+    for (int i_iter = first_iteration; i_iter < max_iterations_; ++i_iter) {
+      // Every hypothesis draws from its own random stream
+      std::seed_seq seed_sequence{seed_, static_cast<unsigned int>(i_iter)};
+      HypothesisGenerator generator(seed_sequence);
+
+      // Draw nr_samples_ random samples
+      float min_sample_distance = min_sample_distance_;
+      selectSamples(
+          *input_, nr_samples_, min_sample_distance, sample_indices, generator);
+      if (min_sample_distance < min_sample_distance_)
+        ++nr_relaxed;
+
+      // Find corresponding features in the target cloud
+      findSimilarFeatures(
+          *input_features_, sample_indices, corresponding_indices, generator);
+
+      // Estimate the transform from the samples to their corresponding points
+      transformation_estimation_->estimateRigidTransformation(
+          *input_, sample_indices, *target_, corresponding_indices, transformation);
+
+      float max_error;
+#pragma omp atomic read
+      max_error = shared_lowest_error;
+      const float error = computeHypothesisError(transformation, max_error);
+
+      // Each thread handles its hypotheses in increasing order, so the first one with
+      // the lowest error is kept
+      auto& best_hypothesis = best_hypotheses[thread_num];
+      if (error < best_hypothesis.first) {
+        best_hypothesis = std::make_pair(error, i_iter);
+        best_transformations[thread_num] = transformation;
+#pragma omp critical(pcl_sac_ia_lowest_error)
+        if (error < shared_lowest_error) {
+#pragma omp atomic write
+          shared_lowest_error = error;
+        }
+      }
+    }
+  }
+
+  int best_thread = -1;
+  for (int thread_num = 0; thread_num < static_cast<int>(num_threads_); ++thread_num) {
+    const auto& hypothesis = best_hypotheses[thread_num];
+    if (hypothesis.second < 0)
+      continue;
+    if (best_thread < 0 || hypothesis < best_hypotheses[best_thread])
+      best_thread = thread_num;
+  }
+  if (best_thread >= 0) {
+    lowest_error = best_hypotheses[best_thread].first;
+    final_transformation_ = best_transformations[best_thread];
+    converged_ = true;
+  }
+
+  if (nr_relaxed != 0) {
+    PCL_WARN("[pcl::%s::computeTransformation] ", getClassName().c_str());
+    PCL_WARN("The minimum sample distance had to be relaxed for %u hypotheses.\n",
+             nr_relaxed);
+  }
+}
+
 template <typename PointSource, typename PointTarget, typename FeatureT>
 void
 SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
@@ -223,10 +409,8 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
   if (!error_functor_)
     error_functor_.reset(new TruncatedError(static_cast<float>(corr_dist_threshold_)));
 
-  pcl::Indices sample_indices(nr_samples_);
-  pcl::Indices corresponding_indices(nr_samples_);
   PointCloudSource input_transformed;
-  float lowest_error(0);
+  float lowest_error = std::numeric_limits<float>::max();
 
   final_transformation_ = guess;
   int i_iter = 0;
@@ -239,29 +423,10 @@ SampleConsensusInitialAlignment<PointSource, PointTarget, FeatureT>::
     i_iter = 1;
   }
 
-  for (; i_iter < max_iterations_; ++i_iter) {
-    // Draw nr_samples_ random samples
-    selectSamples(*input_, nr_samples_, min_sample_distance_, sample_indices);
-
-    // Find corresponding features in the target cloud
-    findSimilarFeatures(*input_features_, sample_indices, corresponding_indices);
-
-    // Estimate the transform from the samples to their corresponding points
-    transformation_estimation_->estimateRigidTransformation(
-        *input_, sample_indices, *target_, corresponding_indices, transformation_);
-
-    // Transform the data and compute the error
-    transformPointCloud(*input_, input_transformed, transformation_);
-    float error =
-        computeErrorMetric(input_transformed, static_cast<float>(corr_dist_threshold_));
-
-    // If the new error is lower, update the final transformation
-    if (i_iter == 0 || error < lowest_error) {
-      lowest_error = error;
-      final_transformation_ = transformation_;
-      converged_ = true;
-    }
-  }
+  // The hypotheses are drawn from the seeded random streams for any number of
+  // threads, including one, so the result only depends on the seed. Unless the guess
+  // was checked, the first hypothesis is accepted whatever its error.
+  computeHypotheses(i_iter, lowest_error);
 
   // Apply the final transformation
   transformPointCloud(*input_, output, final_transformation_);
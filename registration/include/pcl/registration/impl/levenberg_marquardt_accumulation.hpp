@@ -0,0 +1,296 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_LEVENBERG_MARQUARDT_ACCUMULATION_HPP_
+#define PCL_REGISTRATION_IMPL_LEVENBERG_MARQUARDT_ACCUMULATION_HPP_
+
+#include <pcl/memory.h>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace pcl {
+namespace registration {
+namespace detail {
+
+/** \brief Warp a point with a transformation matrix, exactly like
+ * WarpPointRigid::warpPoint does with its current transformation.
+ * \param[in] transform the transformation matrix
+ * \param[in] pnt_in the point to warp (transform)
+ * \param[out] pnt_out the warped (transformed) point
+ */
+template <typename PointT, typename Scalar>
+inline void
+warpPoint(const Eigen::Matrix<Scalar, 4, 4>& transform,
+          const PointT& pnt_in,
+          Eigen::Matrix<Scalar, 4, 1>& pnt_out)
+{
+  pnt_out[0] = static_cast<Scalar>(transform(0, 0) * pnt_in.x +
+                                   transform(0, 1) * pnt_in.y +
+                                   transform(0, 2) * pnt_in.z + transform(0, 3));
+  pnt_out[1] = static_cast<Scalar>(transform(1, 0) * pnt_in.x +
+                                   transform(1, 1) * pnt_in.y +
+                                   transform(1, 2) * pnt_in.z + transform(1, 3));
+  pnt_out[2] = static_cast<Scalar>(transform(2, 0) * pnt_in.x +
+                                   transform(2, 1) * pnt_in.y +
+                                   transform(2, 2) * pnt_in.z + transform(2, 3));
+  pnt_out[3] = 0.0;
+}
+
+/** \brief The number of residuals summed up in one block by
+ * accumulateLevenbergMarquardtSystem and accumulateLevenbergMarquardtCost.
+ */
+constexpr std::ptrdiff_t levenberg_marquardt_block_size = 256;
+
+/** \brief Accumulate the normal equations JTJ * h = -JTr of one Levenberg-Marquardt
+ * iteration, with a forward difference Jacobian J of the residuals r.
+ *
+ * The residuals are split into blocks of levenberg_marquardt_block_size, which are
+ * distributed over the threads. Every block evaluates its residuals at \a
+ * transforms[0] and at the n forward difference steps \a transforms[1..n], and sums
+ * the rows of J into its own partial JTJ, JTr and cost. The partial sums are combined
+ * in block order, so the result does not depend on \a nr_threads.
+ * \param[in] transforms the transformations at the parameters x and at x + steps[j] e_j
+ * \param[in] steps the forward difference step of every parameter
+ * \param[in] nr_residuals the number of residuals
+ * \param[in] residual the function returning residual i under a transformation
+ * \param[in] nr_threads the number of threads to use
+ * \param[out] JTJ the (symmetric) system matrix
+ * \param[out] JTr the gradient of half the cost
+ * \return the cost, i.e. the sum of the squared residuals at \a transforms[0]
+ */
+template <typename Matrix4, typename Residual>
+double
+accumulateLevenbergMarquardtSystem(
+    const std::vector<Matrix4, Eigen::aligned_allocator<Matrix4>>& transforms,
+    const Eigen::VectorXd& steps,
+    std::size_t nr_residuals,
+    const Residual& residual,
+    unsigned int nr_threads,
+    Eigen::MatrixXd& JTJ,
+    Eigen::VectorXd& JTr)
+{
+  const Eigen::Index n = steps.size();
+  const auto nr = static_cast<std::ptrdiff_t>(nr_residuals);
+  const std::ptrdiff_t nr_blocks =
+      (nr + levenberg_marquardt_block_size - 1) / levenberg_marquardt_block_size;
+  // n x n system matrix followed by the n entries of JTr and the cost
+  std::vector<Eigen::MatrixXd> partial_sums(nr_blocks, Eigen::MatrixXd::Zero(n, n + 2));
+
+#pragma omp parallel num_threads(nr_threads)
+  {
+    Eigen::VectorXd row(n);
+#pragma omp for schedule(static)
+    for (std::ptrdiff_t block = 0; block < nr_blocks; ++block) {
+      Eigen::MatrixXd& sums = partial_sums[block];
+      const std::ptrdiff_t end =
+          std::min(nr, (block + 1) * levenberg_marquardt_block_size);
+      for (std::ptrdiff_t i = block * levenberg_marquardt_block_size; i < end; ++i) {
+        const double r = residual(i, transforms[0]);
+        for (Eigen::Index j = 0; j < n; ++j)
+          row[j] = (residual(i, transforms[j + 1]) - r) / steps[j];
+
+        sums.leftCols(n).template selfadjointView<Eigen::Upper>().rankUpdate(row);
+        sums.col(n) += r * row;
+        sums(0, n + 1) += r * r;
+      }
+    }
+  }
+
+  Eigen::MatrixXd total = Eigen::MatrixXd::Zero(n, n + 2);
+  for (const auto& sums : partial_sums)
+    total += sums;
+
+  JTJ = total.leftCols(n).template selfadjointView<Eigen::Upper>();
+  JTr = total.col(n);
+  return (total(0, n + 1));
+}
+
+/** \brief Sum the squared residuals under a transformation, split into blocks like
+ * accumulateLevenbergMarquardtSystem.
+ */
+template <typename Matrix4, typename Residual>
+double
+accumulateLevenbergMarquardtCost(const Matrix4& transform,
+                                 std::size_t nr_residuals,
+                                 const Residual& residual,
+                                 unsigned int nr_threads)
+{
+  const auto nr = static_cast<std::ptrdiff_t>(nr_residuals);
+  const std::ptrdiff_t nr_blocks =
+      (nr + levenberg_marquardt_block_size - 1) / levenberg_marquardt_block_size;
+  std::vector<double> partial_sums(nr_blocks, 0.0);
+
+#pragma omp parallel for num_threads(nr_threads) schedule(static)
+  for (std::ptrdiff_t block = 0; block < nr_blocks; ++block) {
+    const std::ptrdiff_t end =
+        std::min(nr, (block + 1) * levenberg_marquardt_block_size);
+    double sum = 0.0;
+    for (std::ptrdiff_t i = block * levenberg_marquardt_block_size; i < end; ++i) {
+      const double r = residual(i, transform);
+      sum += r * r;
+    }
+    partial_sums[block] = sum;
+  }
+
+  double total = 0.0;
+  for (const double sum : partial_sums)
+    total += sum;
+  return (total);
+}
+
+/** \brief Minimize the sum of the squared residuals over the parameters of a warp
+ * function with Levenberg-Marquardt.
+ *
+ * Unlike Eigen::LevenbergMarquardt, which factorizes the full residual Jacobian on one
+ * thread, the Jacobian is never stored: every iteration accumulates the normal
+ * equations with accumulateLevenbergMarquardtSystem, in parallel, and solves the damped
+ * n x n system. The Jacobian is approximated by forward differences with the steps of
+ * Eigen::NumericalDiff, and the damping is updated as proposed by Nielsen.
+ * \param[in,out] warp_point the warp function, which maps the parameters to a
+ * transformation; its parameters are left in an unspecified state
+ * \param[in] nr_residuals the number of residuals
+ * \param[in] residual the function returning residual i under a transformation, which
+ * is called concurrently
+ * \param[in] nr_threads the number of threads to use
+ * \param[in,out] x the initial parameters, replaced by the solution
+ * \param[out] residual_norm the norm of the residuals at the solution
+ * \return 1 if the relative reduction of the cost fell below the tolerance, 2 if the
+ * step did, 3 if no step reduces the cost any further and 0 if the maximum number of
+ * iterations was reached
+ */
+template <typename WarpPointPtr, typename VectorX, typename Residual>
+int
+minimizeLevenbergMarquardt(const WarpPointPtr& warp_point,
+                           std::size_t nr_residuals,
+                           const Residual& residual,
+                           unsigned int nr_threads,
+                           VectorX& x,
+                           double& residual_norm)
+{
+  using Scalar = typename VectorX::Scalar;
+  using Matrix4 = Eigen::Matrix<Scalar, 4, 4>;
+  constexpr int max_iterations = 200;
+  // Eigen::LevenbergMarquardt uses the square root of the epsilon of the parameter type
+  // as tolerance on both the cost and the step, Eigen::NumericalDiff as relative step
+  const double tolerance = std::sqrt(std::numeric_limits<Scalar>::epsilon());
+
+  const Eigen::Index n = x.size();
+  std::vector<Matrix4, Eigen::aligned_allocator<Matrix4>> transforms(n + 1);
+  Eigen::VectorXd steps(n);
+  Eigen::MatrixXd JTJ;
+  Eigen::VectorXd JTr;
+
+  const auto linearize = [&]() {
+    warp_point->setParam(x);
+    transforms[0] = warp_point->getTransform();
+    for (Eigen::Index j = 0; j < n; ++j) {
+      Scalar step = tolerance * std::abs(x[j]);
+      if (step == 0)
+        step = tolerance;
+      VectorX x_step = x;
+      x_step[j] += step;
+      warp_point->setParam(x_step);
+      transforms[j + 1] = warp_point->getTransform();
+      steps[j] = step;
+    }
+    return (accumulateLevenbergMarquardtSystem(
+        transforms, steps, nr_residuals, residual, nr_threads, JTJ, JTr));
+  };
+
+  double cost = linearize();
+  double damping =
+      1e-3 * std::max(JTJ.diagonal().maxCoeff(), std::numeric_limits<double>::min());
+  double damping_factor = 2.0;
+  int info = 0;
+
+  for (int iteration = 0; iteration < max_iterations && info == 0; ++iteration) {
+    if (cost == 0.0) {
+      info = 1;
+      break;
+    }
+
+    Eigen::MatrixXd A = JTJ;
+    A.diagonal().array() += damping;
+    const Eigen::VectorXd step = A.ldlt().solve(-JTr);
+    if (!step.allFinite() || !std::isfinite(damping)) {
+      info = 3;
+      break;
+    }
+    if (step.norm() <= tolerance * (x.template cast<double>().norm() + tolerance)) {
+      info = 2;
+      break;
+    }
+
+    const VectorX x_new = x + step.template cast<Scalar>();
+    warp_point->setParam(x_new);
+    const double new_cost = accumulateLevenbergMarquardtCost(
+        warp_point->getTransform(), nr_residuals, residual, nr_threads);
+
+    // Reduction of the cost predicted by the linear model, positive for every step
+    const double predicted_reduction = step.dot(damping * step - JTr);
+    const double gain = (cost - new_cost) / predicted_reduction;
+    if (gain > 0.0) {
+      const double previous_cost = cost;
+      x = x_new;
+      cost = linearize();
+      damping *= std::max(1.0 / 3.0, 1.0 - std::pow(2.0 * gain - 1.0, 3));
+      damping_factor = 2.0;
+      if (previous_cost - cost <= tolerance * previous_cost)
+        info = 1;
+    }
+    else {
+      damping *= damping_factor;
+      damping_factor *= 2.0;
+    }
+  }
+
+  residual_norm = std::sqrt(cost);
+  return (info);
+}
+
+} // namespace detail
+} // namespace registration
+} // namespace pcl
+
+#endif /* PCL_REGISTRATION_IMPL_LEVENBERG_MARQUARDT_ACCUMULATION_HPP_ */
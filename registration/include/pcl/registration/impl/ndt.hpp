@@ -70,7 +70,8 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computeTransform
 {
   nr_iterations_ = 0;
   converged_ = false;
-  if (target_cells_.getCentroids()->empty()) {
+  if (target_map_ ? target_map_->getNumberOfValidVoxels() == 0
+                  : target_cells_.getCentroids()->empty()) {
     PCL_ERROR("[%s::computeTransformation] Voxel grid is not searchable!\n",
               getClassName().c_str());
     return;
@@ -189,6 +190,55 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computeTransform
   trans_likelihood_ = score / static_cast<double>(input_->size());
 }
 
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+NormalDistributionsTransform<PointSource, PointTarget, Scalar>::findNeighborhood(
+    const PointSource& point,
+    std::vector<TargetGridLeafConstPtr>& neighborhood,
+    std::vector<float>& distances) const
+{
+  switch (neighbor_search_method_) {
+  case NeighborSearchMethod::DIRECT1:
+    target_cells_.getVoxelAtPoint(point, neighborhood);
+    break;
+  case NeighborSearchMethod::DIRECT7:
+    target_cells_.getFaceNeighborsAtPoint(point, neighborhood);
+    break;
+  case NeighborSearchMethod::DIRECT27:
+    target_cells_.getAllNeighborsAtPoint(point, neighborhood);
+    break;
+  case NeighborSearchMethod::KDTREE:
+  default:
+    target_cells_.radiusSearch(point, resolution_, neighborhood, distances);
+    break;
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+NormalDistributionsTransform<PointSource, PointTarget, Scalar>::findNeighborhood(
+    const PointSource& point,
+    std::vector<TargetMapVoxelConstPtr>& neighborhood,
+    std::vector<float>& distances) const
+{
+  switch (neighbor_search_method_) {
+  case NeighborSearchMethod::DIRECT1:
+    target_map_->getVoxelAtPoint(point.getVector3fMap(), neighborhood);
+    break;
+  case NeighborSearchMethod::DIRECT7:
+    target_map_->getFaceNeighborsAtPoint(point.getVector3fMap(), neighborhood);
+    break;
+  case NeighborSearchMethod::DIRECT27:
+    target_map_->getAllNeighborsAtPoint(point.getVector3fMap(), neighborhood);
+    break;
+  case NeighborSearchMethod::KDTREE:
+  default:
+    target_map_->radiusSearch(
+        point.getVector3fMap(), resolution_, neighborhood, distances);
+    break;
+  }
+}
+
 template <typename PointSource, typename PointTarget, typename Scalar>
 double
 NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computeDerivatives(
@@ -205,38 +255,85 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computeDerivativ
   // Precompute Angular Derivatives (eq. 6.19 and 6.21)[Magnusson 2009]
   computeAngleDerivatives(transform);
 
-  // Update gradient and hessian for each point, line 17 in Algorithm 2 [Magnusson 2009]
-  for (std::size_t idx = 0; idx < input_->size(); idx++) {
-    // Transformed Point
-    const auto& x_trans_pt = trans_cloud[idx];
-
-    // Find neighbors (Radius search has been experimentally faster than direct neighbor
-    // checking.
+  // Per thread accumulators, summed up in thread order afterwards so that the result
+  // does not depend on the scheduling
+  std::vector<double> thread_scores(num_threads_, 0.0);
+  std::vector<Eigen::Matrix<double, 6, 1>,
+              Eigen::aligned_allocator<Eigen::Matrix<double, 6, 1>>>
+      thread_gradients(num_threads_, Eigen::Matrix<double, 6, 1>::Zero());
+  std::vector<Eigen::Matrix<double, 6, 6>,
+              Eigen::aligned_allocator<Eigen::Matrix<double, 6, 6>>>
+      thread_hessians(num_threads_, Eigen::Matrix<double, 6, 6>::Zero());
+
+#pragma omp parallel default(none)                                                     \
+    shared(compute_hessian, thread_gradients, thread_hessians, thread_scores,           \
+           trans_cloud) num_threads(num_threads_)
+  {
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+    Eigen::Matrix<double, 3, 6> point_jacobian = point_jacobian_;
+    Eigen::Matrix<double, 18, 6> point_hessian = point_hessian_;
     std::vector<TargetGridLeafConstPtr> neighborhood;
+    std::vector<TargetMapVoxelConstPtr> map_neighborhood;
     std::vector<float> distances;
-    target_cells_.radiusSearch(x_trans_pt, resolution_, neighborhood, distances);
-
-    for (const auto& cell : neighborhood) {
-      // Original Point
-      const auto& x_pt = (*input_)[idx];
-      const Eigen::Vector3d x = x_pt.getVector3fMap().template cast<double>();
-
-      // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
-      const Eigen::Vector3d x_trans =
-          x_trans_pt.getVector3fMap().template cast<double>() - cell->getMean();
-      // Inverse Covariance of Occupied Voxel
-      // Uses precomputed covariance for speed.
-      const Eigen::Matrix3d c_inv = cell->getInverseCov();
-
-      // Compute derivative of transform function w.r.t. transform vector, J_E and H_E
-      // in Equations 6.18 and 6.20 [Magnusson 2009]
-      computePointDerivatives(x);
-      // Update score, gradient and hessian, lines 19-21 in Algorithm 2, according to
-      // Equations 6.10, 6.12 and 6.13, respectively [Magnusson 2009]
-      score +=
-          updateDerivatives(score_gradient, hessian, x_trans, c_inv, compute_hessian);
+
+    // Update gradient and hessian for each point, line 17 in Algorithm 2 [Magnusson
+    // 2009]
+#pragma omp for schedule(static)
+    for (int idx = 0; idx < static_cast<int>(input_->size()); idx++) {
+      // Transformed Point
+      const auto& x_trans_pt = trans_cloud[idx];
+
+      // Voxels from either the target map or the voxel grid of the target cloud
+      const auto update_neighborhood = [&](const auto& neighborhood) {
+        for (const auto& cell : neighborhood) {
+          // Original Point
+          const auto& x_pt = (*input_)[idx];
+          const Eigen::Vector3d x = x_pt.getVector3fMap().template cast<double>();
+
+          // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
+          const Eigen::Vector3d x_trans =
+              x_trans_pt.getVector3fMap().template cast<double>() - cell->getMean();
+          // Inverse Covariance of Occupied Voxel
+          // Uses precomputed covariance for speed.
+          const Eigen::Matrix3d c_inv = cell->getInverseCov();
+
+          // Compute derivative of transform function w.r.t. transform vector, J_E
+          // and H_E in Equations 6.18 and 6.20 [Magnusson 2009]
+          computePointDerivatives(x, point_jacobian, point_hessian);
+          // Update score, gradient and hessian, lines 19-21 in Algorithm 2,
+          // according to Equations 6.10, 6.12 and 6.13, respectively [Magnusson
+          // 2009]
+          thread_scores[thread_num] += updateDerivatives(thread_gradients[thread_num],
+                                                         thread_hessians[thread_num],
+                                                         point_jacobian,
+                                                         point_hessian,
+                                                         x_trans,
+                                                         c_inv,
+                                                         compute_hessian);
+        }
+      };
+
+      // Find neighbors
+      if (target_map_) {
+        findNeighborhood(x_trans_pt, map_neighborhood, distances);
+        update_neighborhood(map_neighborhood);
+      }
+      else {
+        findNeighborhood(x_trans_pt, neighborhood, distances);
+        update_neighborhood(neighborhood);
+      }
     }
   }
+
+  for (unsigned int thread_num = 0; thread_num < num_threads_; ++thread_num) {
+    score += thread_scores[thread_num];
+    score_gradient += thread_gradients[thread_num];
+    hessian += thread_hessians[thread_num];
+  }
   return score;
 }
 
@@ -329,20 +426,31 @@ template <typename PointSource, typename PointTarget, typename Scalar>
 void
 NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computePointDerivatives(
     const Eigen::Vector3d& x, bool compute_hessian)
+{
+  computePointDerivatives(x, point_jacobian_, point_hessian_, compute_hessian);
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computePointDerivatives(
+    const Eigen::Vector3d& x,
+    Eigen::Matrix<double, 3, 6>& point_jacobian,
+    Eigen::Matrix<double, 18, 6>& point_hessian,
+    bool compute_hessian) const
 {
   // Calculate first derivative of Transformation Equation 6.17 w.r.t. transform vector.
   // Derivative w.r.t. ith element of transform vector corresponds to column i,
   // Equation 6.18 and 6.19 [Magnusson 2009]
   Eigen::Matrix<double, 8, 1> point_angular_jacobian =
       angular_jacobian_ * Eigen::Vector4d(x[0], x[1], x[2], 0.0);
-  point_jacobian_(1, 3) = point_angular_jacobian[0];
-  point_jacobian_(2, 3) = point_angular_jacobian[1];
-  point_jacobian_(0, 4) = point_angular_jacobian[2];
-  point_jacobian_(1, 4) = point_angular_jacobian[3];
-  point_jacobian_(2, 4) = point_angular_jacobian[4];
-  point_jacobian_(0, 5) = point_angular_jacobian[5];
-  point_jacobian_(1, 5) = point_angular_jacobian[6];
-  point_jacobian_(2, 5) = point_angular_jacobian[7];
+  point_jacobian(1, 3) = point_angular_jacobian[0];
+  point_jacobian(2, 3) = point_angular_jacobian[1];
+  point_jacobian(0, 4) = point_angular_jacobian[2];
+  point_jacobian(1, 4) = point_angular_jacobian[3];
+  point_jacobian(2, 4) = point_angular_jacobian[4];
+  point_jacobian(0, 5) = point_angular_jacobian[5];
+  point_jacobian(1, 5) = point_angular_jacobian[6];
+  point_jacobian(2, 5) = point_angular_jacobian[7];
 
   if (compute_hessian) {
     Eigen::Matrix<double, 15, 1> point_angular_hessian =
@@ -359,15 +467,15 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computePointDeri
     // Calculate second derivative of Transformation Equation 6.17 w.r.t. transform
     // vector. Derivative w.r.t. ith and jth elements of transform vector corresponds to
     // the 3x1 block matrix starting at (3i,j), Equation 6.20 and 6.21 [Magnusson 2009]
-    point_hessian_.block<3, 1>(9, 3) = a;
-    point_hessian_.block<3, 1>(12, 3) = b;
-    point_hessian_.block<3, 1>(15, 3) = c;
-    point_hessian_.block<3, 1>(9, 4) = b;
-    point_hessian_.block<3, 1>(12, 4) = d;
-    point_hessian_.block<3, 1>(15, 4) = e;
-    point_hessian_.block<3, 1>(9, 5) = c;
-    point_hessian_.block<3, 1>(12, 5) = e;
-    point_hessian_.block<3, 1>(15, 5) = f;
+    point_hessian.block<3, 1>(9, 3) = a;
+    point_hessian.block<3, 1>(12, 3) = b;
+    point_hessian.block<3, 1>(15, 3) = c;
+    point_hessian.block<3, 1>(9, 4) = b;
+    point_hessian.block<3, 1>(12, 4) = d;
+    point_hessian.block<3, 1>(15, 4) = e;
+    point_hessian.block<3, 1>(9, 5) = c;
+    point_hessian.block<3, 1>(12, 5) = e;
+    point_hessian.block<3, 1>(15, 5) = f;
   }
 }
 
@@ -379,6 +487,26 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateDerivative
     const Eigen::Vector3d& x_trans,
     const Eigen::Matrix3d& c_inv,
     bool compute_hessian) const
+{
+  return updateDerivatives(score_gradient,
+                           hessian,
+                           point_jacobian_,
+                           point_hessian_,
+                           x_trans,
+                           c_inv,
+                           compute_hessian);
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+double
+NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateDerivatives(
+    Eigen::Matrix<double, 6, 1>& score_gradient,
+    Eigen::Matrix<double, 6, 6>& hessian,
+    const Eigen::Matrix<double, 3, 6>& point_jacobian,
+    const Eigen::Matrix<double, 18, 6>& point_hessian,
+    const Eigen::Vector3d& x_trans,
+    const Eigen::Matrix3d& c_inv,
+    bool compute_hessian) const
 {
   // e^(-d_2/2 * (x_k - mu_k)^T Sigma_k^-1 (x_k - mu_k)) Equation 6.9 [Magnusson 2009]
   double e_x_cov_x = std::exp(-gauss_d2_ * x_trans.dot(c_inv * x_trans) / 2);
@@ -399,7 +527,7 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateDerivative
   for (int i = 0; i < 6; i++) {
     // Sigma_k^-1 d(T(x,p))/dpi, Reusable portion of Equation 6.12 and 6.13 [Magnusson
     // 2009]
-    const Eigen::Vector3d cov_dxd_pi = c_inv * point_jacobian_.col(i);
+    const Eigen::Vector3d cov_dxd_pi = c_inv * point_jacobian.col(i);
 
     // Update gradient, Equation 6.12 [Magnusson 2009]
     score_gradient(i) += x_trans.dot(cov_dxd_pi) * e_x_cov_x;
@@ -409,9 +537,9 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateDerivative
         // Update hessian, Equation 6.13 [Magnusson 2009]
         hessian(i, j) +=
             e_x_cov_x * (-gauss_d2_ * x_trans.dot(cov_dxd_pi) *
-                             x_trans.dot(c_inv * point_jacobian_.col(j)) +
-                         x_trans.dot(c_inv * point_hessian_.block<3, 1>(3 * i, j)) +
-                         point_jacobian_.col(j).dot(cov_dxd_pi));
+                             x_trans.dot(c_inv * point_jacobian.col(j)) +
+                         x_trans.dot(c_inv * point_hessian.block<3, 1>(3 * i, j)) +
+                         point_jacobian.col(j).dot(cov_dxd_pi));
       }
     }
   }
@@ -426,45 +554,94 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::computeHessian(
 {
   hessian.setZero();
 
-  // Precompute Angular Derivatives unnecessary because only used after regular
-  // derivative calculation Update hessian for each point, line 17 in Algorithm 2
-  // [Magnusson 2009]
-  for (std::size_t idx = 0; idx < input_->size(); idx++) {
-    // Transformed Point
-    const auto& x_trans_pt = trans_cloud[idx];
-
-    // Find neighbors (Radius search has been experimentally faster than direct neighbor
-    // checking.
+  // Per thread accumulators, summed up in thread order afterwards so that the result
+  // does not depend on the scheduling
+  std::vector<Eigen::Matrix<double, 6, 6>,
+              Eigen::aligned_allocator<Eigen::Matrix<double, 6, 6>>>
+      thread_hessians(num_threads_, Eigen::Matrix<double, 6, 6>::Zero());
+
+#pragma omp parallel default(none) shared(thread_hessians, trans_cloud)               \
+    num_threads(num_threads_)
+  {
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+    Eigen::Matrix<double, 3, 6> point_jacobian = point_jacobian_;
+    Eigen::Matrix<double, 18, 6> point_hessian = point_hessian_;
     std::vector<TargetGridLeafConstPtr> neighborhood;
+    std::vector<TargetMapVoxelConstPtr> map_neighborhood;
     std::vector<float> distances;
-    target_cells_.radiusSearch(x_trans_pt, resolution_, neighborhood, distances);
-
-    for (const auto& cell : neighborhood) {
-      // Original Point
-      const auto& x_pt = (*input_)[idx];
-      const Eigen::Vector3d x = x_pt.getVector3fMap().template cast<double>();
-
-      // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
-      const Eigen::Vector3d x_trans =
-          x_trans_pt.getVector3fMap().template cast<double>() - cell->getMean();
-      // Inverse Covariance of Occupied Voxel
-      // Uses precomputed covariance for speed.
-      const Eigen::Matrix3d c_inv = cell->getInverseCov();
-
-      // Compute derivative of transform function w.r.t. transform vector, J_E and H_E
-      // in Equations 6.18 and 6.20 [Magnusson 2009]
-      computePointDerivatives(x);
-      // Update hessian, lines 21 in Algorithm 2, according to Equations 6.10, 6.12
-      // and 6.13, respectively [Magnusson 2009]
-      updateHessian(hessian, x_trans, c_inv);
+
+    // Precompute Angular Derivatives unnecessary because only used after regular
+    // derivative calculation Update hessian for each point, line 17 in Algorithm 2
+    // [Magnusson 2009]
+#pragma omp for schedule(static)
+    for (int idx = 0; idx < static_cast<int>(input_->size()); idx++) {
+      // Transformed Point
+      const auto& x_trans_pt = trans_cloud[idx];
+
+      // Voxels from either the target map or the voxel grid of the target cloud
+      const auto update_neighborhood = [&](const auto& neighborhood) {
+        for (const auto& cell : neighborhood) {
+          // Original Point
+          const auto& x_pt = (*input_)[idx];
+          const Eigen::Vector3d x = x_pt.getVector3fMap().template cast<double>();
+
+          // Denorm point, x_k' in Equations 6.12 and 6.13 [Magnusson 2009]
+          const Eigen::Vector3d x_trans =
+              x_trans_pt.getVector3fMap().template cast<double>() - cell->getMean();
+          // Inverse Covariance of Occupied Voxel
+          // Uses precomputed covariance for speed.
+          const Eigen::Matrix3d c_inv = cell->getInverseCov();
+
+          // Compute derivative of transform function w.r.t. transform vector, J_E
+          // and H_E in Equations 6.18 and 6.20 [Magnusson 2009]
+          computePointDerivatives(x, point_jacobian, point_hessian);
+          // Update hessian, lines 21 in Algorithm 2, according to Equations 6.10,
+          // 6.12 and 6.13, respectively [Magnusson 2009]
+          updateHessian(thread_hessians[thread_num],
+                        point_jacobian,
+                        point_hessian,
+                        x_trans,
+                        c_inv);
+        }
+      };
+
+      // Find neighbors
+      if (target_map_) {
+        findNeighborhood(x_trans_pt, map_neighborhood, distances);
+        update_neighborhood(map_neighborhood);
+      }
+      else {
+        findNeighborhood(x_trans_pt, neighborhood, distances);
+        update_neighborhood(neighborhood);
+      }
     }
   }
+
+  for (unsigned int thread_num = 0; thread_num < num_threads_; ++thread_num) {
+    hessian += thread_hessians[thread_num];
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateHessian(
+    Eigen::Matrix<double, 6, 6>& hessian,
+    const Eigen::Vector3d& x_trans,
+    const Eigen::Matrix3d& c_inv) const
+{
+  updateHessian(hessian, point_jacobian_, point_hessian_, x_trans, c_inv);
 }
 
 template <typename PointSource, typename PointTarget, typename Scalar>
 void
 NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateHessian(
     Eigen::Matrix<double, 6, 6>& hessian,
+    const Eigen::Matrix<double, 3, 6>& point_jacobian,
+    const Eigen::Matrix<double, 18, 6>& point_hessian,
     const Eigen::Vector3d& x_trans,
     const Eigen::Matrix3d& c_inv) const
 {
@@ -483,15 +660,15 @@ NormalDistributionsTransform<PointSource, PointTarget, Scalar>::updateHessian(
   for (int i = 0; i < 6; i++) {
     // Sigma_k^-1 d(T(x,p))/dpi, Reusable portion of Equation 6.12 and 6.13 [Magnusson
     // 2009]
-    const Eigen::Vector3d cov_dxd_pi = c_inv * point_jacobian_.col(i);
+    const Eigen::Vector3d cov_dxd_pi = c_inv * point_jacobian.col(i);
 
     for (Eigen::Index j = 0; j < hessian.cols(); j++) {
       // Update hessian, Equation 6.13 [Magnusson 2009]
       hessian(i, j) +=
           e_x_cov_x * (-gauss_d2_ * x_trans.dot(cov_dxd_pi) *
-                           x_trans.dot(c_inv * point_jacobian_.col(j)) +
-                       x_trans.dot(c_inv * point_hessian_.block<3, 1>(3 * i, j)) +
-                       point_jacobian_.col(j).dot(cov_dxd_pi));
+                           x_trans.dot(c_inv * point_jacobian.col(j)) +
+                       x_trans.dot(c_inv * point_hessian.block<3, 1>(3 * i, j)) +
+                       point_jacobian.col(j).dot(cov_dxd_pi));
     }
   }
 }
@@ -0,0 +1,102 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_NDT_MAP_IMPL_H_
+#define PCL_REGISTRATION_NDT_MAP_IMPL_H_
+
+#include <pcl/common/point_tests.h> // for isXYZFinite
+
+namespace pcl {
+
+template <typename PointT>
+void
+NormalDistributionsTransformMap::insert(const pcl::PointCloud<PointT>& cloud)
+{
+  makeWritable();
+
+  std::vector<std::uint32_t> touched;
+  touched.reserve(cloud.size());
+  for (const auto& point : cloud) {
+    if (!cloud.is_dense && !pcl::isXYZFinite(point))
+      continue;
+    const std::uint32_t index = addPoint(point.getVector3fMap());
+    if (index != empty_slot_)
+      touched.push_back(index);
+  }
+  updateVoxels(touched);
+}
+
+template <typename PointT>
+void
+NormalDistributionsTransformMap::remove(const pcl::PointCloud<PointT>& cloud)
+{
+  makeWritable();
+
+  std::vector<std::uint32_t> touched;
+  touched.reserve(cloud.size());
+  for (const auto& point : cloud) {
+    if (!cloud.is_dense && !pcl::isXYZFinite(point))
+      continue;
+    const std::uint32_t index = removePoint(point.getVector3fMap());
+    if (index != empty_slot_)
+      touched.push_back(index);
+  }
+  updateVoxels(touched);
+}
+
+template <typename PointT>
+void
+NormalDistributionsTransformMap::getCentroids(pcl::PointCloud<PointT>& centroids) const
+{
+  centroids.clear();
+  centroids.reserve(nr_valid_voxels_);
+  for (std::size_t i = 0; i < nr_voxels_; ++i) {
+    const Voxel& voxel = voxels_data_[i];
+    if (!voxel.valid)
+      continue;
+    PointT centroid;
+    centroid.getVector3fMap() = voxel.getMean().cast<float>();
+    centroids.push_back(centroid);
+  }
+  centroids.width = centroids.size();
+  centroids.height = 1;
+  centroids.is_dense = true;
+}
+
+} // namespace pcl
+
+#endif // PCL_REGISTRATION_NDT_MAP_IMPL_H_
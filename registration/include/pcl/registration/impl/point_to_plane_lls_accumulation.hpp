@@ -0,0 +1,195 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_POINT_TO_PLANE_LLS_ACCUMULATION_HPP_
+#define PCL_REGISTRATION_IMPL_POINT_TO_PLANE_LLS_ACCUMULATION_HPP_
+
+#include <pcl/memory.h>
+
+#include <Eigen/Core>
+
+#include <cstddef>
+#include <vector>
+
+namespace pcl {
+namespace registration {
+namespace detail {
+
+/** \brief Structure-of-arrays buffer holding the correspondences of a linearized
+ * point-to-plane problem. Each coordinate is stored contiguously, so the accumulation
+ * of the normal equations reads unit-stride memory and can be split across threads.
+ */
+struct PointToPlaneCorrespondenceBuffer {
+  std::vector<float> sx, sy, sz;
+  std::vector<float> dx, dy, dz;
+  std::vector<float> nx, ny, nz;
+
+  void
+  reserve(std::size_t nr_correspondences)
+  {
+    for (auto* v : {&sx, &sy, &sz, &dx, &dy, &dz, &nx, &ny, &nz})
+      v->reserve(nr_correspondences);
+  }
+
+  std::size_t
+  size() const
+  {
+    return (sx.size());
+  }
+
+  /** \brief Append a correspondence: source point, target point and target normal. */
+  void
+  push_back(float src_x,
+            float src_y,
+            float src_z,
+            float tgt_x,
+            float tgt_y,
+            float tgt_z,
+            float normal_x,
+            float normal_y,
+            float normal_z)
+  {
+    sx.push_back(src_x);
+    sy.push_back(src_y);
+    sz.push_back(src_z);
+    dx.push_back(tgt_x);
+    dy.push_back(tgt_y);
+    dz.push_back(tgt_z);
+    nx.push_back(normal_x);
+    ny.push_back(normal_y);
+    nz.push_back(normal_z);
+  }
+};
+
+/** \brief Accumulate the normal equations ATA * x = ATb of the point-to-plane linear
+ * least squares problem described by \a buffer, with x = [alpha beta gamma tx ty tz].
+ *
+ * Every thread sums a contiguous block of correspondences into its own partial sums,
+ * which are combined in thread order, so the result only depends on \a nr_threads.
+ * \param[in] buffer the correspondences
+ * \param[in] nr_threads the number of threads to use
+ * \param[out] ATA the (symmetric) 6x6 system matrix
+ * \param[out] ATb the right hand side
+ */
+inline void
+accumulatePointToPlaneSystem(const PointToPlaneCorrespondenceBuffer& buffer,
+                             unsigned int nr_threads,
+                             Eigen::Matrix<double, 6, 6>& ATA,
+                             Eigen::Matrix<double, 6, 1>& ATb)
+{
+  // 21 upper triangular entries of ATA followed by the 6 entries of ATb
+  using PartialSums = Eigen::Matrix<double, 27, 1>;
+  std::vector<PartialSums, Eigen::aligned_allocator<PartialSums>> partial_sums(
+      nr_threads != 0 ? nr_threads : 1, PartialSums::Zero());
+
+  const auto nr_correspondences = static_cast<std::ptrdiff_t>(buffer.size());
+  const float* const sx = buffer.sx.data();
+  const float* const sy = buffer.sy.data();
+  const float* const sz = buffer.sz.data();
+  const float* const dx = buffer.dx.data();
+  const float* const dy = buffer.dy.data();
+  const float* const dz = buffer.dz.data();
+  const float* const nx = buffer.nx.data();
+  const float* const ny = buffer.ny.data();
+  const float* const nz = buffer.nz.data();
+
+#pragma omp parallel num_threads(nr_threads)
+  {
+    double sums[27] = {};
+#pragma omp for schedule(static)
+    for (std::ptrdiff_t i = 0; i < nr_correspondences; ++i) {
+      const double a = nz[i] * sy[i] - ny[i] * sz[i];
+      const double b = nx[i] * sz[i] - nz[i] * sx[i];
+      const double c = ny[i] * sx[i] - nx[i] * sy[i];
+      const double n0 = nx[i];
+      const double n1 = ny[i];
+      const double n2 = nz[i];
+
+      sums[0] += a * a;
+      sums[1] += a * b;
+      sums[2] += a * c;
+      sums[3] += a * n0;
+      sums[4] += a * n1;
+      sums[5] += a * n2;
+      sums[6] += b * b;
+      sums[7] += b * c;
+      sums[8] += b * n0;
+      sums[9] += b * n1;
+      sums[10] += b * n2;
+      sums[11] += c * c;
+      sums[12] += c * n0;
+      sums[13] += c * n1;
+      sums[14] += c * n2;
+      sums[15] += n0 * n0;
+      sums[16] += n0 * n1;
+      sums[17] += n0 * n2;
+      sums[18] += n1 * n1;
+      sums[19] += n1 * n2;
+      sums[20] += n2 * n2;
+
+      const double d = nx[i] * dx[i] + ny[i] * dy[i] + nz[i] * dz[i] -
+                       nx[i] * sx[i] - ny[i] * sy[i] - nz[i] * sz[i];
+      sums[21] += a * d;
+      sums[22] += b * d;
+      sums[23] += c * d;
+      sums[24] += n0 * d;
+      sums[25] += n1 * d;
+      sums[26] += n2 * d;
+    }
+#ifdef _OPENMP
+    const int tid = omp_get_thread_num();
+#else
+    const int tid = 0;
+#endif
+    partial_sums[tid] = Eigen::Map<const PartialSums>(sums);
+  }
+
+  PartialSums total = PartialSums::Zero();
+  for (const auto& sums : partial_sums)
+    total += sums;
+
+  for (int row = 0, k = 0; row < 6; ++row)
+    for (int col = row; col < 6; ++col, ++k)
+      ATA(row, col) = ATA(col, row) = total[k];
+  ATb = total.tail<6>();
+}
+
+} // namespace detail
+} // namespace registration
+} // namespace pcl
+
+#endif /* PCL_REGISTRATION_IMPL_POINT_TO_PLANE_LLS_ACCUMULATION_HPP_ */
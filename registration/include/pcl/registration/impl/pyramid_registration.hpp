@@ -0,0 +1,225 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_PYRAMID_REGISTRATION_HPP_
+#define PCL_REGISTRATION_IMPL_PYRAMID_REGISTRATION_HPP_
+
+namespace pcl {
+
+namespace registration {
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+PyramidRegistration<PointSource, PointTarget, Scalar>::addLevel(
+    float leaf_size,
+    int max_iterations,
+    double max_correspondence_distance,
+    double transformation_epsilon,
+    double euclidean_fitness_epsilon)
+{
+  levels_.push_back({std::max(leaf_size, 0.0f),
+                     max_iterations,
+                     max_correspondence_distance,
+                     transformation_epsilon,
+                     euclidean_fitness_epsilon});
+  source_levels_.clear();
+  target_levels_.clear();
+  target_trees_.clear();
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+PyramidRegistration<PointSource, PointTarget, Scalar>::clearLevels()
+{
+  levels_.clear();
+  source_levels_.clear();
+  target_levels_.clear();
+  target_trees_.clear();
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+PyramidRegistration<PointSource, PointTarget, Scalar>::setInputSource(
+    const PointCloudSourceConstPtr& cloud)
+{
+  source_ = cloud;
+  source_levels_.clear();
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+PyramidRegistration<PointSource, PointTarget, Scalar>::setInputTarget(
+    const PointCloudTargetConstPtr& cloud)
+{
+  target_ = cloud;
+  target_levels_.clear();
+  target_trees_.clear();
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+template <typename PointT>
+typename pcl::PointCloud<PointT>::ConstPtr
+PyramidRegistration<PointSource, PointTarget, Scalar>::downsample(
+    const typename pcl::PointCloud<PointT>::ConstPtr& cloud,
+    float leaf_size,
+    pcl::VoxelGrid<PointT>& grid) const
+{
+  if (leaf_size <= 0.0f)
+    return (cloud);
+
+  typename pcl::PointCloud<PointT>::Ptr downsampled(new pcl::PointCloud<PointT>);
+  grid.setLeafSize(leaf_size, leaf_size, leaf_size);
+  grid.setInputCloud(cloud);
+  grid.filter(*downsampled);
+  return (downsampled);
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+PyramidRegistration<PointSource, PointTarget, Scalar>::align(PointCloudSource& output,
+                                                             const Matrix4& guess)
+{
+  converged_ = false;
+  if (!registration_) {
+    PCL_ERROR("[pcl::registration::PyramidRegistration::align] No registration method "
+              "was given!\n");
+    return;
+  }
+  if (!source_ || !target_) {
+    PCL_ERROR("[pcl::registration::PyramidRegistration::align] No input source or "
+              "target was given!\n");
+    return;
+  }
+  if (levels_.empty()) {
+    PCL_ERROR("[pcl::registration::PyramidRegistration::align] No levels were "
+              "added!\n");
+    return;
+  }
+
+  // Build the missing levels. The ones of the target, and their search trees, are
+  // kept until the target or the levels change.
+  const KdTreePtr registration_tree = registration_->getSearchMethodTarget();
+  if (source_levels_.empty()) {
+    for (const auto& level : levels_)
+      source_levels_.push_back(
+          downsample<PointSource>(source_, level.leaf_size, source_grid_));
+  }
+  if (target_levels_.empty()) {
+    for (const auto& level : levels_) {
+      target_levels_.push_back(
+          downsample<PointTarget>(target_, level.leaf_size, target_grid_));
+      KdTreePtr tree(new KdTree);
+      // Other trees deriving from search::KdTree, e.g. IncrementalKdTree, do not hold
+      // a FLANN tree whose point representation could be taken over
+      if (registration_tree && registration_tree->getName() == "KdTree")
+        tree->setPointRepresentation(registration_tree->getPointRepresentation());
+      tree->setInputCloud(target_levels_.back());
+      target_trees_.push_back(tree);
+    }
+  }
+
+  final_transformation_ = guess;
+  for (std::size_t i = 0; i < levels_.size(); ++i) {
+    const Level& level = levels_[i];
+    registration_->setMaximumIterations(level.max_iterations);
+    registration_->setMaxCorrespondenceDistance(level.max_correspondence_distance);
+    registration_->setTransformationEpsilon(level.transformation_epsilon);
+    registration_->setEuclideanFitnessEpsilon(level.euclidean_fitness_epsilon);
+    registration_->setInputSource(source_levels_[i]);
+    registration_->setInputTarget(target_levels_[i]);
+    registration_->setSearchMethodTarget(target_trees_[i], true);
+
+    registration_->align(output, final_transformation_);
+    final_transformation_ = registration_->getFinalTransformation();
+    converged_ = registration_->hasConverged();
+
+    PCL_DEBUG("[pcl::registration::PyramidRegistration::align] Level %zu (leaf size "
+              "%g, %zu source and %zu target points) %s.\n",
+              i,
+              level.leaf_size,
+              static_cast<std::size_t>(source_levels_[i]->size()),
+              static_cast<std::size_t>(target_levels_[i]->size()),
+              converged_ ? "converged" : "did not converge");
+  }
+
+  // Give the registration its own search method back as it was, so that using it
+  // directly does not modify the tree of the finest level. It is not forced, so the
+  // registration builds it over its target when it is used.
+  if (registration_tree)
+    registration_->setSearchMethodTarget(registration_tree, false);
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+double
+PyramidRegistration<PointSource, PointTarget, Scalar>::getFitnessScore(
+    double max_range) const
+{
+  if (!registration_ || source_levels_.empty() || target_levels_.empty()) {
+    PCL_ERROR("[pcl::registration::PyramidRegistration::getFitnessScore] align has "
+              "not been called!\n");
+    return (std::numeric_limits<double>::max());
+  }
+
+  // Search the tree of the finest level directly, like
+  // Registration::getFitnessScore does with its own tree
+  const PointCloudSourceConstPtr& source = source_levels_.back();
+  PointCloudSource source_transformed;
+  transformPointCloud(*source, source_transformed, final_transformation_);
+
+  pcl::Indices nn_indices(1);
+  std::vector<float> nn_dists(1);
+  double fitness_score = 0.0;
+  int nr = 0;
+  for (const auto& point : source_transformed) {
+    if (!source->is_dense && !pcl::isXYZFinite(point))
+      continue;
+    target_trees_.back()->nearestKSearchT(point, 1, nn_indices, nn_dists);
+    if (nn_dists[0] <= max_range) {
+      fitness_score += nn_dists[0];
+      nr++;
+    }
+  }
+
+  if (nr > 0)
+    return (fitness_score / nr);
+  return (std::numeric_limits<double>::max());
+}
+
+} // namespace registration
+} // namespace pcl
+
+#endif /* PCL_REGISTRATION_IMPL_PYRAMID_REGISTRATION_HPP_ */
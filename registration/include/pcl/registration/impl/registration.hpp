@@ -133,6 +133,18 @@ template <typename PointSource, typename PointTarget, typename Scalar>
 inline double
 Registration<PointSource, PointTarget, Scalar>::getFitnessScore(double max_range)
 {
+  // Nothing to compare against, e.g. for NDT with a target map and a direct neighbor
+  // search, whose search tree was not built
+  if (!target_ || target_->empty())
+    return (std::numeric_limits<double>::max());
+
+  // Registrations which do not search the target points, e.g. VGICP, leave the target
+  // kd-tree unbuilt
+  if (!force_no_recompute_ && tree_->getInputCloud() != target_) {
+    tree_->setInputCloud(target_);
+    target_cloud_updated_ = false;
+  }
+
   double fitness_score = 0.0;
 
   // Transform the input dataset using the final transformation
@@ -41,6 +41,8 @@
 #ifndef PCL_REGISTRATION_SAMPLE_CONSENSUS_PREREJECTIVE_HPP_
 #define PCL_REGISTRATION_SAMPLE_CONSENSUS_PREREJECTIVE_HPP_
 
+#include <pcl/common/transforms.h>
+
 namespace pcl {
 
 template <typename PointSource, typename PointTarget, typename FeatureT>
@@ -149,6 +151,192 @@ SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::findSimilarFeat
   }
 }
 
+template <typename PointSource, typename PointTarget, typename FeatureT>
+void
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::selectSamples(
+    const PointCloudSource& cloud,
+    int nr_samples,
+    pcl::Indices& sample_indices,
+    HypothesisGenerator& generator) const
+{
+  sample_indices.resize(nr_samples);
+
+  // Draw random samples until n samples is reached, keeping them sorted
+  for (int i = 0; i < nr_samples; i++) {
+    sample_indices[i] = getRandomIndex(static_cast<int>(cloud.size()) - i, generator);
+
+    // Run through list of numbers, starting at the lowest, to avoid duplicates
+    for (int j = 0; j < i; j++) {
+      if (sample_indices[i] >= sample_indices[j]) {
+        sample_indices[i]++;
+      }
+      else {
+        const auto temp_sample = sample_indices[i];
+        for (int k = i; k > j; k--)
+          sample_indices[k] = sample_indices[k - 1];
+
+        sample_indices[j] = temp_sample;
+        break;
+      }
+    }
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+void
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::findSimilarFeatures(
+    const pcl::Indices& sample_indices,
+    std::vector<pcl::Indices>& similar_features,
+    pcl::Indices& corresponding_indices,
+    HypothesisGenerator& generator) const
+{
+  corresponding_indices.resize(sample_indices.size());
+  std::vector<float> nn_distances(k_correspondences_);
+
+  for (std::size_t i = 0; i < sample_indices.size(); ++i) {
+    const auto& idx = sample_indices[i];
+
+    // Find the k nearest feature neighbors to the sampled input feature if they are not
+    // in the cache already
+    if (similar_features[idx].empty())
+      feature_tree_->nearestKSearch(*input_features_,
+                                    idx,
+                                    k_correspondences_,
+                                    similar_features[idx],
+                                    nn_distances);
+
+    // Select one at random and add it to corresponding_indices
+    if (k_correspondences_ == 1)
+      corresponding_indices[i] = similar_features[idx][0];
+    else
+      corresponding_indices[i] =
+          similar_features[idx][getRandomIndex(k_correspondences_, generator)];
+  }
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+bool
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::getHypothesisFitness(
+    const Matrix4& transformation, pcl::Indices& inliers, float& fitness_score) const
+{
+  inliers.clear();
+  inliers.reserve(input_->size());
+  fitness_score = 0.0f;
+
+  // Use squared distance for comparison with NN search results
+  const float max_range = corr_dist_threshold_ * corr_dist_threshold_;
+  const Eigen::Affine3f transform(transformation);
+  const auto nr_points = static_cast<float>(input_->size());
+
+  pcl::Indices nn_indices(1);
+  std::vector<float> nn_dists(1);
+  std::size_t nr_outliers = 0;
+  for (std::size_t i = 0; i < input_->size(); ++i) {
+    // Find the nearest neighbor of the transformed point in the target
+    tree_->nearestKSearch(
+        pcl::transformPoint((*input_)[i], transform), 1, nn_indices, nn_dists);
+
+    if (nn_dists[0] < max_range) {
+      inliers.push_back(i);
+      fitness_score += nn_dists[0];
+    }
+    // Stop once the required inlier fraction can not be reached anymore
+    else if (static_cast<float>(input_->size() - ++nr_outliers) / nr_points <
+             inlier_fraction_)
+      return (false);
+  }
+
+  // Calculate MSE
+  if (!inliers.empty())
+    fitness_score /= static_cast<float>(inliers.size());
+  else
+    fitness_score = std::numeric_limits<float>::max();
+  return (static_cast<float>(inliers.size()) / nr_points >= inlier_fraction_);
+}
+
+template <typename PointSource, typename PointTarget, typename FeatureT>
+int
+SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::
+    computeHypotheses(float& lowest_error)
+{
+  // The best hypothesis of each thread as its error and number (-1 for none), with its
+  // transformation and inliers. The hypotheses are compared by error first and number
+  // second, so the result does not depend on how they are distributed over the threads.
+  std::vector<std::pair<float, int>> best_hypotheses(num_threads_,
+                                                     std::make_pair(lowest_error, -1));
+  std::vector<Matrix4, Eigen::aligned_allocator<Matrix4>> best_transformations(
+      num_threads_, Matrix4::Identity());
+  std::vector<pcl::Indices> best_inliers(num_threads_);
+  int num_rejections = 0;
+
+#pragma omp parallel num_threads(num_threads_) reduction(+ : num_rejections)
+  {
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num();
+#else
+    const int thread_num = 0;
+#endif
+    // Feature correspondence cache of this thread
+    std::vector<pcl::Indices> similar_features(input_->size());
+    pcl::Indices sample_indices;
+    pcl::Indices corresponding_indices;
+    pcl::Indices inliers;
+    Matrix4 transformation;
+
+#pragma omp for schedule(dynamic)
+    for (int i = 0; i < max_iterations_; ++i) {
+      // Every hypothesis draws from its own random stream
+      std::seed_seq seed_sequence{seed_, static_cast<unsigned int>(i)};
+      HypothesisGenerator generator(seed_sequence);
+
+      // Draw nr_samples_ random samples
+      selectSamples(*input_, nr_samples_, sample_indices, generator);
+
+      // Find corresponding features in the target cloud
+      findSimilarFeatures(
+          sample_indices, similar_features, corresponding_indices, generator);
+
+      // Apply prerejection
+      if (!correspondence_rejector_poly_->thresholdPolygon(sample_indices,
+                                                           corresponding_indices)) {
+        ++num_rejections;
+        continue;
+      }
+
+      // Estimate the transform from the correspondences
+      transformation_estimation_->estimateRigidTransformation(
+          *input_, sample_indices, *target_, corresponding_indices, transformation);
+
+      // Each thread handles its hypotheses in increasing order, so the first one with
+      // the lowest error is kept
+      float error;
+      auto& best_hypothesis = best_hypotheses[thread_num];
+      if (getHypothesisFitness(transformation, inliers, error) &&
+          error < best_hypothesis.first) {
+        best_hypothesis = std::make_pair(error, i);
+        best_transformations[thread_num] = transformation;
+        best_inliers[thread_num].swap(inliers);
+      }
+    }
+  }
+
+  int best_thread = -1;
+  for (int thread_num = 0; thread_num < static_cast<int>(num_threads_); ++thread_num) {
+    const auto& hypothesis = best_hypotheses[thread_num];
+    if (hypothesis.second < 0)
+      continue;
+    if (best_thread < 0 || hypothesis < best_hypotheses[best_thread])
+      best_thread = thread_num;
+  }
+  if (best_thread >= 0) {
+    lowest_error = best_hypotheses[best_thread].first;
+    final_transformation_ = best_transformations[best_thread];
+    inliers_.swap(best_inliers[best_thread]);
+    converged_ = true;
+  }
+  return (num_rejections);
+}
+
 template <typename PointSource, typename PointTarget, typename FeatureT>
 void
 SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::computeTransformation(
@@ -239,56 +427,9 @@ SampleConsensusPrerejective<PointSource, PointTarget, FeatureT>::computeTransfor
     }
   }
 
-  // Feature correspondence cache
-  std::vector<pcl::Indices> similar_features(input_->size());
-
-  // Start
-  for (int i = 0; i < max_iterations_; ++i) {
-    // Temporary containers
-    pcl::Indices sample_indices;
-    pcl::Indices corresponding_indices;
-
-    // Draw nr_samples_ random samples
-    selectSamples(*input_, nr_samples_, sample_indices);
-
-    // Find corresponding features in the target cloud
-    findSimilarFeatures(sample_indices, similar_features, corresponding_indices);
-
-    // Apply prerejection
-    if (!correspondence_rejector_poly_->thresholdPolygon(sample_indices,
-                                                         corresponding_indices)) {
-      ++num_rejections;
-      continue;
-    }
-
-    // Estimate the transform from the correspondences, write to transformation_
-    transformation_estimation_->estimateRigidTransformation(
-        *input_, sample_indices, *target_, corresponding_indices, transformation_);
-
-    // Take a backup of previous result
-    const Matrix4 final_transformation_prev = final_transformation_;
-
-    // Set final result to current transformation
-    final_transformation_ = transformation_;
-
-    // Transform the input and compute the error (uses input_ and final_transformation_)
-    getFitness(inliers, error);
-
-    // Restore previous result
-    final_transformation_ = final_transformation_prev;
-
-    // If the new fit is better, update results
-    inlier_fraction =
-        static_cast<float>(inliers.size()) / static_cast<float>(input_->size());
-
-    // Update result if pose hypothesis is better
-    if (inlier_fraction >= inlier_fraction_ && error < lowest_error) {
-      inliers_ = inliers;
-      lowest_error = error;
-      converged_ = true;
-      final_transformation_ = transformation_;
-    }
-  }
+  // The hypotheses are drawn from the seeded random streams for any number of
+  // threads, including one, so the result only depends on the seed
+  num_rejections = computeHypotheses(lowest_error);
 
   // Apply the final transformation
   if (converged_)
@@ -40,6 +40,7 @@
 #ifndef PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_LM_HPP_
 #define PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_LM_HPP_
 
+#include <pcl/registration/impl/levenberg_marquardt_accumulation.hpp>
 #include <pcl/registration/warp_point_rigid_6d.h>
 
 #include <unsupported/Eigen/NonLinearOptimization>
@@ -84,24 +85,23 @@ pcl::registration::TransformationEstimationLM<PointSource, PointTarget, MatScala
   VectorX x(n_unknowns);
   x.setZero();
 
-  // Set temporary pointers
-  tmp_src_ = &cloud_src;
-  tmp_tgt_ = &cloud_tgt;
-
-  OptimizationFunctor functor(static_cast<int>(cloud_src.size()), this);
-  Eigen::NumericalDiff<OptimizationFunctor> num_diff(functor);
-  // Eigen::LevenbergMarquardt<Eigen::NumericalDiff<OptimizationFunctor>, double> lm
-  // (num_diff);
-  Eigen::LevenbergMarquardt<Eigen::NumericalDiff<OptimizationFunctor>, MatScalar> lm(
-      num_diff);
-  int info = lm.minimize(x);
+  double residual_norm;
+  // Transform each source point and compute its distance to the corresponding target
+  // point, accumulating the normal equations in parallel
+  const auto residual = [&](std::ptrdiff_t i, const Matrix4& transform) {
+    Vector4 p_src_warped;
+    detail::warpPoint(transform, cloud_src[i], p_src_warped);
+    return (computeDistance(p_src_warped, cloud_tgt[i]));
+  };
+  const int info = detail::minimizeLevenbergMarquardt(
+      warp_point_, cloud_src.size(), residual, num_threads_, x, residual_norm);
 
   // Compute the norm of the residuals
   PCL_DEBUG(
       "[pcl::registration::TransformationEstimationLM::estimateRigidTransformation]");
   PCL_DEBUG("LM solver finished with exit code %i, having a residual norm of %g. \n",
             info,
-            lm.fvec.norm());
+            residual_norm);
   PCL_DEBUG("Final solution: [%f", x[0]);
   for (int i = 1; i < n_unknowns; ++i)
     PCL_DEBUG(" %f", x[i]);
@@ -110,9 +110,6 @@ pcl::registration::TransformationEstimationLM<PointSource, PointTarget, MatScala
   // Return the correct transformation
   warp_point_->setParam(x);
   transformation_matrix = warp_point_->getTransform();
-
-  tmp_src_ = nullptr;
-  tmp_tgt_ = nullptr;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -178,27 +175,23 @@ pcl::registration::TransformationEstimationLM<PointSource, PointTarget, MatScala
   VectorX x(n_unknowns);
   x.setConstant(n_unknowns, 0);
 
-  // Set temporary pointers
-  tmp_src_ = &cloud_src;
-  tmp_tgt_ = &cloud_tgt;
-  tmp_idx_src_ = &indices_src;
-  tmp_idx_tgt_ = &indices_tgt;
-
-  OptimizationFunctorWithIndices functor(static_cast<int>(indices_src.size()), this);
-  Eigen::NumericalDiff<OptimizationFunctorWithIndices> num_diff(functor);
-  // Eigen::LevenbergMarquardt<Eigen::NumericalDiff<OptimizationFunctorWithIndices> > lm
-  // (num_diff);
-  Eigen::LevenbergMarquardt<Eigen::NumericalDiff<OptimizationFunctorWithIndices>,
-                            MatScalar>
-      lm(num_diff);
-  int info = lm.minimize(x);
+  double residual_norm;
+  // Transform each source point and compute its distance to the corresponding target
+  // point, accumulating the normal equations in parallel
+  const auto residual = [&](std::ptrdiff_t i, const Matrix4& transform) {
+    Vector4 p_src_warped;
+    detail::warpPoint(transform, cloud_src[indices_src[i]], p_src_warped);
+    return (computeDistance(p_src_warped, cloud_tgt[indices_tgt[i]]));
+  };
+  const int info = detail::minimizeLevenbergMarquardt(
+      warp_point_, indices_src.size(), residual, num_threads_, x, residual_norm);
 
   // Compute the norm of the residuals
   PCL_DEBUG(
       "[pcl::registration::TransformationEstimationLM::estimateRigidTransformation] LM "
       "solver finished with exit code %i, having a residual norm of %g. \n",
       info,
-      lm.fvec.norm());
+      residual_norm);
   PCL_DEBUG("Final solution: [%f", x[0]);
   for (int i = 1; i < n_unknowns; ++i)
     PCL_DEBUG(" %f", x[i]);
@@ -207,10 +200,6 @@ pcl::registration::TransformationEstimationLM<PointSource, PointTarget, MatScala
   // Return the correct transformation
   warp_point_->setParam(x);
   transformation_matrix = warp_point_->getTransform();
-
-  tmp_src_ = nullptr;
-  tmp_tgt_ = nullptr;
-  tmp_idx_src_ = tmp_idx_tgt_ = nullptr;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
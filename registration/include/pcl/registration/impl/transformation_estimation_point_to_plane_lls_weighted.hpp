@@ -40,6 +40,7 @@
 #ifndef PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_POINT_TO_PLANE_LLS_WEIGHTED_HPP_
 #define PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_POINT_TO_PLANE_LLS_WEIGHTED_HPP_
 
+#include <pcl/registration/impl/point_to_plane_lls_accumulation.hpp>
 #include <pcl/cloud_iterator.h>
 
 namespace pcl {
@@ -201,11 +202,9 @@ TransformationEstimationPointToPlaneLLSWeighted<PointSource, PointTarget, Scalar
   using Vector6d = Eigen::Matrix<double, 6, 1>;
   using Matrix6d = Eigen::Matrix<double, 6, 6>;
 
-  Matrix6d ATA;
-  Vector6d ATb;
-  ATA.setZero();
-  ATb.setZero();
-
+  // Gather the valid correspondences into contiguous buffers
+  detail::PointToPlaneCorrespondenceBuffer buffer;
+  buffer.reserve(source_it.size());
   while (source_it.isValid() && target_it.isValid()) {
     if (!std::isfinite(source_it->x) || !std::isfinite(source_it->y) ||
         !std::isfinite(source_it->z) || !std::isfinite(target_it->x) ||
@@ -218,77 +217,25 @@ TransformationEstimationPointToPlaneLLSWeighted<PointSource, PointTarget, Scalar
       continue;
     }
 
-    const float& sx = source_it->x;
-    const float& sy = source_it->y;
-    const float& sz = source_it->z;
-    const float& dx = target_it->x;
-    const float& dy = target_it->y;
-    const float& dz = target_it->z;
-    const float& nx = target_it->normal[0] * (*weights_it);
-    const float& ny = target_it->normal[1] * (*weights_it);
-    const float& nz = target_it->normal[2] * (*weights_it);
-
-    double a = nz * sy - ny * sz;
-    double b = nx * sz - nz * sx;
-    double c = ny * sx - nx * sy;
-
-    //    0  1  2  3  4  5
-    //    6  7  8  9 10 11
-    //   12 13 14 15 16 17
-    //   18 19 20 21 22 23
-    //   24 25 26 27 28 29
-    //   30 31 32 33 34 35
-
-    ATA.coeffRef(0) += a * a;
-    ATA.coeffRef(1) += a * b;
-    ATA.coeffRef(2) += a * c;
-    ATA.coeffRef(3) += a * nx;
-    ATA.coeffRef(4) += a * ny;
-    ATA.coeffRef(5) += a * nz;
-    ATA.coeffRef(7) += b * b;
-    ATA.coeffRef(8) += b * c;
-    ATA.coeffRef(9) += b * nx;
-    ATA.coeffRef(10) += b * ny;
-    ATA.coeffRef(11) += b * nz;
-    ATA.coeffRef(14) += c * c;
-    ATA.coeffRef(15) += c * nx;
-    ATA.coeffRef(16) += c * ny;
-    ATA.coeffRef(17) += c * nz;
-    ATA.coeffRef(21) += nx * nx;
-    ATA.coeffRef(22) += nx * ny;
-    ATA.coeffRef(23) += nx * nz;
-    ATA.coeffRef(28) += ny * ny;
-    ATA.coeffRef(29) += ny * nz;
-    ATA.coeffRef(35) += nz * nz;
-
-    double d = nx * dx + ny * dy + nz * dz - nx * sx - ny * sy - nz * sz;
-    ATb.coeffRef(0) += a * d;
-    ATb.coeffRef(1) += b * d;
-    ATb.coeffRef(2) += c * d;
-    ATb.coeffRef(3) += nx * d;
-    ATb.coeffRef(4) += ny * d;
-    ATb.coeffRef(5) += nz * d;
+    buffer.push_back(source_it->x,
+                     source_it->y,
+                     source_it->z,
+                     target_it->x,
+                     target_it->y,
+                     target_it->z,
+                     target_it->normal[0] * (*weights_it),
+                     target_it->normal[1] * (*weights_it),
+                     target_it->normal[2] * (*weights_it));
 
     ++source_it;
     ++target_it;
     ++weights_it;
   }
 
-  ATA.coeffRef(6) = ATA.coeff(1);
-  ATA.coeffRef(12) = ATA.coeff(2);
-  ATA.coeffRef(13) = ATA.coeff(8);
-  ATA.coeffRef(18) = ATA.coeff(3);
-  ATA.coeffRef(19) = ATA.coeff(9);
-  ATA.coeffRef(20) = ATA.coeff(15);
-  ATA.coeffRef(24) = ATA.coeff(4);
-  ATA.coeffRef(25) = ATA.coeff(10);
-  ATA.coeffRef(26) = ATA.coeff(16);
-  ATA.coeffRef(27) = ATA.coeff(22);
-  ATA.coeffRef(30) = ATA.coeff(5);
-  ATA.coeffRef(31) = ATA.coeff(11);
-  ATA.coeffRef(32) = ATA.coeff(17);
-  ATA.coeffRef(33) = ATA.coeff(23);
-  ATA.coeffRef(34) = ATA.coeff(29);
+  // Approximate as a linear least squares problem
+  Matrix6d ATA;
+  Vector6d ATb;
+  detail::accumulatePointToPlaneSystem(buffer, num_threads_, ATA, ATb);
 
   // Solve A*x = b
   Vector6d x = static_cast<Vector6d>(ATA.inverse() * ATb);
@@ -39,6 +39,7 @@
 #ifndef PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_POINT_TO_PLANE_WEIGHTED_HPP_
 #define PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_POINT_TO_PLANE_WEIGHTED_HPP_
 
+#include <pcl/registration/impl/levenberg_marquardt_accumulation.hpp>
 #include <pcl/registration/distances.h>
 #include <pcl/registration/warp_point_rigid.h>
 #include <pcl/registration/warp_point_rigid_6d.h>
@@ -98,22 +99,24 @@ pcl::registration::
   VectorX x(n_unknowns);
   x.setZero();
 
-  // Set temporary pointers
-  tmp_src_ = &cloud_src;
-  tmp_tgt_ = &cloud_tgt;
-
-  OptimizationFunctor functor(static_cast<int>(cloud_src.size()), this);
-  Eigen::NumericalDiff<OptimizationFunctor> num_diff(functor);
-  Eigen::LevenbergMarquardt<Eigen::NumericalDiff<OptimizationFunctor>, MatScalar> lm(
-      num_diff);
-  int info = lm.minimize(x);
+  double residual_norm;
+  // Transform each source point and compute its weighted distance to the
+  // corresponding target point, accumulating the normal equations in parallel
+  const auto residual = [&](std::ptrdiff_t i, const Matrix4& transform) {
+    Vector4 p_src_warped;
+    detail::warpPoint(transform, cloud_src[i], p_src_warped);
+    return (correspondence_weights_[i] *
+            this->computeDistance(p_src_warped, cloud_tgt[i]));
+  };
+  const int info = detail::minimizeLevenbergMarquardt(
+      warp_point_, cloud_src.size(), residual, this->num_threads_, x, residual_norm);
 
   // Compute the norm of the residuals
   PCL_DEBUG("[pcl::registration::TransformationEstimationPointToPlaneWeighted::"
             "estimateRigidTransformation]");
   PCL_DEBUG("LM solver finished with exit code %i, having a residual norm of %g. \n",
             info,
-            lm.fvec.norm());
+            residual_norm);
   PCL_DEBUG("Final solution: [%f", x[0]);
   for (int i = 1; i < n_unknowns; ++i)
     PCL_DEBUG(" %f", x[i]);
@@ -122,9 +125,6 @@ pcl::registration::
   // Return the correct transformation
   warp_point_->setParam(x);
   transformation_matrix = warp_point_->getTransform();
-
-  tmp_src_ = NULL;
-  tmp_tgt_ = NULL;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -210,25 +210,24 @@ pcl::registration::
   VectorX x(n_unknowns);
   x.setConstant(n_unknowns, 0);
 
-  // Set temporary pointers
-  tmp_src_ = &cloud_src;
-  tmp_tgt_ = &cloud_tgt;
-  tmp_idx_src_ = &indices_src;
-  tmp_idx_tgt_ = &indices_tgt;
-
-  OptimizationFunctorWithIndices functor(static_cast<int>(indices_src.size()), this);
-  Eigen::NumericalDiff<OptimizationFunctorWithIndices> num_diff(functor);
-  Eigen::LevenbergMarquardt<Eigen::NumericalDiff<OptimizationFunctorWithIndices>,
-                            MatScalar>
-      lm(num_diff);
-  int info = lm.minimize(x);
+  double residual_norm;
+  // Transform each source point and compute its weighted distance to the
+  // corresponding target point, accumulating the normal equations in parallel
+  const auto residual = [&](std::ptrdiff_t i, const Matrix4& transform) {
+    Vector4 p_src_warped;
+    detail::warpPoint(transform, cloud_src[indices_src[i]], p_src_warped);
+    return (correspondence_weights_[i] *
+            this->computeDistance(p_src_warped, cloud_tgt[indices_tgt[i]]));
+  };
+  const int info = detail::minimizeLevenbergMarquardt(
+      warp_point_, indices_src.size(), residual, this->num_threads_, x, residual_norm);
 
   // Compute the norm of the residuals
   PCL_DEBUG("[pcl::registration::TransformationEstimationPointToPlaneWeighted::"
             "estimateRigidTransformation] LM solver finished with exit code %i, having "
             "a residual norm of %g. \n",
             info,
-            lm.fvec.norm());
+            residual_norm);
   PCL_DEBUG("Final solution: [%f", x[0]);
   for (int i = 1; i < n_unknowns; ++i)
     PCL_DEBUG(" %f", x[i]);
@@ -237,10 +236,6 @@ pcl::registration::
   // Return the correct transformation
   warp_point_->setParam(x);
   transformation_matrix = warp_point_->getTransform();
-
-  tmp_src_ = NULL;
-  tmp_tgt_ = NULL;
-  tmp_idx_src_ = tmp_idx_tgt_ = nullptr;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
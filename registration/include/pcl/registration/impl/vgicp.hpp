@@ -0,0 +1,237 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_VGICP_HPP_
+#define PCL_REGISTRATION_IMPL_VGICP_HPP_
+
+namespace pcl {
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+VoxelizedGeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+    computeTargetVoxels()
+{
+  target_cells_.setLeafSize(resolution_, resolution_, resolution_);
+  target_cells_.setInputCloud(target_);
+  // The voxels are looked up directly, so no kd-tree of their centroids is needed
+  target_cells_.filter(false);
+
+  voxel_means_.reset(new PointCloudTarget);
+  voxel_covariances_.clear();
+  // The usable voxels are stored in the order of their Leaf::valid_index_, so that a
+  // matched leaf gives its voxel without a lookup
+  for (const auto& leaf : target_cells_.getLeaves()) {
+    if (leaf.second.valid_index_ < 0)
+      continue;
+
+    PointTarget mean;
+    mean.getVector3fMap() = leaf.second.getMean().template cast<float>();
+    voxel_means_->push_back(mean);
+
+    // Keep the principal directions of the voxel, but regularize its covariance like
+    // GeneralizedIterativeClosestPoint::computeCovariances does for single points.
+    // The eigenvalues are sorted in increasing order.
+    const Eigen::Matrix3d& evecs = leaf.second.evecs_;
+    voxel_covariances_.push_back(
+        evecs * Eigen::Vector3d(gicp_epsilon_, 1.0, 1.0).asDiagonal() *
+        evecs.transpose());
+  }
+  PCL_DEBUG("[pcl::%s::computeTargetVoxels] Computed %zu voxels.\n",
+            getClassName().c_str(),
+            voxel_means_->size());
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+int
+VoxelizedGeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::findVoxel(
+    const PointSource& point, std::vector<TargetGridLeafConstPtr>& neighborhood) const
+{
+  PointTarget query;
+  query.getVector3fMap() = point.getVector3fMap();
+  target_cells_.getAllNeighborsAtPoint(query, neighborhood);
+
+  const Eigen::Vector3d p = point.getVector3fMap().template cast<double>();
+  double min_sqr_distance = corr_dist_threshold_ * corr_dist_threshold_;
+  TargetGridLeafConstPtr closest = nullptr;
+  for (const auto& leaf : neighborhood) {
+    const double sqr_distance = (leaf->mean_ - p).squaredNorm();
+    if (sqr_distance <= min_sqr_distance) {
+      min_sqr_distance = sqr_distance;
+      closest = leaf;
+    }
+  }
+  if (!closest)
+    return -1;
+  return closest->valid_index_;
+}
+
+template <typename PointSource, typename PointTarget, typename Scalar>
+void
+VoxelizedGeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+    computeTransformation(PointCloudSource& output, const Matrix4& guess)
+{
+  pcl::IterativeClosestPoint<PointSource, PointTarget, Scalar>::initComputeReciprocal();
+  const unsigned int nr_threads = this->getNumberOfThreads();
+
+  if (target_cells_updated_) {
+    computeTargetVoxels();
+    target_cells_updated_ = false;
+  }
+  if (voxel_means_->empty()) {
+    PCL_ERROR("[pcl::%s::computeTransformation] No voxels with a sufficient number of "
+              "points, try increasing the resolution!\n",
+              getClassName().c_str());
+    return;
+  }
+
+  // Compute input cloud covariance matrices
+  this->checkCovarianceCaches();
+  if (!source_covariance_cache_ &&
+      ((!input_covariances_) || (input_covariances_->empty()))) {
+    input_covariances_.reset(new MatricesVector);
+    this->template computeCovariances<PointSource>(
+        input_, tree_reciprocal_, *input_covariances_);
+  }
+  mahalanobis_.resize(input_->size(), Eigen::Matrix3d::Identity());
+
+  base_transformation_ = Matrix4::Identity();
+  nr_iterations_ = 0;
+  converged_ = false;
+  double delta = 0;
+
+  pcl::transformPointCloud(output, output, guess);
+  PointCloudSource output_transformed;
+  std::vector<int> matches(indices_->size());
+
+  while (!converged_) {
+    // guess corresponds to base_t and transformation_ to t
+    const Eigen::Matrix4d transform_R =
+        transformation_.template cast<double>() * guess.template cast<double>();
+    const Eigen::Matrix3d R = transform_R.topLeftCorner<3, 3>();
+
+    transformPointCloud(
+        output, output_transformed, transformation_.template cast<float>(), false);
+
+    // Match every source point with a voxel, and update its Mahalanobis matrix
+#pragma omp parallel default(none) num_threads(nr_threads)                              \
+    shared(matches, output_transformed, R)
+    {
+      std::vector<TargetGridLeafConstPtr> neighborhood;
+#pragma omp for schedule(dynamic, 256)
+      for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(indices_->size());
+           ++i) {
+        const auto index = (*indices_)[i];
+        const int match = findVoxel(output_transformed[index], neighborhood);
+        matches[i] = match;
+        if (match < 0)
+          continue;
+        const Eigen::Matrix3d C1 = this->getSourceCovariance(index);
+        const Eigen::Matrix3d& C2 = voxel_covariances_[match];
+        pcl::invert3x3SymMatrix<Eigen::Matrix3d>(R * C1 * R.transpose() + C2,
+                                                 mahalanobis_[index]);
+      }
+    }
+
+    pcl::Indices source_indices, target_indices;
+    source_indices.reserve(indices_->size());
+    target_indices.reserve(indices_->size());
+    for (std::size_t i = 0; i < indices_->size(); ++i) {
+      if (matches[i] < 0)
+        continue;
+      source_indices.push_back((*indices_)[i]);
+      target_indices.push_back(matches[i]);
+    }
+
+    /* optimize transformation using the current assignment and Mahalanobis metrics*/
+    previous_transformation_ = transformation_;
+    try {
+      rigid_transformation_estimation_(
+          output, source_indices, *voxel_means_, target_indices, transformation_);
+      /* compute the delta from this iteration */
+      delta = 0.;
+      for (int k = 0; k < 4; k++) {
+        for (int l = 0; l < 4; l++) {
+          double ratio = 1;
+          if (k < 3 && l < 3) // rotation part of the transform
+            ratio = 1. / rotation_epsilon_;
+          else
+            ratio = 1. / transformation_epsilon_;
+          double c_delta =
+              ratio * std::abs(previous_transformation_(k, l) - transformation_(k, l));
+          if (c_delta > delta)
+            delta = c_delta;
+        }
+      }
+    } catch (PCLException& e) {
+      PCL_DEBUG("[pcl::%s::computeTransformation] Optimization issue %s\n",
+                getClassName().c_str(),
+                e.what());
+      break;
+    }
+    nr_iterations_++;
+
+    if (update_visualizer_ != nullptr) {
+      PointCloudSourcePtr input_transformed(new PointCloudSource);
+      pcl::transformPointCloud(output, *input_transformed, transformation_);
+      update_visualizer_(
+          *input_transformed, source_indices, *voxel_means_, target_indices);
+    }
+
+    // Check for convergence
+    if (nr_iterations_ >= max_iterations_ || delta < 1) {
+      converged_ = true;
+      PCL_DEBUG("[pcl::%s::computeTransformation] Convergence reached. Number of "
+                "iterations: %d out of %d. Transformation difference: %f\n",
+                getClassName().c_str(),
+                nr_iterations_,
+                max_iterations_,
+                (transformation_ - previous_transformation_).array().abs().sum());
+      previous_transformation_ = transformation_;
+    }
+    else
+      PCL_DEBUG("[pcl::%s::computeTransformation] Convergence failed\n",
+                getClassName().c_str());
+  }
+  final_transformation_.noalias() = previous_transformation_ * guess;
+
+  // Transform the point cloud
+  pcl::transformPointCloud(*input_, output, final_transformation_);
+}
+
+} // namespace pcl
+
+#endif // PCL_REGISTRATION_IMPL_VGICP_HPP_
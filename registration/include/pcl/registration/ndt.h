@@ -42,6 +42,7 @@
 
 #include <pcl/common/utils.h>
 #include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/registration/ndt_map.h>
 #include <pcl/registration/registration.h>
 #include <pcl/memory.h>
 #include <pcl/pcl_macros.h>
@@ -89,6 +90,9 @@ protected:
   /** \brief Typename of const pointer to searchable voxel grid leaf. */
   using TargetGridLeafConstPtr = typename TargetGrid::LeafConstPtr;
 
+  /** \brief Typename of a voxel of a prebuilt target map. */
+  using TargetMapVoxelConstPtr = NormalDistributionsTransformMap::VoxelConstPtr;
+
 public:
   using Ptr =
       shared_ptr<NormalDistributionsTransform<PointSource, PointTarget, Scalar>>;
@@ -98,6 +102,19 @@ public:
   using Matrix4 = typename Registration<PointSource, PointTarget, Scalar>::Matrix4;
   using Affine3 = typename Eigen::Transform<Scalar, 3, Eigen::Affine>;
 
+  /** \brief Methods to find the voxels a transformed source point is scored against. */
+  enum class NeighborSearchMethod {
+    /** \brief Radius search of one resolution in the kd-tree of the voxel centroids. */
+    KDTREE,
+    /** \brief Direct lookup of the voxel containing the point. */
+    DIRECT1,
+    /** \brief Direct lookup of the voxel containing the point and its 6 face
+       neighbors. */
+    DIRECT7,
+    /** \brief Direct lookup of the voxel containing the point and its 26 neighbors. */
+    DIRECT27
+  };
+
   /** \brief Constructor.  Sets \ref outlier_ratio_ to 0.55, \ref step_size_ to
    * 0.1 and \ref resolution_ to 1.0
    */
@@ -113,16 +130,59 @@ public:
   inline void
   setInputTarget(const PointCloudTargetConstPtr& cloud) override
   {
+    target_map_.reset();
     Registration<PointSource, PointTarget, Scalar>::setInputTarget(cloud);
     init();
   }
 
-  /** \brief Set/change the voxel grid resolution.
+  /** \brief Provide a prebuilt map of normal distributions as the target (e.g., one
+   * loaded from disk), instead of computing the voxel grid from a target cloud. The
+   * resolution is taken from the map. With NeighborSearchMethod::KDTREE the voxel
+   * means become the input target used by e.g. getFitnessScore. The direct neighbor
+   * search methods do not need them, so they are not extracted, which would read
+   * every voxel of the map: the input target is then empty, and getFitnessScore
+   * returns std::numeric_limits<double>::max (). Calling setInputTarget discards the
+   * map.
+   * \note The voxels are read from the map during every alignment, so points
+   * inserted into or removed from it are taken into account by the next call to
+   * align. Call this function again to also update the voxel means used as input
+   * target.
+   * \param[in] map the target map, a null map is rejected
+   */
+  inline void
+  setTargetMap(const NormalDistributionsTransformMap::ConstPtr& map)
+  {
+    if (!map) {
+      PCL_ERROR("[pcl::%s::setTargetMap] Invalid target map given!\n",
+                getClassName().c_str());
+      return;
+    }
+    target_map_ = map;
+    resolution_ = static_cast<float>(map->getResolution());
+    setTargetMapCentroids();
+  }
+
+  /** \brief Get the prebuilt target map, nullptr if the target was given as a cloud.
+   */
+  inline NormalDistributionsTransformMap::ConstPtr
+  getTargetMap() const
+  {
+    return target_map_;
+  }
+
+  /** \brief Set/change the voxel grid resolution. Ignored while a target map is
+   * used, whose resolution is fixed.
    * \param[in] resolution side length of voxels
    */
   inline void
   setResolution(float resolution)
   {
+    if (target_map_) {
+      PCL_WARN("[pcl::%s::setResolution] The resolution of a target map can not be "
+               "changed!\n",
+               getClassName().c_str());
+      return;
+    }
     // Prevents unnecessary voxel initiations
     if (resolution_ != resolution) {
       resolution_ = resolution;
@@ -246,6 +306,56 @@ public:
     return nr_iterations_;
   }
 
+  /** \brief Set the method used to find the voxels a transformed source point is
+   * scored against. The direct lookups take constant time per point, independent of
+   * the number of voxels, while the default radius search in the kd-tree of the
+   * voxel centroids gets slower for large target maps.
+   * \param[in] method the neighbor search method
+   */
+  inline void
+  setNeighborSearchMethod(NeighborSearchMethod method)
+  {
+    const bool extract_centroids = target_map_ &&
+                                   method == NeighborSearchMethod::KDTREE &&
+                                   neighbor_search_method_ != method;
+    neighbor_search_method_ = method;
+    if (extract_centroids)
+      setTargetMapCentroids();
+  }
+
+  /** \brief Get the method used to find the voxels a transformed source point is
+   * scored against. */
+  inline NeighborSearchMethod
+  getNeighborSearchMethod() const
+  {
+    return neighbor_search_method_;
+  }
+
+  /** \brief Set the number of threads to use for the evaluation of the score, its
+   * gradient and hessian, including the evaluations done by the line search.
+   * \param nr_threads the number of hardware threads to use (0 sets the value back to
+   * automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads)
+  {
+#ifdef _OPENMP
+    num_threads_ = nr_threads != 0 ? nr_threads : omp_get_num_procs();
+#else
+    if (nr_threads != 1) {
+      PCL_WARN("OpenMP is not available. Keeping number of threads unchanged at 1\n");
+    }
+    num_threads_ = 1;
+#endif
+  }
+
+  /** \brief Get the number of threads used for the evaluation of the score. */
+  inline unsigned int
+  getNumberOfThreads() const
+  {
+    return num_threads_;
+  }
+
   /** \brief Get access to the `VoxelGridCovariance` generated from target cloud
    * containing point means and covariances. Set the input target cloud before calling
    * this. Useful for debugging, e.g.
@@ -293,6 +403,7 @@ protected:
   using Registration<PointSource, PointTarget, Scalar>::input_;
   using Registration<PointSource, PointTarget, Scalar>::indices_;
   using Registration<PointSource, PointTarget, Scalar>::target_;
+  using Registration<PointSource, PointTarget, Scalar>::target_cloud_updated_;
   using Registration<PointSource, PointTarget, Scalar>::nr_iterations_;
   using Registration<PointSource, PointTarget, Scalar>::max_iterations_;
   using Registration<PointSource, PointTarget, Scalar>::previous_transformation_;
@@ -338,6 +449,49 @@ protected:
               target_cells_.getCentroids()->size());
   }
 
+  /** \brief Set the means of the valid voxels of \ref target_map_ as the input
+   * target, or an empty input target for the direct neighbor search methods, which
+   * do not need it.
+   */
+  void
+  setTargetMapCentroids()
+  {
+    PointCloudTargetPtr centroids(new PointCloudTarget);
+    if (neighbor_search_method_ == NeighborSearchMethod::KDTREE) {
+      target_map_->getCentroids(*centroids);
+      Registration<PointSource, PointTarget, Scalar>::setInputTarget(centroids);
+      return;
+    }
+    // Registration::setInputTarget rejects empty clouds. The search tree is not
+    // built over it either, getFitnessScore does not search an empty target.
+    target_ = centroids;
+    target_cloud_updated_ = false;
+  }
+
+  /** \brief Find the voxels a transformed source point is scored against, using
+   * \ref neighbor_search_method_.
+   * \param[in] point the transformed source point
+   * \param[out] neighborhood the voxels
+   * \param[out] distances the squared distances to the voxel centroids, only
+   * filled by the kd-tree search
+   */
+  void
+  findNeighborhood(const PointSource& point,
+                   std::vector<TargetGridLeafConstPtr>& neighborhood,
+                   std::vector<float>& distances) const;
+
+  /** \brief Find the voxels of \ref target_map_ a transformed source point is scored
+   * against, using \ref neighbor_search_method_.
+   * \param[in] point the transformed source point
+   * \param[out] neighborhood the voxels
+   * \param[out] distances the squared distances to the voxel means, only filled by
+   * the radius search used for NeighborSearchMethod::KDTREE
+   */
+  void
+  findNeighborhood(const PointSource& point,
+                   std::vector<TargetMapVoxelConstPtr>& neighborhood,
+                   std::vector<float>& distances) const;
+
   /** \brief Compute derivatives of likelihood function w.r.t. the
    * transformation vector.
    * \note Equation 6.10, 6.12 and 6.13 [Magnusson 2009].
@@ -377,6 +531,33 @@ protected:
                     const Eigen::Matrix3d& c_inv,
                     bool compute_hessian = true) const;
 
+  /** \brief Compute individual point contributions to derivatives of
+   * likelihood function w.r.t. the transformation vector, using the given point
+   * derivatives.
+   * \note Equation 6.10, 6.12 and 6.13 [Magnusson 2009].
+   * \param[in,out] score_gradient the gradient vector of the likelihood
+   * function w.r.t. the transformation vector
+   * \param[in,out] hessian the hessian matrix of the likelihood function
+   * w.r.t. the transformation vector
+   * \param[in] point_jacobian the first order derivative of the transformation of
+   * the point, see computePointDerivatives
+   * \param[in] point_hessian the second order derivative of the transformation of
+   * the point, see computePointDerivatives
+   * \param[in] x_trans transformed point minus mean of occupied covariance
+   * voxel
+   * \param[in] c_inv covariance of occupied covariance voxel
+   * \param[in] compute_hessian flag to calculate hessian, unnecessary for step
+   * calculation.
+   */
+  double
+  updateDerivatives(Eigen::Matrix<double, 6, 1>& score_gradient,
+                    Eigen::Matrix<double, 6, 6>& hessian,
+                    const Eigen::Matrix<double, 3, 6>& point_jacobian,
+                    const Eigen::Matrix<double, 18, 6>& point_hessian,
+                    const Eigen::Vector3d& x_trans,
+                    const Eigen::Matrix3d& c_inv,
+                    bool compute_hessian = true) const;
+
   /** \brief Precompute angular components of derivatives.
    * \note Equation 6.19 and 6.21 [Magnusson 2009].
    * \param[in] transform the current transform vector
@@ -396,6 +577,22 @@ protected:
   void
   computePointDerivatives(const Eigen::Vector3d& x, bool compute_hessian = true);
 
+  /** \brief Compute point derivatives into the given matrices.
+   * \note Equation 6.18-21 [Magnusson 2009].
+   * \param[in] x point from the input cloud
+   * \param[in,out] point_jacobian the first order derivative of the transformation
+   * of x, only the angular part is updated
+   * \param[in,out] point_hessian the second order derivative of the transformation
+   * of x, only the angular part is updated
+   * \param[in] compute_hessian flag to calculate hessian, unnecessary for step
+   * calculation.
+   */
+  void
+  computePointDerivatives(const Eigen::Vector3d& x,
+                          Eigen::Matrix<double, 3, 6>& point_jacobian,
+                          Eigen::Matrix<double, 18, 6>& point_hessian,
+                          bool compute_hessian = true) const;
+
   /** \brief Compute hessian of likelihood function w.r.t. the transformation
    * vector.
    * \note Equation 6.13 [Magnusson 2009].
@@ -421,6 +618,26 @@ protected:
                 const Eigen::Vector3d& x_trans,
                 const Eigen::Matrix3d& c_inv) const;
 
+  /** \brief Compute individual point contributions to hessian of likelihood
+   * function w.r.t. the transformation vector, using the given point derivatives.
+   * \note Equation 6.13 [Magnusson 2009].
+   * \param[in,out] hessian the hessian matrix of the likelihood function
+   * w.r.t. the transformation vector
+   * \param[in] point_jacobian the first order derivative of the transformation of
+   * the point, see computePointDerivatives
+   * \param[in] point_hessian the second order derivative of the transformation of
+   * the point, see computePointDerivatives
+   * \param[in] x_trans transformed point minus mean of occupied covariance
+   * voxel
+   * \param[in] c_inv covariance of occupied covariance voxel
+   */
+  void
+  updateHessian(Eigen::Matrix<double, 6, 6>& hessian,
+                const Eigen::Matrix<double, 3, 6>& point_jacobian,
+                const Eigen::Matrix<double, 18, 6>& point_hessian,
+                const Eigen::Vector3d& x_trans,
+                const Eigen::Matrix3d& c_inv) const;
+
   /** \brief Compute line search step length and update transform and
    * likelihood derivatives using More-Thuente method.
    * \note Search Algorithm [More, Thuente 1994]
@@ -582,6 +799,9 @@ protected:
    * and covariances. */
   TargetGrid target_cells_;
 
+  /** \brief The prebuilt target map, used instead of \ref target_cells_ if set. */
+  NormalDistributionsTransformMap::ConstPtr target_map_;
+
   /** \brief The side length of voxels. */
   float resolution_{1.0f};
 
@@ -630,6 +850,12 @@ protected:
    * 2009]. */
   Eigen::Matrix<double, 18, 6> point_hessian_;
 
+  /** \brief The number of threads the scheduler should use. */
+  unsigned int num_threads_{1};
+
+  /** \brief The method used to find the voxels a point is scored against. */
+  NeighborSearchMethod neighbor_search_method_{NeighborSearchMethod::KDTREE};
+
 public:
   PCL_MAKE_ALIGNED_OPERATOR_NEW
 };
@@ -0,0 +1,381 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/common/mapped_file.h>
+#include <pcl/memory.h>
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pcl {
+/** \brief A map of normal distributions for NormalDistributionsTransform, which
+ * can be updated incrementally and saved to disk.
+ *
+ * Every voxel keeps the running mean and scatter matrix of its points, so that
+ * points can be inserted and removed one scan at a time without rebuilding the
+ * map. The normal distributions of the modified voxels are recomputed at the end
+ * of each insert() or remove() call. Like VoxelGridCovariance, a voxel is used
+ * only if it has at least getMinPointPerVoxel() points, and small eigenvalues of
+ * its covariance are inflated.
+ *
+ * The voxels are stored in a flat array and found through an open addressing hash
+ * table of their grid coordinates. save() writes both as they are in memory, and
+ * load() maps the file read-only and only reads its header, so that a map can be
+ * used right away no matter its size: the pages of the file are loaded, and their
+ * hash table entries checked, when the voxels are looked up. The voxels are only
+ * copied into memory when the map is first modified.
+ *
+ * \code
+ * pcl::NormalDistributionsTransformMap::Ptr map (new pcl::NormalDistributionsTransformMap);
+ * map->load ("city.ndtmap");
+ * ndt.setTargetMap (map);
+ * ndt.align (output, guess);
+ * // fold the aligned scan into the map
+ * map->insert (output);
+ * \endcode
+ *
+ * \note Files are written in the native byte order.
+ * \note The map must not be modified while a registration uses it.
+ * \ingroup registration
+ */
+class PCL_EXPORTS NormalDistributionsTransformMap {
+public:
+  using Ptr = shared_ptr<NormalDistributionsTransformMap>;
+  using ConstPtr = shared_ptr<const NormalDistributionsTransformMap>;
+
+  /** \brief A voxel of the map. Plain data, so that it can be written to and
+   * mapped from disk as is. */
+  struct Voxel {
+    /** \brief Integer coordinates of the voxel in the grid. */
+    std::int32_t coordinates[3];
+    /** \brief Number of points in the voxel. */
+    std::int32_t nr_points;
+    /** \brief Whether the voxel has a usable normal distribution. */
+    std::int32_t valid;
+    std::int32_t padding;
+    /** \brief Running mean of the points. */
+    double mean[3];
+    /** \brief Running sum of the outer products of the deviations from the mean. */
+    double scatter[9];
+    /** \brief Covariance, with inflated small eigenvalues. */
+    double cov[9];
+    /** \brief Inverse of \ref cov. */
+    double icov[9];
+
+    /** \brief Get the mean of the points in the voxel. */
+    inline Eigen::Map<const Eigen::Vector3d>
+    getMean() const
+    {
+      return Eigen::Map<const Eigen::Vector3d>(mean);
+    }
+
+    /** \brief Get the voxel covariance. */
+    inline Eigen::Map<const Eigen::Matrix3d>
+    getCov() const
+    {
+      return Eigen::Map<const Eigen::Matrix3d>(cov);
+    }
+
+    /** \brief Get the inverse of the voxel covariance. */
+    inline Eigen::Map<const Eigen::Matrix3d>
+    getInverseCov() const
+    {
+      return Eigen::Map<const Eigen::Matrix3d>(icov);
+    }
+
+    /** \brief Get the number of points in the voxel. */
+    inline int
+    getPointCount() const
+    {
+      return nr_points;
+    }
+  };
+
+  /** \brief Const pointer to a voxel. */
+  using VoxelConstPtr = const Voxel*;
+
+  /** \brief Constructor.
+   * \param[in] resolution the side length of the voxels
+   */
+  NormalDistributionsTransformMap(double resolution = 1.0);
+
+  /** \brief Remove all voxels and set the side length of the voxels.
+   * \param[in] resolution the side length of the voxels
+   */
+  void
+  clear(double resolution);
+
+  /** \brief Get the side length of the voxels. */
+  inline double
+  getResolution() const
+  {
+    return resolution_;
+  }
+
+  /** \brief Set the minimum number of points required for a voxel to be used (must
+   * be 3 or greater for covariance calculation). Recomputes all voxels.
+   * \param[in] min_points_per_voxel the minimum number of points for a voxel
+   */
+  void
+  setMinPointPerVoxel(int min_points_per_voxel);
+
+  /** \brief Get the minimum number of points required for a voxel to be used. */
+  inline int
+  getMinPointPerVoxel() const
+  {
+    return min_points_per_voxel_;
+  }
+
+  /** \brief Set the minimum allowable ratio between eigenvalues to prevent singular
+   * covariance matrices. Recomputes all voxels.
+   * \param[in] min_covar_eigvalue_mult the minimum allowable ratio between
+   * eigenvalues
+   */
+  void
+  setCovEigValueInflationRatio(double min_covar_eigvalue_mult);
+
+  /** \brief Get the minimum allowable ratio between eigenvalues. */
+  inline double
+  getCovEigValueInflationRatio() const
+  {
+    return min_covar_eigvalue_mult_;
+  }
+
+  /** \brief Get the number of voxels, including the ones without a usable normal
+   * distribution. */
+  inline std::size_t
+  size() const
+  {
+    return nr_voxels_;
+  }
+
+  /** \brief Get the number of voxels with a usable normal distribution. */
+  inline std::size_t
+  getNumberOfValidVoxels() const
+  {
+    return nr_valid_voxels_;
+  }
+
+  /** \brief Get the voxels, size() elements. */
+  inline const Voxel*
+  getVoxels() const
+  {
+    return voxels_data_;
+  }
+
+  /** \brief Add the finite points of a cloud to the map.
+   * \param[in] cloud the points, in the frame of the map
+   */
+  template <typename PointT>
+  void
+  insert(const pcl::PointCloud<PointT>& cloud);
+
+  /** \brief Remove the finite points of a cloud from the map, e.g. to fold out a
+   * scan that was inserted before. Points in empty voxels are ignored.
+   * \param[in] cloud the points, in the frame of the map
+   */
+  template <typename PointT>
+  void
+  remove(const pcl::PointCloud<PointT>& cloud);
+
+  /** \brief Get the means of the voxels with a usable normal distribution.
+   * \param[out] centroids the means of the voxels
+   */
+  template <typename PointT>
+  void
+  getCentroids(pcl::PointCloud<PointT>& centroids) const;
+
+  /** \brief Get the voxel containing a point, if it has a usable normal distribution.
+   * \param[in] point the query point
+   * \return the voxel or nullptr
+   */
+  VoxelConstPtr
+  getVoxel(const Eigen::Vector3f& point) const;
+
+  /** \brief Get the voxel at p (up to 1 voxel).
+   * \param[in] point the query point
+   * \param[out] neighbors the voxels with a usable normal distribution
+   * \return number of neighbors found
+   */
+  int
+  getVoxelAtPoint(const Eigen::Vector3f& point,
+                  std::vector<VoxelConstPtr>& neighbors) const;
+
+  /** \brief Get the voxel at p and its facing voxels (up to 7 voxels).
+   * \param[in] point the query point
+   * \param[out] neighbors the voxels with a usable normal distribution
+   * \return number of neighbors found
+   */
+  int
+  getFaceNeighborsAtPoint(const Eigen::Vector3f& point,
+                          std::vector<VoxelConstPtr>& neighbors) const;
+
+  /** \brief Get all 3x3x3 neighbor voxels of p (up to 27 voxels).
+   * \param[in] point the query point
+   * \param[out] neighbors the voxels with a usable normal distribution
+   * \return number of neighbors found
+   */
+  int
+  getAllNeighborsAtPoint(const Eigen::Vector3f& point,
+                         std::vector<VoxelConstPtr>& neighbors) const;
+
+  /** \brief Search for the voxels whose mean is within a radius of the query point.
+   * \param[in] point the query point
+   * \param[in] radius the radius of the sphere bounding the means
+   * \param[out] neighbors the voxels with a usable normal distribution
+   * \param[out] sqr_distances the squared distances to the means
+   * \return number of neighbors found
+   */
+  int
+  radiusSearch(const Eigen::Vector3f& point,
+               double radius,
+               std::vector<VoxelConstPtr>& neighbors,
+               std::vector<float>& sqr_distances) const;
+
+  /** \brief Save the map to a file.
+   * \param[in] file_name the name of the file
+   * \return 0 on success, -1 on error
+   */
+  int
+  save(const std::string& file_name) const;
+
+  /** \brief Load a map from a file written by save(). The file is mapped into
+   * memory and stays in use until the map is modified, cleared or destroyed. Only
+   * the header is checked, the voxels are read when they are looked up.
+   * \param[in] file_name the name of the file
+   * \return 0 on success, -1 on error (the map is then empty)
+   */
+  int
+  load(const std::string& file_name);
+
+protected:
+  /** \brief Marker of an empty slot of the hash table. */
+  static constexpr std::uint32_t empty_slot_ = 0xFFFFFFFF;
+
+  /** \brief Get the grid coordinates of the voxel containing a point.
+   * \return false if the coordinates do not fit into 32 bit integers
+   */
+  bool
+  getCoordinates(const Eigen::Vector3f& point, Eigen::Vector3i& coordinates) const;
+
+  /** \brief Get the index of the voxel with the given coordinates, empty_slot_ if
+   * there is none. */
+  std::uint32_t
+  findVoxel(const Eigen::Vector3i& coordinates) const;
+
+  /** \brief Get the neighbors at the given offsets of the voxel containing a point. */
+  int
+  getNeighborhoodAtPoint(const Eigen::Vector3f& point,
+                         const int (*offsets)[3],
+                         std::size_t nr_offsets,
+                         std::vector<VoxelConstPtr>& neighbors) const;
+
+  /** \brief Copy the voxels and the hash table of a loaded file into memory, so
+   * that they can be modified. */
+  void
+  makeWritable();
+
+  /** \brief Add a point to the running statistics of its voxel, creating the voxel
+   * if needed.
+   * \return the index of the voxel, or empty_slot_ if the point is out of range
+   */
+  std::uint32_t
+  addPoint(const Eigen::Vector3f& point);
+
+  /** \brief Remove a point from the running statistics of its voxel.
+   * \return the index of the voxel, or empty_slot_ if there is no such voxel
+   */
+  std::uint32_t
+  removePoint(const Eigen::Vector3f& point);
+
+  /** \brief Recompute the normal distributions of the given voxels. */
+  void
+  updateVoxels(const std::vector<std::uint32_t>& indices);
+
+  /** \brief Recompute the normal distribution of a voxel from its running
+   * statistics. */
+  void
+  updateVoxel(Voxel& voxel) const;
+
+  /** \brief Rebuild the hash table with the given number of slots (a power of 2). */
+  void
+  rehash(std::size_t nr_slots);
+
+  /** \brief The side length of the voxels. */
+  double resolution_;
+
+  /** \brief 1 / resolution_. */
+  double inverse_resolution_;
+
+  /** \brief Minimum number of points in a voxel to use it. */
+  int min_points_per_voxel_{6};
+
+  /** \brief Minimum allowable ratio between eigenvalues. */
+  double min_covar_eigvalue_mult_{0.01};
+
+  /** \brief The voxels, when the map is in memory. */
+  std::vector<Voxel> voxels_;
+
+  /** \brief Open addressing hash table of voxel indices, when the map is in memory. */
+  std::vector<std::uint32_t> table_;
+
+  /** \brief The loaded file, while the map has not been modified. */
+  pcl::MappedFile mapped_file_;
+
+  /** \brief The voxels, either in \ref voxels_ or in \ref mapped_file_. */
+  const Voxel* voxels_data_{nullptr};
+
+  /** \brief The hash table, either in \ref table_ or in \ref mapped_file_. */
+  const std::uint32_t* table_data_{nullptr};
+
+  /** \brief Number of voxels. */
+  std::size_t nr_voxels_{0};
+
+  /** \brief Number of voxels with a usable normal distribution. */
+  std::size_t nr_valid_voxels_{0};
+
+  /** \brief Number of slots of the hash table, a power of 2. */
+  std::size_t nr_slots_{0};
+};
+} // namespace pcl
+
+#include <pcl/registration/impl/ndt_map.hpp>
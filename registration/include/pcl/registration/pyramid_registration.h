@@ -0,0 +1,301 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/registration/registration.h>
+#include <pcl/point_cloud.h>
+
+#include <limits>
+#include <vector>
+
+namespace pcl {
+namespace registration {
+
+/** \brief Coarse-to-fine driver for any @ref Registration method.
+ *
+ * The source and target clouds are downsampled with a VoxelGrid into one level per
+ * call of addLevel, and the wrapped registration is run on every level in the order
+ * in which the levels were added, each level starting from the result of the
+ * previous one. Most iterations are thus spent on small clouds, and the last levels
+ * only have to refine an already good estimate. Every level has its own maximum
+ * number of iterations, correspondence distance and convergence thresholds, which
+ * overwrite the ones of the wrapped registration.
+ *
+ * The levels of the target and their search trees are built once and kept until the
+ * target or the levels change, so aligning several sources against the same target
+ * only downsamples the sources. The trees are handed to the registration with
+ * setSearchMethodTarget, so only methods which search the target through that search
+ * method (e.g. ICP and GICP) benefit from this reuse. Methods which build their own
+ * target representation (e.g. NDT) get no reuse and rebuild it on every level.
+ *
+ * \code
+ * IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp
+ *   (new IterativeClosestPoint<PointXYZ, PointXYZ>);
+ *
+ * PyramidRegistration<PointXYZ, PointXYZ> pyramid;
+ * pyramid.setRegistration (icp);
+ * pyramid.addLevel (0.4f, 30, 2.0);
+ * pyramid.addLevel (0.1f, 20, 0.5);
+ * pyramid.addLevel (0.0f, 10, 0.15); // full resolution
+ * pyramid.setInputTarget (map);
+ *
+ * for (const auto& scan : scans)
+ * {
+ *   pyramid.setInputSource (scan);
+ *   pyramid.align (aligned, guess);
+ *   guess = pyramid.getFinalTransformation ();
+ * }
+ * \endcode
+ *
+ * \note With a leaf size of 0 a level uses the clouds at full resolution. VoxelGrid
+ * averages all fields of the points in a voxel, so normals of coarse levels are not
+ * of unit length.
+ * \ingroup registration
+ */
+template <typename PointSource, typename PointTarget, typename Scalar = float>
+class PyramidRegistration {
+public:
+  using Ptr = shared_ptr<PyramidRegistration<PointSource, PointTarget, Scalar>>;
+  using ConstPtr =
+      shared_ptr<const PyramidRegistration<PointSource, PointTarget, Scalar>>;
+
+  using RegistrationType = pcl::Registration<PointSource, PointTarget, Scalar>;
+  using RegistrationPtr = typename RegistrationType::Ptr;
+  using Matrix4 = typename RegistrationType::Matrix4;
+  using KdTree = typename RegistrationType::KdTree;
+  using KdTreePtr = typename RegistrationType::KdTreePtr;
+
+  using PointCloudSource = pcl::PointCloud<PointSource>;
+  using PointCloudSourcePtr = typename PointCloudSource::Ptr;
+  using PointCloudSourceConstPtr = typename PointCloudSource::ConstPtr;
+
+  using PointCloudTarget = pcl::PointCloud<PointTarget>;
+  using PointCloudTargetPtr = typename PointCloudTarget::Ptr;
+  using PointCloudTargetConstPtr = typename PointCloudTarget::ConstPtr;
+
+  /** \brief Parameters of one level of the pyramid. */
+  struct Level {
+    /** \brief The leaf size of the VoxelGrid, 0 for the full resolution. */
+    float leaf_size;
+    /** \brief The maximum number of iterations of the registration. */
+    int max_iterations;
+    /** \brief The maximum distance between corresponding points. */
+    double max_correspondence_distance;
+    /** \brief The transformation epsilon of the registration. */
+    double transformation_epsilon;
+    /** \brief The euclidean fitness epsilon of the registration. */
+    double euclidean_fitness_epsilon;
+  };
+
+  PyramidRegistration() : final_transformation_(Matrix4::Identity()) {}
+
+  /** \brief Empty destructor */
+  virtual ~PyramidRegistration() = default;
+
+  /** \brief Set the registration method run on every level. */
+  inline void
+  setRegistration(const RegistrationPtr& registration)
+  {
+    registration_ = registration;
+  }
+
+  /** \brief Get the registration method run on every level. */
+  inline RegistrationPtr
+  getRegistration() const
+  {
+    return (registration_);
+  }
+
+  /** \brief Append a level to the pyramid. Levels are processed in the order in which
+   * they are added, so add them from coarse to fine.
+   * \param[in] leaf_size the leaf size used to downsample both clouds (0 for the full
+   * resolution)
+   * \param[in] max_iterations the maximum number of iterations on this level
+   * \param[in] max_correspondence_distance the maximum correspondence distance on this
+   * level
+   * \param[in] transformation_epsilon the transformation epsilon on this level
+   * \param[in] euclidean_fitness_epsilon the euclidean fitness epsilon on this level
+   */
+  void
+  addLevel(float leaf_size,
+           int max_iterations,
+           double max_correspondence_distance,
+           double transformation_epsilon = 0.0,
+           double euclidean_fitness_epsilon = -std::numeric_limits<double>::max());
+
+  /** \brief Get the levels of the pyramid. */
+  inline const std::vector<Level>&
+  getLevels() const
+  {
+    return (levels_);
+  }
+
+  /** \brief Remove all levels. */
+  void
+  clearLevels();
+
+  /** \brief Provide a pointer to the input source. Its levels are built by the next
+   * call to align. \param[in] cloud the input point cloud source
+   */
+  void
+  setInputSource(const PointCloudSourceConstPtr& cloud);
+
+  /** \brief Get a pointer to the input source. */
+  inline PointCloudSourceConstPtr
+  getInputSource() const
+  {
+    return (source_);
+  }
+
+  /** \brief Provide a pointer to the input target. Its levels and their search trees
+   * are built by the next call to align and reused by the following ones.
+   * \param[in] cloud the input point cloud target
+   */
+  void
+  setInputTarget(const PointCloudTargetConstPtr& cloud);
+
+  /** \brief Get a pointer to the input target. */
+  inline PointCloudTargetConstPtr
+  getInputTarget() const
+  {
+    return (target_);
+  }
+
+  /** \brief Register the input source to the input target, from the coarsest to the
+   * finest level.
+   * \param[out] output the source of the finest level, transformed by the final
+   * transformation (the full resolution source if the leaf size of the finest level is
+   * 0)
+   * \param[in] guess the initial guess of the transformation
+   */
+  void
+  align(PointCloudSource& output, const Matrix4& guess = Matrix4::Identity());
+
+  /** \brief Whether the registration converged on the finest level. */
+  inline bool
+  hasConverged() const
+  {
+    return (converged_);
+  }
+
+  /** \brief Obtain the Euclidean fitness score of the finest level (i.e., the mean of
+   * the squared distances from the source of the finest level to the target of the
+   * finest level), searched in the tree of that level. The wrapped registration is not
+   * modified.
+   * \param[in] max_range maximum allowable distance between a point and its
+   * correspondence in the target (default: double::max)
+   */
+  double
+  getFitnessScore(double max_range = std::numeric_limits<double>::max()) const;
+
+  /** \brief Get the final transformation estimated on the finest level. */
+  inline Matrix4
+  getFinalTransformation() const
+  {
+    return (final_transformation_);
+  }
+
+  /** \brief Get the downsampled source of a level, as used by the last call to align.
+   * \param[in] level the index of the level
+   */
+  inline PointCloudSourceConstPtr
+  getSourceLevel(std::size_t level) const
+  {
+    return (level < source_levels_.size() ? source_levels_[level] : nullptr);
+  }
+
+  /** \brief Get the downsampled target of a level, as used by the last call to align.
+   * \param[in] level the index of the level
+   */
+  inline PointCloudTargetConstPtr
+  getTargetLevel(std::size_t level) const
+  {
+    return (level < target_levels_.size() ? target_levels_[level] : nullptr);
+  }
+
+protected:
+  /** \brief Downsample a cloud with the given leaf size, or return it unchanged if the
+   * leaf size is 0. */
+  template <typename PointT>
+  typename pcl::PointCloud<PointT>::ConstPtr
+  downsample(const typename pcl::PointCloud<PointT>::ConstPtr& cloud,
+             float leaf_size,
+             pcl::VoxelGrid<PointT>& grid) const;
+
+  /** \brief The registration method run on every level. */
+  RegistrationPtr registration_;
+
+  /** \brief The levels of the pyramid, from coarse to fine. */
+  std::vector<Level> levels_;
+
+  /** \brief The full resolution input source. */
+  PointCloudSourceConstPtr source_;
+
+  /** \brief The full resolution input target. */
+  PointCloudTargetConstPtr target_;
+
+  /** \brief The downsampled source of every level. */
+  std::vector<PointCloudSourceConstPtr> source_levels_;
+
+  /** \brief The downsampled target of every level. */
+  std::vector<PointCloudTargetConstPtr> target_levels_;
+
+  /** \brief The search tree over the target of every level. */
+  std::vector<KdTreePtr> target_trees_;
+
+  /** \brief The VoxelGrid used to build the levels of the source. */
+  pcl::VoxelGrid<PointSource> source_grid_;
+
+  /** \brief The VoxelGrid used to build the levels of the target. */
+  pcl::VoxelGrid<PointTarget> target_grid_;
+
+  /** \brief The transformation estimated on the finest level. */
+  Matrix4 final_transformation_;
+
+  /** \brief Whether the registration converged on the finest level. */
+  bool converged_{false};
+
+public:
+  PCL_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+} // namespace registration
+} // namespace pcl
+
+#include <pcl/registration/impl/pyramid_registration.hpp>
@@ -45,6 +45,8 @@
 #include <pcl/registration/transformation_estimation_svd.h>
 #include <pcl/registration/transformation_validation.h>
 
+#include <random>
+
 namespace pcl {
 /** \brief Pose estimation and alignment class using a prerejective RANSAC routine.
  *
@@ -243,7 +245,56 @@ public:
     return inliers_;
   }
 
+  /** \brief Set the number of threads used to generate and score the pose hypotheses.
+   * Every hypothesis draws its samples from its own random stream, seeded from the
+   * seed given in setSeed and the number of the hypothesis, so the result is the same
+   * for a given seed and any number of threads, including one.
+   * \note The transformation estimation must support concurrent calls, as the default
+   * TransformationEstimationSVD does.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value back
+   * to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads)
+  {
+#ifdef _OPENMP
+    num_threads_ = nr_threads != 0 ? nr_threads : omp_get_num_procs();
+#else
+    if (nr_threads != 1) {
+      PCL_WARN("OpenMP is not available. Keeping number of threads unchanged at 1\n");
+    }
+    num_threads_ = 1;
+#endif
+  }
+
+  /** \brief Get the number of threads used to generate and score the pose hypotheses.
+   */
+  unsigned int
+  getNumberOfThreads() const
+  {
+    return (num_threads_);
+  }
+
+  /** \brief Set the seed of the random streams of the pose hypotheses.
+   * \param[in] seed the seed
+   */
+  void
+  setSeed(unsigned int seed)
+  {
+    seed_ = seed;
+  }
+
+  /** \brief Get the seed of the random streams of the pose hypotheses. */
+  unsigned int
+  getSeed() const
+  {
+    return (seed_);
+  }
+
 protected:
+  /** \brief The random number generator of a single pose hypothesis. */
+  using HypothesisGenerator = std::minstd_rand;
+
   /** \brief Choose a random index between 0 and n-1
    * \param n the number of possible indices to choose from
    */
@@ -253,6 +304,18 @@ protected:
     return (static_cast<int>(n * (rand() / (RAND_MAX + 1.0))));
   };
 
+  /** \brief Choose a random index between 0 and n-1
+   * \param n the number of possible indices to choose from
+   * \param generator the random number generator of the current hypothesis
+   */
+  static inline int
+  getRandomIndex(int n, HypothesisGenerator& generator)
+  {
+    return (static_cast<int>(
+        n * (static_cast<double>(generator() - HypothesisGenerator::min()) /
+             (HypothesisGenerator::max() - HypothesisGenerator::min() + 1.0))));
+  };
+
   /** \brief Select \a nr_samples sample points from cloud while making sure that their
    * pairwise distances are greater than a user-defined minimum distance, \a
    * min_sample_distance. \param cloud the input point cloud \param nr_samples the
@@ -295,6 +358,49 @@ protected:
   void
   getFitness(pcl::Indices& inliers, float& fitness_score);
 
+  /** \brief Select \a nr_samples sample points from cloud for a single hypothesis, like
+   * selectSamples. \param cloud the input point cloud \param nr_samples the number of
+   * samples to select \param sample_indices the resulting sample indices \param
+   * generator the random number generator of the hypothesis
+   */
+  void
+  selectSamples(const PointCloudSource& cloud,
+                int nr_samples,
+                pcl::Indices& sample_indices,
+                HypothesisGenerator& generator) const;
+
+  /** \brief Find the corresponding points of the samples of a single hypothesis, like
+   * findSimilarFeatures. \param sample_indices the indices of each sample point \param
+   * similar_features correspondence cache of the calling thread \param
+   * corresponding_indices the resulting indices of each sample's corresponding point
+   * in the target cloud \param generator the random number generator of the hypothesis
+   */
+  void
+  findSimilarFeatures(const pcl::Indices& sample_indices,
+                      std::vector<pcl::Indices>& similar_features,
+                      pcl::Indices& corresponding_indices,
+                      HypothesisGenerator& generator) const;
+
+  /** \brief Obtain the fitness of a pose hypothesis, like getFitness, but stop as soon
+   * as the hypothesis can not reach the required inlier fraction anymore.
+   * \param transformation the pose hypothesis
+   * \param inliers indices of source point cloud inliers
+   * \param fitness_score output fitness score as RMSE
+   * \return false if the hypothesis does not reach the required inlier fraction
+   */
+  bool
+  getHypothesisFitness(const Matrix4& transformation,
+                       pcl::Indices& inliers,
+                       float& fitness_score) const;
+
+  /** \brief Generate and score the pose hypotheses with num_threads_ threads (one or
+   * more).
+   * \param lowest_error the error of the best pose so far, updated on return
+   * \return the number of rejected hypotheses
+   */
+  int
+  computeHypotheses(float& lowest_error);
+
   /** \brief The source point cloud's feature descriptors. */
   FeatureCloudConstPtr input_features_;
 
@@ -320,6 +426,12 @@ protected:
 
   /** \brief Inlier points of final transformation as indices into source */
   pcl::Indices inliers_;
+
+  /** \brief The number of threads the scheduler should use. */
+  unsigned int num_threads_{1};
+
+  /** \brief The seed of the random streams of the pose hypotheses. */
+  unsigned int seed_{12345u};
 };
 } // namespace pcl
 
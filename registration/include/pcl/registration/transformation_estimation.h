@@ -115,6 +115,15 @@ public:
                               const pcl::Correspondences& correspondences,
                               Matrix4& transformation_matrix) const = 0;
 
+  /** \brief Set the number of threads to use. Estimators that do not support
+   * multithreading ignore this setting.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value back
+   * to automatic)
+   */
+  virtual void
+  setNumberOfThreads(unsigned int /*nr_threads*/)
+  {}
+
   using Ptr = shared_ptr<TransformationEstimation<PointSource, PointTarget, Scalar>>;
   using ConstPtr =
       shared_ptr<const TransformationEstimation<PointSource, PointTarget, Scalar>>;
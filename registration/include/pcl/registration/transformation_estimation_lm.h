@@ -88,7 +88,8 @@ public:
   , tmp_tgt_(src.tmp_tgt_)
   , tmp_idx_src_(src.tmp_idx_src_)
   , tmp_idx_tgt_(src.tmp_idx_tgt_)
-  , warp_point_(src.warp_point_){};
+  , warp_point_(src.warp_point_)
+  , num_threads_(src.num_threads_){};
 
   /** \brief Copy operator.
    * \param[in] src the TransformationEstimationLM object to copy into this
@@ -101,6 +102,7 @@ public:
     tmp_idx_src_ = src.tmp_idx_src_;
     tmp_idx_tgt_ = src.tmp_idx_tgt_;
     warp_point_ = src.warp_point_;
+    num_threads_ = src.num_threads_;
     return (*this);
   }
 
@@ -168,6 +170,35 @@ public:
     warp_point_ = warp_fcn;
   }
 
+  /** \brief Set the number of threads used by the optimization. The normal equations
+   * are accumulated over blocks of correspondences in parallel, so the Jacobian is
+   * never stored and only the small damped system is solved serially. The blocks do
+   * not depend on the number of threads, and neither does the result.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value back
+   * to automatic)
+   * \note With more than one thread, computeDistance is called concurrently, so
+   * subclasses overriding it must keep it free of side effects.
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads) override
+  {
+#ifdef _OPENMP
+    num_threads_ = nr_threads != 0 ? nr_threads : omp_get_num_procs();
+#else
+    if (nr_threads != 1) {
+      PCL_WARN("OpenMP is not available. Keeping number of threads unchanged at 1\n");
+    }
+    num_threads_ = 1;
+#endif
+  }
+
+  /** \brief Get the number of threads used by the optimization. */
+  unsigned int
+  getNumberOfThreads() const
+  {
+    return (num_threads_);
+  }
+
 protected:
   /** \brief Compute the distance between a source point and its corresponding target
    * point \param[in] p_src The source point \param[in] p_tgt The target point \return
@@ -217,6 +248,9 @@ protected:
   typename pcl::registration::WarpPointRigid<PointSource, PointTarget, MatScalar>::Ptr
       warp_point_;
 
+  /** \brief The number of threads the scheduler should use. */
+  unsigned int num_threads_{1};
+
   /** Base functor all the models that need non linear optimization must
    * define their own one and implement operator() (const Eigen::VectorXd& x,
    * Eigen::VectorXd& fvec) or operator() (const Eigen::VectorXf& x, Eigen::VectorXf&
@@ -137,6 +137,30 @@ public:
     weights_ = weights;
   }
 
+  /** \brief Set the number of threads used to accumulate the normal equations.
+   * \param[in] nr_threads the number of hardware threads to use (0 sets the value back
+   * to automatic)
+   */
+  void
+  setNumberOfThreads(unsigned int nr_threads)
+  {
+#ifdef _OPENMP
+    num_threads_ = nr_threads != 0 ? nr_threads : omp_get_num_procs();
+#else
+    if (nr_threads != 1) {
+      PCL_WARN("OpenMP is not available. Keeping number of threads unchanged at 1\n");
+    }
+    num_threads_ = 1;
+#endif
+  }
+
+  /** \brief Get the number of threads used to accumulate the normal equations. */
+  unsigned int
+  getNumberOfThreads() const
+  {
+    return (num_threads_);
+  }
+
 protected:
   /** \brief Estimate a rigid rotation transformation between a source and a target
    * \param[in] source_it an iterator over the source point cloud dataset
@@ -166,6 +190,9 @@ protected:
                                 Matrix4& transformation_matrix) const;
 
   std::vector<Scalar> weights_;
+
+  /** \brief The number of threads the scheduler should use. */
+  unsigned int num_threads_{1};
 };
 } // namespace registration
 } // namespace pcl
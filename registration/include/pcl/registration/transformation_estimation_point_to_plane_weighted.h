@@ -96,7 +96,10 @@ public:
   , tmp_idx_tgt_(src.tmp_idx_tgt_)
   , warp_point_(src.warp_point_)
   , correspondence_weights_(src.correspondence_weights_)
-  , use_correspondence_weights_(src.use_correspondence_weights_){};
+  , use_correspondence_weights_(src.use_correspondence_weights_)
+  {
+    this->num_threads_ = src.num_threads_;
+  };
 
   /** \brief Copy operator.
    * \param[in] src the TransformationEstimationPointToPlaneWeighted object to copy into
@@ -112,6 +115,7 @@ public:
     warp_point_ = src.warp_point_;
     correspondence_weights_ = src.correspondence_weights_;
     use_correspondence_weights_ = src.use_correspondence_weights_;
+    this->num_threads_ = src.num_threads_;
     return (*this);
   }
 
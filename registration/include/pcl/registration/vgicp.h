@@ -0,0 +1,250 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/filters/voxel_grid_covariance.h>
+#include <pcl/registration/gicp.h>
+
+namespace pcl {
+/** \brief VoxelizedGeneralizedIterativeClosestPoint is a variant of
+ * GeneralizedIterativeClosestPoint which aggregates the target cloud into voxels, as
+ * described by Kenji Koide et al. in "Voxelized GICP for Fast and Accurate 3D Point
+ * Cloud Registration" (ICRA 2021).
+ *
+ * Instead of a covariance per target point, which needs a k nearest neighbor search
+ * for every point, the target is represented by the means and covariances of the
+ * voxels of a VoxelGridCovariance. Each source point is matched with the voxel among
+ * the one containing it and its 26 neighbors whose mean is closest, which only takes
+ * a constant number of hash lookups instead of a kd-tree search per iteration. The
+ * covariances of the voxels are regularized like the ones of GICP, i.e. they keep
+ * their principal directions but their eigenvalues are replaced by (epsilon, 1, 1).
+ *
+ * The covariances of the source points, the correspondences and the Newton
+ * optimization are evaluated using setNumberOfThreads() threads.
+ *
+ * \code
+ * pcl::VoxelizedGeneralizedIterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ> reg;
+ * reg.setResolution(1.0f);
+ * reg.setInputSource(src);
+ * reg.setInputTarget(tgt);
+ * reg.align(*output, guess);
+ * \endcode
+ * \ingroup registration
+ */
+template <typename PointSource, typename PointTarget, typename Scalar = float>
+class VoxelizedGeneralizedIterativeClosestPoint
+: public GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar> {
+public:
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::reg_name_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      getClassName;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::indices_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::target_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      target_cloud_updated_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::input_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      tree_reciprocal_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      nr_iterations_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      max_iterations_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      previous_transformation_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      final_transformation_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      transformation_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      transformation_epsilon_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::converged_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      corr_dist_threshold_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      update_visualizer_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      gicp_epsilon_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      rotation_epsilon_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      base_transformation_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      input_covariances_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      source_covariance_cache_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      mahalanobis_;
+  using GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+      rigid_transformation_estimation_;
+
+  using PointCloudSource =
+      typename GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+          PointCloudSource;
+  using PointCloudSourcePtr = typename PointCloudSource::Ptr;
+  using PointCloudSourceConstPtr = typename PointCloudSource::ConstPtr;
+
+  using PointCloudTarget =
+      typename GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+          PointCloudTarget;
+  using PointCloudTargetPtr = typename PointCloudTarget::Ptr;
+  using PointCloudTargetConstPtr = typename PointCloudTarget::ConstPtr;
+
+  using MatricesVector =
+      typename GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+          MatricesVector;
+  using Matrix4 =
+      typename GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::
+          Matrix4;
+
+  /** \brief Typename of the voxel grid of the target. */
+  using TargetGrid = VoxelGridCovariance<PointTarget>;
+  /** \brief Typename of a const pointer to a voxel of the target. */
+  using TargetGridLeafConstPtr = typename TargetGrid::LeafConstPtr;
+
+  using Ptr = shared_ptr<
+      VoxelizedGeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>>;
+  using ConstPtr = shared_ptr<
+      const VoxelizedGeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>>;
+
+  PCL_MAKE_ALIGNED_OPERATOR_NEW
+
+  /** \brief Empty constructor. */
+  VoxelizedGeneralizedIterativeClosestPoint()
+  {
+    reg_name_ = "VoxelizedGeneralizedIterativeClosestPoint";
+    corr_dist_threshold_ = resolution_;
+  }
+
+  /** \brief Provide a pointer to the input target (e.g., the point cloud that we want
+   * to align the input source to). The voxels are computed by the next call to align.
+   * The correspondences are searched in the voxels, so no kd-tree is built over the
+   * target unless getFitnessScore needs it.
+   * \param[in] target the input point cloud target
+   */
+  inline void
+  setInputTarget(const PointCloudTargetConstPtr& target) override
+  {
+    GeneralizedIterativeClosestPoint<PointSource, PointTarget, Scalar>::setInputTarget(
+        target);
+    target_cloud_updated_ = false;
+    target_cells_updated_ = true;
+  }
+
+  /** \brief Set the side length of the voxels of the target. Also sets the maximum
+   * correspondence distance to the same value, call setMaxCorrespondenceDistance
+   * afterwards to choose a different one.
+   * \param[in] resolution side length of the voxels
+   */
+  inline void
+  setResolution(float resolution)
+  {
+    if (resolution_ != resolution) {
+      resolution_ = resolution;
+      corr_dist_threshold_ = resolution;
+      target_cells_updated_ = true;
+    }
+  }
+
+  /** \brief Get the side length of the voxels of the target. */
+  inline float
+  getResolution() const
+  {
+    return resolution_;
+  }
+
+  /** \brief Set the minimum number of points required for a voxel to be used (must be
+   * 3 or greater for covariance calculation).
+   * \param[in] min_points_per_voxel the minimum number of points for a voxel
+   */
+  inline void
+  setMinPointPerVoxel(int min_points_per_voxel)
+  {
+    target_cells_.setMinPointPerVoxel(min_points_per_voxel);
+    target_cells_updated_ = true;
+  }
+
+  /** \brief Get access to the voxel grid of the target, computed by align. */
+  inline const TargetGrid&
+  getTargetCells() const
+  {
+    return target_cells_;
+  }
+
+protected:
+  /** \brief Rigid transformation computation method with initial guess.
+   * \param output the transformed input point cloud dataset using the rigid
+   * transformation found
+   * \param guess the initial guess of the transformation to compute
+   */
+  void
+  computeTransformation(PointCloudSource& output, const Matrix4& guess) override;
+
+  /** \brief Compute the voxels of the target, their means and regularized
+   * covariances. */
+  void
+  computeTargetVoxels();
+
+  /** \brief Find the voxel a transformed source point is matched with.
+   * \param[in] point the transformed source point
+   * \param[in] neighborhood buffer for the candidate voxels
+   * \return the index of the voxel in \ref voxel_means_ (its Leaf::valid_index_), or -1
+   * if there is none within the maximum correspondence distance
+   */
+  int
+  findVoxel(const PointSource& point,
+            std::vector<TargetGridLeafConstPtr>& neighborhood) const;
+
+  /** \brief The voxel grid of the target. */
+  TargetGrid target_cells_;
+
+  /** \brief Whether the voxels have to be recomputed by the next call to align. */
+  bool target_cells_updated_{true};
+
+  /** \brief The side length of the voxels. */
+  float resolution_{1.0f};
+
+  /** \brief The means of the usable voxels. */
+  PointCloudTargetPtr voxel_means_;
+
+  /** \brief The regularized covariances of the usable voxels, in the order of \ref
+   * voxel_means_. */
+  MatricesVector voxel_covariances_;
+};
+} // namespace pcl
+
+#include <pcl/registration/impl/vgicp.hpp>
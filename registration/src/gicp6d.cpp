@@ -113,13 +113,16 @@ GeneralizedIterativeClosestPoint6D::computeTransformation(PointCloudSource& outp
   // Set the mahalanobis matrices to identity
   mahalanobis_.resize(N, Eigen::Matrix3d::Identity());
 
+  checkCovarianceCaches();
   // Compute target cloud covariance matrices
-  if ((!target_covariances_) || (target_covariances_->empty())) {
+  if (!target_covariance_cache_ &&
+      ((!target_covariances_) || (target_covariances_->empty()))) {
     target_covariances_.reset(new MatricesVector);
     computeCovariances<PointTarget>(target_, tree_, *target_covariances_);
   }
   // Compute input cloud covariance matrices
-  if ((!input_covariances_) || (input_covariances_->empty())) {
+  if (!source_covariance_cache_ &&
+      ((!input_covariances_) || (input_covariances_->empty()))) {
     input_covariances_.reset(new MatricesVector);
     computeCovariances<PointSource>(input_, tree_reciprocal_, *input_covariances_);
   }
@@ -163,8 +166,8 @@ GeneralizedIterativeClosestPoint6D::computeTransformation(PointCloudSource& outp
       // Check if the distance to the nearest neighbor is smaller than the user imposed
       // threshold
       if (nn_dists[0] < dist_threshold) {
-        Eigen::Matrix3d& C1 = (*input_covariances_)[i];
-        Eigen::Matrix3d& C2 = (*target_covariances_)[nn_indices[0]];
+        const Eigen::Matrix3d C1 = getSourceCovariance(i);
+        const Eigen::Matrix3d C2 = getTargetCovariance(nn_indices[0]);
         Eigen::Matrix3d& M = mahalanobis_[i];
         // M = R*C1
         M = R * C1;
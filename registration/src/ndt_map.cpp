@@ -0,0 +1,551 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/registration/ndt_map.h>
+#include <pcl/console/print.h>
+
+#include <Eigen/Eigenvalues> // for SelfAdjointEigenSolver
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace {
+/** \brief Header of the files written by NormalDistributionsTransformMap::save. */
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t voxel_size;
+  double resolution;
+  double min_covar_eigvalue_mult;
+  std::int32_t min_points_per_voxel;
+  std::uint32_t reserved;
+  std::uint64_t nr_voxels;
+  std::uint64_t nr_valid_voxels;
+  std::uint64_t nr_slots;
+};
+
+// The voxels follow the header and have to stay aligned when the file is mapped
+static_assert(sizeof(FileHeader) % alignof(pcl::NormalDistributionsTransformMap::Voxel) ==
+                  0,
+              "NDT map file header breaks voxel alignment");
+
+constexpr char file_magic[8] = "PCLNDTM";
+constexpr std::uint32_t file_version = 2;
+
+// Offsets of the voxel itself and its facing voxels
+constexpr int face_offsets[7][3] = {
+    {0, 0, 0}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+// Offsets of all voxels of the 3x3x3 block centered at the voxel itself
+constexpr int all_offsets[27][3] = {
+    {0, 0, 0},    {-1, 0, 0},   {1, 0, 0},   {0, -1, 0},   {0, 1, 0},   {0, 0, -1},
+    {0, 0, 1},    {-1, -1, 0},  {-1, 1, 0},  {1, -1, 0},   {1, 1, 0},   {-1, 0, -1},
+    {-1, 0, 1},   {1, 0, -1},   {1, 0, 1},   {0, -1, -1},  {0, -1, 1},  {0, 1, -1},
+    {0, 1, 1},    {-1, -1, -1}, {-1, -1, 1}, {-1, 1, -1},  {-1, 1, 1},  {1, -1, -1},
+    {1, -1, 1},   {1, 1, -1},   {1, 1, 1}};
+
+inline std::size_t
+hashCoordinates(const Eigen::Vector3i& coordinates)
+{
+  std::uint64_t hash = static_cast<std::uint32_t>(coordinates[0]);
+  hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<std::uint32_t>(coordinates[1]);
+  hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<std::uint32_t>(coordinates[2]);
+  hash ^= hash >> 29;
+  hash *= 0xBF58476D1CE4E5B9ULL;
+  hash ^= hash >> 32;
+  return static_cast<std::size_t>(hash);
+}
+
+inline bool
+hasCoordinates(const pcl::NormalDistributionsTransformMap::Voxel& voxel,
+               const Eigen::Vector3i& coordinates)
+{
+  return voxel.coordinates[0] == coordinates[0] &&
+         voxel.coordinates[1] == coordinates[1] &&
+         voxel.coordinates[2] == coordinates[2];
+}
+} // namespace
+
+pcl::NormalDistributionsTransformMap::NormalDistributionsTransformMap(
+    double resolution)
+{
+  clear(resolution);
+}
+
+void
+pcl::NormalDistributionsTransformMap::clear(double resolution)
+{
+  resolution_ = resolution;
+  inverse_resolution_ = 1.0 / resolution;
+  voxels_.clear();
+  table_.clear();
+  mapped_file_.close();
+  voxels_data_ = nullptr;
+  table_data_ = nullptr;
+  nr_voxels_ = 0;
+  nr_valid_voxels_ = 0;
+  nr_slots_ = 0;
+}
+
+void
+pcl::NormalDistributionsTransformMap::setMinPointPerVoxel(int min_points_per_voxel)
+{
+  if (min_points_per_voxel > 2) {
+    min_points_per_voxel_ = min_points_per_voxel;
+  }
+  else {
+    PCL_WARN("[pcl::NormalDistributionsTransformMap::setMinPointPerVoxel] Covariance "
+             "calculation requires at least 3 points, setting Min Point per Voxel to "
+             "3\n");
+    min_points_per_voxel_ = 3;
+  }
+
+  if (nr_voxels_ == 0)
+    return;
+  makeWritable();
+  nr_valid_voxels_ = 0;
+  for (auto& voxel : voxels_) {
+    updateVoxel(voxel);
+    nr_valid_voxels_ += voxel.valid != 0;
+  }
+}
+
+void
+pcl::NormalDistributionsTransformMap::setCovEigValueInflationRatio(
+    double min_covar_eigvalue_mult)
+{
+  min_covar_eigvalue_mult_ = min_covar_eigvalue_mult;
+
+  if (nr_voxels_ == 0)
+    return;
+  makeWritable();
+  nr_valid_voxels_ = 0;
+  for (auto& voxel : voxels_) {
+    updateVoxel(voxel);
+    nr_valid_voxels_ += voxel.valid != 0;
+  }
+}
+
+bool
+pcl::NormalDistributionsTransformMap::getCoordinates(const Eigen::Vector3f& point,
+                                                    Eigen::Vector3i& coordinates) const
+{
+  for (int d = 0; d < 3; ++d) {
+    const double c = std::floor(point[d] * inverse_resolution_);
+    if (!(c >= std::numeric_limits<std::int32_t>::min() &&
+          c <= std::numeric_limits<std::int32_t>::max()))
+      return false;
+    coordinates[d] = static_cast<int>(c);
+  }
+  return true;
+}
+
+std::uint32_t
+pcl::NormalDistributionsTransformMap::findVoxel(const Eigen::Vector3i& coordinates) const
+{
+  if (nr_slots_ == 0)
+    return empty_slot_;
+
+  // The entries of a loaded file are only checked here, when they are looked up, so
+  // invalid indices are skipped and the probing is bounded
+  const std::size_t mask = nr_slots_ - 1;
+  std::size_t slot = hashCoordinates(coordinates) & mask;
+  for (std::size_t probe = 0; probe < nr_slots_; ++probe, slot = (slot + 1) & mask) {
+    const std::uint32_t index = table_data_[slot];
+    if (index == empty_slot_)
+      return empty_slot_;
+    if (index < nr_voxels_ && hasCoordinates(voxels_data_[index], coordinates))
+      return index;
+  }
+  return empty_slot_;
+}
+
+pcl::NormalDistributionsTransformMap::VoxelConstPtr
+pcl::NormalDistributionsTransformMap::getVoxel(const Eigen::Vector3f& point) const
+{
+  Eigen::Vector3i coordinates;
+  if (!getCoordinates(point, coordinates))
+    return nullptr;
+  const std::uint32_t index = findVoxel(coordinates);
+  if (index == empty_slot_ || !voxels_data_[index].valid)
+    return nullptr;
+  return &voxels_data_[index];
+}
+
+int
+pcl::NormalDistributionsTransformMap::getNeighborhoodAtPoint(
+    const Eigen::Vector3f& point,
+    const int (*offsets)[3],
+    std::size_t nr_offsets,
+    std::vector<VoxelConstPtr>& neighbors) const
+{
+  neighbors.clear();
+
+  Eigen::Vector3i coordinates;
+  if (!getCoordinates(point, coordinates))
+    return 0;
+
+  for (std::size_t i = 0; i < nr_offsets; ++i) {
+    const Eigen::Vector3i neighbor =
+        coordinates + Eigen::Vector3i(offsets[i][0], offsets[i][1], offsets[i][2]);
+    const std::uint32_t index = findVoxel(neighbor);
+    if (index != empty_slot_ && voxels_data_[index].valid)
+      neighbors.push_back(&voxels_data_[index]);
+  }
+  return static_cast<int>(neighbors.size());
+}
+
+int
+pcl::NormalDistributionsTransformMap::getVoxelAtPoint(
+    const Eigen::Vector3f& point, std::vector<VoxelConstPtr>& neighbors) const
+{
+  return getNeighborhoodAtPoint(point, face_offsets, 1, neighbors);
+}
+
+int
+pcl::NormalDistributionsTransformMap::getFaceNeighborsAtPoint(
+    const Eigen::Vector3f& point, std::vector<VoxelConstPtr>& neighbors) const
+{
+  return getNeighborhoodAtPoint(point, face_offsets, 7, neighbors);
+}
+
+int
+pcl::NormalDistributionsTransformMap::getAllNeighborsAtPoint(
+    const Eigen::Vector3f& point, std::vector<VoxelConstPtr>& neighbors) const
+{
+  return getNeighborhoodAtPoint(point, all_offsets, 27, neighbors);
+}
+
+int
+pcl::NormalDistributionsTransformMap::radiusSearch(
+    const Eigen::Vector3f& point,
+    double radius,
+    std::vector<VoxelConstPtr>& neighbors,
+    std::vector<float>& sqr_distances) const
+{
+  neighbors.clear();
+  sqr_distances.clear();
+
+  // The mean of a voxel lies inside of it, so only the voxels intersecting the
+  // bounding box of the sphere need to be checked
+  Eigen::Vector3i min_coordinates, max_coordinates;
+  if (!getCoordinates(point - Eigen::Vector3f::Constant(radius), min_coordinates) ||
+      !getCoordinates(point + Eigen::Vector3f::Constant(radius), max_coordinates))
+    return 0;
+
+  const double sqr_radius = radius * radius;
+  const Eigen::Vector3d p = point.cast<double>();
+  Eigen::Vector3i coordinates;
+  for (coordinates[2] = min_coordinates[2]; coordinates[2] <= max_coordinates[2];
+       ++coordinates[2])
+    for (coordinates[1] = min_coordinates[1]; coordinates[1] <= max_coordinates[1];
+         ++coordinates[1])
+      for (coordinates[0] = min_coordinates[0]; coordinates[0] <= max_coordinates[0];
+           ++coordinates[0]) {
+        const std::uint32_t index = findVoxel(coordinates);
+        if (index == empty_slot_ || !voxels_data_[index].valid)
+          continue;
+        const double sqr_distance =
+            (voxels_data_[index].getMean() - p).squaredNorm();
+        if (sqr_distance <= sqr_radius) {
+          neighbors.push_back(&voxels_data_[index]);
+          sqr_distances.push_back(static_cast<float>(sqr_distance));
+        }
+      }
+  return static_cast<int>(neighbors.size());
+}
+
+void
+pcl::NormalDistributionsTransformMap::makeWritable()
+{
+  if (!mapped_file_.isOpen())
+    return;
+
+  // The hash table and the number of valid voxels are rebuilt from the voxels, so
+  // that the entries of the file which were never looked up do not have to be trusted
+  voxels_.assign(voxels_data_, voxels_data_ + nr_voxels_);
+  mapped_file_.close();
+  voxels_data_ = voxels_.data();
+  nr_valid_voxels_ = 0;
+  for (const auto& voxel : voxels_)
+    nr_valid_voxels_ += voxel.valid != 0;
+  if (nr_slots_ != 0)
+    rehash(nr_slots_);
+  else
+    table_data_ = nullptr;
+}
+
+void
+pcl::NormalDistributionsTransformMap::rehash(std::size_t nr_slots)
+{
+  nr_slots_ = nr_slots;
+  table_.assign(nr_slots_, empty_slot_);
+  table_data_ = table_.data();
+
+  const std::size_t mask = nr_slots_ - 1;
+  for (std::size_t i = 0; i < nr_voxels_; ++i) {
+    const Eigen::Vector3i coordinates(voxels_[i].coordinates[0],
+                                      voxels_[i].coordinates[1],
+                                      voxels_[i].coordinates[2]);
+    std::size_t slot = hashCoordinates(coordinates) & mask;
+    while (table_[slot] != empty_slot_)
+      slot = (slot + 1) & mask;
+    table_[slot] = static_cast<std::uint32_t>(i);
+  }
+}
+
+std::uint32_t
+pcl::NormalDistributionsTransformMap::addPoint(const Eigen::Vector3f& point)
+{
+  Eigen::Vector3i coordinates;
+  if (!getCoordinates(point, coordinates))
+    return empty_slot_;
+
+  std::uint32_t index = findVoxel(coordinates);
+  if (index == empty_slot_) {
+    if (nr_voxels_ + 1 >= empty_slot_) {
+      PCL_ERROR("[pcl::NormalDistributionsTransformMap::insert] Too many voxels, "
+                "increase the resolution!\n");
+      return empty_slot_;
+    }
+    // Keep the load factor at or below 0.5
+    if (2 * (nr_voxels_ + 1) > nr_slots_)
+      rehash(std::max<std::size_t>(64, 2 * nr_slots_));
+
+    Voxel voxel{};
+    voxel.coordinates[0] = coordinates[0];
+    voxel.coordinates[1] = coordinates[1];
+    voxel.coordinates[2] = coordinates[2];
+    voxels_.push_back(voxel);
+    voxels_data_ = voxels_.data();
+    index = static_cast<std::uint32_t>(nr_voxels_++);
+
+    const std::size_t mask = nr_slots_ - 1;
+    std::size_t slot = hashCoordinates(coordinates) & mask;
+    while (table_[slot] != empty_slot_)
+      slot = (slot + 1) & mask;
+    table_[slot] = index;
+  }
+
+  // Welford update of the running mean and scatter matrix
+  Voxel& voxel = voxels_[index];
+  Eigen::Map<Eigen::Vector3d> mean(voxel.mean);
+  Eigen::Map<Eigen::Matrix3d> scatter(voxel.scatter);
+  const Eigen::Vector3d x = point.cast<double>();
+  const Eigen::Vector3d delta = x - mean;
+  ++voxel.nr_points;
+  mean += delta / voxel.nr_points;
+  scatter.noalias() += delta * (x - mean).transpose();
+  return index;
+}
+
+std::uint32_t
+pcl::NormalDistributionsTransformMap::removePoint(const Eigen::Vector3f& point)
+{
+  Eigen::Vector3i coordinates;
+  if (!getCoordinates(point, coordinates))
+    return empty_slot_;
+
+  const std::uint32_t index = findVoxel(coordinates);
+  if (index == empty_slot_ || voxels_[index].nr_points == 0)
+    return empty_slot_;
+
+  // Inverse of the Welford update in addPoint. Empty voxels are kept, so that the
+  // hash table never has to delete entries.
+  Voxel& voxel = voxels_[index];
+  Eigen::Map<Eigen::Vector3d> mean(voxel.mean);
+  Eigen::Map<Eigen::Matrix3d> scatter(voxel.scatter);
+  if (--voxel.nr_points == 0) {
+    mean.setZero();
+    scatter.setZero();
+    return index;
+  }
+  const Eigen::Vector3d x = point.cast<double>();
+  const Eigen::Vector3d old_mean = mean;
+  mean = ((voxel.nr_points + 1) * old_mean - x) / voxel.nr_points;
+  scatter.noalias() -= (x - mean) * (x - old_mean).transpose();
+  return index;
+}
+
+void
+pcl::NormalDistributionsTransformMap::updateVoxels(
+    const std::vector<std::uint32_t>& indices)
+{
+  std::vector<std::uint32_t> unique_indices = indices;
+  std::sort(unique_indices.begin(), unique_indices.end());
+  unique_indices.erase(std::unique(unique_indices.begin(), unique_indices.end()),
+                       unique_indices.end());
+
+  for (const auto index : unique_indices) {
+    Voxel& voxel = voxels_[index];
+    nr_valid_voxels_ -= voxel.valid;
+    updateVoxel(voxel);
+    nr_valid_voxels_ += voxel.valid != 0;
+  }
+}
+
+void
+pcl::NormalDistributionsTransformMap::updateVoxel(Voxel& voxel) const
+{
+  voxel.valid = 0;
+  if (voxel.nr_points < min_points_per_voxel_)
+    return;
+
+  Eigen::Map<Eigen::Matrix3d> cov(voxel.cov);
+  Eigen::Map<Eigen::Matrix3d> icov(voxel.icov);
+  cov = Eigen::Map<const Eigen::Matrix3d>(voxel.scatter) / (voxel.nr_points - 1.0);
+
+  // Same eigenvalue inflation as VoxelGridCovariance, to avoid matrices near
+  // singularities (eq 6.11)[Magnusson 2009]
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver(cov);
+  Eigen::Vector3d eigen_val = eigensolver.eigenvalues();
+  if (eigen_val[0] < -Eigen::NumTraits<double>::dummy_precision() ||
+      eigen_val[1] < -Eigen::NumTraits<double>::dummy_precision() ||
+      eigen_val[2] <= 0)
+    return;
+
+  const double min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val[2];
+  if (eigen_val[0] < min_covar_eigvalue) {
+    eigen_val[0] = min_covar_eigvalue;
+    if (eigen_val[1] < min_covar_eigvalue)
+      eigen_val[1] = min_covar_eigvalue;
+    const Eigen::Matrix3d& evecs = eigensolver.eigenvectors();
+    cov.noalias() = evecs * eigen_val.asDiagonal() * evecs.transpose();
+  }
+
+  icov = cov.inverse();
+  if (!icov.allFinite())
+    return;
+  voxel.valid = 1;
+}
+
+int
+pcl::NormalDistributionsTransformMap::save(const std::string& file_name) const
+{
+  FileHeader header{};
+  std::memcpy(header.magic, file_magic, sizeof(header.magic));
+  header.version = file_version;
+  header.voxel_size = sizeof(Voxel);
+  header.resolution = resolution_;
+  header.min_covar_eigvalue_mult = min_covar_eigvalue_mult_;
+  header.min_points_per_voxel = min_points_per_voxel_;
+  header.nr_voxels = nr_voxels_;
+  header.nr_valid_voxels = nr_valid_voxels_;
+  header.nr_slots = nr_slots_;
+
+  std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    PCL_ERROR("[pcl::NormalDistributionsTransformMap::save] Could not open %s for "
+              "writing!\n",
+              file_name.c_str());
+    return -1;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(voxels_data_), nr_voxels_ * sizeof(Voxel));
+  file.write(reinterpret_cast<const char*>(table_data_),
+             nr_slots_ * sizeof(std::uint32_t));
+  if (!file) {
+    PCL_ERROR("[pcl::NormalDistributionsTransformMap::save] Error writing %s!\n",
+              file_name.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+int
+pcl::NormalDistributionsTransformMap::load(const std::string& file_name)
+{
+  clear(resolution_);
+
+  if (mapped_file_.open(file_name) < 0) {
+    PCL_ERROR("[pcl::NormalDistributionsTransformMap::load] Could not map %s!\n",
+              file_name.c_str());
+    return -1;
+  }
+
+  FileHeader header;
+  if (mapped_file_.size() < sizeof(header)) {
+    PCL_ERROR("[pcl::NormalDistributionsTransformMap::load] %s is too small!\n",
+              file_name.c_str());
+    clear(resolution_);
+    return -1;
+  }
+  std::memcpy(&header, mapped_file_.data(), sizeof(header));
+
+  if (std::memcmp(header.magic, file_magic, sizeof(header.magic)) != 0 ||
+      header.version != file_version || header.voxel_size != sizeof(Voxel)) {
+    PCL_ERROR("[pcl::NormalDistributionsTransformMap::load] %s is not a supported NDT "
+              "map file!\n",
+              file_name.c_str());
+    clear(resolution_);
+    return -1;
+  }
+
+  // An empty slot is needed to terminate lookups
+  if (!(header.resolution > 0) || header.nr_voxels >= empty_slot_ ||
+      header.nr_valid_voxels > header.nr_voxels ||
+      (header.nr_slots != 0 && (header.nr_slots & (header.nr_slots - 1)) != 0) ||
+      (header.nr_voxels != 0 && header.nr_slots <= header.nr_voxels) ||
+      mapped_file_.size() != sizeof(header) + header.nr_voxels * sizeof(Voxel) +
+                                 header.nr_slots * sizeof(std::uint32_t)) {
+    PCL_ERROR("[pcl::NormalDistributionsTransformMap::load] %s is corrupt!\n",
+              file_name.c_str());
+    clear(resolution_);
+    return -1;
+  }
+
+  const auto* voxels =
+      reinterpret_cast<const Voxel*>(mapped_file_.data() + sizeof(header));
+  const auto* table = reinterpret_cast<const std::uint32_t*>(
+      mapped_file_.data() + sizeof(header) + header.nr_voxels * sizeof(Voxel));
+
+  // Neither the voxels nor the hash table are read here, so that loading does not
+  // touch the pages of the file. Their entries are checked by findVoxel.
+  resolution_ = header.resolution;
+  inverse_resolution_ = 1.0 / header.resolution;
+  min_covar_eigvalue_mult_ = header.min_covar_eigvalue_mult;
+  min_points_per_voxel_ = header.min_points_per_voxel;
+  voxels_data_ = voxels;
+  table_data_ = table;
+  nr_voxels_ = header.nr_voxels;
+  nr_slots_ = header.nr_slots;
+  nr_valid_voxels_ = header.nr_valid_voxels;
+  return 0;
+}
@@ -60,30 +60,12 @@ namespace pcl
       using pcl::search::Search<PointT>::indices_;
       using pcl::search::Search<PointT>::sorted_results_;
 
-      struct Entry
-      {
-        Entry (index_t idx, float dist) : index (idx), distance (dist) {}
-
-        Entry () : index (0), distance (0) {}
-        index_t index;
-        float distance;
-        
-        inline bool 
-        operator < (const Entry& other) const
-        {
-          return (distance < other.distance);
-        }
-        
-        inline bool 
-        operator > (const Entry& other) const
-        {
-          return (distance > other.distance);
-        }
-      };
-
       // replace by some metric functor
       float getDistSqr (const PointT& point1, const PointT& point2) const;
       public:
+        using pcl::search::Search<PointT>::nearestKSearch;
+        using pcl::search::Search<PointT>::radiusSearch;
+
         BruteForce (bool sorted_results = false)
         : Search<PointT> ("BruteForce", sorted_results)
         {
@@ -258,6 +258,7 @@ namespace pcl
         setInputCloud (const PointCloudConstPtr& cloud, const IndicesConstPtr& indices = IndicesConstPtr ()) override;
 
         using Search<PointT>::nearestKSearch;
+        using Search<PointT>::radiusSearch;
 
         /** \brief Search for the k-nearest neighbors for the given query point.
           * \param[in] point the given query point
@@ -39,7 +39,6 @@
 
 #include <pcl/common/point_tests.h> // for pcl::isFinite
 #include <pcl/search/brute_force.h>
-#include <queue>
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> float
@@ -71,66 +70,34 @@ template <typename PointT> int
 pcl::search::BruteForce<PointT>::denseKSearch (
     const PointT &point, int k, Indices &k_indices, std::vector<float> &k_distances) const
 {
-  // container for first k elements -> O(1) for insertion, since order not required here
-  std::vector<Entry> result;
-  result.reserve (k);
-  std::priority_queue<Entry> queue;
-  if (indices_)
+  // The k nearest points found so far are kept as a max-heap in the output vectors
+  k_indices.reserve (k);
+  k_distances.reserve (k);
+  const auto add = [&] (index_t index)
   {
-    auto iIt = indices_->cbegin ();
-    auto iEnd = indices_->cbegin () + std::min (static_cast<unsigned> (k), static_cast<unsigned> (indices_->size ()));
-    for (; iIt != iEnd; ++iIt)
-      result.push_back (Entry (*iIt, getDistSqr ((*input_)[*iIt], point)));
-
-    queue = std::priority_queue<Entry> (result.begin (), result.end ());
-
-    // add the rest
-    Entry entry;
-    for (; iIt != indices_->cend (); ++iIt)
+    const float distance = getDistSqr ((*input_)[index], point);
+    if (k_indices.size () < static_cast<std::size_t> (k))
+      detail::pushNeighbor (k_indices, k_distances, index, distance);
+    else if (detail::precedes (distance, index, k_distances[0], k_indices[0]))
     {
-      entry.distance = getDistSqr ((*input_)[*iIt], point);
-      if (queue.top ().distance > entry.distance)
-      {
-        entry.index = *iIt;
-        queue.pop ();
-        queue.push (entry);
-      }
+      k_indices[0] = index;
+      k_distances[0] = distance;
+      detail::siftDownNeighbor (k_indices, k_distances, 0, k_indices.size ());
     }
+  };
+
+  if (indices_)
+  {
+    for (const auto& idx : *indices_)
+      add (idx);
   }
   else
   {
-    Entry entry;
-    for (entry.index = 0; entry.index < std::min<pcl::index_t> (k, input_->size ()); ++entry.index)
-    {
-      entry.distance = getDistSqr ((*input_)[entry.index], point);
-      result.push_back (entry);
-    }
-
-    queue = std::priority_queue<Entry> (result.begin (), result.end ());
-
-    // add the rest
-    for (; entry.index < static_cast<pcl::index_t>(input_->size ()); ++entry.index)
-    {
-      entry.distance = getDistSqr ((*input_)[entry.index], point);
-      if (queue.top ().distance > entry.distance)
-      {
-        queue.pop ();
-        queue.push (entry);
-      }      
-    }
+    for (index_t idx = 0; idx < static_cast<index_t> (input_->size ()); ++idx)
+      add (idx);
   }
 
-  k_indices.resize (queue.size ());
-  k_distances.resize (queue.size ());
-  std::size_t idx = queue.size () - 1;
-  while (!queue.empty ())
-  {
-    k_indices [idx] = queue.top ().index;
-    k_distances [idx] = queue.top ().distance;
-    queue.pop ();
-    --idx;
-  }
-  
+  detail::sortNeighborHeap (k_indices, k_distances);
   return (static_cast<int> (k_indices.size ()));
 }
 
@@ -139,77 +106,36 @@ template <typename PointT> int
 pcl::search::BruteForce<PointT>::sparseKSearch (
     const PointT &point, int k, Indices &k_indices, std::vector<float> &k_distances) const
 {
-  // result used to collect the first k neighbors -> unordered
-  std::vector<Entry> result;
-  result.reserve (k);
-  
-  std::priority_queue<Entry> queue;
-  if (indices_)
+  // The k nearest points found so far are kept as a max-heap in the output vectors
+  k_indices.reserve (k);
+  k_distances.reserve (k);
+  const auto add = [&] (index_t index)
   {
-    auto iIt =indices_->cbegin ();
-    for (; iIt != indices_->cend () && result.size () < static_cast<unsigned> (k); ++iIt)
+    if (!std::isfinite ((*input_)[index].x))
+      return;
+    const float distance = getDistSqr ((*input_)[index], point);
+    if (k_indices.size () < static_cast<std::size_t> (k))
+      detail::pushNeighbor (k_indices, k_distances, index, distance);
+    else if (detail::precedes (distance, index, k_distances[0], k_indices[0]))
     {
-      if (std::isfinite ((*input_)[*iIt].x))
-        result.push_back (Entry (*iIt, getDistSqr ((*input_)[*iIt], point)));
+      k_indices[0] = index;
+      k_distances[0] = distance;
+      detail::siftDownNeighbor (k_indices, k_distances, 0, k_indices.size ());
     }
-    
-    queue = std::priority_queue<Entry> (result.begin (), result.end ());
-
-    // either we have k elements, or there are none left to iterate >in either case we're fine
-    // add the rest
-    Entry entry;
-    for (; iIt != indices_->cend (); ++iIt)
-    {
-      if (!std::isfinite ((*input_)[*iIt].x))
-        continue;
+  };
 
-      entry.distance = getDistSqr ((*input_)[*iIt], point);
-      if (queue.top ().distance > entry.distance)
-      {
-        entry.index = *iIt;
-        queue.pop ();
-        queue.push (entry);
-      }
-    }
-  }
-  else
+  if (indices_)
   {
-    Entry entry;
-    for (entry.index = 0; (entry.index < static_cast<pcl::index_t>(input_->size ())) && (result.size () < static_cast<std::size_t> (k)); ++entry.index)
-    {
-      if (std::isfinite ((*input_)[entry.index].x))
-      {
-        entry.distance = getDistSqr ((*input_)[entry.index], point);
-        result.push_back (entry);
-      }
-    }
-    queue = std::priority_queue<Entry> (result.begin (), result.end ());
-    
-    // add the rest
-    for (; entry.index < static_cast<pcl::index_t>(input_->size ()); ++entry.index)
-    {
-      if (!std::isfinite ((*input_)[entry.index].x))
-        continue;
-
-      entry.distance = getDistSqr ((*input_)[entry.index], point);
-      if (queue.top ().distance > entry.distance)
-      {
-        queue.pop ();
-        queue.push (entry);
-      }
-    }
+    for (const auto& idx : *indices_)
+      add (idx);
   }
-  
-  k_indices.resize (queue.size ());
-  k_distances.resize (queue.size ());
-  std::size_t idx = queue.size () - 1;
-  while (!queue.empty ())
+  else
   {
-    k_indices [idx] = queue.top ().index;
-    k_distances [idx] = queue.top ().distance;
-    queue.pop ();
-    --idx;
+    for (index_t idx = 0; idx < static_cast<index_t> (input_->size ()); ++idx)
+      add (idx);
   }
+
+  detail::sortNeighborHeap (k_indices, k_distances);
   return (static_cast<int> (k_indices.size ()));
 }
 
@@ -0,0 +1,482 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/common/point_tests.h> // for pcl::isFinite
+#include <pcl/search/incremental_kdtree.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::search::IncrementalKdTree<PointT>::setInputCloud (
+    const PointCloudConstPtr& cloud, const IndicesConstPtr& indices)
+{
+  cloud_.reset (new PointCloud (*cloud));
+  input_ = cloud_;
+  indices_ = indices;
+
+  nodes_.clear ();
+  free_nodes_.clear ();
+  root_ = -1;
+
+  const auto add = [this] (index_t index)
+  {
+    const PointT &point = (*cloud_)[index];
+    if (pcl::isFinite (point))
+      allocateNode (point.getVector3fMap (), index, 0);
+  };
+  if (indices_)
+  {
+    nodes_.reserve (indices_->size ());
+    for (const auto &index : *indices_)
+      add (index);
+  }
+  else
+  {
+    nodes_.reserve (cloud_->size ());
+    for (index_t index = 0; index < static_cast<index_t> (cloud_->size ()); ++index)
+      add (index);
+  }
+
+  std::vector<int> ids (nodes_.size ());
+  std::iota (ids.begin (), ids.end (), 0);
+  root_ = buildSubtree (ids.data (), ids.data () + ids.size ());
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::IncrementalKdTree<PointT>::addPoints (const PointCloud &cloud)
+{
+  if (!cloud_)
+  {
+    setInputCloud (cloud.makeShared ());
+    return;
+  }
+
+  const auto offset = static_cast<index_t> (cloud_->size ());
+  cloud_->insert (cloud_->end (), cloud.begin (), cloud.end ());
+  cloud_->is_dense = cloud_->is_dense && cloud.is_dense;
+
+  for (index_t i = 0; i < static_cast<index_t> (cloud.size ()); ++i)
+    if (pcl::isFinite (cloud[i]))
+      insert (cloud[i].getVector3fMap (), offset + i);
+  root_ = maintain (root_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> std::size_t
+pcl::search::IncrementalKdTree<PointT>::deletePointsInBox (
+    const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt)
+{
+  const std::size_t nr_deleted = deleteInBox (root_, min_pt, max_pt);
+  if (nr_deleted != 0)
+    root_ = maintain (root_);
+  return (nr_deleted);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::IncrementalKdTree<PointT>::compact ()
+{
+  if (!cloud_)
+    return;
+
+  // Nodes freed by a rebuild are always deleted ones, so the nodes which are not
+  // deleted are exactly the points in the tree
+  std::vector<index_t> live;
+  live.reserve (getNumberOfPoints ());
+  for (const auto &node : nodes_)
+    if (!node.deleted)
+      live.push_back (node.index);
+  // Keep the points in their current order, so the renumbering is predictable
+  std::sort (live.begin (), live.end ());
+
+  PointCloudPtr cloud (new PointCloud);
+  cloud->header = cloud_->header;
+  cloud->sensor_origin_ = cloud_->sensor_origin_;
+  cloud->sensor_orientation_ = cloud_->sensor_orientation_;
+  cloud->reserve (live.size ());
+  for (const auto &index : live)
+    cloud->push_back ((*cloud_)[index]);
+  setInputCloud (cloud);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::IncrementalKdTree<PointT>::allocateNode (
+    const Eigen::Vector3f &point, index_t index, int axis)
+{
+  int id;
+  if (free_nodes_.empty ())
+  {
+    id = static_cast<int> (nodes_.size ());
+    nodes_.emplace_back ();
+  }
+  else
+  {
+    id = free_nodes_.back ();
+    free_nodes_.pop_back ();
+  }
+
+  Node &node = nodes_[id];
+  node.point = point;
+  node.min_p = node.max_p = point;
+  node.index = index;
+  node.left = node.right = -1;
+  node.axis = axis;
+  node.size = 1;
+  node.nr_deleted = 0;
+  node.deleted = false;
+  node.dirty = false;
+  return (id);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::IncrementalKdTree<PointT>::buildSubtree (int *begin, int *end)
+{
+  if (begin == end)
+    return (-1);
+
+  // Split at the median of the axis with the largest extent
+  Eigen::Vector3f min_p = nodes_[*begin].point, max_p = min_p;
+  for (int *it = begin + 1; it != end; ++it)
+  {
+    min_p = min_p.cwiseMin (nodes_[*it].point);
+    max_p = max_p.cwiseMax (nodes_[*it].point);
+  }
+  int axis;
+  (max_p - min_p).maxCoeff (&axis);
+
+  int *mid = begin + (end - begin) / 2;
+  std::nth_element (begin, mid, end, [this, axis] (int a, int b)
+  {
+    return (nodes_[a].point[axis] < nodes_[b].point[axis]);
+  });
+
+  const int id = *mid;
+  Node &node = nodes_[id];
+  node.axis = axis;
+  node.deleted = false;
+  node.dirty = false;
+  node.left = buildSubtree (begin, mid);
+  node.right = buildSubtree (mid + 1, end);
+  node.size = static_cast<uindex_t> (end - begin);
+  node.nr_deleted = 0;
+  node.min_p = min_p;
+  node.max_p = max_p;
+  return (id);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::IncrementalKdTree<PointT>::rebuildSubtree (int id)
+{
+  std::vector<int> ids, stack (1, id);
+  ids.reserve (nodes_[id].size - nodes_[id].nr_deleted);
+  while (!stack.empty ())
+  {
+    const int current = stack.back ();
+    stack.pop_back ();
+    const Node &node = nodes_[current];
+    if (node.left >= 0)
+      stack.push_back (node.left);
+    if (node.right >= 0)
+      stack.push_back (node.right);
+    if (node.deleted)
+      free_nodes_.push_back (current);
+    else
+      ids.push_back (current);
+  }
+  return (buildSubtree (ids.data (), ids.data () + ids.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::IncrementalKdTree<PointT>::updateNode (int id)
+{
+  Node &node = nodes_[id];
+  node.size = 1;
+  node.nr_deleted = node.deleted ? 1 : 0;
+  bool empty = node.deleted;
+  if (!node.deleted)
+    node.min_p = node.max_p = node.point;
+
+  for (const int child_id : {node.left, node.right})
+  {
+    if (child_id < 0)
+      continue;
+    const Node &child = nodes_[child_id];
+    node.size += child.size;
+    node.nr_deleted += child.nr_deleted;
+    if (child.nr_deleted == child.size)
+      continue;
+    if (empty)
+    {
+      node.min_p = child.min_p;
+      node.max_p = child.max_p;
+      empty = false;
+    }
+    else
+    {
+      node.min_p = node.min_p.cwiseMin (child.min_p);
+      node.max_p = node.max_p.cwiseMax (child.max_p);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::IncrementalKdTree<PointT>::maintain (int id)
+{
+  if (id < 0 || !nodes_[id].dirty)
+    return (id);
+
+  Node &node = nodes_[id];
+  node.dirty = false;
+  if (node.size >= min_rebuild_size_)
+  {
+    const uindex_t left_size = node.left < 0 ? 0 : nodes_[node.left].size;
+    const uindex_t right_size = node.right < 0 ? 0 : nodes_[node.right].size;
+    if (static_cast<float> (std::max (left_size, right_size)) > balance_factor_ * static_cast<float> (node.size - 1) ||
+        static_cast<float> (node.nr_deleted) > deleted_factor_ * static_cast<float> (node.size))
+      return (rebuildSubtree (id));
+  }
+
+  node.left = maintain (node.left);
+  node.right = maintain (node.right);
+  updateNode (id);
+  return (id);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::IncrementalKdTree<PointT>::insert (const Eigen::Vector3f &point, index_t index)
+{
+  if (root_ < 0)
+  {
+    root_ = allocateNode (point, index, 0);
+    return;
+  }
+
+  int id = root_;
+  while (true)
+  {
+    Node &node = nodes_[id];
+    if (node.nr_deleted == node.size)
+      node.min_p = node.max_p = point;
+    else
+    {
+      node.min_p = node.min_p.cwiseMin (point);
+      node.max_p = node.max_p.cwiseMax (point);
+    }
+    ++node.size;
+    node.dirty = true;
+
+    const bool go_left = point[node.axis] < node.point[node.axis];
+    const int child = go_left ? node.left : node.right;
+    if (child >= 0)
+    {
+      id = child;
+      continue;
+    }
+    // allocateNode may reallocate the node storage, so node must not be used afterwards
+    const int new_id = allocateNode (point, index, (node.axis + 1) % 3);
+    if (go_left)
+      nodes_[id].left = new_id;
+    else
+      nodes_[id].right = new_id;
+    return;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> std::size_t
+pcl::search::IncrementalKdTree<PointT>::deleteInBox (
+    int id, const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt)
+{
+  if (id < 0)
+    return (0);
+  {
+    const Node &node = nodes_[id];
+    if (node.nr_deleted == node.size ||
+        (node.max_p.array () < min_pt.array ()).any () ||
+        (node.min_p.array () > max_pt.array ()).any ())
+      return (0);
+  }
+
+  std::size_t nr_deleted = 0;
+  Node &node = nodes_[id];
+  if (!node.deleted &&
+      (node.point.array () >= min_pt.array ()).all () &&
+      (node.point.array () <= max_pt.array ()).all ())
+  {
+    node.deleted = true;
+    ++nr_deleted;
+  }
+  nr_deleted += deleteInBox (node.left, min_pt, max_pt);
+  nr_deleted += deleteInBox (node.right, min_pt, max_pt);
+  if (nr_deleted != 0)
+  {
+    updateNode (id);
+    node.dirty = true;
+  }
+  return (nr_deleted);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::IncrementalKdTree<PointT>::searchKNN (
+    int id, const Eigen::Vector3f &p, std::size_t k,
+    std::vector<std::pair<float, index_t> > &heap) const
+{
+  const Node &node = nodes_[id];
+  const float sqr_eps_factor = (1.0f + epsilon_) * (1.0f + epsilon_);
+  if (node.nr_deleted == node.size ||
+      (heap.size () == k && getBoxSqrDistance (node, p) * sqr_eps_factor > heap.front ().first))
+    return;
+
+  if (!node.deleted)
+  {
+    const std::pair<float, index_t> candidate ((node.point - p).squaredNorm (), node.index);
+    if (heap.size () < k)
+    {
+      heap.push_back (candidate);
+      std::push_heap (heap.begin (), heap.end ());
+    }
+    else if (candidate < heap.front ())
+    {
+      std::pop_heap (heap.begin (), heap.end ());
+      heap.back () = candidate;
+      std::push_heap (heap.begin (), heap.end ());
+    }
+  }
+
+  // Visit the side of the splitting plane containing p first
+  int first = node.left, second = node.right;
+  if (p[node.axis] >= node.point[node.axis])
+    std::swap (first, second);
+  if (first >= 0)
+    searchKNN (first, p, k, heap);
+  if (second >= 0)
+    searchKNN (second, p, k, heap);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::search::IncrementalKdTree<PointT>::searchRadius (
+    int id, const Eigen::Vector3f &p, float sqr_radius, std::size_t max_nn,
+    std::vector<std::pair<float, index_t> > &results) const
+{
+  const Node &node = nodes_[id];
+  if (node.nr_deleted == node.size || getBoxSqrDistance (node, p) > sqr_radius)
+    return (false);
+
+  if (!node.deleted)
+  {
+    const float sqr_dist = (node.point - p).squaredNorm ();
+    if (sqr_dist <= sqr_radius)
+    {
+      results.emplace_back (sqr_dist, node.index);
+      if (results.size () == max_nn)
+        return (true);
+    }
+  }
+  return ((node.left >= 0 && searchRadius (node.left, p, sqr_radius, max_nn, results)) ||
+          (node.right >= 0 && searchRadius (node.right, p, sqr_radius, max_nn, results)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::IncrementalKdTree<PointT>::nearestKSearch (
+    const PointT &point, int k, Indices &k_indices, std::vector<float> &k_sqr_distances) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (root_ < 0 || k <= 0)
+    return (0);
+
+  std::vector<std::pair<float, index_t> > heap;
+  heap.reserve (k);
+  searchKNN (root_, point.getVector3fMap (), static_cast<std::size_t> (k), heap);
+  std::sort_heap (heap.begin (), heap.end ());
+
+  k_indices.resize (heap.size ());
+  k_sqr_distances.resize (heap.size ());
+  for (std::size_t i = 0; i < heap.size (); ++i)
+  {
+    k_sqr_distances[i] = heap[i].first;
+    k_indices[i] = heap[i].second;
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::IncrementalKdTree<PointT>::radiusSearch (
+    const PointT &point, double radius, Indices &k_indices,
+    std::vector<float> &k_sqr_distances, unsigned int max_nn) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to radiusSearch!");
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (root_ < 0)
+    return (0);
+
+  std::vector<std::pair<float, index_t> > results;
+  searchRadius (root_, point.getVector3fMap (), static_cast<float> (radius * radius),
+                max_nn == 0 ? std::numeric_limits<std::size_t>::max () : max_nn, results);
+  if (sorted_results_)
+    std::sort (results.begin (), results.end ());
+
+  k_indices.resize (results.size ());
+  k_sqr_distances.resize (results.size ());
+  for (std::size_t i = 0; i < results.size (); ++i)
+  {
+    k_sqr_distances[i] = results[i].first;
+    k_indices[i] = results[i].second;
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+#define PCL_INSTANTIATE_IncrementalKdTree(T) template class PCL_EXPORTS pcl::search::IncrementalKdTree<T>;
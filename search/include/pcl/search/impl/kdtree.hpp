@@ -114,6 +114,23 @@ pcl::search::KdTree<PointT,Tree>::radiusSearch (
   return (tree_->radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn));
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, class Tree> int
+pcl::search::KdTree<PointT,Tree>::nearestKSearch (
+    const PointT &point, int k, SearchContext &context) const
+{
+  return (tree_->nearestKSearch (point, k, context));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, class Tree> int
+pcl::search::KdTree<PointT,Tree>::radiusSearch (
+    const PointT& point, double radius, SearchContext &context,
+    unsigned int max_nn) const
+{
+  return (tree_->radiusSearch (point, radius, context, max_nn));
+}
+
 #define PCL_INSTANTIATE_KdTree(T) template class PCL_EXPORTS pcl::search::KdTree<T>;
 
 #endif  //#ifndef _PCL_SEARCH_KDTREE_IMPL_HPP_
@@ -40,6 +40,8 @@
 
 #include <pcl/search/search.h>
 
+#include <algorithm> // for copy_n, min
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 pcl::search::Search<PointT>::Search (const std::string& name, bool sorted)
@@ -81,6 +83,23 @@ pcl::search::Search<PointT>::setInputCloud (
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::Search<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    num_threads_ = omp_get_num_procs ();
+  else
+    num_threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::search::Search::setNumberOfThreads] Setting number of threads to %u.\n", num_threads_);
+#else
+  num_threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::search::Search::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::search::Search<PointT>::nearestKSearch (
@@ -120,18 +139,79 @@ pcl::search::Search<PointT>::nearestKSearch (
   {
     k_indices.resize (cloud.size ());
     k_sqr_distances.resize (cloud.size ());
-    for (std::size_t i = 0; i < cloud.size (); i++)
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, k, k_indices, k_sqr_distances) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 64)
+    for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (cloud.size ()); i++)
       nearestKSearch (cloud, static_cast<index_t> (i), k, k_indices[i], k_sqr_distances[i]);
   }
   else
   {
     k_indices.resize (indices.size ());
     k_sqr_distances.resize (indices.size ());
-    for (std::size_t i = 0; i < indices.size (); i++)
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, indices, k, k_indices, k_sqr_distances) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 64)
+    for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (indices.size ()); i++)
       nearestKSearch (cloud, indices[i], k, k_indices[i], k_sqr_distances[i]);
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::Search<PointT>::nearestKSearch (
+    const PointCloud& cloud, const Indices& indices,
+    int k, Neighborhoods& neighborhoods) const
+{
+  std::size_t nr_queries = indices.empty () ? cloud.size () : indices.size ();
+  std::size_t capacity = static_cast<std::size_t> (std::max (k, 0));
+
+  // Every query writes into its own slot of k neighbors, the number of neighbors it
+  // found is kept in offsets[i + 1] until the slots are compacted below
+  neighborhoods.offsets.resize (nr_queries + 1);
+  neighborhoods.indices.resize (nr_queries * capacity);
+  neighborhoods.sqr_distances.resize (nr_queries * capacity);
+
+  // Per-thread scratch buffers, allocated once per thread instead of once per query
+  Indices k_indices (capacity);
+  std::vector<float> k_sqr_distances (capacity);
+
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, indices, k, capacity, neighborhoods, nr_queries) \
+  firstprivate(k_indices, k_sqr_distances) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 64)
+  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (nr_queries); ++i)
+  {
+    const index_t query = indices.empty () ? static_cast<index_t> (i) : indices[i];
+    const int found = std::min (nearestKSearch (cloud, query, k, k_indices, k_sqr_distances), k);
+    std::copy_n (k_indices.begin (), found, neighborhoods.indices.begin () + i * capacity);
+    std::copy_n (k_sqr_distances.begin (), found, neighborhoods.sqr_distances.begin () + i * capacity);
+    neighborhoods.offsets[i + 1] = static_cast<std::size_t> (std::max (found, 0));
+  }
+
+  // Turn the counts into offsets, moving the neighbors down if a query found less than k
+  neighborhoods.offsets[0] = 0;
+  for (std::size_t i = 0; i < nr_queries; ++i)
+  {
+    const std::size_t begin = neighborhoods.offsets[i];
+    const std::size_t count = neighborhoods.offsets[i + 1];
+    if (begin != i * capacity)
+    {
+      std::copy_n (neighborhoods.indices.begin () + i * capacity, count, neighborhoods.indices.begin () + begin);
+      std::copy_n (neighborhoods.sqr_distances.begin () + i * capacity, count, neighborhoods.sqr_distances.begin () + begin);
+    }
+    neighborhoods.offsets[i + 1] = begin + count;
+  }
+  neighborhoods.indices.resize (neighborhoods.offsets.back ());
+  neighborhoods.sqr_distances.resize (neighborhoods.offsets.back ());
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::search::Search<PointT>::radiusSearch (
@@ -172,38 +252,172 @@ pcl::search::Search<PointT>::radiusSearch (
   {
     k_indices.resize (cloud.size ());
     k_sqr_distances.resize (cloud.size ());
-    for (std::size_t i = 0; i < cloud.size (); i++)
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, radius, k_indices, k_sqr_distances, max_nn) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 64)
+    for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (cloud.size ()); i++)
       radiusSearch (cloud, static_cast<index_t> (i), radius,k_indices[i], k_sqr_distances[i], max_nn);
   }
   else
   {
     k_indices.resize (indices.size ());
     k_sqr_distances.resize (indices.size ());
-    for (std::size_t i = 0; i < indices.size (); i++)
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, indices, radius, k_indices, k_sqr_distances, max_nn) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 64)
+    for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (indices.size ()); i++)
       radiusSearch (cloud,indices[i],radius,k_indices[i],k_sqr_distances[i], max_nn);
   }
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
-pcl::search::Search<PointT>::sortResults (
-    Indices& indices, std::vector<float>& distances) const
+pcl::search::Search<PointT>::radiusSearch (
+    const PointCloud& cloud,
+    const Indices& indices,
+    double radius,
+    Neighborhoods& neighborhoods,
+    unsigned int max_nn) const
 {
-  Indices order (indices.size ());
-  for (std::size_t idx = 0; idx < order.size (); ++idx)
-    order [idx] = static_cast<index_t> (idx);
+  std::size_t nr_queries = indices.empty () ? cloud.size () : indices.size ();
+  neighborhoods.offsets.resize (nr_queries + 1);
+
+  // The number of neighbors is not known in advance, so every thread appends the
+  // results of its queries to its own buffers, remembering where each query went
+  std::vector<Indices> thread_indices (num_threads_);
+  std::vector<std::vector<float> > thread_sqr_distances (num_threads_);
+  std::vector<unsigned int> query_thread (nr_queries);
+  std::vector<std::size_t> query_position (nr_queries);
 
-  Compare compare (distances);
-  sort (order.begin (), order.end (), compare);
+  Indices k_indices;
+  std::vector<float> k_sqr_distances;
 
-  Indices sorted (indices.size ());
-  for (std::size_t idx = 0; idx < order.size (); ++idx)
-    sorted [idx] = indices[order [idx]];
+#pragma omp parallel for \
+  default(none) \
+  shared(cloud, indices, radius, max_nn, neighborhoods, nr_queries, thread_indices, thread_sqr_distances, query_thread, query_position) \
+  firstprivate(k_indices, k_sqr_distances) \
+  num_threads(num_threads_) \
+  schedule(dynamic, 64)
+  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (nr_queries); ++i)
+  {
+#ifdef _OPENMP
+    const int thread_num = omp_get_thread_num ();
+#else
+    const int thread_num = 0;
+#endif
+    const index_t query = indices.empty () ? static_cast<index_t> (i) : indices[i];
+    const int found = radiusSearch (cloud, query, radius, k_indices, k_sqr_distances, max_nn);
+
+    auto &local_indices = thread_indices[thread_num];
+    auto &local_sqr_distances = thread_sqr_distances[thread_num];
+    query_thread[i] = static_cast<unsigned int> (thread_num);
+    query_position[i] = local_indices.size ();
+    local_indices.insert (local_indices.end (), k_indices.begin (), k_indices.begin () + found);
+    local_sqr_distances.insert (local_sqr_distances.end (), k_sqr_distances.begin (), k_sqr_distances.begin () + found);
+    neighborhoods.offsets[i + 1] = static_cast<std::size_t> (found);
+  }
+
+  neighborhoods.offsets[0] = 0;
+  for (std::size_t i = 0; i < nr_queries; ++i)
+    neighborhoods.offsets[i + 1] += neighborhoods.offsets[i];
+  neighborhoods.indices.resize (neighborhoods.offsets.back ());
+  neighborhoods.sqr_distances.resize (neighborhoods.offsets.back ());
+
+#pragma omp parallel for \
+  default(none) \
+  shared(neighborhoods, nr_queries, thread_indices, thread_sqr_distances, query_thread, query_position) \
+  num_threads(num_threads_) \
+  schedule(static)
+  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t> (nr_queries); ++i)
+  {
+    const std::size_t count = neighborhoods.getNumberOfNeighbors (i);
+    std::copy_n (thread_indices[query_thread[i]].begin () + query_position[i], count,
+                 neighborhoods.indices.begin () + neighborhoods.offsets[i]);
+    std::copy_n (thread_sqr_distances[query_thread[i]].begin () + query_position[i], count,
+                 neighborhoods.sqr_distances.begin () + neighborhoods.offsets[i]);
+  }
+}
 
-  indices = sorted;
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::nearestKSearch (
+    const PointT &point, int k, SearchContext &context) const
+{
+  return (nearestKSearch (point, k, context.indices, context.sqr_distances));
+}
 
-  // sort  the according distances.
-  sort (distances.begin (), distances.end ());
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::nearestKSearch (
+    const PointCloud &cloud, index_t index, int k, SearchContext &context) const
+{
+  assert (index >= 0 && index < static_cast<index_t> (cloud.size ()) && "Out-of-bounds error in nearestKSearch!");
+  return (nearestKSearch (cloud[index], k, context));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::nearestKSearch (
+    index_t index, int k, SearchContext &context) const
+{
+  if (!indices_)
+  {
+    assert (index >= 0 && index < static_cast<index_t> (input_->size ()) && "Out-of-bounds error in nearestKSearch!");
+    return (nearestKSearch ((*input_)[index], k, context));
+  }
+  assert (index >= 0 && index < static_cast<index_t> (indices_->size ()) && "Out-of-bounds error in nearestKSearch!");
+  if (index >= static_cast<index_t> (indices_->size ()) || index < 0)
+    return (0);
+  return (nearestKSearch ((*input_)[(*indices_)[index]], k, context));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::radiusSearch (
+    const PointT &point, double radius, SearchContext &context,
+    unsigned int max_nn) const
+{
+  return (radiusSearch (point, radius, context.indices, context.sqr_distances, max_nn));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::radiusSearch (
+    const PointCloud &cloud, index_t index, double radius,
+    SearchContext &context, unsigned int max_nn) const
+{
+  assert (index >= 0 && index < static_cast<index_t> (cloud.size ()) && "Out-of-bounds error in radiusSearch!");
+  return (radiusSearch (cloud[index], radius, context, max_nn));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::Search<PointT>::radiusSearch (
+    index_t index, double radius, SearchContext &context,
+    unsigned int max_nn) const
+{
+  if (!indices_)
+  {
+    assert (index >= 0 && index < static_cast<index_t> (input_->size ()) && "Out-of-bounds error in radiusSearch!");
+    return (radiusSearch ((*input_)[index], radius, context, max_nn));
+  }
+  assert (index >= 0 && index < static_cast<index_t> (indices_->size ()) && "Out-of-bounds error in radiusSearch!");
+  return (radiusSearch ((*input_)[(*indices_)[index]], radius, context, max_nn));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::Search<PointT>::sortResults (
+    Indices& indices, std::vector<float>& distances) const
+{
+  // Heap sort on both vectors at once
+  for (std::size_t pos = indices.size () / 2; pos-- > 0;)
+    detail::siftDownNeighbor (indices, distances, pos, indices.size ());
+  detail::sortNeighborHeap (indices, distances);
 }
 
 #define PCL_INSTANTIATE_Search(T) template class PCL_EXPORTS pcl::search::Search<T>;
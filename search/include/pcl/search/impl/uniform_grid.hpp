@@ -0,0 +1,325 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/common/point_tests.h> // for pcl::isFinite
+#include <pcl/search/uniform_grid.h>
+
+#include <algorithm>
+#include <limits>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::search::UniformGrid<PointT>::setInputCloud (
+    const PointCloudConstPtr& cloud, const IndicesConstPtr& indices)
+{
+  input_ = cloud;
+  indices_ = indices;
+
+  nr_cells_ = 0;
+  dims_.setZero ();
+  cells_.clear ();
+  sorted_indices_.clear ();
+  sorted_points_.clear ();
+
+  if (resolution_ <= 0.0)
+  {
+    PCL_ERROR ("[pcl::search::UniformGrid::setInputCloud] Invalid resolution (%g)!\n", resolution_);
+    return (false);
+  }
+  inverse_resolution_ = static_cast<float> (1.0 / resolution_);
+
+  // Collect the valid points and their bounding box
+  Indices valid_indices;
+  if (indices_)
+  {
+    valid_indices.reserve (indices_->size ());
+    for (const auto &index : *indices_)
+      if (isFinite ((*input_)[index]))
+        valid_indices.push_back (index);
+  }
+  else
+  {
+    valid_indices.reserve (input_->size ());
+    for (index_t index = 0; index < static_cast<index_t> (input_->size ()); ++index)
+      if (isFinite ((*input_)[index]))
+        valid_indices.push_back (index);
+  }
+  if (valid_indices.empty ())
+    return (true);
+
+  Eigen::Vector3f max_p = Eigen::Vector3f::Constant (-std::numeric_limits<float>::max ());
+  min_p_ = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+  for (const auto &index : valid_indices)
+  {
+    min_p_ = min_p_.cwiseMin ((*input_)[index].getVector3fMap ());
+    max_p = max_p.cwiseMax ((*input_)[index].getVector3fMap ());
+  }
+
+  // The cell coordinates are packed into 21 bits each
+  const Eigen::Array3f max_cell = ((max_p - min_p_).array () * inverse_resolution_).floor ();
+  if ((max_cell >= static_cast<float> ((1 << 21) - 2)).any ())
+  {
+    PCL_ERROR ("[pcl::search::UniformGrid::setInputCloud] Resolution (%g) is too small for the extent of the input cloud!\n", resolution_);
+    return (false);
+  }
+  dims_ = max_cell.template cast<int> () + 1;
+
+  // Sort the points by cell
+  std::vector<std::pair<std::uint64_t, index_t> > entries;
+  entries.reserve (valid_indices.size ());
+  for (const auto &index : valid_indices)
+  {
+    const Eigen::Array3i ijk = getCellCoordinates ((*input_)[index].getVector3fMap ());
+    entries.emplace_back (getKey (ijk.x (), ijk.y (), ijk.z ()), index);
+  }
+  std::sort (entries.begin (), entries.end ());
+
+  sorted_indices_.resize (entries.size ());
+  sorted_points_.resize (entries.size ());
+  nr_cells_ = 0;
+  for (std::size_t i = 0; i < entries.size (); ++i)
+  {
+    sorted_indices_[i] = entries[i].second;
+    sorted_points_[i] = (*input_)[entries[i].second].getVector3fMap ();
+    if (i == 0 || entries[i].first != entries[i - 1].first)
+      ++nr_cells_;
+  }
+
+  // Insert the occupied cells in a hash table that is at most half full
+  std::size_t nr_slots = 2;
+  while (nr_slots < 2 * nr_cells_)
+    nr_slots *= 2;
+  cells_.assign (nr_slots, Cell {std::numeric_limits<std::uint64_t>::max (), 0, 0});
+  for (std::size_t begin = 0, end = 0; begin < entries.size (); begin = end)
+  {
+    const std::uint64_t key = entries[begin].first;
+    for (end = begin + 1; end < entries.size () && entries[end].first == key; ++end) {}
+
+    std::size_t slot = getSlot (key);
+    while (cells_[slot].key != std::numeric_limits<std::uint64_t>::max ())
+      slot = (slot + 1) & (cells_.size () - 1);
+    cells_[slot] = Cell {key, static_cast<uindex_t> (begin), static_cast<uindex_t> (end)};
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> const typename pcl::search::UniformGrid<PointT>::Cell*
+pcl::search::UniformGrid<PointT>::findCell (std::int64_t i, std::int64_t j, std::int64_t k) const
+{
+  const std::uint64_t key = getKey (i, j, k);
+  for (std::size_t slot = getSlot (key); ; slot = (slot + 1) & (cells_.size () - 1))
+  {
+    if (cells_[slot].key == key)
+      return (&cells_[slot]);
+    if (cells_[slot].key == std::numeric_limits<std::uint64_t>::max ())
+      return (nullptr);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::search::UniformGrid<PointT>::addRangeToHeap (
+    uindex_t begin, uindex_t end, const Eigen::Vector3f &p, std::size_t k,
+    std::vector<std::pair<float, index_t> > &heap) const
+{
+  for (uindex_t n = begin; n < end; ++n)
+  {
+    const float distance = (sorted_points_[n] - p).squaredNorm ();
+    if (heap.size () < k)
+    {
+      heap.emplace_back (distance, sorted_indices_[n]);
+      std::push_heap (heap.begin (), heap.end ());
+    }
+    else if (distance < heap.front ().first)
+    {
+      std::pop_heap (heap.begin (), heap.end ());
+      heap.back () = std::make_pair (distance, sorted_indices_[n]);
+      std::push_heap (heap.begin (), heap.end ());
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::search::UniformGrid<PointT>::addRangeInRadius (
+    uindex_t begin, uindex_t end, const Eigen::Vector3f &p, double sqr_radius, unsigned int max_nn,
+    Indices &k_indices, std::vector<float> &k_sqr_distances) const
+{
+  for (uindex_t n = begin; n < end; ++n)
+  {
+    const float distance = (sorted_points_[n] - p).squaredNorm ();
+    if (distance <= sqr_radius)
+    {
+      k_indices.push_back (sorted_indices_[n]);
+      k_sqr_distances.push_back (distance);
+      if (k_indices.size () == max_nn) // never true if max_nn = 0
+        return (true);
+    }
+  }
+  return (false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::UniformGrid<PointT>::nearestKSearch (
+    const PointT& point, int k, Indices& k_indices, std::vector<float>& k_sqr_distances) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
+
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (k < 1 || nr_cells_ == 0)
+    return (0);
+
+  const Eigen::Vector3f p = point.getVector3fMap ();
+  const Eigen::Array3i center = getCellCoordinates (p);
+  const auto nr_neighbors = static_cast<std::size_t> (k);
+  std::vector<std::pair<float, index_t> > heap;
+  heap.reserve (std::min (nr_neighbors, sorted_indices_.size ()));
+
+  // Number of cells of the grid inside the block [lo, hi]
+  const auto nr_cells_in_block = [this] (const Eigen::Array3i &lo, const Eigen::Array3i &hi)
+  {
+    const Eigen::Array3i extent = (hi.min (dims_ - 1) - lo.max (0) + 1).max (0);
+    return (static_cast<std::size_t> (extent.x ()) * extent.y () * extent.z ());
+  };
+
+  // Visit shells of cells around the query point, until the whole grid was
+  // visited or no point outside of the visited cells can be closer
+  for (int s = 0; ; ++s)
+  {
+    const Eigen::Array3i lo = center - s, hi = center + s;
+
+    // Far away from the points or in a sparse grid, the shells contain mostly
+    // empty cells: fall back to checking all points when that is cheaper
+    if (nr_cells_in_block (lo, hi) - nr_cells_in_block (lo + 1, hi - 1) > sorted_points_.size ())
+    {
+      heap.clear ();
+      addRangeToHeap (0, static_cast<uindex_t> (sorted_points_.size ()), p, nr_neighbors, heap);
+      break;
+    }
+
+    for (int z = std::max (lo.z (), 0); z <= std::min (hi.z (), dims_.z () - 1); ++z)
+    {
+      for (int y = std::max (lo.y (), 0); y <= std::min (hi.y (), dims_.y () - 1); ++y)
+      {
+        // Inside the shell, only the first and last cell of a row belong to it
+        const bool inside = (z != lo.z () && z != hi.z () && y != lo.y () && y != hi.y ());
+        const int step = inside ? hi.x () - lo.x () : 1;
+        for (int x = lo.x (); x <= hi.x (); x += step)
+        {
+          if (x < 0 || x >= dims_.x ())
+            continue;
+          const Cell *cell = findCell (x, y, z);
+          if (cell)
+            addRangeToHeap (cell->begin, cell->end, p, nr_neighbors, heap);
+        }
+      }
+    }
+
+    if ((lo <= 0).all () && (hi >= dims_ - 1).all ())
+      break;
+    if (heap.size () == nr_neighbors)
+    {
+      const Eigen::Array3f block_min = min_p_.array () + lo.cast<float> () * static_cast<float> (resolution_);
+      const Eigen::Array3f block_max = min_p_.array () + (hi + 1).cast<float> () * static_cast<float> (resolution_);
+      const float margin = std::min ((p.array () - block_min).minCoeff (), (block_max - p.array ()).minCoeff ());
+      if (margin > 0.0f && heap.front ().first <= margin * margin)
+        break;
+    }
+  }
+
+  std::sort_heap (heap.begin (), heap.end ());
+  k_indices.resize (heap.size ());
+  k_sqr_distances.resize (heap.size ());
+  for (std::size_t i = 0; i < heap.size (); ++i)
+  {
+    k_sqr_distances[i] = heap[i].first;
+    k_indices[i] = heap[i].second;
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::UniformGrid<PointT>::radiusSearch (
+    const PointT& point, double radius, Indices &k_indices,
+    std::vector<float> &k_sqr_distances, unsigned int max_nn) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to radiusSearch!");
+
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  if (nr_cells_ == 0)
+    return (0);
+
+  const Eigen::Vector3f p = point.getVector3fMap ();
+  const double sqr_radius = radius * radius;
+  // Slightly enlarge the box of cells to visit, to be robust to rounding
+  const Eigen::Vector3f half_size = Eigen::Vector3f::Constant (static_cast<float> (radius) * 1.0001f);
+  const Eigen::Array3i lo = getCellCoordinates (p - half_size).max (0);
+  const Eigen::Array3i hi = getCellCoordinates (p + half_size).min (dims_ - 1);
+
+  // For a large radius it is cheaper to check all points than to visit all cells
+  const Eigen::Array3i extent = (hi - lo + 1).max (0);
+  if (static_cast<std::size_t> (extent.x ()) * extent.y () * extent.z () > sorted_points_.size ())
+  {
+    addRangeInRadius (0, static_cast<uindex_t> (sorted_points_.size ()), p, sqr_radius, max_nn, k_indices, k_sqr_distances);
+  }
+  else
+  {
+    bool full = false;
+    for (int z = lo.z (); z <= hi.z () && !full; ++z)
+      for (int y = lo.y (); y <= hi.y () && !full; ++y)
+        for (int x = lo.x (); x <= hi.x () && !full; ++x)
+        {
+          const Cell *cell = findCell (x, y, z);
+          if (cell)
+            full = addRangeInRadius (cell->begin, cell->end, p, sqr_radius, max_nn, k_indices, k_sqr_distances);
+        }
+  }
+
+  if (sorted_results_)
+    this->sortResults (k_indices, k_sqr_distances);
+
+  return (static_cast<int> (k_indices.size ()));
+}
+
+#define PCL_INSTANTIATE_UniformGrid(T) template class PCL_EXPORTS pcl::search::UniformGrid<T>;
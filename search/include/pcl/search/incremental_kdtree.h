@@ -0,0 +1,377 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/search/kdtree.h>
+
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+  namespace search
+  {
+    /** \brief A kd-tree that can be updated incrementally, for targets which change
+      * a little between searches, e.g. the local map of a scan-to-map odometry.
+      *
+      * Points can be appended with addPoints () and removed with deletePointsInBox ()
+      * without rebuilding the whole tree. New points are inserted as leaves and deleted
+      * points are only marked; every node keeps the size, the number of deleted points
+      * and the bounding box of its subtree. After each update, the topmost subtree which
+      * became unbalanced (one child holds more than the balance factor of its nodes) or
+      * holds too many deleted points (more than the deleted factor) is rebuilt, similar
+      * to the ikd-Tree of Cai et al., "ikd-Tree: An Incremental K-D Tree for Robotic
+      * Applications" (2021). The searches prune subtrees by their bounding boxes.
+      *
+      * The tree owns the cloud returned by getInputCloud (): setInputCloud () copies the
+      * given cloud, and added points are appended to it, so the indices returned by the
+      * searches always refer to that cloud. Deleted points stay in the cloud until
+      * compact () is called. The class derives from search::KdTree, so it can be used as
+      * the target search method of a Registration or CorrespondenceEstimation. It does not
+      * use the FLANN tree of search::KdTree: the point representation and the epsilon are
+      * kept by the class itself, and have to be accessed through an IncrementalKdTree:
+      *
+      * \code
+      * pcl::search::IncrementalKdTree<pcl::PointXYZ>::Ptr map_tree (new pcl::search::IncrementalKdTree<pcl::PointXYZ>);
+      * map_tree->setInputCloud (first_scan);
+      * icp.setSearchMethodTarget (map_tree, true); // never rebuilt by the registration
+      * for (const auto& scan : scans)
+      * {
+      *   icp.setInputSource (scan);
+      *   icp.setInputTarget (map_tree->getInputCloud ());
+      *   icp.align (aligned);
+      *   map_tree->addPoints (aligned);
+      *   map_tree->deletePointsInBox (...); // drop the part of the map left behind
+      * }
+      * \endcode
+      *
+      * \note Only the x, y and z coordinates of the points are used.
+      * \ingroup search
+      */
+    template<typename PointT>
+    class IncrementalKdTree: public pcl::search::KdTree<PointT>
+    {
+      public:
+        using PointCloud = typename Search<PointT>::PointCloud;
+        using PointCloudPtr = typename PointCloud::Ptr;
+        using PointCloudConstPtr = typename Search<PointT>::PointCloudConstPtr;
+        using IndicesConstPtr = pcl::IndicesConstPtr;
+        using PointRepresentationConstPtr = typename PointRepresentation<PointT>::ConstPtr;
+
+        using pcl::search::Search<PointT>::indices_;
+        using pcl::search::Search<PointT>::input_;
+        using pcl::search::Search<PointT>::nearestKSearch;
+        using pcl::search::Search<PointT>::radiusSearch;
+        using pcl::search::Search<PointT>::sorted_results_;
+
+        using Ptr = shared_ptr<IncrementalKdTree<PointT> >;
+        using ConstPtr = shared_ptr<const IncrementalKdTree<PointT> >;
+
+        /** \brief Constructor.
+          * \param[in] sorted set to true if the results of the searches need to be sorted
+          * in ascending order based on their distance to the query point
+          */
+        IncrementalKdTree (bool sorted = true)
+        : pcl::search::KdTree<PointT> ("IncrementalKdTree", sorted)
+        {
+        }
+
+        ~IncrementalKdTree () override = default;
+
+        /** \brief Sets whether the results have to be sorted or not.
+          * \param[in] sorted_results set to true if the radius search results should be sorted
+          */
+        void
+        setSortedResults (bool sorted_results) override
+        {
+          sorted_results_ = sorted_results;
+        }
+
+        /** \brief Provide a pointer to a point representation. The tree itself only uses the
+          * x, y and z coordinates of the points; the representation is only stored, so that
+          * it can be passed on to other search methods built for the same cloud.
+          * \param[in] point_representation the const shared pointer to a PointRepresentation
+          */
+        void
+        setPointRepresentation (const PointRepresentationConstPtr &point_representation)
+        {
+          point_representation_ = point_representation;
+        }
+
+        /** \brief Get the point representation given to setPointRepresentation (). */
+        inline PointRepresentationConstPtr
+        getPointRepresentation () const
+        {
+          return (point_representation_);
+        }
+
+        /** \brief Set the search epsilon precision (error bound) for nearest neighbors
+          * searches: a subtree is skipped when its bounding box is farther away than the
+          * current k-th neighbor divided by (1 + eps). The radius searches stay exact.
+          * \param[in] eps precision (error bound) for nearest neighbors searches
+          */
+        inline void
+        setEpsilon (float eps) { epsilon_ = eps; }
+
+        /** \brief Get the search epsilon precision (error bound) for nearest neighbors searches. */
+        inline float
+        getEpsilon () const { return (epsilon_); }
+
+        /** \brief Set the balance factor: a subtree is rebuilt when one of its children
+          * holds more than this fraction of its nodes. Must be in [0.5, 1), default 0.7.
+          */
+        inline void
+        setBalanceFactor (float balance_factor) { balance_factor_ = balance_factor; }
+
+        /** \brief Get the balance factor. */
+        inline float
+        getBalanceFactor () const { return (balance_factor_); }
+
+        /** \brief Set the deleted factor: a subtree is rebuilt when more than this fraction
+          * of its nodes are deleted. Must be in (0, 1), default 0.5.
+          */
+        inline void
+        setDeletedFactor (float deleted_factor) { deleted_factor_ = deleted_factor; }
+
+        /** \brief Get the deleted factor. */
+        inline float
+        getDeletedFactor () const { return (deleted_factor_); }
+
+        /** \brief Copy the input dataset and build a balanced tree over its finite points.
+          * \param[in] cloud the const boost shared pointer to a PointCloud message
+          * \param[in] indices the point indices subset that is to be used from \a cloud
+          */
+        bool
+        setInputCloud (const PointCloudConstPtr& cloud,
+                       const IndicesConstPtr& indices = IndicesConstPtr ()) override;
+
+        /** \brief Append points to the cloud and insert the finite ones into the tree. The
+          * new points get the indices following the ones already in the cloud.
+          * \param[in] cloud the points to add
+          */
+        void
+        addPoints (const PointCloud &cloud);
+
+        /** \brief Delete all points inside an axis aligned box from the tree. The points stay
+          * in the cloud, but are not returned by the searches anymore.
+          * \param[in] min_pt the minimum corner of the box
+          * \param[in] max_pt the maximum corner of the box
+          * \return the number of deleted points
+          */
+        std::size_t
+        deletePointsInBox (const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt);
+
+        /** \brief Remove the deleted points from the cloud and rebuild the tree. The points
+          * are renumbered, and the cloud returned by getInputCloud () is a new one.
+          */
+        void
+        compact ();
+
+        /** \brief Get the number of points in the tree, i.e. without the deleted ones. */
+        inline std::size_t
+        getNumberOfPoints () const
+        {
+          return (root_ < 0 ? 0 : nodes_[root_].size - nodes_[root_].nr_deleted);
+        }
+
+        /** \brief Search for the k-nearest neighbors for the given query point.
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &point, int k, Indices &k_indices, std::vector<float> &k_sqr_distances) const override;
+
+        /** \brief Search for all the nearest neighbors of the query point in a given radius.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value. If \a max_nn is set to
+          * 0 or to a number higher than the number of points in the input cloud, all neighbors in \a radius will be
+          * returned.
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT& point, double radius,
+                      Indices &k_indices, std::vector<float> &k_sqr_distances,
+                      unsigned int max_nn = 0) const override;
+
+        /** \brief Search for the k-nearest neighbors for the given query point, using the
+          * buffers of a search context.
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &point, int k, SearchContext &context) const override
+        {
+          return (nearestKSearch (point, k, context.indices, context.sqr_distances));
+        }
+
+        /** \brief Search for all the nearest neighbors of the query point in a given radius,
+          * using the buffers of a search context.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT& point, double radius, SearchContext &context,
+                      unsigned int max_nn = 0) const override
+        {
+          return (radiusSearch (point, radius, context.indices, context.sqr_distances, max_nn));
+        }
+
+      protected:
+        /** \brief A node of the tree, holding one point. */
+        struct Node
+        {
+          /** \brief The coordinates of the point. */
+          Eigen::Vector3f point;
+          /** \brief The bounding box of the points of the subtree which are not deleted. */
+          Eigen::Vector3f min_p;
+          Eigen::Vector3f max_p;
+          /** \brief The index of the point in the cloud. */
+          index_t index;
+          /** \brief The children, -1 if there is none. */
+          int left;
+          int right;
+          /** \brief The splitting axis. */
+          int axis;
+          /** \brief The number of nodes of the subtree, including the deleted ones. */
+          uindex_t size;
+          /** \brief The number of deleted nodes of the subtree. */
+          uindex_t nr_deleted;
+          /** \brief Whether the point of this node is deleted. */
+          bool deleted;
+          /** \brief Whether the subtree changed since the last call to maintain (). */
+          bool dirty;
+        };
+
+        /** \brief Get a new node for a point, reusing the nodes freed by rebuilds. */
+        int
+        allocateNode (const Eigen::Vector3f &point, index_t index, int axis);
+
+        /** \brief Build a balanced subtree over the given nodes.
+          * \return the root of the subtree, -1 if there are no nodes
+          */
+        int
+        buildSubtree (int *begin, int *end);
+
+        /** \brief Rebuild a subtree without its deleted nodes.
+          * \return the new root of the subtree, -1 if all its nodes were deleted
+          */
+        int
+        rebuildSubtree (int id);
+
+        /** \brief Recompute the size, the number of deleted nodes and the bounding box of a
+          * node from its children. */
+        void
+        updateNode (int id);
+
+        /** \brief Rebuild the topmost unbalanced subtrees among the dirty nodes.
+          * \return the (possibly new) root of the subtree
+          */
+        int
+        maintain (int id);
+
+        /** \brief Insert a point below the root, without rebalancing. */
+        void
+        insert (const Eigen::Vector3f &point, index_t index);
+
+        /** \brief Mark the points of a subtree inside a box as deleted. */
+        std::size_t
+        deleteInBox (int id, const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt);
+
+        /** \brief Get the squared distance between a point and the bounding box of a subtree. */
+        inline float
+        getBoxSqrDistance (const Node &node, const Eigen::Vector3f &p) const
+        {
+          return ((node.min_p - p).cwiseMax (p - node.max_p).cwiseMax (0.0f).squaredNorm ());
+        }
+
+        /** \brief Add the points of a subtree to a max-heap of the k nearest neighbors found so far. */
+        void
+        searchKNN (int id, const Eigen::Vector3f &p, std::size_t k,
+                   std::vector<std::pair<float, index_t> > &heap) const;
+
+        /** \brief Add the points of a subtree within a radius of p to the results.
+          * \return true if max_nn results were found
+          */
+        bool
+        searchRadius (int id, const Eigen::Vector3f &p, float sqr_radius, std::size_t max_nn,
+                      std::vector<std::pair<float, index_t> > &results) const;
+
+        /** \brief The cloud owned by the tree, which input_ points to. */
+        PointCloudPtr cloud_;
+
+        /** \brief The point representation given to setPointRepresentation (). */
+        PointRepresentationConstPtr point_representation_;
+
+        /** \brief The error bound of the nearest neighbors searches. */
+        float epsilon_{0.0f};
+
+        /** \brief The nodes of the tree. */
+        std::vector<Node> nodes_;
+
+        /** \brief Nodes which can be reused. */
+        std::vector<int> free_nodes_;
+
+        /** \brief The root node, -1 if the tree is empty. */
+        int root_{-1};
+
+        /** \brief The maximum fraction of the nodes of a subtree one child may hold. */
+        float balance_factor_{0.7f};
+
+        /** \brief The maximum fraction of deleted nodes of a subtree. */
+        float deleted_factor_{0.5f};
+
+        /** \brief Subtrees smaller than this are never rebuilt. */
+        static constexpr uindex_t min_rebuild_size_ = 16;
+    };
+  }
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/search/impl/incremental_kdtree.hpp>
+#endif
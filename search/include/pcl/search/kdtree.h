@@ -102,7 +102,7 @@ namespace pcl
         inline PointRepresentationConstPtr
         getPointRepresentation () const
         {
-          return (tree_->getPointRepresentation ());
+          return (tree_ ? tree_->getPointRepresentation () : PointRepresentationConstPtr ());
         }
 
         /** \brief Sets whether the results have to be sorted or not.
@@ -121,7 +121,7 @@ namespace pcl
         inline float
         getEpsilon () const
         {
-          return (tree_->getEpsilon ());
+          return (tree_ ? tree_->getEpsilon () : 0.0f);
         }
 
         /** \brief Provide a pointer to the input dataset.
@@ -160,6 +160,28 @@ namespace pcl
                       Indices &k_indices,
                       std::vector<float> &k_sqr_distances,
                       unsigned int max_nn = 0) const override;
+
+        /** \brief Search for the k-nearest neighbors for the given query point, using the
+          * buffers of a search context.
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &point, int k, SearchContext &context) const override;
+
+        /** \brief Search for all the nearest neighbors of the query point in a given radius,
+          * using the buffers of a search context.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT& point, double radius, SearchContext &context,
+                      unsigned int max_nn = 0) const override;
       protected:
         /** \brief This leaves the internal tree_ object uninitialized! */
         KdTree (const std::string& name, bool sorted);
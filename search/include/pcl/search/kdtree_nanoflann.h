@@ -436,6 +436,99 @@ public:
                  int k,
                  Indices& k_indices,
                  std::vector<float>& k_sqr_distances) const override
+  {
+    std::vector<float> query;
+    return searchNearestK(point, k, k_indices, k_sqr_distances, query);
+  }
+
+  /** @brief Search for the k-nearest neighbors for the given query point, using the
+   * buffers of a search context.
+   * @param[in] point the given query point
+   * @param[in] k the number of neighbors to search for
+   * @param[in,out] context the buffers of the calling thread, holding the results
+   * afterwards
+   * @return number of neighbors found
+   */
+  int
+  nearestKSearch(const PointT& point, int k, SearchContext& context) const override
+  {
+    return searchNearestK(
+        point, k, context.indices, context.sqr_distances, context.query);
+  }
+
+  /** @brief Search for all the nearest neighbors of the query point in a given radius.
+   * @param[in] point the given query point
+   * @param[in] radius the radius of the sphere bounding all of p_q's neighbors
+   * @param[out] k_indices the resultant indices of the neighboring points
+   * @param[out] k_sqr_distances the resultant squared distances to the neighboring
+   * points
+   * @param[in] max_nn if given, bounds the maximum returned neighbors to this value. If
+   * \a max_nn is set to 0 or to a number higher than the number of points in the input
+   * cloud, all neighbors in \a radius will be returned.
+   * @return number of neighbors found in radius
+   */
+  int
+  radiusSearch(const PointT& point,
+               double radius,
+               Indices& k_indices,
+               std::vector<float>& k_sqr_distances,
+               unsigned int max_nn = 0) const override
+  {
+    std::vector<float> query;
+    return searchRadius(point, radius, k_indices, k_sqr_distances, max_nn, query, false);
+  }
+
+  /** @brief Search for all the nearest neighbors of the query point in a given radius,
+   * using the buffers of a search context.
+   *
+   * Sorted results are sorted in place, instead of by nanoflann in a vector of its own,
+   * so that the search does not allocate once the buffers of the context have grown.
+   *
+   * @param[in] point the given query point
+   * @param[in] radius the radius of the sphere bounding all of p_q's neighbors
+   * @param[in,out] context the buffers of the calling thread, holding the results
+   * afterwards
+   * @param[in] max_nn if given, bounds the maximum returned neighbors to this value
+   * @return number of neighbors found in radius
+   */
+  int
+  radiusSearch(const PointT& point,
+               double radius,
+               SearchContext& context,
+               unsigned int max_nn = 0) const override
+  {
+    return searchRadius(point,
+                        radius,
+                        context.indices,
+                        context.sqr_distances,
+                        max_nn,
+                        context.query,
+                        true);
+  }
+
+private:
+  /** Get the coordinates of a query point, converted into \a buffer if the point
+   * representation is not trivial.
+   */
+  const float*
+  getQueryPoint(const PointT& point, std::vector<float>& buffer) const
+  {
+    if (point_representation_->isTrivial())
+      return reinterpret_cast<const float*>(&point);
+    buffer.resize(point_representation_->getNumberOfDimensions());
+    point_representation_->vectorize(point, buffer);
+    return buffer.data();
+  }
+
+  /** Search for the k-nearest neighbors, with the buffer for the converted query point
+   * given by the caller.
+   */
+  int
+  searchNearestK(const PointT& point,
+                 int k,
+                 Indices& k_indices,
+                 std::vector<float>& k_sqr_distances,
+                 std::vector<float>& query) const
   {
     assert(point_representation_->isValid(point) &&
            "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
@@ -443,24 +536,19 @@ public:
       k = adaptor_->kdtree_get_point_count();
     k_indices.resize(k);
     k_sqr_distances.resize(k);
-    float* query_point = nullptr;
-    if (!point_representation_->isTrivial()) {
-      query_point = new float[point_representation_->getNumberOfDimensions()];
-      point_representation_->vectorize(point, query_point);
-    }
+    const float* query_point = getQueryPoint(point, query);
     // like nanoflann_tree_->knnSearch
     nanoflann::KNNResultSet<float, pcl::index_t> resultSet(k);
     resultSet.init(k_indices.data(), k_sqr_distances.data());
     nanoflann_tree_->findNeighbors(
         resultSet,
-        (query_point ? query_point : reinterpret_cast<const float*>(&point))
+        query_point
 #if NANOFLANN_VERSION < 0x150
             ,
         nanoflann::SearchParams()
 #endif // NANOFLANN_VERSION < 0x150
     );
     const auto search_result = resultSet.size();
-    delete[] query_point;
     assert(search_result == k);
 
     if (!identity_mapping_) {
@@ -471,37 +559,28 @@ public:
     return search_result;
   }
 
-  /** @brief Search for all the nearest neighbors of the query point in a given radius.
-   * @param[in] point the given query point
-   * @param[in] radius the radius of the sphere bounding all of p_q's neighbors
-   * @param[out] k_indices the resultant indices of the neighboring points
-   * @param[out] k_sqr_distances the resultant squared distances to the neighboring
-   * points
-   * @param[in] max_nn if given, bounds the maximum returned neighbors to this value. If
-   * \a max_nn is set to 0 or to a number higher than the number of points in the input
-   * cloud, all neighbors in \a radius will be returned.
-   * @return number of neighbors found in radius
+  /** Search for all the nearest neighbors in a given radius, with the buffer for the
+   * converted query point given by the caller. If sort_in_place is true, sorted
+   * results are sorted in the output vectors instead of in a vector of nanoflann.
    */
   int
-  radiusSearch(const PointT& point,
+  searchRadius(const PointT& point,
                double radius,
                Indices& k_indices,
                std::vector<float>& k_sqr_distances,
-               unsigned int max_nn = 0) const override
+               unsigned int max_nn,
+               std::vector<float>& query,
+               bool sort_in_place) const
   {
     assert(point_representation_->isValid(point) &&
            "Invalid (NaN, Inf) point coordinates given to radiusSearch!");
-    float* query_point = nullptr;
-    if (!point_representation_->isTrivial()) {
-      query_point = new float[point_representation_->getNumberOfDimensions()];
-      point_representation_->vectorize(point, query_point);
-    }
+    const float* query_point = getQueryPoint(point, query);
     if (max_nn == 0) {
       // return _all_ points within radius
       // Calling this->sortResults is currently slower than sorting the vector of
       // nanoflann::ResultItem However, if sorted results are not requested, using
       // PCLRadiusResultSet with radiusSearchCustomCallback avoids copies and is faster
-      if (sorted_results_) {
+      if (sorted_results_ && !sort_in_place) {
 #if NANOFLANN_VERSION < 0x150
         std::vector<std::pair<pcl::index_t, float>>
             IndicesDists; // nanoflann::ResultItem was introduced in version 1.5.0
@@ -513,7 +592,7 @@ public:
             pcl::search::internal::square_if_l2<Distance>(radius), IndicesDists);
         nanoflann_tree_->findNeighbors(
             resultSet,
-            (query_point ? query_point : reinterpret_cast<const float*>(&point)),
+            query_point,
 #if NANOFLANN_VERSION < 0x150
             {32, eps_, sorted_results_} // first parameter is ignored in older versions,
                                         // and removed in newer versions
@@ -535,7 +614,6 @@ public:
                                            : index_mapping_[IndicesDists[i].first];
           k_sqr_distances[i] = IndicesDists[i].second;
         }
-        delete[] query_point;
         return search_result;
       }
       else {
@@ -546,7 +624,7 @@ public:
         // like nanoflann_tree_->radiusSearchCustomCallback
         nanoflann_tree_->findNeighbors(
             resultSet,
-            (query_point ? query_point : reinterpret_cast<const float*>(&point)),
+            query_point,
 #if NANOFLANN_VERSION < 0x150
             {32, eps_, sorted_results_} // first parameter is ignored in older versions,
                                         // and removed in newer versions
@@ -562,7 +640,6 @@ public:
         }
         if (sorted_results_)
           this->sortResults(k_indices, k_sqr_distances);
-        delete[] query_point;
         return search_result;
       }
     }
@@ -581,7 +658,7 @@ public:
         resultSet.init(k_indices.data(), k_sqr_distances.data());
         nanoflann_tree_->findNeighbors(
             resultSet,
-            (query_point ? query_point : reinterpret_cast<const float*>(&point))
+            query_point
 #if NANOFLANN_VERSION < 0x150
                 ,
             nanoflann::SearchParams()
@@ -603,7 +680,7 @@ public:
         resultSet.init(k_indices.data(), k_sqr_distances.data());
         nanoflann_tree_->findNeighbors(
             resultSet,
-            (query_point ? query_point : reinterpret_cast<const float*>(&point)));
+            query_point);
         const auto search_result = resultSet.size();
         k_indices.resize(search_result);
         k_sqr_distances.resize(search_result);
@@ -613,7 +690,6 @@ public:
             index = index_mapping_[index];
           }
         }
-        delete[] query_point;
         return search_result;
       }
       else {
@@ -626,7 +702,7 @@ public:
         // like nanoflann_tree_->radiusSearchCustomCallback
         nanoflann_tree_->findNeighbors(
             resultSet,
-            (query_point ? query_point : reinterpret_cast<const float*>(&point)),
+            query_point,
 #if NANOFLANN_VERSION < 0x150
             {32, eps_, sorted_results_} // first parameter is ignored in older versions,
                                         // and removed in newer versions
@@ -642,13 +718,11 @@ public:
         }
         if (sorted_results_)
           this->sortResults(k_indices, k_sqr_distances);
-        delete[] query_point;
         return search_result;
       }
     }
   }
 
-private:
   /** Set up index_mapping_, adaptor_, and nanoflann_tree_, based on
    * point_representation_, input_, and indices_.
    */
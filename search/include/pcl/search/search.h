@@ -40,14 +40,122 @@
 
 #include <pcl/pcl_base.h> // for IndicesConstPtr
 #include <pcl/point_cloud.h>
+#include <pcl/search_context.h>
 #include <pcl/for_each_type.h>
 #include <pcl/common/concatenate.h>
 #include <pcl/common/copy_point.h>
 
+#include <utility> // for swap
+
 namespace pcl
 {
   namespace search
   {
+    /** \brief Neighbors of a batch of query points, stored in flat arrays (compressed sparse row layout).
+      *
+      * The neighbors of the i-th query point are stored at the positions
+      * [offsets[i], offsets[i + 1]) of \a indices and \a sqr_distances. The vectors are
+      * only resized by the batched searches, so an object reused across calls does not
+      * reallocate once it has grown large enough.
+      *
+      * \ingroup search
+      */
+    struct Neighborhoods
+    {
+      /** \brief Start of the neighbors of every query point in \a indices, followed by the total number of neighbors. */
+      std::vector<std::size_t> offsets;
+
+      /** \brief The indices of the neighbors of all query points. */
+      Indices indices;
+
+      /** \brief The squared distances of the neighbors of all query points. */
+      std::vector<float> sqr_distances;
+
+      /** \brief Get the number of query points. */
+      inline std::size_t
+      size () const
+      {
+        return (offsets.empty () ? 0 : offsets.size () - 1);
+      }
+
+      /** \brief Get the number of neighbors of a query point.
+        * \param[in] query the position of the query point in the batch
+        */
+      inline std::size_t
+      getNumberOfNeighbors (std::size_t query) const
+      {
+        return (offsets[query + 1] - offsets[query]);
+      }
+
+      /** \brief Remove all query points, keeping the allocated memory. */
+      inline void
+      clear ()
+      {
+        offsets.clear ();
+        indices.clear ();
+        sqr_distances.clear ();
+      }
+    };
+
+    namespace detail
+    {
+      /** \brief Whether a neighbor comes before another one in sorted results: it is closer,
+        * or as close and has a smaller index.
+        */
+      inline bool
+      precedes (float distance, index_t index, float other_distance, index_t other_index)
+      {
+        return (distance < other_distance || (distance == other_distance && index < other_index));
+      }
+
+      /** \brief Move the neighbor at position \a pos down the max-heap formed by the first
+        * \a size neighbors, which keeps the neighbor that comes last in sorted results on top.
+        */
+      inline void
+      siftDownNeighbor (Indices &indices, std::vector<float> &distances, std::size_t pos, std::size_t size)
+      {
+        for (std::size_t child = 2 * pos + 1; child < size; pos = child, child = 2 * pos + 1)
+        {
+          if (child + 1 < size && precedes (distances[child], indices[child], distances[child + 1], indices[child + 1]))
+            ++child;
+          if (!precedes (distances[pos], indices[pos], distances[child], indices[child]))
+            return;
+          std::swap (indices[pos], indices[child]);
+          std::swap (distances[pos], distances[child]);
+        }
+      }
+
+      /** \brief Add a neighbor to the max-heap formed by all neighbors. */
+      inline void
+      pushNeighbor (Indices &indices, std::vector<float> &distances, index_t index, float distance)
+      {
+        indices.push_back (index);
+        distances.push_back (distance);
+        for (std::size_t pos = indices.size () - 1; pos > 0;)
+        {
+          const std::size_t parent = (pos - 1) / 2;
+          if (!precedes (distances[parent], indices[parent], distances[pos], indices[pos]))
+            return;
+          std::swap (indices[parent], indices[pos]);
+          std::swap (distances[parent], distances[pos]);
+          pos = parent;
+        }
+      }
+
+      /** \brief Sort the neighbors of the max-heap formed by all neighbors, in place. */
+      inline void
+      sortNeighborHeap (Indices &indices, std::vector<float> &distances)
+      {
+        for (std::size_t end = indices.size (); end > 1;)
+        {
+          --end;
+          std::swap (indices[0], indices[end]);
+          std::swap (distances[0], distances[end]);
+          siftDownNeighbor (indices, distances, 0, end);
+        }
+      }
+    } // namespace detail
+
     /** \brief Generic search class. All search wrappers must inherit from this.
       *
       * Each search method must implement 2 different types of search:
@@ -133,6 +241,20 @@ namespace pcl
           return (indices_);
         }
 
+        /** \brief Set the number of threads used by the batched searches, which query
+          * the points of a batch concurrently.
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        void
+        setNumberOfThreads (unsigned int nr_threads = 0);
+
+        /** \brief Get the number of threads used by the batched searches. */
+        inline unsigned int
+        getNumberOfThreads () const
+        {
+          return (num_threads_);
+        }
+
         /** \brief Search for the k-nearest neighbors for the given query point.
           * \param[in] point the given query point
           * \param[in] k the number of neighbors to search for
@@ -218,6 +340,17 @@ namespace pcl
                         int k, std::vector<Indices>& k_indices,
                         std::vector< std::vector<float> >& k_sqr_distances) const;
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, writing
+          * all results into flat arrays.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices a vector of point cloud indices to query for nearest neighbors. If indices is empty, neighbors will be searched for all points.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighborhoods the neighbors of all query points, in the order of the query points
+          */
+        virtual void
+        nearestKSearch (const PointCloud& cloud, const Indices& indices,
+                        int k, Neighborhoods& neighborhoods) const;
+
         /** \brief Search for the k-nearest neighbors for the given query point. Use this method if the query points are of a different type than the points in the data set (e.g. PointXYZRGBA instead of PointXYZ).
           * \param[in] cloud the point cloud data
           * \param[in] indices a vector of point cloud indices to query for nearest neighbors
@@ -354,6 +487,23 @@ namespace pcl
                       std::vector< std::vector<float> > &k_sqr_distances,
                       unsigned int max_nn = 0) const;
 
+        /** \brief Search for all the nearest neighbors of a batch of query points in a given
+          * radius, writing all results into flat arrays.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud. If indices is empty, neighbors will be searched for all points.
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[out] neighborhoods the neighbors of all query points, in the order of the query points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value. If \a max_nn is set to
+          * 0 or to a number higher than the number of points in the input cloud, all neighbors in \a radius will be
+          * returned.
+          */
+        virtual void
+        radiusSearch (const PointCloud& cloud,
+                      const Indices& indices,
+                      double radius,
+                      Neighborhoods& neighborhoods,
+                      unsigned int max_nn = 0) const;
+
         /** \brief Search for all the nearest neighbors of the query points in a given radius.
           * \param[in] cloud the point cloud data
           * \param[in] indices a vector of point cloud indices to query for nearest neighbors
@@ -395,7 +545,98 @@ namespace pcl
           }
         }
 
+        /** \brief Search for the k-nearest neighbors of the given query point, using the
+          * buffers of a search context. The results are stored in \a context.indices and
+          * \a context.sqr_distances.
+          *
+          * Search methods which need intermediate buffers take them from the context, so that
+          * reusing a context saves the allocations of these buffers. Allocations inside the
+          * search method itself remain, see \ref pcl::SearchContext. The default implementation
+          * forwards to the search into vectors.
+          *
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \return number of neighbors found
+          */
+        virtual int
+        nearestKSearch (const PointT &point, int k, SearchContext &context) const;
+
+        /** \brief Search for the k-nearest neighbors of a point of a cloud, using the buffers
+          * of a search context.
+          * \param[in] cloud the point cloud data
+          * \param[in] index a \a valid index in \a cloud representing a \a valid (i.e., finite) query point
+          * \param[in] k the number of neighbors to search for
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointCloud &cloud, index_t index, int k, SearchContext &context) const;
+
+        /** \brief Search for the k-nearest neighbors of a point of the input cloud, using the
+          * buffers of a search context.
+          * \param[in] index a \a valid index representing a \a valid query point in the dataset given
+          * by \a setInputCloud. If indices were given in setInputCloud, index will be the position in
+          * the indices vector.
+          * \param[in] k the number of neighbors to search for
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (index_t index, int k, SearchContext &context) const;
+
+        /** \brief Search for all the nearest neighbors of the query point in a given radius,
+          * using the buffers of a search context. The results are stored in \a context.indices
+          * and \a context.sqr_distances.
+          *
+          * Search methods which need intermediate buffers take them from the context, so that
+          * reusing a context saves the allocations of these buffers. Allocations inside the
+          * search method itself remain, see \ref pcl::SearchContext. The default implementation
+          * forwards to the search into vectors.
+          *
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value. If \a max_nn is set to
+          * 0 or to a number higher than the number of points in the input cloud, all neighbors in \a radius will be
+          * returned.
+          * \return number of neighbors found in radius
+          */
+        virtual int
+        radiusSearch (const PointT &point, double radius, SearchContext &context,
+                      unsigned int max_nn = 0) const;
+
+        /** \brief Search for all the nearest neighbors of a point of a cloud in a given radius,
+          * using the buffers of a search context.
+          * \param[in] cloud the point cloud data
+          * \param[in] index a \a valid index in \a cloud representing a \a valid (i.e., finite) query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointCloud &cloud, index_t index, double radius,
+                      SearchContext &context, unsigned int max_nn = 0) const;
+
+        /** \brief Search for all the nearest neighbors of a point of the input cloud in a given
+          * radius, using the buffers of a search context.
+          * \param[in] index a \a valid index representing a \a valid query point in the dataset given
+          * by \a setInputCloud. If indices were given in setInputCloud, index will be the position in
+          * the indices vector.
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[in,out] context the buffers of the calling thread, holding the results afterwards
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (index_t index, double radius, SearchContext &context,
+                      unsigned int max_nn = 0) const;
+
       protected:
+        /** \brief Sort the neighbors by their distance, and the ones at the same distance by
+          * their index. The neighbors are sorted in place, without any buffer.
+          */
         void 
         sortResults (Indices& indices, std::vector<float>& distances) const;
 
@@ -403,23 +644,8 @@ namespace pcl
         IndicesConstPtr indices_;
         bool sorted_results_;
         std::string name_;
-        
-      private:
-        struct Compare
-        {
-          Compare (const std::vector<float>& distances)
-          : distances_ (distances)
-          {
-          }
-          
-          bool 
-          operator () (index_t first, index_t second) const
-          {
-            return (distances_ [first] < distances_[second]);
-          }
-
-          const std::vector<float>& distances_;
-        };
+        /** \brief The number of threads used by the batched searches. */
+        unsigned int num_threads_{1};
     }; // class Search    
   } // namespace search
 } // namespace pcl
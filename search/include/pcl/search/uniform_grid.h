@@ -0,0 +1,230 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/search/search.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+  namespace search
+  {
+    /** \brief Search over a uniform grid of cubic cells, stored in a hash table.
+      *
+      * The grid is built once in setInputCloud (): the points are sorted by
+      * cell, and each occupied cell is stored with the range of its points in
+      * an open addressing hash table. A radius search then only visits the
+      * cells that overlap the bounding box of the query sphere, e.g. the 27
+      * cells around the query point when the radius is equal to the resolution.
+      *
+      * This is well suited for searches with a fixed radius, e.g. as the search
+      * method of EuclideanClusterExtraction or ConditionalEuclideanClustering with
+      * the resolution set to the cluster tolerance, since building the grid is much
+      * cheaper than building a kd-tree:
+      *
+      * \code
+      * pcl::EuclideanClusterExtraction<pcl::PointXYZ> ec;
+      * ec.setClusterTolerance (0.2);
+      * ec.setSearchMethod (pcl::make_shared<pcl::search::UniformGrid<pcl::PointXYZ>> (0.2));
+      * \endcode
+      *
+      * k nearest neighbor searches visit shells of cells of increasing size
+      * around the query point, until no closer point can be found.
+      *
+      * \ingroup search
+      */
+    template<typename PointT>
+    class UniformGrid: public Search<PointT>
+    {
+      using PointCloudConstPtr = typename Search<PointT>::PointCloudConstPtr;
+      using IndicesConstPtr = pcl::IndicesConstPtr;
+
+      using pcl::search::Search<PointT>::input_;
+      using pcl::search::Search<PointT>::indices_;
+      using pcl::search::Search<PointT>::sorted_results_;
+
+      public:
+        using Ptr = shared_ptr<UniformGrid<PointT> >;
+        using ConstPtr = shared_ptr<const UniformGrid<PointT> >;
+
+        using pcl::search::Search<PointT>::nearestKSearch;
+        using pcl::search::Search<PointT>::radiusSearch;
+
+        /** \brief Constructor.
+          * \param[in] resolution the edge length of the grid cells
+          * \param[in] sorted_results whether the results should be sorted by distance
+          */
+        UniformGrid (double resolution, bool sorted_results = false)
+        : Search<PointT> ("UniformGrid", sorted_results)
+        , resolution_ (resolution)
+        {
+        }
+
+        ~UniformGrid () override = default;
+
+        /** \brief Set the edge length of the grid cells. The grid is rebuilt by the next call to setInputCloud ().
+          * \param[in] resolution the edge length of the grid cells
+          */
+        inline void
+        setResolution (double resolution) { resolution_ = resolution; }
+
+        /** \brief Get the edge length of the grid cells. */
+        inline double
+        getResolution () const { return (resolution_); }
+
+        /** \brief Get the number of occupied cells. */
+        inline std::size_t
+        getNumberOfCells () const { return (nr_cells_); }
+
+        /** \brief Provide a pointer to the input dataset and build the grid.
+          * \param[in] cloud the const boost shared pointer to a PointCloud message
+          * \param[in] indices the point indices subset that is to be used from \a cloud
+          * \return false if the grid could not be built, e.g. because the resolution is too
+          * small for the extent of the cloud
+          */
+        bool
+        setInputCloud (const PointCloudConstPtr& cloud,
+                       const IndicesConstPtr& indices = IndicesConstPtr ()) override;
+
+        /** \brief Search for the k-nearest neighbors for the given query point.
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &point, int k, Indices &k_indices, std::vector<float> &k_sqr_distances) const override;
+
+        /** \brief Search for all the nearest neighbors of the query point in a given radius.
+          * \param[in] point the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value. If \a max_nn is set to
+          * 0 or to a number higher than the number of points in the input cloud, all neighbors in \a radius will be
+          * returned.
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT& point, double radius,
+                      Indices &k_indices, std::vector<float> &k_sqr_distances,
+                      unsigned int max_nn = 0) const override;
+
+      protected:
+        /** \brief An occupied cell: its key and the range of its points in sorted_indices_. */
+        struct Cell
+        {
+          std::uint64_t key;
+          uindex_t begin;
+          uindex_t end;
+        };
+
+        /** \brief Get the key of the cell with the given integer coordinates (which must lie inside the grid). */
+        inline std::uint64_t
+        getKey (std::int64_t i, std::int64_t j, std::int64_t k) const
+        {
+          return (static_cast<std::uint64_t> (i) | (static_cast<std::uint64_t> (j) << 21) | (static_cast<std::uint64_t> (k) << 42));
+        }
+
+        /** \brief Get the slot of a key in the hash table. */
+        inline std::size_t
+        getSlot (std::uint64_t key) const
+        {
+          return (static_cast<std::size_t> ((key * 0x9E3779B97F4A7C15ull) >> 20) & (cells_.size () - 1));
+        }
+
+        /** \brief Find an occupied cell, nullptr if the cell is empty. */
+        const Cell*
+        findCell (std::int64_t i, std::int64_t j, std::int64_t k) const;
+
+        /** \brief Get the integer coordinates of the cell containing a point. Points outside of
+          * the grid are mapped to the layer of cells just outside of it.
+          */
+        inline Eigen::Array3i
+        getCellCoordinates (const Eigen::Vector3f &p) const
+        {
+          return (((p - min_p_).array () * inverse_resolution_).floor ()
+                  .max (-1.0f).min (dims_.template cast<float> ()).template cast<int> ());
+        }
+
+        /** \brief Add the points [begin, end) of sorted_points_ that lie within a radius of p to the results.
+          * \return true if max_nn results were found
+          */
+        bool
+        addRangeInRadius (uindex_t begin, uindex_t end, const Eigen::Vector3f &p, double sqr_radius, unsigned int max_nn,
+                          Indices &k_indices, std::vector<float> &k_sqr_distances) const;
+
+        /** \brief Add the points [begin, end) of sorted_points_ to a max-heap of the k nearest neighbors found so far. */
+        void
+        addRangeToHeap (uindex_t begin, uindex_t end, const Eigen::Vector3f &p, std::size_t k,
+                        std::vector<std::pair<float, index_t> > &heap) const;
+
+        /** \brief The edge length of the grid cells. */
+        double resolution_;
+
+        /** \brief 1 / resolution_, as used to compute the cell coordinates. */
+        float inverse_resolution_{0.0f};
+
+        /** \brief The minimum corner of the grid. */
+        Eigen::Vector3f min_p_{Eigen::Vector3f::Zero ()};
+
+        /** \brief The number of cells along each axis. */
+        Eigen::Array3i dims_{Eigen::Array3i::Zero ()};
+
+        /** \brief The number of occupied cells. */
+        std::size_t nr_cells_{0};
+
+        /** \brief Open addressing hash table of the occupied cells. */
+        std::vector<Cell> cells_;
+
+        /** \brief The indices of the valid input points, sorted by cell. */
+        Indices sorted_indices_;
+
+        /** \brief The coordinates of the points in sorted_indices_, stored contiguously. */
+        std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > sorted_points_;
+    };
+  }
+}
+
+#ifdef PCL_NO_PRECOMPILE
+#include <pcl/search/impl/uniform_grid.hpp>
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#pragma once
+
+#include <pcl/types.h> // for index_t
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Disjoint sets over the elements [0, size) that can be merged from several threads at once.
+    *
+    * Every set is represented by its smallest element: merging two sets links
+    * the larger root to the smaller one with a compare-and-swap, and find ()
+    * shortens the paths it walks (path halving) the same way. The resulting
+    * partition therefore does not depend on the order in which the merges
+    * are performed, nor on the number of threads.
+    *
+    * \ingroup segmentation
+    */
+  class ConcurrentUnionFind
+  {
+    public:
+      /** \brief Constructor.
+        * \param[in] size the number of elements, each one starting in its own set
+        */
+      explicit ConcurrentUnionFind (std::size_t size = 0) { reset (size); }
+
+      /** \brief Put each of the \a size elements back into its own set. */
+      inline void
+      reset (std::size_t size)
+      {
+        if (parent_.size () != size)
+          parent_ = std::vector<std::atomic<index_t> > (size);
+        for (std::size_t i = 0; i < size; ++i)
+          parent_[i].store (static_cast<index_t> (i), std::memory_order_relaxed);
+      }
+
+      /** \brief Get the number of elements. */
+      inline std::size_t
+      size () const { return (parent_.size ()); }
+
+      /** \brief Get the representative (smallest element) of the set containing \a element. */
+      inline index_t
+      find (index_t element)
+      {
+        index_t parent = parent_[element].load ();
+        while (parent != element)
+        {
+          index_t grandparent = parent_[parent].load ();
+          // Path halving, only ever moves an element closer to its root
+          if (grandparent != parent)
+            parent_[element].compare_exchange_weak (parent, grandparent);
+          element = grandparent;
+          parent = parent_[element].load ();
+        }
+        return (element);
+      }
+
+      /** \brief Merge the sets containing \a a and \a b. */
+      inline void
+      merge (index_t a, index_t b)
+      {
+        while (true)
+        {
+          a = find (a);
+          b = find (b);
+          if (a == b)
+            return;
+          if (a > b)
+            std::swap (a, b);
+          // Only succeeds if b is still a root, otherwise retry from the new roots
+          index_t expected = b;
+          if (parent_[b].compare_exchange_strong (expected, a))
+            return;
+        }
+      }
+
+    private:
+      /** \brief The parent of each element, roots are their own parent. */
+      std::vector<std::atomic<index_t> > parent_;
+  };
+}
@@ -106,6 +106,8 @@ namespace pcl
       }
 
       /** \brief Provide a pointer to the search object.
+        * \note For unorganized clouds, a pcl::search::UniformGrid with its resolution set
+        * to the cluster tolerance is usually much faster to build than a kd-tree.
         * \param[in] tree a pointer to the spatial search object.
         */
       inline void
@@ -74,13 +74,17 @@ namespace pcl
     * \param clusters the resultant clusters containing point indices (as a vector of PointIndices)
     * \param min_pts_per_cluster minimum number of points that a cluster may contain (default: 1)
     * \param max_pts_per_cluster maximum number of points that a cluster may contain (default: max int)
+    * \param num_threads the number of threads to use (default: 1). With more than one thread,
+    * the neighbors of all points are searched concurrently and the connected components are
+    * merged with a ConcurrentUnionFind. The clusters, and their order, are the same as with a single thread.
     * \ingroup segmentation
     */
   template <typename PointT> void 
   extractEuclideanClusters (
       const PointCloud<PointT> &cloud, const Indices &indices,
       const typename search::Search<PointT>::Ptr &tree, float tolerance, std::vector<PointIndices> &clusters,
-      unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) ());
+      unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) (),
+      unsigned int num_threads = 1);
 
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   /** \brief Decompose a region of space into clusters based on the euclidean distance between points, and the normal
@@ -344,6 +348,8 @@ namespace pcl
       EuclideanClusterExtraction () = default;
 
       /** \brief Provide a pointer to the search object.
+        * \note For unorganized clouds, a pcl::search::UniformGrid with its resolution set
+        * to the cluster tolerance is usually much faster to build than a kd-tree.
         * \param[in] tree a pointer to the spatial search object.
         */
       inline void 
@@ -409,6 +415,20 @@ namespace pcl
         return (max_pts_per_cluster_); 
       }
 
+      /** \brief Set the number of threads to use for the neighbor searches. The clusters
+        * do not depend on the number of threads.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0);
+
+      /** \brief Get the number of threads used for the neighbor searches. */
+      inline unsigned int
+      getNumberOfThreads () const
+      {
+        return (num_threads_);
+      }
+
       /** \brief Cluster extraction in a PointCloud given by <setInputCloud (), setIndices ()>
         * \param[out] clusters the resultant point clusters
         */
@@ -434,6 +454,9 @@ namespace pcl
       /** \brief The maximum number of points that a cluster needs to contain in order to be considered valid (default = MAXINT). */
       pcl::uindex_t max_pts_per_cluster_{std::numeric_limits<pcl::uindex_t>::max()};
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int num_threads_{1};
+
       /** \brief Class getName method. */
       virtual std::string getClassName () const { return ("EuclideanClusterExtraction"); }
 
@@ -64,7 +64,12 @@ pcl::ConditionalEuclideanClustering<PointT>::segment (pcl::IndicesClusters &clus
     else
       searcher_.reset (new pcl::search::KdTree<PointT> (false)); // not requiring sorted results is much faster
   }
-  searcher_->setInputCloud (input_, indices_);
+  if (!searcher_->setInputCloud (input_, indices_))
+  {
+    PCL_ERROR ("[pcl::ConditionalEuclideanClustering::segment] The search method rejected the input cloud.\n");
+    deinitCompute ();
+    return;
+  }
   // If searcher_ gives sorted results, we can skip the first one because it is the query point itself
   const int nn_start_idx = searcher_->getSortedResults () ? 1 : 0;
 
@@ -39,6 +39,7 @@
 #define PCL_SEGMENTATION_IMPL_EXTRACT_CLUSTERS_H_
 
 #include <pcl/segmentation/extract_clusters.h>
+#include <pcl/segmentation/concurrent_union_find.h>
 #include <pcl/search/organized.h> // for OrganizedNeighbor
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,7 +128,8 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
                                const typename search::Search<PointT>::Ptr &tree,
                                float tolerance, std::vector<PointIndices> &clusters,
                                unsigned int min_pts_per_cluster,
-                               unsigned int max_pts_per_cluster)
+                               unsigned int max_pts_per_cluster,
+                               unsigned int num_threads)
 {
   // \note If the tree was created over <cloud, indices>, we guarantee a 1-1 mapping between what the tree returns
   //and indices[i]
@@ -145,6 +147,80 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
               indices.size());
     return;
   }
+  if (num_threads > 1)
+  {
+    // Search the neighbors of all points concurrently, and merge each point with its neighbors
+    ConcurrentUnionFind components (cloud.size ());
+    auto nr_indices = static_cast<std::ptrdiff_t> (indices.size ());
+    int nr_failed_searches = 0;
+#pragma omp parallel \
+  default(none) \
+  shared(cloud, indices, tree, tolerance, components, nr_indices) \
+  reduction(+:nr_failed_searches) \
+  num_threads(num_threads)
+    {
+      Indices nn_indices;
+      std::vector<float> nn_distances;
+#pragma omp for schedule(dynamic, 256)
+      for (std::ptrdiff_t i = 0; i < nr_indices; ++i)
+      {
+        if (tree->radiusSearch (cloud[indices[i]], tolerance, nn_indices, nn_distances) == -1)
+        {
+          ++nr_failed_searches;
+          continue;
+        }
+        for (const auto &nn_index : nn_indices)
+        {
+          if (nn_index != UNAVAILABLE)
+            components.merge (indices[i], nn_index);
+        }
+      }
+    }
+    if (nr_failed_searches > 0)
+    {
+      PCL_ERROR("[pcl::extractEuclideanClusters] Received error code -1 from radiusSearch\n");
+      return;
+    }
+
+    // Number the clusters in the order in which the serial flood fill finds their first point
+    std::vector<bool> processed (cloud.size (), false);
+    std::vector<int> cluster_of_root (cloud.size (), -1);
+    std::vector<Indices> components_indices;
+    for (const auto &index : indices)
+    {
+      if (processed[index])
+        continue;
+      processed[index] = true;
+
+      const index_t root = components.find (index);
+      if (cluster_of_root[root] == -1)
+      {
+        cluster_of_root[root] = static_cast<int> (components_indices.size ());
+        components_indices.emplace_back ();
+      }
+      components_indices[cluster_of_root[root]].push_back (index);
+    }
+
+    for (auto &component : components_indices)
+    {
+      // If this cluster is satisfactory, add to the clusters
+      if (component.size () >= min_pts_per_cluster && component.size () <= max_pts_per_cluster)
+      {
+        pcl::PointIndices r;
+        r.indices = std::move (component);
+        std::sort (r.indices.begin (), r.indices.end ());
+        r.header = cloud.header;
+        clusters.push_back (std::move (r));
+      }
+      else
+      {
+        PCL_DEBUG("[pcl::extractEuclideanClusters] This cluster has %zu points, which is not between %u and %u points, so it is not a final cluster\n",
+                  component.size (), min_pts_per_cluster, max_pts_per_cluster);
+      }
+    }
+    return;
+  }
+
   // Check if the tree is sorted -- if it is we don't need to check the first element
   int nn_start_idx = tree->getSortedResults () ? 1 : 0;
 
@@ -220,6 +296,23 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+template <typename PointT> void
+pcl::EuclideanClusterExtraction<PointT>::setNumberOfThreads (unsigned int nr_threads)
+{
+#ifdef _OPENMP
+  if (nr_threads == 0)
+    num_threads_ = omp_get_num_procs ();
+  else
+    num_threads_ = nr_threads;
+  PCL_DEBUG ("[pcl::EuclideanClusterExtraction::setNumberOfThreads] Setting number of threads to %u.\n", num_threads_);
+#else
+  num_threads_ = 1;
+  if (nr_threads != 1)
+    PCL_WARN ("[pcl::EuclideanClusterExtraction::setNumberOfThreads] Parallelization is requested, but OpenMP is not available! Continuing without parallelization.\n");
+#endif // _OPENMP
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void 
 pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clusters)
 {
@@ -241,8 +334,14 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
   }
 
   // Send the input dataset to the spatial locator
-  tree_->setInputCloud (input_, indices_);
-  extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_);
+  if (!tree_->setInputCloud (input_, indices_))
+  {
+    PCL_ERROR ("[pcl::%s::extract] The search method rejected the input cloud.\n", getClassName ().c_str ());
+    clusters.clear ();
+    deinitCompute ();
+    return;
+  }
+  extractEuclideanClusters (*input_, *indices_, tree_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_, num_threads_);
 
   //tree_->setInputCloud (input_);
   //extractEuclideanClusters (*input_, tree_, cluster_tolerance_, clusters, min_pts_per_cluster_, max_pts_per_cluster_);
@@ -255,6 +354,6 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
 
 #define PCL_INSTANTIATE_EuclideanClusterExtraction(T) template class PCL_EXPORTS pcl::EuclideanClusterExtraction<T>;
 #define PCL_INSTANTIATE_extractEuclideanClusters(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const typename pcl::search::Search<T>::Ptr &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int);
-#define PCL_INSTANTIATE_extractEuclideanClusters_indices(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const pcl::Indices &, const typename pcl::search::Search<T>::Ptr &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int);
+#define PCL_INSTANTIATE_extractEuclideanClusters_indices(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const pcl::Indices &, const typename pcl::search::Search<T>::Ptr &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int, unsigned int);
 
 #endif        // PCL_EXTRACT_CLUSTERS_IMPL_H_
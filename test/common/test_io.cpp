@@ -39,6 +39,7 @@
 #include <pcl/pcl_tests.h>
 #include <pcl/point_types.h>
 #include <pcl/common/io.h>
+#include <pcl/point_cloud_converter.h>
 
 using namespace pcl;
 
@@ -372,6 +373,91 @@ TEST(PCL, fromPCLPointCloud2CastingSHOT352)
   }
 }
 
+TEST (PCL, PointCloudConverter)
+{
+  pcl::PointCloud<pcl::PointXYZRGBNormal> cloud;
+  cloud.resize (static_cast<pcl::uindex_t> (5000), static_cast<pcl::uindex_t> (3));
+  for (std::size_t i = 0; i < cloud.size (); ++i)
+  {
+    cloud[i].x = 0.1f * i; cloud[i].y = -0.2f * i; cloud[i].z = 0.3f * i;
+    cloud[i].normal_x = 1.0f; cloud[i].normal_y = 0.5f * i; cloud[i].normal_z = -1.0f;
+    cloud[i].curvature = 0.01f * i;
+    cloud[i].rgba = static_cast<std::uint32_t> (i);
+  }
+
+  pcl::PointCloudConverter<pcl::PointXYZRGBNormal> converter;
+  converter.setNumberOfThreads (4);
+  for (const bool padding : {true, false})
+  {
+    pcl::PCLPointCloud2 msg, expected_msg;
+    pcl::toPCLPointCloud2 (cloud, expected_msg, padding);
+    converter.toPCLPointCloud2 (cloud, msg, padding);
+    EXPECT_EQ (msg.width, expected_msg.width);
+    EXPECT_EQ (msg.height, expected_msg.height);
+    EXPECT_EQ (msg.point_step, expected_msg.point_step);
+    EXPECT_EQ (msg.row_step, expected_msg.row_step);
+    ASSERT_EQ (msg.fields.size (), expected_msg.fields.size ());
+    for (std::size_t f = 0; f < msg.fields.size (); ++f)
+    {
+      EXPECT_EQ (msg.fields[f].name, expected_msg.fields[f].name);
+      EXPECT_EQ (msg.fields[f].offset, expected_msg.fields[f].offset);
+    }
+    // With padding, the padding bytes are not initialized
+    if (!padding)
+    {
+      EXPECT_TRUE (msg.data == expected_msg.data);
+    }
+
+    // Convert twice with the same converter, the second time with the cached plan
+    for (int repeat = 0; repeat < 2; ++repeat)
+    {
+      pcl::PointCloud<pcl::PointXYZRGBNormal> cloud2;
+      converter.fromPCLPointCloud2 (msg, cloud2);
+      EXPECT_EQ (cloud2.width, cloud.width);
+      EXPECT_EQ (cloud2.height, cloud.height);
+      ASSERT_EQ (cloud2.size (), cloud.size ());
+      for (std::size_t i = 0; i < cloud.size (); ++i)
+      {
+        EXPECT_EQ (cloud2[i].x, cloud[i].x);
+        EXPECT_EQ (cloud2[i].z, cloud[i].z);
+        EXPECT_EQ (cloud2[i].normal_y, cloud[i].normal_y);
+        EXPECT_EQ (cloud2[i].curvature, cloud[i].curvature);
+        EXPECT_EQ (cloud2[i].rgba, cloud[i].rgba);
+      }
+    }
+  }
+
+  // A message with a different layout (and datatypes) is converted with a new plan
+  pcl::PCLPointCloud2 msg;
+  msg.height = 2;
+  msg.width = 2;
+  msg.fields.resize (2);
+  msg.fields[0].name = "z";
+  msg.fields[0].offset = 0;
+  msg.fields[0].datatype = pcl::PCLPointField::FLOAT64;
+  msg.fields[0].count = 1;
+  msg.fields[1].name = "x";
+  msg.fields[1].offset = 8;
+  msg.fields[1].datatype = pcl::PCLPointField::FLOAT32;
+  msg.fields[1].count = 1;
+  msg.point_step = 12;
+  msg.row_step = 12 * msg.width;
+  msg.data.resize (12 * msg.width * msg.height);
+  for (std::size_t i = 0; i < msg.width * msg.height; ++i)
+  {
+    msg.at<double> (i, 0) = -3.5 * i;
+    msg.at<float> (i, 8) = 2.0f * i;
+  }
+  pcl::PointCloud<pcl::PointXYZRGBNormal> cloud3;
+  converter.fromPCLPointCloud2 (msg, cloud3);
+  ASSERT_EQ (cloud3.size (), 4);
+  for (std::size_t i = 0; i < cloud3.size (); ++i)
+  {
+    EXPECT_EQ (cloud3[i].x, 2.0f * i);
+    EXPECT_EQ (cloud3[i].z, -3.5f * i);
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
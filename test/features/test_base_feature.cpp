@@ -40,6 +40,8 @@
 #include <pcl/test/gtest.h>
 #include <pcl/point_cloud.h>
 #include <pcl/features/feature.h>
+#include <pcl/features/neighborhood_graph.h>
+#include <pcl/features/normal_3d.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/common/centroid.h>
 
@@ -155,6 +157,121 @@ TEST (PCL, BaseFeature)
   EXPECT_NEAR (curvature, 0.0693136, 1e-4);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Counts the radius searches that reach the tree
+class CountingKdTree : public search::KdTree<PointXYZ>
+{
+  public:
+    CountingKdTree () : search::KdTree<PointXYZ> (false) {}
+
+    using search::KdTree<PointXYZ>::radiusSearch;
+
+    int
+    radiusSearch (const PointXYZ &point, double radius, pcl::Indices &k_indices,
+                  std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const override
+    {
+      ++nr_searches;
+      return (search::KdTree<PointXYZ>::radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn));
+    }
+
+    mutable std::size_t nr_searches = 0;
+};
+
+TEST (PCL, NeighborhoodGraph)
+{
+  const double radius = 0.01;
+  PointCloud<PointXYZ>::ConstPtr cloudptr = tree->getInputCloud ();
+
+  NeighborhoodGraph<PointXYZ>::Ptr graph (new NeighborhoodGraph<PointXYZ> (4));
+  ASSERT_TRUE (graph->computeRadiusNeighborhoods (cloudptr, tree, radius));
+  EXPECT_EQ (graph->size (), cloudptr->size ());
+  EXPECT_EQ (graph->getInputCloud (), cloudptr);
+  EXPECT_EQ (graph->getSearchSurface (), cloudptr);
+  EXPECT_TRUE (graph->isRadiusSearch ());
+
+  pcl::Indices nn_indices;
+  std::vector<float> nn_dists;
+  std::size_t nr_edges = 0;
+  for (std::size_t i = 0; i < cloudptr->size (); ++i)
+  {
+    const int nr_neighbors = tree->radiusSearch ((*cloudptr)[i], radius, nn_indices, nn_dists);
+    const auto neighbors = graph->getNeighbors (i);
+    ASSERT_EQ (neighbors.size, static_cast<std::size_t> (nr_neighbors));
+    EXPECT_EQ (graph->getNumberOfNeighbors (i), static_cast<std::size_t> (nr_neighbors));
+    EXPECT_EQ (pcl::Indices (neighbors.indices, neighbors.indices + neighbors.size), nn_indices);
+    EXPECT_EQ (std::vector<float> (neighbors.sqr_distances, neighbors.sqr_distances + neighbors.size), nn_dists);
+    nr_edges += nr_neighbors;
+  }
+  EXPECT_EQ (graph->getNumberOfEdges (), nr_edges);
+
+  // A feature estimator reads the neighborhoods from the graph instead of searching the tree
+  shared_ptr<CountingKdTree> counting_tree (new CountingKdTree);
+  counting_tree->setInputCloud (cloudptr);
+  NormalEstimation<PointXYZ, Normal> ne;
+  ne.setInputCloud (cloudptr);
+  ne.setSearchMethod (counting_tree);
+  ne.setRadiusSearch (radius);
+  PointCloud<Normal> normals, graph_normals;
+  ne.compute (normals);
+  EXPECT_EQ (counting_tree->nr_searches, cloudptr->size ());
+
+  counting_tree->nr_searches = 0;
+  ne.setNeighborhoodGraph (graph);
+  EXPECT_EQ (ne.getNeighborhoodGraph (), graph);
+  ne.compute (graph_normals);
+  EXPECT_EQ (counting_tree->nr_searches, 0);
+  ASSERT_EQ (graph_normals.size (), normals.size ());
+  for (std::size_t i = 0; i < normals.size (); ++i)
+  {
+    if (!std::isfinite (normals[i].normal_x))
+    {
+      EXPECT_FALSE (std::isfinite (graph_normals[i].normal_x));
+      continue;
+    }
+    EXPECT_EQ (graph_normals[i].normal_x, normals[i].normal_x);
+    EXPECT_EQ (graph_normals[i].normal_y, normals[i].normal_y);
+    EXPECT_EQ (graph_normals[i].normal_z, normals[i].normal_z);
+    EXPECT_EQ (graph_normals[i].curvature, normals[i].curvature);
+  }
+
+  // A graph computed with another search parameter is ignored
+  ne.setRadiusSearch (2 * radius);
+  ne.compute (graph_normals);
+  EXPECT_EQ (counting_tree->nr_searches, cloudptr->size ());
+}
+
+TEST (PCL, NeighborhoodGraphNonFinite)
+{
+  // Non-finite points get empty neighborhoods, the others the k nearest neighbors
+  PointCloud<PointXYZ>::Ptr sparse (new PointCloud<PointXYZ> (cloud));
+  for (std::size_t i = 0; i < sparse->size (); i += 7)
+    (*sparse)[i].x = std::numeric_limits<float>::quiet_NaN ();
+  sparse->is_dense = false;
+  search::KdTree<PointXYZ>::Ptr sparse_tree (new search::KdTree<PointXYZ> (false));
+  sparse_tree->setInputCloud (sparse);
+
+  NeighborhoodGraph<PointXYZ> graph (2);
+  ASSERT_TRUE (graph.computeKNeighborhoods (sparse, sparse_tree, 10));
+  ASSERT_EQ (graph.size (), sparse->size ());
+  EXPECT_FALSE (graph.isRadiusSearch ());
+  EXPECT_EQ (sparse_tree->getNumberOfThreads (), 1u);
+
+  pcl::Indices nn_indices;
+  std::vector<float> nn_dists;
+  for (std::size_t i = 0; i < sparse->size (); ++i)
+  {
+    const auto neighbors = graph.getNeighbors (i);
+    if (i % 7 == 0)
+    {
+      EXPECT_EQ (neighbors.size, 0u);
+      continue;
+    }
+    sparse_tree->nearestKSearch ((*sparse)[i], 10, nn_indices, nn_dists);
+    ASSERT_EQ (neighbors.size, nn_indices.size ());
+    EXPECT_EQ (pcl::Indices (neighbors.indices, neighbors.indices + neighbors.size), nn_indices);
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
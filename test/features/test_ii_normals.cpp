@@ -489,6 +489,135 @@ TEST (PCL, IINormalEstimationSimple3DGradient)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The normal of a pixel computed by computePointNormal or computePointNormalMirror, with the rectangle and the
+// border handling of compute. computeFeaturePart also keeps the last row and column before the ignored border.
+Normal
+referenceNormal (IntegralImageNormalEstimation<PointXYZ, Normal> &estimation, const PointCloud<PointXYZ> &surface,
+                 float smoothing_size, bool depth_dependent_smoothing, bool mirror, bool part, unsigned u, unsigned v)
+{
+  Normal normal;
+  normal.getNormalVector3fMap ().setConstant (std::numeric_limits<float>::quiet_NaN ());
+  normal.curvature = std::numeric_limits<float>::quiet_NaN ();
+
+  const auto border = static_cast<unsigned> (smoothing_size);
+  const unsigned last = part ? 1 : 0;
+  if (!mirror && (u < border || v < border || u + border >= surface.width + last || v + border >= surface.height + last))
+    return (normal);
+
+  const unsigned index = v * surface.width + u;
+  const float depth = surface[index].z;
+  if (!std::isfinite (depth))
+    return (normal);
+  float smoothing = smoothing_size + (depth_dependent_smoothing ? depth / 10.0f : 0.0f);
+  smoothing = std::min (estimation.getDistanceMap ()[index], smoothing);
+  if (smoothing <= 2.0f)
+    return (normal);
+  const int rect_size = static_cast<int> (smoothing);
+  estimation.setRectSize (rect_size, rect_size);
+
+  if (mirror)
+  {
+    estimation.computePointNormalMirror (u, v, index, normal);
+    return (normal);
+  }
+  const unsigned rect_size_2 = rect_size / 2;
+  if (u <= rect_size_2 || v <= rect_size_2 || u + rect_size_2 >= surface.width || v + rect_size_2 >= surface.height)
+    return (normal);
+  estimation.computePointNormal (u, v, index, normal);
+  return (normal);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IINormalEstimationMultithreaded)
+{
+  // A curved surface with a few holes, so that the multithreaded results are not trivially equal
+  PointCloud<PointXYZ>::Ptr surface (new PointCloud<PointXYZ> (160, 120));
+  for (std::size_t v = 0; v < surface->height; ++v)
+  {
+    for (std::size_t u = 0; u < surface->width; ++u)
+    {
+      PointXYZ &point = (*surface) (u, v);
+      point.x = static_cast<float> (u) * 0.01f;
+      point.y = static_cast<float> (v) * 0.01f;
+      point.z = 2.0f + 0.1f * std::sin (point.x * 5.0f) * std::cos (point.y * 3.0f);
+      if ((u * 7 + v * 13) % 97 == 0)
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+    }
+  }
+  surface->is_dense = false;
+
+  // Every third pixel, so that computeFeaturePart is used
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (std::size_t i = 0; i < surface->size (); i += 3)
+    indices->push_back (static_cast<index_t> (i));
+
+  const float smoothing_size = 5.0f;
+  for (const auto method : {ne.COVARIANCE_MATRIX, ne.AVERAGE_3D_GRADIENT, ne.AVERAGE_DEPTH_CHANGE})
+  {
+    for (const bool depth_dependent_smoothing : {false, true})
+    {
+      for (const auto border_policy : {ne.BORDER_POLICY_IGNORE, ne.BORDER_POLICY_MIRROR})
+      {
+        for (const bool use_indices : {false, true})
+        {
+          PointCloud<Normal> output, output_mt;
+          IntegralImageNormalEstimation<PointXYZ, Normal> ne_st, ne_mt;
+          for (auto *estimation : {&ne_st, &ne_mt})
+          {
+            if (estimation == &ne_mt)
+              estimation->setNumberOfThreads (4);
+            estimation->setNormalEstimationMethod (method);
+            estimation->setNormalSmoothingSize (smoothing_size);
+            estimation->setDepthDependentSmoothing (depth_dependent_smoothing);
+            estimation->setBorderPolicy (border_policy);
+            estimation->setInputCloud (surface);
+            if (use_indices)
+              estimation->setIndices (indices);
+          }
+          ne_st.compute (output);
+          ne_mt.compute (output_mt);
+
+          ASSERT_EQ (output.size (), output_mt.size ());
+          ASSERT_EQ (output.size (), use_indices ? indices->size () : surface->size ());
+          for (std::size_t i = 0; i < output.size (); ++i)
+          {
+            // The same result with one and with several threads
+            ASSERT_EQ (std::isfinite (output[i].normal_x), std::isfinite (output_mt[i].normal_x));
+            if (std::isfinite (output[i].normal_x))
+            {
+              EXPECT_NEAR (output[i].normal_x, output_mt[i].normal_x, 1e-4);
+              EXPECT_NEAR (output[i].normal_y, output_mt[i].normal_y, 1e-4);
+              EXPECT_NEAR (output[i].normal_z, output_mt[i].normal_z, 1e-4);
+              if (std::isfinite (output[i].curvature))
+              {
+                EXPECT_NEAR (output[i].curvature, output_mt[i].curvature, 1e-4);
+              }
+            }
+
+            // The same result as the normal of the single pixel
+            const std::size_t index = use_indices ? (*indices)[i] : i;
+            const Normal expected = referenceNormal (ne_st, *surface, smoothing_size, depth_dependent_smoothing,
+                                                     border_policy == ne.BORDER_POLICY_MIRROR, use_indices,
+                                                     index % surface->width, index / surface->width);
+            ASSERT_EQ (std::isfinite (expected.normal_x), std::isfinite (output_mt[i].normal_x)) << "at pixel " << index;
+            if (!std::isfinite (expected.normal_x))
+              continue;
+            EXPECT_NEAR (expected.normal_x, output_mt[i].normal_x, 1e-4);
+            EXPECT_NEAR (expected.normal_y, output_mt[i].normal_y, 1e-4);
+            EXPECT_NEAR (expected.normal_z, output_mt[i].normal_z, 1e-4);
+            ASSERT_EQ (std::isfinite (expected.curvature), std::isfinite (output_mt[i].curvature));
+            if (std::isfinite (expected.curvature))
+            {
+              EXPECT_NEAR (expected.curvature, output_mt[i].curvature, 1e-4);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IINormalEstimationSimple3DGradientUnorganized)
 {
@@ -402,6 +402,67 @@ TEST (PCL, NormalEstimationOpenMP)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The normals are solved in batches of neighborhoods. Compare them with the per point solution, including
+// invalid points and neighborhoods whose smallest eigenvalues coincide.
+TEST (PCL, NormalEstimationBatch)
+{
+  PointCloud<PointXYZ>::Ptr cloudptr (new PointCloud<PointXYZ> (cloud));
+  for (std::size_t i = 0; i < cloudptr->size (); i += 37)
+    (*cloudptr)[i].x = std::numeric_limits<float>::quiet_NaN ();
+  // A line of points far from the rest of the cloud
+  for (int i = 0; i < 10; ++i)
+    cloudptr->push_back (PointXYZ (10.0f + 0.01f * static_cast<float> (i), 10.0f, 10.0f));
+  cloudptr->is_dense = false;
+
+  const int k = 10;
+  search::KdTree<PointXYZ>::Ptr kdtree (new search::KdTree<PointXYZ> (false));
+  kdtree->setInputCloud (cloudptr);
+
+  NormalEstimation<PointXYZ, Normal> n;
+  n.setInputCloud (cloudptr);
+  n.setSearchMethod (kdtree);
+  n.setKSearch (k);
+  PointCloud<Normal> normals;
+  n.compute (normals);
+
+  NormalEstimationOMP<PointXYZ, Normal> n_omp (4);
+  n_omp.setInputCloud (cloudptr);
+  n_omp.setSearchMethod (kdtree);
+  n_omp.setKSearch (k);
+  PointCloud<Normal> normals_omp;
+  n_omp.compute (normals_omp);
+
+  ASSERT_EQ (normals.size (), cloudptr->size ());
+  ASSERT_EQ (normals_omp.size (), cloudptr->size ());
+  EXPECT_FALSE (normals.is_dense);
+  EXPECT_FALSE (normals_omp.is_dense);
+
+  pcl::Indices nn_indices;
+  std::vector<float> nn_dists;
+  for (std::size_t i = 0; i < cloudptr->size (); ++i)
+  {
+    if (!isFinite ((*cloudptr)[i]))
+    {
+      EXPECT_FALSE (std::isfinite (normals[i].normal_x));
+      EXPECT_FALSE (std::isfinite (normals_omp[i].normal_x));
+      continue;
+    }
+    kdtree->nearestKSearch ((*cloudptr)[i], k, nn_indices, nn_dists);
+    Eigen::Vector4f plane_parameters;
+    float curvature;
+    ASSERT_TRUE (computePointNormal (*cloudptr, nn_indices, plane_parameters, curvature));
+    flipNormalTowardsViewpoint ((*cloudptr)[i], 0.0f, 0.0f, 0.0f, plane_parameters);
+    for (const auto &normal : {normals[i], normals_omp[i]})
+    {
+      EXPECT_NEAR (normal.normal_x, plane_parameters[0], 1e-4);
+      EXPECT_NEAR (normal.normal_y, plane_parameters[1], 1e-4);
+      EXPECT_NEAR (normal.normal_z, plane_parameters[2], 1e-4);
+      EXPECT_NEAR (normal.curvature, curvature, 1e-4);
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // This tests the indexing issue from #3573
 // In certain cases when you used a subset of the indices
@@ -249,6 +249,18 @@ TEST (PCL, PFHEstimation)
   //Eigen::Map<Eigen::VectorXf> h (&((*pfhs)[0].histogram[0]), 125);
   //std::cerr << h.head<27> () << std::endl;
 
+  // Multithreaded estimation (without the internal cache) should give the same results
+  pfh.setKSearch (10);
+  pfh.compute (*pfhs);
+  PointCloud<PFHSignature125> pfhs_mt;
+  pfh.setUseInternalCache (false);
+  pfh.setNumberOfThreads (4);
+  pfh.compute (pfhs_mt);
+  ASSERT_EQ (pfhs_mt.size (), pfhs->size ());
+  for (std::size_t i = 0; i < pfhs->size (); ++i)
+    for (int j = 0; j < 125; ++j)
+      EXPECT_FLOAT_EQ ((*pfhs)[i].histogram[j], pfhs_mt[i].histogram[j]);
+
   // Test results when setIndices and/or setSearchSurface are used
 
   pcl::IndicesPtr test_indices (new pcl::Indices (0));
@@ -444,6 +456,119 @@ TYPED_TEST (FPFHTest, Estimation)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, FPFHEstimationOMPRadius)
+{
+  // The OpenMP variant bins its pair features in batches and reuses the neighborhoods of the query points, so
+  // compare it against the reference implementation on a radius search with a subset of the points
+  pcl::IndicesPtr test_indices (new pcl::Indices);
+  for (std::size_t i = 0; i < cloud->size (); i += 3)
+    test_indices->push_back (static_cast<int> (i));
+
+  for (const bool use_indices : {false, true})
+  {
+    FPFHEstimation<PointT, PointT, FPFHSignature33> fpfh;
+    FPFHEstimationOMP<PointT, PointT, FPFHSignature33> fpfh_omp (4);
+    const auto setup = [&] (FPFHEstimation<PointT, PointT, FPFHSignature33> &est)
+    {
+      est.setInputCloud (cloud);
+      est.setInputNormals (cloud);
+      est.setSearchMethod (tree);
+      est.setRadiusSearch (0.02);
+      if (use_indices)
+        est.setIndices (test_indices);
+    };
+    setup (fpfh);
+    setup (fpfh_omp);
+
+    PointCloud<FPFHSignature33> fpfhs, fpfhs_omp;
+    fpfh.compute (fpfhs);
+    fpfh_omp.compute (fpfhs_omp);
+
+    ASSERT_EQ (fpfhs.size (), fpfhs_omp.size ());
+    for (std::size_t i = 0; i < fpfhs.size (); ++i)
+      for (int d = 0; d < 33; ++d)
+      {
+        if (!std::isfinite (fpfhs[i].histogram[d]))
+          EXPECT_FALSE (std::isfinite (fpfhs_omp[i].histogram[d]));
+        else
+          EXPECT_NEAR (fpfhs[i].histogram[d], fpfhs_omp[i].histogram[d], 1e-3);
+      }
+  }
+
+  // A separate search surface with an isolated point, whose only neighbor is itself. The query point next to
+  // it is not part of the surface.
+  PointCloud<PointT>::Ptr surface (new PointCloud<PointT>);
+  PointCloud<PointT>::Ptr queries (new PointCloud<PointT>);
+  for (std::size_t i = 0; i < cloud->size (); ++i)
+    (i % 2 == 0 ? surface : queries)->push_back ((*cloud)[i]);
+  PointT isolated = (*cloud)[0];
+  isolated.x += 1.0f;
+  surface->push_back (isolated);
+  isolated.x += 0.01f;
+  queries->push_back (isolated);
+
+  FPFHEstimation<PointT, PointT, FPFHSignature33> fpfh;
+  FPFHEstimationOMP<PointT, PointT, FPFHSignature33> fpfh_omp (4);
+  const auto setup = [&] (FPFHEstimation<PointT, PointT, FPFHSignature33> &est)
+  {
+    est.setInputCloud (queries);
+    est.setSearchSurface (surface);
+    est.setInputNormals (surface);
+    est.setSearchMethod (KdTreePtr (new pcl::search::KdTree<PointT> (false)));
+    est.setRadiusSearch (0.02);
+  };
+  setup (fpfh);
+  setup (fpfh_omp);
+
+  PointCloud<FPFHSignature33> fpfhs, fpfhs_omp;
+  fpfh.compute (fpfhs);
+  fpfh_omp.compute (fpfhs_omp);
+
+  ASSERT_EQ (fpfhs.size (), fpfhs_omp.size ());
+  for (std::size_t i = 0; i < fpfhs.size (); ++i)
+    for (int d = 0; d < 33; ++d)
+    {
+      if (!std::isfinite (fpfhs[i].histogram[d]))
+        EXPECT_FALSE (std::isfinite (fpfhs_omp[i].histogram[d]));
+      else
+        EXPECT_NEAR (fpfhs[i].histogram[d], fpfhs_omp[i].histogram[d], 1e-3);
+    }
+  for (int d = 0; d < 33; ++d)
+    EXPECT_EQ (fpfhs_omp.back ().histogram[d], 0.0f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, FPFHEstimationOMPDuplicatePoints)
+{
+  // Pairs of coincident points have no pair features and are counted with all features set to 0 by both
+  // implementations
+  PointCloud<PointT>::Ptr duplicated (new PointCloud<PointT> (*cloud));
+  for (std::size_t i = 0; i < cloud->size (); i += 2)
+    duplicated->push_back ((*cloud)[i]);
+
+  FPFHEstimation<PointT, PointT, FPFHSignature33> fpfh;
+  FPFHEstimationOMP<PointT, PointT, FPFHSignature33> fpfh_omp (4);
+  const auto setup = [&] (FPFHEstimation<PointT, PointT, FPFHSignature33> &est)
+  {
+    est.setInputCloud (duplicated);
+    est.setInputNormals (duplicated);
+    est.setSearchMethod (KdTreePtr (new pcl::search::KdTree<PointT> (false)));
+    est.setKSearch (30);
+  };
+  setup (fpfh);
+  setup (fpfh_omp);
+
+  PointCloud<FPFHSignature33> fpfhs, fpfhs_omp;
+  fpfh.compute (fpfhs);
+  fpfh_omp.compute (fpfhs_omp);
+
+  ASSERT_EQ (fpfhs.size (), fpfhs_omp.size ());
+  for (std::size_t i = 0; i < fpfhs.size (); ++i)
+    for (int d = 0; d < 33; ++d)
+      EXPECT_NEAR (fpfhs[i].histogram[d], fpfhs_omp[i].histogram[d], 1e-3);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, VFHEstimation)
 {
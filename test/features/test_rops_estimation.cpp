@@ -71,6 +71,15 @@ TEST (ROPSFeature, FeatureExtraction)
   feature_estimator.compute (*histograms);
 
   EXPECT_NE (0, histograms->size ());
+
+  // multithreaded estimation should give the same results
+  pcl::PointCloud<pcl::Histogram <135> > histograms_mt;
+  feature_estimator.setNumberOfThreads (4);
+  feature_estimator.compute (histograms_mt);
+  ASSERT_EQ (histograms_mt.size (), histograms->size ());
+  for (std::size_t i = 0; i < histograms->size (); ++i)
+    for (int j = 0; j < 135; ++j)
+      EXPECT_FLOAT_EQ ((*histograms)[i].histogram[j], histograms_mt[i].histogram[j]);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,256 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/test/gtest.h>
+#include <pcl/point_cloud.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/features/fpfh.h>
+#include <pcl/filters/radius_outlier_removal.h>
+#include <pcl/search/brute_force.h>
+#include <pcl/io/pcd_io.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace pcl;
+using namespace pcl::io;
+
+// NormalEstimation, FPFHEstimation and RadiusOutlierRemoval search through the buffers of a
+// SearchContext, so their number of allocations must not grow with the number of points they
+// process. Each class runs once on the indices of every other point and once on these indices
+// four times over, on search::BruteForce, which allocates only through the buffers of its caller.
+// search::KdTree is not checked: flann allocates its result sets inside every search, which is
+// beyond the reach of PCL.
+// Only allocations through the global operator new are counted, Eigen's dynamic matrices go to
+// malloc directly.
+
+PointCloud<PointXYZ>::Ptr cloud;
+PointCloud<Normal>::Ptr normals;
+IndicesPtr indices, repeated_indices;
+
+// The replacements below pair malloc with free, GCC does not see that through inlining
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+std::atomic<bool> count_allocations {false};
+std::atomic<std::size_t> nr_allocations {0};
+
+void*
+operator new (std::size_t size)
+{
+  if (count_allocations)
+    ++nr_allocations;
+  if (void* ptr = std::malloc (size == 0 ? 1 : size))
+    return (ptr);
+  throw std::bad_alloc ();
+}
+
+void*
+operator new[] (std::size_t size)
+{
+  return (operator new (size));
+}
+
+void
+operator delete (void* ptr) noexcept
+{
+  std::free (ptr);
+}
+
+void
+operator delete[] (void* ptr) noexcept
+{
+  operator delete (ptr);
+}
+
+void
+operator delete (void* ptr, std::size_t) noexcept
+{
+  operator delete (ptr);
+}
+
+void
+operator delete[] (void* ptr, std::size_t) noexcept
+{
+  operator delete[] (ptr);
+}
+
+/** \brief Run the computation once to warm up, then return the number of allocations of a second run. */
+template <typename Computation> std::size_t
+countAllocations (const Computation& computation)
+{
+  computation ();
+  nr_allocations = 0;
+  count_allocations = true;
+  computation ();
+  count_allocations = false;
+  return (nr_allocations);
+}
+
+/** \brief Check that running an estimator or filter on \a repeated_indices does not allocate more
+  * than running it on \a indices.
+  */
+template <typename Estimator, typename Output> void
+checkAllocations (Estimator& estimator, Output& output)
+{
+  estimator.setIndices (indices);
+  const std::size_t nr_allocations_once = countAllocations ([&] () { estimator.compute (output); });
+  estimator.setIndices (repeated_indices);
+  const std::size_t nr_allocations_repeated = countAllocations ([&] () { estimator.compute (output); });
+  EXPECT_EQ (nr_allocations_once, nr_allocations_repeated);
+}
+
+/** \brief Let a filter be run by checkAllocations. */
+template <typename Filter>
+struct FilterRunner
+{
+  Filter& filter;
+
+  void
+  setIndices (const IndicesPtr& filter_indices) { filter.setIndices (filter_indices); }
+
+  void
+  compute (Indices& output) { filter.filter (output); }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalEstimationAllocations)
+{
+  for (const bool sorted : {true, false})
+  {
+    search::BruteForce<PointXYZ>::Ptr tree (new search::BruteForce<PointXYZ> (sorted));
+    PointCloud<Normal> output;
+
+    NormalEstimation<PointXYZ, Normal> n;
+    n.setInputCloud (cloud);
+    n.setSearchMethod (tree);
+    n.setRadiusSearch (0.02);
+    checkAllocations (n, output);
+
+    n.setRadiusSearch (0);
+    n.setKSearch (10);
+    checkAllocations (n, output);
+
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, FPFHEstimationAllocations)
+{
+  for (const bool sorted : {true, false})
+  {
+    search::BruteForce<PointXYZ>::Ptr tree (new search::BruteForce<PointXYZ> (sorted));
+    PointCloud<FPFHSignature33> output;
+
+    FPFHEstimation<PointXYZ, Normal, FPFHSignature33> fpfh;
+    fpfh.setInputCloud (cloud);
+    fpfh.setInputNormals (normals);
+    fpfh.setSearchMethod (tree);
+    fpfh.setRadiusSearch (0.02);
+    checkAllocations (fpfh, output);
+
+    fpfh.setRadiusSearch (0);
+    fpfh.setKSearch (10);
+    checkAllocations (fpfh, output);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, RadiusOutlierRemovalAllocations)
+{
+  // A dense cloud is filtered with nearest-k searches, any other one with radius searches
+  PointCloud<PointXYZ>::Ptr not_dense (new PointCloud<PointXYZ> (*cloud));
+  not_dense->is_dense = false;
+
+  for (const bool sorted : {true, false})
+  {
+    for (const auto& input : {cloud, not_dense})
+    {
+      search::BruteForce<PointXYZ>::Ptr tree (new search::BruteForce<PointXYZ> (sorted));
+      Indices output;
+
+      RadiusOutlierRemoval<PointXYZ> ror;
+      ror.setInputCloud (input);
+      ror.setSearchMethod (tree);
+      ror.setRadiusSearch (0.01);
+      ror.setMinNeighborsInRadius (5);
+      FilterRunner<RadiusOutlierRemoval<PointXYZ> > runner {ror};
+      checkAllocations (runner, output);
+      EXPECT_FALSE (output.empty ());
+    }
+  }
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "No test file given. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  cloud.reset (new PointCloud<PointXYZ>);
+  if (loadPCDFile<PointXYZ> (argv[1], *cloud) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  // Not all points, FPFHEstimation skips a search pass for those
+  indices.reset (new Indices);
+  for (std::size_t i = 0; i < cloud->size (); i += 2)
+    indices->push_back (static_cast<index_t> (i));
+  repeated_indices.reset (new Indices);
+  for (int repetition = 0; repetition < 4; ++repetition)
+    repeated_indices->insert (repeated_indices->end (), indices->cbegin (), indices->cend ());
+
+  search::BruteForce<PointXYZ>::Ptr tree (new search::BruteForce<PointXYZ>);
+  NormalEstimation<PointXYZ, Normal> n;
+  n.setInputCloud (cloud);
+  n.setSearchMethod (tree);
+  n.setRadiusSearch (0.02);
+  normals.reset (new PointCloud<Normal>);
+  n.compute (*normals);
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
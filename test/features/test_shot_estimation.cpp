@@ -749,6 +749,22 @@ TEST (PCL,3DSCEstimation)
   EXPECT_FLOAT_EQ ((*sc3ds)[108].descriptor[1421], 38.08799f);
   EXPECT_FLOAT_EQ ((*sc3ds)[108].descriptor[1900], 43.799442f);
 
+  // Multithreaded estimation should give the same results, as the random axes are drawn in point order
+  ShapeContext3DEstimation<PointXYZ, Normal, ShapeContext1980> sc3d_mt;
+  sc3d_mt.setInputCloud (cloudptr);
+  sc3d_mt.setInputNormals (normals);
+  sc3d_mt.setSearchMethod (tree);
+  sc3d_mt.setRadiusSearch (radius);
+  sc3d_mt.setMinimalRadius (rmin);
+  sc3d_mt.setPointDensityRadius (ptDensityRad);
+  sc3d_mt.setNumberOfThreads (4);
+  PointCloud<ShapeContext1980> sc3ds_mt;
+  sc3d_mt.compute (sc3ds_mt);
+  ASSERT_EQ (sc3ds_mt.size (), sc3ds->size ());
+  for (std::size_t i = 0; i < sc3ds->size (); ++i)
+    for (std::size_t j = 0; j < 1980; ++j)
+      EXPECT_FLOAT_EQ ((*sc3ds)[i].descriptor[j], sc3ds_mt[i].descriptor[j]);
+
   // Test results when setIndices and/or setSearchSurface are used
   pcl::IndicesPtr test_indices (new pcl::Indices (0));
   for (std::size_t i = 0; i < cloud.size (); i++)
@@ -802,6 +818,19 @@ TEST (PCL, USCEstimation)
   EXPECT_NEAR ((*uscds)[168].descriptor[1175], 83.4680f, 1e-4f);
   EXPECT_NEAR ((*uscds)[168].descriptor[1756], 65.1737f, 1e-4f);
 
+  // Multithreaded estimation should give the same results
+  PointCloud<UniqueShapeContext1960> uscds_mt;
+  uscd.setNumberOfThreads (4);
+  uscd.compute (uscds_mt);
+  ASSERT_EQ (uscds_mt.size (), uscds->size ());
+  for (std::size_t i = 0; i < uscds->size (); ++i)
+  {
+    for (std::size_t j = 0; j < 9; ++j)
+      EXPECT_FLOAT_EQ ((*uscds)[i].rf[j], uscds_mt[i].rf[j]);
+    for (std::size_t j = 0; j < 1960; ++j)
+      EXPECT_FLOAT_EQ ((*uscds)[i].descriptor[j], uscds_mt[i].descriptor[j]);
+  }
+
   // Test results when setIndices and/or setSearchSurface are used
   pcl::IndicesPtr test_indices (new pcl::Indices (0));
   for (std::size_t i = 0; i < cloud.size (); i+=3)
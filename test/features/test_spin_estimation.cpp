@@ -229,6 +229,15 @@ TEST (PCL, SpinImageEstimation)
   EXPECT_NEAR ((*spin_images)[300].histogram[120], 0, 1e-4);
   EXPECT_NEAR ((*spin_images)[300].histogram[132], 0, 1e-4);
   EXPECT_NEAR ((*spin_images)[300].histogram[144], 0.272542, 1e-4);
+
+  // multithreaded estimation should give the same results
+  PointCloud<SpinImage> spin_images_mt;
+  spin_est.setNumberOfThreads (4);
+  spin_est.compute (spin_images_mt);
+  ASSERT_EQ (spin_images_mt.size (), spin_images->size ());
+  for (std::size_t i = 0; i < spin_images->size (); ++i)
+    for (int j = 0; j < 153; ++j)
+      EXPECT_FLOAT_EQ ((*spin_images)[i].histogram[j], spin_images_mt[i].histogram[j]);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -48,6 +48,7 @@
 #include <pcl/filters/frustum_culling.h>
 #include <pcl/filters/sampling_surface_normal.h>
 #include <pcl/filters/voxel_grid.h>
+#include <pcl/filters/streaming_voxel_grid.h>
 #include <pcl/filters/voxel_grid_occlusion_estimation.h>
 #include <pcl/filters/voxel_grid_covariance.h>
 #include <pcl/filters/extract_indices.h>
@@ -1349,6 +1350,25 @@ TEST (VoxelGridCovariance, Filters)
   EXPECT_NEAR (leaves[2]->getMean ()[0], -0.00936106, 1e-4);
   EXPECT_NEAR (leaves[2]->getMean ()[1], 0.0516725, 1e-4);
   EXPECT_NEAR (leaves[2]->getMean ()[2], 0.0508024, 1e-4);
+
+  // neighborhood lookups of a copy should return the leaves of the copy
+  std::vector<VoxelGridCovariance<pcl::PointXYZ>::LeafConstPtr> neighborhood;
+  ASSERT_GT (grid.getAllNeighborsAtPoint ((*cloud)[38], neighborhood), 0);
+  VoxelGridCovariance<PointXYZ> copied (grid);
+  VoxelGridCovariance<PointXYZ> assigned;
+  assigned = grid;
+  for (auto* copy : {&copied, &assigned})
+  {
+    std::vector<VoxelGridCovariance<pcl::PointXYZ>::LeafConstPtr> copy_neighborhood;
+    ASSERT_EQ (copy->getAllNeighborsAtPoint ((*cloud)[38], copy_neighborhood), static_cast<int> (neighborhood.size ()));
+    for (std::size_t i = 0; i < neighborhood.size (); ++i)
+    {
+      const auto leaf = std::find_if (copy->getLeaves ().begin (), copy->getLeaves ().end (),
+                                      [&] (const auto &l) { return (&l.second == copy_neighborhood[i]); });
+      EXPECT_NE (leaf, copy->getLeaves ().end ());
+      EXPECT_EQ (copy_neighborhood[i]->getMean (), neighborhood[i]->getMean ());
+    }
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1452,6 +1472,132 @@ TEST (VoxelGridMinPoints, Filters)
   EXPECT_NEAR (out_pc->at(0).y, outputMin6[0].y, 1e-4);
   EXPECT_NEAR (out_pc->at(0).z, outputMin6[0].z, 1e-4);
 }
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGridMultiThreaded, Filters)
+{
+  PointCloud<PointXYZRGB>::Ptr input (new PointCloud<PointXYZRGB>);
+  copyPointCloud (*cloud, *input);
+  for (std::size_t i = 0; i < input->size (); ++i)
+  {
+    (*input)[i].r = static_cast<std::uint8_t> (i % 256);
+    (*input)[i].g = static_cast<std::uint8_t> ((3 * i) % 256);
+    (*input)[i].b = static_cast<std::uint8_t> ((7 * i) % 256);
+  }
+
+  VoxelGrid<PointXYZRGB> grid;
+  grid.setLeafSize (0.01f, 0.01f, 0.01f);
+  grid.setInputCloud (input);
+  grid.setSaveLeafLayout (true);
+
+  for (const bool downsample_all_data : {true, false})
+  {
+    grid.setDownsampleAllData (downsample_all_data);
+    grid.setFilterFieldName ("");
+
+    PointCloud<PointXYZRGB> output_serial, output_parallel;
+    grid.setNumberOfThreads (1);
+    grid.filter (output_serial);
+    const auto leaf_serial = grid.getLeafLayout ();
+
+    grid.setNumberOfThreads (4);
+    grid.filter (output_parallel);
+
+    // The parallel filter must produce exactly the same centroids in the same order
+    ASSERT_EQ (output_parallel.size (), output_serial.size ());
+    EXPECT_EQ (grid.getLeafLayout (), leaf_serial);
+    for (std::size_t i = 0; i < output_serial.size (); ++i)
+    {
+      EXPECT_EQ (output_parallel[i].x, output_serial[i].x);
+      EXPECT_EQ (output_parallel[i].y, output_serial[i].y);
+      EXPECT_EQ (output_parallel[i].z, output_serial[i].z);
+      EXPECT_EQ (output_parallel[i].rgba, output_serial[i].rgba);
+    }
+
+    // Same with a filter field and negative limits
+    grid.setFilterFieldName ("z");
+    grid.setFilterLimits (0.05, 0.1);
+    grid.setFilterLimitsNegative (true);
+    grid.setNumberOfThreads (1);
+    grid.filter (output_serial);
+    grid.setNumberOfThreads (3);
+    grid.filter (output_parallel);
+    grid.setFilterLimitsNegative (false);
+
+    ASSERT_EQ (output_parallel.size (), output_serial.size ());
+    for (std::size_t i = 0; i < output_serial.size (); ++i)
+    {
+      EXPECT_EQ (output_parallel[i].x, output_serial[i].x);
+      EXPECT_EQ (output_parallel[i].y, output_serial[i].y);
+      EXPECT_EQ (output_parallel[i].z, output_serial[i].z);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (StreamingVoxelGrid, Filters)
+{
+  const auto lexicographic = [] (const PointXYZ &lhs, const PointXYZ &rhs)
+  {
+    return std::tie (lhs.x, lhs.y, lhs.z) < std::tie (rhs.x, rhs.y, rhs.z);
+  };
+
+  PointCloud<PointXYZ> output_voxel_grid;
+  VoxelGrid<PointXYZ> voxel_grid;
+  voxel_grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  voxel_grid.setInputCloud (cloud);
+  voxel_grid.filter (output_voxel_grid);
+  std::sort (output_voxel_grid.begin (), output_voxel_grid.end (), lexicographic);
+
+  PointCloud<PointXYZ> output;
+  StreamingVoxelGrid<PointXYZ> grid;
+  grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid.setInputCloud (cloud);
+  grid.filter (output);
+
+  EXPECT_EQ (output.size (), 103);
+  EXPECT_EQ (output.width, 103);
+  EXPECT_EQ (output.height, 1);
+  EXPECT_TRUE (output.is_dense);
+  EXPECT_EQ (grid.getNumberOfVoxels (), 103);
+
+  // Same centroids as VoxelGrid, up to their order
+  std::sort (output.begin (), output.end (), lexicographic);
+  ASSERT_EQ (output.size (), output_voxel_grid.size ());
+  for (std::size_t i = 0; i < output.size (); ++i)
+  {
+    EXPECT_EQ (output[i].x, output_voxel_grid[i].x);
+    EXPECT_EQ (output[i].y, output_voxel_grid[i].y);
+    EXPECT_EQ (output[i].z, output_voxel_grid[i].z);
+  }
+
+  // Adding the cloud in chunks must give the same result as filtering it at once
+  grid.clear ();
+  EXPECT_EQ (grid.getNumberOfVoxels (), 0);
+  for (std::size_t begin = 0; begin < cloud->size (); begin += 50)
+  {
+    PointCloud<PointXYZ> chunk;
+    chunk.assign (cloud->begin () + begin, cloud->begin () + std::min (cloud->size (), begin + 50), 1);
+    grid.addPointCloud (chunk);
+  }
+  PointCloud<PointXYZ> output_chunked;
+  grid.getCentroids (output_chunked);
+  std::sort (output_chunked.begin (), output_chunked.end (), lexicographic);
+  ASSERT_EQ (output_chunked.size (), output.size ());
+  for (std::size_t i = 0; i < output.size (); ++i)
+  {
+    EXPECT_EQ (output_chunked[i].x, output[i].x);
+    EXPECT_EQ (output_chunked[i].y, output[i].y);
+    EXPECT_EQ (output_chunked[i].z, output[i].z);
+  }
+
+  // Minimum number of points per voxel
+  voxel_grid.setMinimumPointsNumberPerVoxel (5);
+  voxel_grid.filter (output_voxel_grid);
+  grid.setMinimumPointsNumberPerVoxel (5);
+  grid.getCentroids (output);
+  EXPECT_EQ (output.size (), output_voxel_grid.size ());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (ProjectInliers, Filters)
 {
@@ -45,6 +45,8 @@
 #include <pcl/console/print.h>
 #include <pcl/io/auto_io.h>
 #include <pcl/io/pcd_io.h>
+#include <pcl/io/pcd_mapped_cloud.h>
+#include <pcl/io/pcd_stream_reader.h>
 #include <pcl/io/ply_io.h>
 #include <pcl/io/ascii_io.h>
 #include <pcl/io/obj_io.h>
@@ -944,6 +946,93 @@ TEST (PCL, PCDReaderWriter)
   remove ("test_pcl_io.pcd");
 }
 
+TEST (PCL, PCDMappedCloud)
+{
+  PointCloud<PointXYZI> cloud;
+  cloud.width  = 64;
+  cloud.height = 48;
+  cloud.resize (cloud.width * cloud.height);
+  cloud.is_dense = true;
+  for (std::size_t i = 0; i < cloud.size (); ++i)
+  {
+    cloud[i].x = static_cast<float> (i % cloud.width);
+    cloud[i].y = static_cast<float> (i / cloud.width);
+    cloud[i].z = static_cast<float> (i) * 0.5f;
+    cloud[i].intensity = static_cast<float> (i);
+  }
+
+  const auto expect_equal_clouds = [&cloud] (const PCDMappedCloud<PointXYZI> &mapped)
+  {
+    ASSERT_EQ (mapped.size (), cloud.size ());
+    EXPECT_EQ (mapped.getWidth (), cloud.width);
+    EXPECT_EQ (mapped.getHeight (), cloud.height);
+    for (std::size_t i = 0; i < cloud.size (); ++i)
+    {
+      EXPECT_EQ (mapped[i].x, cloud[i].x);
+      EXPECT_EQ (mapped[i].y, cloud[i].y);
+      EXPECT_EQ (mapped[i].z, cloud[i].z);
+      EXPECT_EQ (mapped[i].intensity, cloud[i].intensity);
+    }
+  };
+
+  // Memory layout with aligned data: used in place
+  pcl::PCLPointCloud2 blob;
+  toPCLPointCloud2 (cloud, blob);
+  PCDWriter writer;
+  writer.setBinaryDataAlignment (alignof (PointXYZI));
+  writer.writeBinary ("test_pcl_io_mapped.pcd", blob);
+
+  PCDMappedCloud<PointXYZI> mapped;
+  ASSERT_EQ (mapped.read ("test_pcl_io_mapped.pcd"), 0);
+  EXPECT_TRUE (mapped.isZeroCopy ());
+  EXPECT_TRUE (mapped.isDense ());
+  expect_equal_clouds (mapped);
+
+  // The padded header must still be readable by PCDReader
+  PointCloud<PointXYZI> cloud_in;
+  ASSERT_EQ (loadPCDFile ("test_pcl_io_mapped.pcd", cloud_in), 0);
+  EXPECT_EQ (cloud_in.size (), cloud.size ());
+  EXPECT_EQ (cloud_in[10].intensity, cloud[10].intensity);
+
+  // Packed layout: converted from the mapped body
+  writer.writeBinary ("test_pcl_io_mapped.pcd", cloud);
+  ASSERT_EQ (mapped.read ("test_pcl_io_mapped.pcd"), 0);
+  EXPECT_FALSE (mapped.isZeroCopy ());
+  expect_equal_clouds (mapped);
+
+  // Compressed and ASCII: decoded by PCDReader
+  cloud[5].z = std::numeric_limits<float>::quiet_NaN ();
+  writer.writeBinaryCompressed ("test_pcl_io_mapped.pcd", cloud);
+  ASSERT_EQ (mapped.read ("test_pcl_io_mapped.pcd"), 0);
+  EXPECT_FALSE (mapped.isZeroCopy ());
+  EXPECT_FALSE (mapped.isDense ());
+  EXPECT_EQ (mapped.size (), cloud.size ());
+  EXPECT_EQ (mapped[10].intensity, cloud[10].intensity);
+
+  writer.writeASCII ("test_pcl_io_mapped.pcd", cloud);
+  ASSERT_EQ (mapped.read ("test_pcl_io_mapped.pcd"), 0);
+  EXPECT_FALSE (mapped.isZeroCopy ());
+  EXPECT_EQ (mapped[10].intensity, cloud[10].intensity);
+
+  // Non-finite values are detected in place as well
+  toPCLPointCloud2 (cloud, blob);
+  writer.writeBinary ("test_pcl_io_mapped.pcd", blob);
+  ASSERT_EQ (mapped.read ("test_pcl_io_mapped.pcd"), 0);
+  EXPECT_TRUE (mapped.isZeroCopy ());
+  EXPECT_FALSE (mapped.isDense ());
+
+  PointCloud<PointXYZI> copy;
+  mapped.copyTo (copy);
+  EXPECT_EQ (copy.width, cloud.width);
+  EXPECT_EQ (copy.height, cloud.height);
+  EXPECT_EQ (copy[10].intensity, cloud[10].intensity);
+
+  EXPECT_LT (mapped.read ("does_not_exist.pcd"), 0);
+  EXPECT_TRUE (mapped.empty ());
+
+  remove ("test_pcl_io_mapped.pcd");
+}
+
 TEST (PCL, PCDReaderWriterASCIIColorPrecision)
 {
   PointCloud<PointXYZRGB> cloud;
@@ -1425,6 +1514,190 @@ TEST (PCL, LZFExtended)
   remove ("test_pcl_io_compressed.pcd");
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, LZFChunked)
+{
+  PointCloud<PointXYZRGBNormal> cloud, cloud2;
+  cloud.width  = 640;
+  cloud.height = 48;
+  cloud.resize (cloud.width * cloud.height);
+  cloud.is_dense = true;
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+  const auto nr_p = cloud.size ();
+  // Randomly create a new point cloud
+  for (std::size_t i = 0; i < nr_p; ++i)
+  {
+    cloud[i].x = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].y = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].z = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].normal_x = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].normal_y = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].normal_z = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].rgb = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+  }
+
+  pcl::PCLPointCloud2 blob;
+  pcl::toPCLPointCloud2 (cloud, blob);
+
+  PCDWriter writer;
+  PCDReader reader;
+  // Chunk sizes that do and do not divide the number of points, and a single chunk
+  for (const unsigned int chunk_size : {1000u, 4096u, 1000000u})
+  {
+    for (const unsigned int nr_threads : {1u, 4u})
+    {
+      writer.setChunkSize (chunk_size);
+      writer.setNumberOfThreads (nr_threads);
+      int res = writer.writeBinaryCompressedChunked ("test_pcl_io_compressed_chunked.pcd", blob);
+      EXPECT_EQ (res, 0);
+
+      reader.setNumberOfThreads (nr_threads);
+      res = reader.read<PointXYZRGBNormal> ("test_pcl_io_compressed_chunked.pcd", cloud2);
+      EXPECT_EQ (res, 0);
+
+      EXPECT_EQ (cloud2.width, blob.width);
+      EXPECT_EQ (cloud2.height, blob.height);
+      EXPECT_EQ (cloud2.is_dense, cloud.is_dense);
+      ASSERT_EQ (cloud2.size (), cloud.size ());
+
+      for (std::size_t i = 0; i < cloud2.size (); ++i)
+      {
+        EXPECT_EQ (cloud2[i].x, cloud[i].x);
+        EXPECT_EQ (cloud2[i].normal_z, cloud[i].normal_z);
+        EXPECT_EQ (cloud2[i].rgb, cloud[i].rgb);
+      }
+    }
+  }
+
+  // Partial reads only decompress the chunks overlapping the range
+  writer.setChunkSize (1000);
+  writer.writeBinaryCompressedChunked ("test_pcl_io_compressed_chunked.pcd", blob);
+  pcl::PCLPointCloud2 blob2;
+  int res = reader.readRange ("test_pcl_io_compressed_chunked.pcd", blob2, 1500, 3000);
+  EXPECT_EQ (res, 0);
+  EXPECT_EQ (blob2.width, 3000);
+  EXPECT_EQ (blob2.height, 1);
+  pcl::fromPCLPointCloud2 (blob2, cloud2);
+  ASSERT_EQ (cloud2.size (), 3000);
+  for (std::size_t i = 0; i < cloud2.size (); ++i)
+  {
+    EXPECT_EQ (cloud2[i].x, cloud[1500 + i].x);
+    EXPECT_EQ (cloud2[i].normal_y, cloud[1500 + i].normal_y);
+  }
+
+  // The range is clamped to the number of points in the file
+  res = reader.readRange ("test_pcl_io_compressed_chunked.pcd", blob2, static_cast<uindex_t> (nr_p) - 10, 100);
+  EXPECT_EQ (res, 0);
+  EXPECT_EQ (blob2.width, 10);
+
+  // Same partial read from an uncompressed binary file
+  writer.writeBinary ("test_pcl_io_compressed_chunked.pcd", blob);
+  res = reader.readRange ("test_pcl_io_compressed_chunked.pcd", blob2, 1500, 3000);
+  EXPECT_EQ (res, 0);
+  pcl::fromPCLPointCloud2 (blob2, cloud2);
+  ASSERT_EQ (cloud2.size (), 3000);
+  EXPECT_EQ (cloud2[0].x, cloud[1500].x);
+  EXPECT_EQ (cloud2[2999].rgb, cloud[4499].rgb);
+
+  // NaN points are detected when decoding
+  cloud[nr_p / 2].x = std::numeric_limits<float>::quiet_NaN ();
+  cloud.is_dense = false;
+  pcl::toPCLPointCloud2 (cloud, blob);
+  writer.writeBinaryCompressedChunked ("test_pcl_io_compressed_chunked.pcd", blob);
+  res = reader.read<PointXYZRGBNormal> ("test_pcl_io_compressed_chunked.pcd", cloud2);
+  EXPECT_EQ (res, 0);
+  EXPECT_FALSE (cloud2.is_dense);
+  EXPECT_TRUE (std::isnan (cloud2[nr_p / 2].x));
+
+  remove ("test_pcl_io_compressed_chunked.pcd");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PCDStreamReader)
+{
+  PointCloud<PointXYZRGBNormal> cloud;
+  cloud.width  = 640;
+  cloud.height = 48;
+  cloud.resize (cloud.width * cloud.height);
+  cloud.is_dense = false;
+
+  srand (static_cast<unsigned int> (time (nullptr)));
+  const auto nr_p = cloud.size ();
+  // Randomly create a new point cloud
+  for (std::size_t i = 0; i < nr_p; ++i)
+  {
+    cloud[i].x = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].y = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].z = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].normal_x = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].normal_y = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].normal_z = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+    cloud[i].rgb = static_cast<float> (1024 * rand () / (RAND_MAX + 1.0));
+  }
+  // A single invalid point, in the second batch
+  cloud[1500].x = std::numeric_limits<float>::quiet_NaN ();
+
+  pcl::PCLPointCloud2 blob;
+  pcl::toPCLPointCloud2 (cloud, blob);
+
+  PCDWriter writer;
+  writer.setChunkSize (4096);
+  for (int data_type = 0; data_type < 4; ++data_type)
+  {
+    int res = 0;
+    switch (data_type)
+    {
+      case 0: res = writer.writeASCII ("test_pcl_io_stream.pcd", blob, Eigen::Vector4f::Zero (), Eigen::Quaternionf::Identity (), 10); break;
+      case 1: res = writer.writeBinary ("test_pcl_io_stream.pcd", blob); break;
+      case 2: res = writer.writeBinaryCompressed ("test_pcl_io_stream.pcd", blob); break;
+      case 3: res = writer.writeBinaryCompressedChunked ("test_pcl_io_stream.pcd", blob); break;
+    }
+    ASSERT_EQ (res, 0);
+
+    // Batches smaller than a chunk, which share chunks, and larger than a chunk
+    for (const std::size_t batch_size : {1000, 5000})
+    {
+      PCDStreamReader reader;
+      reader.setBatchSize (static_cast<uindex_t> (batch_size));
+      ASSERT_EQ (reader.open ("test_pcl_io_stream.pcd"), 0);
+      EXPECT_EQ (reader.getHeader ().width, cloud.width);
+      EXPECT_EQ (reader.getHeader ().height, cloud.height);
+      EXPECT_EQ (reader.getNumberOfPoints (), nr_p);
+
+      PointCloud<PointXYZRGBNormal> batch;
+      std::size_t nr_batches = 0, idx = 0;
+      while (!reader.eof ())
+      {
+        ASSERT_EQ (reader.read (batch), 0);
+        EXPECT_EQ (batch.height, 1);
+        EXPECT_EQ (batch.is_dense, nr_batches != 1500 / batch_size);
+        for (const auto &point : batch)
+        {
+          if (idx == 1500)
+            EXPECT_TRUE (std::isnan (point.x));
+          else
+            EXPECT_EQ (point.x, cloud[idx].x);
+          EXPECT_EQ (point.y, cloud[idx].y);
+          EXPECT_EQ (point.normal_z, cloud[idx].normal_z);
+          EXPECT_EQ (point.rgb, cloud[idx].rgb);
+          ++idx;
+        }
+        ++nr_batches;
+      }
+      EXPECT_EQ (idx, nr_p);
+      EXPECT_EQ (nr_batches, (nr_p + batch_size - 1) / batch_size);
+      EXPECT_EQ (reader.getNumberOfPointsRead (), nr_p);
+
+      // Reading past the end returns an empty batch
+      EXPECT_EQ (reader.read (batch), 0);
+      EXPECT_TRUE (batch.empty ());
+    }
+  }
+
+  remove ("test_pcl_io_stream.pcd");
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, WriteBinaryToOStream)
 {
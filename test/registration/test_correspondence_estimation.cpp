@@ -37,6 +37,7 @@
 
 #include <pcl/test/gtest.h>
 #include <pcl/registration/correspondence_estimation_normal_shooting.h>
+#include <pcl/registration/correspondence_estimation_backprojection.h>
 #include <pcl/features/normal_3d.h>
 #include <pcl/kdtree/kdtree.h>
 
@@ -174,6 +175,70 @@ TYPED_TEST (CorrespondenceEstimationTestSuite, CorrespondenceEstimationSetSearch
   
 }
 
+//////////////////////////////////////////////////////////////////////////////////////
+template <typename CorrespondenceEstimationT> void
+expectSameCorrespondencesMultithreaded (CorrespondenceEstimationT &ce)
+{
+  for (const bool reciprocal : {false, true})
+  {
+    pcl::Correspondences corr_serial, corr_parallel;
+    ce.setNumberOfThreads (1);
+    if (reciprocal)
+      ce.determineReciprocalCorrespondences (corr_serial);
+    else
+      ce.determineCorrespondences (corr_serial);
+    ce.setNumberOfThreads (4);
+    if (reciprocal)
+      ce.determineReciprocalCorrespondences (corr_parallel);
+    else
+      ce.determineCorrespondences (corr_parallel);
+
+    EXPECT_FALSE (corr_serial.empty ());
+    ASSERT_EQ (corr_serial.size (), corr_parallel.size ());
+    for (std::size_t i = 0; i < corr_serial.size (); i++)
+    {
+      EXPECT_EQ (corr_serial[i].index_query, corr_parallel[i].index_query);
+      EXPECT_EQ (corr_serial[i].index_match, corr_parallel[i].index_match);
+      EXPECT_EQ (corr_serial[i].distance, corr_parallel[i].distance);
+    }
+  }
+}
+
+TEST (PCL, CorrespondenceEstimationNormalsMultithreaded)
+{
+  // A wavy surface and a shifted copy of it, both with their analytic normals
+  auto cloud1 (pcl::make_shared<pcl::PointCloud<pcl::PointNormal>> ());
+  auto cloud2 (pcl::make_shared<pcl::PointCloud<pcl::PointNormal>> ());
+  for (std::size_t i = 0; i < 60; ++i)
+  {
+    for (std::size_t j = 0; j < 40; ++j)
+    {
+      const float x = i * 0.05f, y = j * 0.05f;
+      pcl::PointNormal point;
+      point.getVector3fMap () = Eigen::Vector3f (x, y, 0.2f * std::sin (2.f * x) * std::cos (3.f * y));
+      point.getNormalVector3fMap () = Eigen::Vector3f (-0.4f * std::cos (2.f * x) * std::cos (3.f * y),
+                                                       0.6f * std::sin (2.f * x) * std::sin (3.f * y),
+                                                       1.f).normalized ();
+      cloud1->push_back (point);
+      point.getVector3fMap () += Eigen::Vector3f (0.01f, 0.02f, 0.03f);
+      cloud2->push_back (point);
+    }
+  }
+
+  pcl::registration::CorrespondenceEstimationNormalShooting<pcl::PointNormal, pcl::PointNormal, pcl::PointNormal> ns;
+  ns.setInputSource (cloud1);
+  ns.setSourceNormals (cloud1);
+  ns.setInputTarget (cloud2);
+  expectSameCorrespondencesMultithreaded (ns);
+
+  pcl::registration::CorrespondenceEstimationBackProjection<pcl::PointNormal, pcl::PointNormal, pcl::PointNormal> bp;
+  bp.setInputSource (cloud1);
+  bp.setSourceNormals (cloud1);
+  bp.setInputTarget (cloud2);
+  bp.setTargetNormals (cloud2);
+  expectSameCorrespondencesMultithreaded (bp);
+}
+
 /* ---[ */
 int
   main (int argc, char** argv)
@@ -94,6 +94,151 @@ TEST (PCL, NormalDistributionsTransform)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalDistributionsTransformMultiThreaded)
+{
+  PointCloud<PointXYZ>::Ptr src = cloud_source.makeShared ();
+  PointCloud<PointXYZ>::Ptr tgt = cloud_target.makeShared ();
+  PointCloud<PointXYZ> output;
+
+  NormalDistributionsTransform<PointXYZ, PointXYZ> reg;
+  reg.setStepSize (0.05);
+  reg.setResolution (0.025f);
+  reg.setInputSource (src);
+  reg.setInputTarget (tgt);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.align (output);
+  const Eigen::Matrix4f serial_transformation = reg.getFinalTransformation ();
+
+  reg.setNumberOfThreads (4);
+  reg.align (output);
+  EXPECT_EQ (output.size (), cloud_source.size ());
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+  EXPECT_TRUE (reg.getFinalTransformation ().isApprox (serial_transformation, 1e-4f));
+
+  // The per thread results are reduced in a fixed order
+  const Eigen::Matrix4f parallel_transformation = reg.getFinalTransformation ();
+  reg.align (output);
+  EXPECT_EQ (reg.getFinalTransformation (), parallel_transformation);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalDistributionsTransformDirectNeighborSearch)
+{
+  using NDT = NormalDistributionsTransform<PointXYZ, PointXYZ>;
+  PointCloud<PointXYZ>::Ptr src = cloud_source.makeShared ();
+  PointCloud<PointXYZ>::Ptr tgt = cloud_target.makeShared ();
+  PointCloud<PointXYZ> output;
+
+  NDT reg;
+  reg.setStepSize (0.05);
+  reg.setResolution (0.025f);
+  reg.setInputSource (src);
+  reg.setInputTarget (tgt);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  EXPECT_EQ (reg.getNeighborSearchMethod (), NDT::NeighborSearchMethod::KDTREE);
+
+  for (const auto method : {NDT::NeighborSearchMethod::DIRECT7, NDT::NeighborSearchMethod::DIRECT27})
+  {
+    reg.setNeighborSearchMethod (method);
+    reg.align (output);
+    EXPECT_EQ (output.size (), cloud_source.size ());
+    EXPECT_LT (reg.getFitnessScore (), 0.001);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NormalDistributionsTransformMap)
+{
+  using NDT = NormalDistributionsTransform<PointXYZ, PointXYZ>;
+  PointCloud<PointXYZ>::Ptr src = cloud_source.makeShared ();
+  PointCloud<PointXYZ> output;
+
+  NormalDistributionsTransformMap::Ptr map (new NormalDistributionsTransformMap (0.025));
+  map->insert (cloud_target);
+  EXPECT_GT (map->getNumberOfValidVoxels (), 0u);
+  EXPECT_LE (map->getNumberOfValidVoxels (), map->size ());
+
+  // The running statistics match the ones computed from all points at once
+  NormalDistributionsTransformMap half_map (0.025);
+  PointCloud<PointXYZ> first_half, second_half;
+  for (std::size_t i = 0; i < cloud_target.size (); ++i)
+    (i % 2 ? second_half : first_half).push_back (cloud_target[i]);
+  half_map.insert (first_half);
+  half_map.insert (second_half);
+  half_map.insert (cloud_source);
+  half_map.remove (cloud_source);
+  ASSERT_EQ (half_map.getNumberOfValidVoxels (), map->getNumberOfValidVoxels ());
+  for (std::size_t i = 0; i < map->size (); ++i)
+  {
+    const auto& voxel = map->getVoxels ()[i];
+    if (!voxel.valid)
+      continue;
+    const auto* other = half_map.getVoxel (voxel.getMean ().cast<float> ());
+    ASSERT_NE (other, nullptr);
+    EXPECT_EQ (other->getPointCount (), voxel.getPointCount ());
+    EXPECT_TRUE (other->getMean ().isApprox (voxel.getMean (), 1e-6));
+    EXPECT_TRUE (other->getCov ().isApprox (voxel.getCov (), 1e-4));
+  }
+
+  // Save, and align against the memory mapped copy
+  const std::string file_name = "test_ndt_map.ndtmap";
+  ASSERT_EQ (map->save (file_name), 0);
+  NormalDistributionsTransformMap::Ptr loaded_map (new NormalDistributionsTransformMap);
+  ASSERT_EQ (loaded_map->load (file_name), 0);
+  EXPECT_DOUBLE_EQ (loaded_map->getResolution (), 0.025);
+  EXPECT_EQ (loaded_map->size (), map->size ());
+  EXPECT_EQ (loaded_map->getNumberOfValidVoxels (), map->getNumberOfValidVoxels ());
+
+  NDT reg;
+  reg.setStepSize (0.05);
+  reg.setTargetMap (nullptr);
+  EXPECT_EQ (reg.getTargetMap (), nullptr);
+  reg.setTargetMap (loaded_map);
+  EXPECT_FLOAT_EQ (reg.getResolution (), 0.025f);
+  reg.setTargetMap (nullptr);
+  EXPECT_EQ (reg.getTargetMap (), loaded_map);
+  reg.setInputSource (src);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  for (const auto method : {NDT::NeighborSearchMethod::KDTREE, NDT::NeighborSearchMethod::DIRECT7})
+  {
+    reg.setNeighborSearchMethod (method);
+    reg.align (output);
+    EXPECT_EQ (output.size (), cloud_source.size ());
+    EXPECT_LT (reg.getFitnessScore (), 0.001);
+  }
+
+  // The direct neighbor searches do not extract the voxel means
+  NDT reg_direct;
+  reg_direct.setStepSize (0.05);
+  reg_direct.setNeighborSearchMethod (NDT::NeighborSearchMethod::DIRECT7);
+  reg_direct.setTargetMap (loaded_map);
+  reg_direct.setInputSource (src);
+  reg_direct.setMaximumIterations (50);
+  reg_direct.setTransformationEpsilon (1e-8);
+  EXPECT_TRUE (reg_direct.getInputTarget ()->empty ());
+  reg_direct.align (output);
+  EXPECT_TRUE (reg_direct.getFinalTransformation ().isApprox (reg.getFinalTransformation (), 1e-4f));
+  EXPECT_EQ (reg_direct.getFitnessScore (), std::numeric_limits<double>::max ());
+  reg_direct.setNeighborSearchMethod (NDT::NeighborSearchMethod::KDTREE);
+  EXPECT_EQ (reg_direct.getInputTarget ()->size (), loaded_map->getNumberOfValidVoxels ());
+
+  // The first update copies the mapped file into memory
+  loaded_map->insert (cloud_source);
+  loaded_map->remove (cloud_source);
+  EXPECT_EQ (loaded_map->getNumberOfValidVoxels (), map->getNumberOfValidVoxels ());
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+
+  // Files that are not NDT maps are rejected
+  EXPECT_EQ (loaded_map->load ("no_such_file.ndtmap"), -1);
+  EXPECT_EQ (loaded_map->size (), 0u);
+  remove (file_name.c_str ());
+}
+
 int
 main (int argc, char** argv)
 {
@@ -48,6 +48,7 @@
 #include <pcl/registration/icp_nl.h>
 #include <pcl/registration/gicp.h>
 #include <pcl/registration/gicp6d.h>
+#include <pcl/registration/vgicp.h>
 #include <pcl/registration/transformation_estimation_point_to_plane.h>
 #include <pcl/registration/transformation_validation_euclidean.h>
 #include <pcl/registration/correspondence_rejection_median_distance.h>
@@ -55,6 +56,9 @@
 #include <pcl/registration/correspondence_rejection_surface_normal.h>
 #include <pcl/registration/correspondence_estimation_normal_shooting.h>
 #include <pcl/registration/pyramid_feature_matching.h>
+#include <pcl/registration/pyramid_registration.h>
+#include <pcl/search/brute_force.h>
+#include <pcl/search/incremental_kdtree.h>
 #include <pcl/features/ppf.h>
 #include <pcl/registration/ppf_registration.h>
 #include <pcl/filters/voxel_grid.h>
@@ -231,6 +235,131 @@ TEST (PCL, IterativeClosestPoint)
   EXPECT_EQ (transformation (3, 3), 1);
 }
 
+TEST (PCL, PyramidRegistration)
+{
+  IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp (new IterativeClosestPoint<PointXYZ, PointXYZ>);
+  const auto icp_tree = icp->getSearchMethodTarget ();
+
+  registration::PyramidRegistration<PointXYZ, PointXYZ> pyramid;
+  pyramid.setRegistration (icp);
+  pyramid.addLevel (0.01f, 50, 0.05);
+  pyramid.addLevel (0.005f, 50, 0.05);
+  pyramid.addLevel (0.0f, 50, 0.05, 1e-8);
+  EXPECT_EQ (pyramid.getLevels ().size (), 3u);
+
+  PointCloud<PointXYZ>::ConstPtr source (cloud_source.makeShared ());
+  PointCloud<PointXYZ>::ConstPtr target (cloud_target.makeShared ());
+  pyramid.setInputSource (source);
+  pyramid.setInputTarget (target);
+
+  // Register
+  pyramid.align (cloud_reg);
+  EXPECT_TRUE (pyramid.hasConverged ());
+  EXPECT_EQ (cloud_reg.size (), cloud_source.size ());
+  EXPECT_LT (pyramid.getSourceLevel (0)->size (), pyramid.getSourceLevel (1)->size ());
+  EXPECT_LT (pyramid.getTargetLevel (1)->size (), target->size ());
+  EXPECT_EQ (pyramid.getTargetLevel (2), target);
+  // The search method of the registration is given back without being built
+  EXPECT_EQ (icp->getSearchMethodTarget (), icp_tree);
+  EXPECT_EQ (icp_tree->getInputCloud (), nullptr);
+
+  // Same result as the single resolution IterativeClosestPoint test
+  Eigen::Matrix4f reference;
+  reference << 0.8806f,   0.03648f, -0.4724f,  0.03453f,
+              -0.02354f,  0.9992f,   0.03326f, -0.001519f,
+               0.4732f,  -0.01817f,  0.8808f,  0.04116f,
+               0.0f,      0.0f,      0.0f,     1.0f;
+  const Eigen::Matrix4f transformation = pyramid.getFinalTransformation ();
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_NEAR (transformation (i, j), reference (i, j), 1e-2);
+
+  // The fitness score is computed against the target of the finest level
+  PointCloud<PointXYZ> source_transformed;
+  transformPointCloud (*source, source_transformed, transformation);
+  search::KdTree<PointXYZ> target_tree;
+  target_tree.setInputCloud (target);
+  pcl::Indices nn_indices (1);
+  std::vector<float> nn_dists (1);
+  double fitness_score = 0.0;
+  for (const auto& point : source_transformed)
+  {
+    target_tree.nearestKSearch (point, 1, nn_indices, nn_dists);
+    fitness_score += nn_dists[0];
+  }
+  fitness_score /= static_cast<double> (source_transformed.size ());
+  EXPECT_NEAR (pyramid.getFitnessScore (), fitness_score, 1e-6);
+  EXPECT_EQ (icp->getSearchMethodTarget (), icp_tree);
+  EXPECT_EQ (icp_tree->getInputCloud (), nullptr);
+
+  // Aligning again reuses the levels and search trees of the target
+  const auto coarse_target = pyramid.getTargetLevel (0);
+  pyramid.setInputSource (source);
+  pyramid.align (cloud_reg);
+  EXPECT_EQ (pyramid.getTargetLevel (0), coarse_target);
+  EXPECT_TRUE (pyramid.getFinalTransformation ().isApprox (transformation, 1e-5f));
+
+  // Used directly against another target, the registration searches that target
+  icp->setInputSource (source);
+  icp->setInputTarget (source);
+  icp->setMaximumIterations (50);
+  icp->align (cloud_reg);
+  EXPECT_TRUE (icp->hasConverged ());
+  EXPECT_EQ (icp_tree->getInputCloud (), source);
+  EXPECT_TRUE (icp->getFinalTransformation ().isApprox (Eigen::Matrix4f::Identity (), 1e-4f));
+  EXPECT_NEAR (icp->getFitnessScore (), 0.0, 1e-10);
+}
+
+TEST (PCL, PyramidRegistrationIncrementalKdTree)
+{
+  // A target search method without a FLANN tree, whose point representation can not be
+  // taken over by the trees of the levels
+  IterativeClosestPoint<PointXYZ, PointXYZ>::Ptr icp (new IterativeClosestPoint<PointXYZ, PointXYZ>);
+  search::IncrementalKdTree<PointXYZ>::Ptr icp_tree (new search::IncrementalKdTree<PointXYZ>);
+  icp->setSearchMethodTarget (icp_tree);
+
+  registration::PyramidRegistration<PointXYZ, PointXYZ> pyramid;
+  pyramid.setRegistration (icp);
+  pyramid.addLevel (0.01f, 50, 0.05);
+  pyramid.addLevel (0.0f, 50, 0.05, 1e-8);
+  PointCloud<PointXYZ>::ConstPtr source (cloud_source.makeShared ());
+  pyramid.setInputSource (source);
+  pyramid.setInputTarget (cloud_target.makeShared ());
+
+  pyramid.align (cloud_reg);
+  EXPECT_TRUE (pyramid.hasConverged ());
+  EXPECT_EQ (icp->getSearchMethodTarget (), icp_tree);
+  EXPECT_EQ (icp_tree->getInputCloud (), nullptr);
+
+  Eigen::Matrix4f reference;
+  reference << 0.8806f,   0.03648f, -0.4724f,  0.03453f,
+              -0.02354f,  0.9992f,   0.03326f, -0.001519f,
+               0.4732f,  -0.01817f,  0.8808f,  0.04116f,
+               0.0f,      0.0f,      0.0f,     1.0f;
+  const Eigen::Matrix4f transformation = pyramid.getFinalTransformation ();
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_NEAR (transformation (i, j), reference (i, j), 1e-2);
+
+  // The fitness score leaves the search method of the registration untouched
+  PointCloud<PointXYZ> source_transformed;
+  transformPointCloud (*source, source_transformed, transformation);
+  search::BruteForce<PointXYZ> target_search;
+  target_search.setInputCloud (cloud_target.makeShared ());
+  pcl::Indices nn_indices (1);
+  std::vector<float> nn_dists (1);
+  double fitness_score = 0.0;
+  for (const auto& point : source_transformed)
+  {
+    target_search.nearestKSearch (point, 1, nn_indices, nn_dists);
+    fitness_score += nn_dists[0];
+  }
+  fitness_score /= static_cast<double> (source_transformed.size ());
+  EXPECT_NEAR (pyramid.getFitnessScore (), fitness_score, 1e-6);
+  EXPECT_EQ (icp->getSearchMethodTarget (), icp_tree);
+  EXPECT_EQ (icp_tree->getInputCloud (), nullptr);
+}
+
 TEST (PCL, IterativeClosestPointWithNormals)
 {
   IterativeClosestPointWithNormals<PointNormal, PointNormal, float> reg_float;
@@ -646,6 +775,135 @@ TEST (PCL, GeneralizedIterativeClosestPointBFGS)
   EXPECT_LT (reg.getFitnessScore (), 0.0001);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GeneralizedIterativeClosestPointCovarianceCache)
+{
+  using PointT = PointXYZ;
+  using Covariances = pcl::registration::GICPCovariances<PointT>;
+  PointCloud<PointT>::Ptr src (new PointCloud<PointT>);
+  copyPointCloud (cloud_source, *src);
+  PointCloud<PointT>::Ptr tgt (new PointCloud<PointT>);
+  copyPointCloud (cloud_target, *tgt);
+  PointCloud<PointT> output;
+
+  Covariances::Ptr src_covariances (new Covariances);
+  src_covariances->setInputCloud (src);
+  src_covariances->setNumberOfThreads (2);
+  ASSERT_TRUE (src_covariances->compute ());
+  ASSERT_EQ (src_covariances->size (), src->size ());
+  Covariances::Ptr tgt_covariances (new Covariances);
+  tgt_covariances->setInputCloud (tgt);
+  ASSERT_TRUE (tgt_covariances->compute ());
+
+  // The covariances describe local planes
+  for (std::size_t i = 0; i < src->size (); i += 10)
+  {
+    const Eigen::Matrix3d covariance = src_covariances->getCovariance (i);
+    const Eigen::Vector3d eigenvalues = Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> (covariance).eigenvalues ();
+    EXPECT_NEAR (eigenvalues[0], src_covariances->getEpsilon (), 1e-5);
+    EXPECT_NEAR (eigenvalues[1], 1.0, 1e-5);
+    EXPECT_NEAR (eigenvalues[2], 1.0, 1e-5);
+  }
+
+  // Reuse the covariances of each cloud as source and as target
+  GeneralizedIterativeClosestPoint<PointT, PointT> reg;
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setInputSource (src);
+  reg.setSourceCovarianceCache (src_covariances);
+  reg.setInputTarget (tgt);
+  reg.setTargetCovarianceCache (tgt_covariances);
+  reg.align (output);
+  EXPECT_EQ (output.size (), cloud_source.size ());
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+
+  reg.setInputSource (tgt);
+  reg.setSourceCovarianceCache (tgt_covariances);
+  reg.setInputTarget (src);
+  reg.setTargetCovarianceCache (src_covariances);
+  reg.align (output);
+  EXPECT_EQ (output.size (), cloud_target.size ());
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+
+  // Covariances of another cloud are ignored
+  reg.setSourceCovarianceCache (src_covariances);
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+
+  // Covariances computed with another number of neighbors are ignored
+  GeneralizedIterativeClosestPoint<PointT, PointT> reg_no_cache;
+  reg_no_cache.setMaximumIterations (50);
+  reg_no_cache.setTransformationEpsilon (1e-8);
+  reg_no_cache.setInputSource (src);
+  reg_no_cache.setInputTarget (tgt);
+  reg_no_cache.align (output);
+  Covariances::Ptr src_covariances_k5 (new Covariances);
+  src_covariances_k5->setInputCloud (src);
+  src_covariances_k5->setKSearch (5);
+  ASSERT_TRUE (src_covariances_k5->compute ());
+  reg.setInputSource (src);
+  reg.setSourceCovarianceCache (src_covariances_k5);
+  reg.setInputTarget (tgt);
+  reg.align (output);
+  EXPECT_EQ (reg.getFinalTransformation (), reg_no_cache.getFinalTransformation ());
+
+  // The caches do not make resetting the external covariance vectors ambiguous
+  reg.setSourceCovariances (nullptr);
+  reg.setTargetCovariances (nullptr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, VoxelizedGeneralizedIterativeClosestPoint)
+{
+  using PointT = PointXYZ;
+  PointCloud<PointT>::Ptr src (new PointCloud<PointT>);
+  copyPointCloud (cloud_source, *src);
+  PointCloud<PointT>::Ptr tgt (new PointCloud<PointT>);
+  copyPointCloud (cloud_target, *tgt);
+  PointCloud<PointT> output;
+
+  VoxelizedGeneralizedIterativeClosestPoint<PointT, PointT> reg;
+  reg.setResolution (0.02f);
+  EXPECT_DOUBLE_EQ (reg.getMaxCorrespondenceDistance (), 0.02f);
+  reg.setInputSource (src);
+  reg.setInputTarget (tgt);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setNumberOfThreads (1);
+
+  // Register. Only the voxels of the target are needed, its kd-tree is built by getFitnessScore.
+  reg.align (output);
+  EXPECT_EQ (output.size (), cloud_source.size ());
+  EXPECT_EQ (reg.getSearchMethodTarget ()->getInputCloud (), nullptr);
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+  EXPECT_EQ (reg.getSearchMethodTarget ()->getInputCloud (), tgt);
+  const Eigen::Matrix4f serial_transformation = reg.getFinalTransformation ();
+
+  // The per thread results are reduced in a fixed order
+  reg.setNumberOfThreads (4);
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.0001);
+  EXPECT_TRUE (reg.getFinalTransformation ().isApprox (serial_transformation, 1e-4f));
+
+  // Test guess matrix
+  Eigen::Isometry3f transform = Eigen::Isometry3f (Eigen::AngleAxisf (0.25 * M_PI, Eigen::Vector3f::UnitX ())
+                                                 * Eigen::AngleAxisf (0.50 * M_PI, Eigen::Vector3f::UnitY ())
+                                                 * Eigen::AngleAxisf (0.33 * M_PI, Eigen::Vector3f::UnitZ ()));
+  transform.translation () = Eigen::Vector3f (0.1, 0.2, 0.3);
+  PointCloud<PointT>::Ptr transformed_tgt (new PointCloud<PointT>);
+  pcl::transformPointCloud (*tgt, *transformed_tgt, transform.matrix ());
+
+  VoxelizedGeneralizedIterativeClosestPoint<PointT, PointT> reg_guess;
+  reg_guess.setResolution (0.02f);
+  reg_guess.setInputSource (src);
+  reg_guess.setInputTarget (transformed_tgt);
+  reg_guess.setMaximumIterations (50);
+  reg_guess.setTransformationEpsilon (1e-8);
+  reg_guess.align (output, transform.matrix ());
+  EXPECT_EQ (output.size (), cloud_source.size ());
+  EXPECT_LT (reg_guess.getFitnessScore (), 0.0001);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, GeneralizedIterativeClosestPoint6D)
 {
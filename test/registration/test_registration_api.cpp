@@ -56,6 +56,7 @@
 #include <pcl/registration/transformation_estimation_svd.h>
 #include <pcl/registration/transformation_estimation_dual_quaternion.h>
 #include <pcl/registration/transformation_estimation_point_to_plane_lls.h>
+#include <pcl/registration/transformation_estimation_point_to_plane_lls_weighted.h>
 #include <pcl/registration/transformation_estimation_point_to_plane.h>
 #include <pcl/registration/transformation_estimation_symmetric_point_to_plane_lls.h>
 #include <pcl/features/normal_3d.h>
@@ -655,6 +656,72 @@ TEST (PCL, TransformationEstimationPointToPlane)
       EXPECT_NEAR (estimated_transform_double (i, j), ground_truth_tform (i, j), 1e-3);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, TransformationEstimationPointToPlaneMultithreaded)
+{
+  // Create a dense test cloud, with one invalid correspondence
+  pcl::PointCloud<pcl::PointNormal>::Ptr src (new pcl::PointCloud<pcl::PointNormal>);
+  src->height = 1;
+  for (float x = -5.0f; x <= 5.0f; x += 0.05f)
+    for (float y = -5.0f; y <= 5.0f; y += 0.05f)
+    {
+      pcl::PointNormal p;
+      p.x = x;
+      p.y = y;
+      p.z = 0.1f * powf (x, 2.0f) + 0.2f * p.x * p.y - 0.3f * y + 1.0f;
+      p.getNormalVector3fMap () = Eigen::Vector3f (-0.2f * p.x - 0.2f, 0.6f * p.y - 0.2f, 1.0f).normalized ();
+      src->points.push_back (p);
+    }
+  src->points[src->size () / 2].x = std::numeric_limits<float>::quiet_NaN ();
+  src->width = src->size ();
+  src->is_dense = false;
+
+  Eigen::Matrix4f ground_truth_tform = Eigen::Matrix4f::Identity ();
+  ground_truth_tform.row (0) <<  0.9938f,  0.0988f,  0.0517f,  0.1000f;
+  ground_truth_tform.row (1) << -0.0997f,  0.9949f,  0.0149f, -0.2000f;
+  ground_truth_tform.row (2) << -0.0500f, -0.0200f,  0.9986f,  0.3000f;
+  ground_truth_tform.row (3) <<  0.0000f,  0.0000f,  0.0000f,  1.0000f;
+
+  pcl::PointCloud<pcl::PointNormal>::Ptr tgt (new pcl::PointCloud<pcl::PointNormal>);
+  pcl::transformPointCloudWithNormals (*src, *tgt, ground_truth_tform);
+
+  // The LM estimators do not skip invalid points, so leave that one out
+  pcl::Correspondences correspondences;
+  for (std::size_t i = 0; i < src->size (); ++i)
+    if (pcl::isFinite ((*src)[i]))
+      correspondences.emplace_back (i, i, 0.f);
+  std::vector<float> weights (src->size (), 1.0f);
+
+  pcl::registration::TransformationEstimationPointToPlaneLLS<pcl::PointNormal, pcl::PointNormal> lls;
+  pcl::registration::TransformationEstimationPointToPlaneLLSWeighted<pcl::PointNormal, pcl::PointNormal> lls_weighted;
+  lls_weighted.setCorrespondenceWeights (weights);
+  pcl::registration::TransformationEstimationPointToPlane<pcl::PointNormal, pcl::PointNormal, double> lm;
+
+  Eigen::Matrix4f lls_serial, lls_parallel, weighted_serial, weighted_parallel;
+  Eigen::Matrix4d lm_serial, lm_parallel;
+  lls.estimateRigidTransformation (*src, *tgt, correspondences, lls_serial);
+  lls_weighted.estimateRigidTransformation (*src, *tgt, weighted_serial);
+  lm.estimateRigidTransformation (*src, *tgt, correspondences, lm_serial);
+
+  lls.setNumberOfThreads (4);
+  lls_weighted.setNumberOfThreads (4);
+  lm.setNumberOfThreads (4);
+  lls.estimateRigidTransformation (*src, *tgt, correspondences, lls_parallel);
+  lls_weighted.estimateRigidTransformation (*src, *tgt, weighted_parallel);
+  lm.estimateRigidTransformation (*src, *tgt, correspondences, lm_parallel);
+
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR (lls_serial (i, j), ground_truth_tform (i, j), 1e-2);
+      EXPECT_NEAR (weighted_serial (i, j), lls_serial (i, j), 1e-6);
+      EXPECT_NEAR (lls_parallel (i, j), lls_serial (i, j), 1e-6);
+      EXPECT_NEAR (weighted_parallel (i, j), weighted_serial (i, j), 1e-6);
+      EXPECT_NEAR (lm_serial (i, j), ground_truth_tform (i, j), 1e-3);
+      EXPECT_EQ (lm_parallel (i, j), lm_serial (i, j));
+    }
+}
+
 TEST (PCL, TransformationEstimationSymmetricPointToPlaneLLS)
 {
   pcl::registration::TransformationEstimationSymmetricPointToPlaneLLS<pcl::PointNormal, pcl::PointNormal> transform_estimator;
@@ -235,6 +235,112 @@ TEST (PCL, SampleConsensusPrerejective)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, SampleConsensusMultithreaded)
+{
+  // Transform the source cloud by a large amount
+  Eigen::Vector3f initial_offset (100, 0, 0);
+  float angle = static_cast<float> (M_PI) / 2.0f;
+  Eigen::Quaternionf initial_rotation (std::cos (angle / 2), 0, 0, std::sin (angle / 2));
+  PointCloud<PointXYZ> cloud_source_transformed;
+  transformPointCloud (cloud_source, cloud_source_transformed, initial_offset, initial_rotation);
+
+  // Create shared pointers
+  PointCloud<PointXYZ>::Ptr cloud_source_ptr, cloud_target_ptr;
+  cloud_source_ptr = cloud_source_transformed.makeShared ();
+  cloud_target_ptr = cloud_target.makeShared ();
+
+  // Estimate the FPFH features of both clouds
+  search::KdTree<PointXYZ>::Ptr tree (new search::KdTree<PointXYZ>);
+
+  NormalEstimation<PointXYZ, Normal> norm_est;
+  norm_est.setSearchMethod (tree);
+  norm_est.setRadiusSearch (0.05);
+  PointCloud<Normal>::Ptr normals(new PointCloud<Normal>);
+
+  FPFHEstimation<PointXYZ, Normal, FPFHSignature33> fpfh_est;
+  fpfh_est.setSearchMethod (tree);
+  fpfh_est.setRadiusSearch (0.05);
+  PointCloud<FPFHSignature33>::Ptr features_source(new PointCloud<FPFHSignature33>), features_target(new PointCloud<FPFHSignature33>);
+
+  norm_est.setInputCloud (cloud_source_ptr);
+  norm_est.compute (*normals);
+  fpfh_est.setInputCloud (cloud_source_ptr);
+  fpfh_est.setInputNormals (normals);
+  fpfh_est.compute (*features_source);
+
+  norm_est.setInputCloud (cloud_target_ptr);
+  norm_est.compute (*normals);
+  fpfh_est.setInputCloud (cloud_target_ptr);
+  fpfh_est.setInputNormals (normals);
+  fpfh_est.compute (*features_target);
+
+  // The result only depends on the seed, for any number of threads including one
+  SampleConsensusInitialAlignment<PointXYZ, PointXYZ, FPFHSignature33> sac_ia;
+  sac_ia.setMinSampleDistance (0.05f);
+  sac_ia.setMaxCorrespondenceDistance (0.1);
+  sac_ia.setMaximumIterations (1000);
+  sac_ia.setInputSource (cloud_source_ptr);
+  sac_ia.setInputTarget (cloud_target_ptr);
+  sac_ia.setSourceFeatures (features_source);
+  sac_ia.setTargetFeatures (features_target);
+
+  sac_ia.setNumberOfThreads (1);
+  sac_ia.align (cloud_reg);
+  EXPECT_EQ (cloud_reg.size (), cloud_source.size ());
+  EXPECT_LT (sac_ia.getFitnessScore (), 0.0005);
+  const Eigen::Matrix4f sac_ia_transformation = sac_ia.getFinalTransformation ();
+
+  for (const unsigned int nr_threads : {1u, 2u, 4u})
+  {
+    std::srand (nr_threads); // std::rand has no influence on the result
+    sac_ia.setNumberOfThreads (nr_threads);
+    sac_ia.align (cloud_reg);
+    EXPECT_LT (sac_ia.getFitnessScore (), 0.0005);
+    if (sac_ia.getNumberOfThreads () == nr_threads)
+    {
+      EXPECT_EQ (sac_ia_transformation, sac_ia.getFinalTransformation ());
+    }
+  }
+
+  SampleConsensusPrerejective<PointXYZ, PointXYZ, FPFHSignature33> prerejective;
+  prerejective.setMaxCorrespondenceDistance (0.1);
+  prerejective.setMaximumIterations (5000);
+  prerejective.setSimilarityThreshold (0.6f);
+  prerejective.setCorrespondenceRandomness (2);
+  prerejective.setInlierFraction (0.5f);
+  prerejective.setInputSource (cloud_source_ptr);
+  prerejective.setInputTarget (cloud_target_ptr);
+  prerejective.setSourceFeatures (features_source);
+  prerejective.setTargetFeatures (features_target);
+
+  prerejective.setNumberOfThreads (1);
+  prerejective.align (cloud_reg);
+  EXPECT_TRUE (prerejective.hasConverged ());
+  const pcl::Indices prerejective_inliers = prerejective.getInliers ();
+  EXPECT_GT (static_cast<float> (prerejective_inliers.size ()) / static_cast<float> (cloud_source.size ()), 0.95f);
+  const Eigen::Matrix4f prerejective_transformation = prerejective.getFinalTransformation ();
+
+  for (const unsigned int nr_threads : {1u, 2u, 4u})
+  {
+    std::srand (nr_threads); // std::rand has no influence on the result
+    prerejective.setNumberOfThreads (nr_threads);
+    prerejective.align (cloud_reg);
+    EXPECT_TRUE (prerejective.hasConverged ());
+    if (prerejective.getNumberOfThreads () == nr_threads)
+    {
+      EXPECT_EQ (prerejective_transformation, prerejective.getFinalTransformation ());
+      EXPECT_EQ (prerejective_inliers, prerejective.getInliers ());
+    }
+  }
+
+  // Another seed draws other hypotheses
+  prerejective.setSeed (prerejective.getSeed () + 1);
+  prerejective.align (cloud_reg);
+  EXPECT_TRUE (prerejective.hasConverged ());
+  EXPECT_NE (prerejective_transformation, prerejective.getFinalTransformation ());
+}
+
 int
 main (int argc, char** argv)
 {
@@ -342,6 +342,62 @@ TEST (PCL, Octree_Pointcloud_Neighbours_Within_Radius_Search)
   }
 }
 
+TEST (PCL, Octree_Batched_Search)
+{
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+
+  const unsigned int seed = time (nullptr);
+  srand (seed);
+  SCOPED_TRACE("seed=" + std::to_string(seed));
+
+  for (std::size_t i = 0; i < 1000; i++)
+  {
+    cloudIn->push_back (PointXYZ (static_cast<float> (10.0 * (rand () / static_cast<double> (RAND_MAX))),
+                                  static_cast<float> (10.0 * (rand () / static_cast<double> (RAND_MAX))),
+                                  static_cast<float> (5.0 *  (rand () / static_cast<double> (RAND_MAX)))));
+  }
+
+  pcl::search::Octree<PointXYZ> octree (0.1);
+  octree.setInputCloud (cloudIn);
+
+  pcl::Indices queries;
+  for (index_t i = 0; i < static_cast<index_t> (cloudIn->size ()); i += 3)
+    queries.push_back (i);
+
+  for (const unsigned int nr_threads : {1u, 4u})
+  {
+    octree.setNumberOfThreads (nr_threads);
+
+    // batched results must match the single query results, in the order of the queries
+    pcl::search::Neighborhoods neighborhoods;
+    octree.nearestKSearch (*cloudIn, queries, 8, neighborhoods);
+    ASSERT_EQ (neighborhoods.size (), queries.size ());
+    pcl::Indices k_indices;
+    std::vector<float> k_sqr_distances;
+    for (std::size_t i = 0; i < queries.size (); ++i)
+    {
+      octree.nearestKSearch ((*cloudIn)[queries[i]], 8, k_indices, k_sqr_distances);
+      ASSERT_EQ (neighborhoods.getNumberOfNeighbors (i), k_indices.size ());
+      for (std::size_t j = 0; j < k_indices.size (); ++j)
+      {
+        EXPECT_EQ (neighborhoods.indices[neighborhoods.offsets[i] + j], k_indices[j]);
+        EXPECT_EQ (neighborhoods.sqr_distances[neighborhoods.offsets[i] + j], k_sqr_distances[j]);
+      }
+    }
+
+    octree.radiusSearch (*cloudIn, pcl::Indices (), 0.8, neighborhoods);
+    ASSERT_EQ (neighborhoods.size (), cloudIn->size ());
+    EXPECT_EQ (neighborhoods.offsets.back (), neighborhoods.indices.size ());
+    for (std::size_t i = 0; i < cloudIn->size (); ++i)
+    {
+      octree.radiusSearch ((*cloudIn)[i], 0.8, k_indices, k_sqr_distances);
+      ASSERT_EQ (neighborhoods.getNumberOfNeighbors (i), k_indices.size ());
+      for (std::size_t j = 0; j < k_indices.size (); ++j)
+        EXPECT_EQ (neighborhoods.indices[neighborhoods.offsets[i] + j], k_indices[j]);
+    }
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
@@ -45,6 +45,8 @@
 #include <pcl/search/kdtree_nanoflann.h>
 #include <pcl/search/organized.h>
 #include <pcl/search/octree.h>
+#include <pcl/search/uniform_grid.h>
+#include <pcl/search/incremental_kdtree.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/common/point_tests.h> // for pcl::isFinite
 
@@ -129,6 +131,12 @@ pcl::search::Octree<pcl::PointXYZ> octree_search (0.1);
 /** \brief instance of Organized search method to be tested*/
 pcl::search::OrganizedNeighbor<pcl::PointXYZ> organized;
 
+/** \brief instance of UniformGrid search method to be tested*/
+pcl::search::UniformGrid<pcl::PointXYZ> uniform_grid (0.05, true);
+
+/** \brief instance of IncrementalKdTree search method to be tested*/
+pcl::search::IncrementalKdTree<pcl::PointXYZ> incremental_kdtree;
+
 /** \brief list of search methods for unorganized search test*/
 std::vector<search::Search<PointXYZ>* > unorganized_search_methods;
 
@@ -557,6 +565,110 @@ TEST (PCL, Organized_Sparse_View_Radius)
 }
 #endif
 
+TEST (PCL, IncrementalKdTree_Update)
+{
+  // Build the tree on the first half of the cloud, add the second half in small batches
+  // and delete the points of a box, then compare against a brute force search over the
+  // remaining points
+  const std::size_t half = unorganized_dense_cloud->size () / 2;
+  PointCloud<PointXYZ>::Ptr first_half (new PointCloud<PointXYZ>);
+  first_half->insert (first_half->end (), unorganized_dense_cloud->begin (), unorganized_dense_cloud->begin () + half);
+
+  pcl::search::IncrementalKdTree<PointXYZ> tree;
+  tree.setInputCloud (first_half);
+  for (std::size_t start = half; start < unorganized_dense_cloud->size (); start += 100)
+  {
+    PointCloud<PointXYZ> batch;
+    const std::size_t end = std::min<std::size_t> (start + 100, unorganized_dense_cloud->size ());
+    batch.insert (batch.end (), unorganized_dense_cloud->begin () + start, unorganized_dense_cloud->begin () + end);
+    tree.addPoints (batch);
+  }
+  ASSERT_EQ (unorganized_dense_cloud->size (), tree.getInputCloud ()->size ());
+  ASSERT_EQ (unorganized_dense_cloud->size (), tree.getNumberOfPoints ());
+
+  const Eigen::Vector3f min_pt (0.2f, 0.2f, 0.2f), max_pt (0.6f, 0.7f, 0.8f);
+  const std::size_t nr_deleted = tree.deletePointsInBox (min_pt, max_pt);
+  PointCloud<PointXYZ>::Ptr remaining (new PointCloud<PointXYZ>);
+  for (const auto &point : *unorganized_dense_cloud)
+    if (!((point.getVector3fMap ().array () >= min_pt.array ()).all () &&
+          (point.getVector3fMap ().array () <= max_pt.array ()).all ()))
+      remaining->push_back (point);
+  EXPECT_EQ (unorganized_dense_cloud->size () - remaining->size (), nr_deleted);
+  EXPECT_EQ (remaining->size (), tree.getNumberOfPoints ());
+
+  pcl::search::BruteForce<PointXYZ> reference (true);
+  reference.setInputCloud (remaining);
+
+  const auto compare = [&] (bool same_indices)
+  {
+    pcl::Indices indices, reference_indices;
+    std::vector<float> distances, reference_distances;
+    for (const auto &query_index : unorganized_dense_cloud_query_indices)
+    {
+      const PointXYZ &query = (*unorganized_dense_cloud)[query_index];
+      tree.nearestKSearch (query, 10, indices, distances);
+      reference.nearestKSearch (query, 10, reference_indices, reference_distances);
+      ASSERT_EQ (reference_indices.size (), indices.size ());
+      for (std::size_t i = 0; i < indices.size (); ++i)
+      {
+        EXPECT_FLOAT_EQ (reference_distances[i], distances[i]);
+        const PointXYZ &point = (*tree.getInputCloud ())[indices[i]];
+        EXPECT_FALSE ((point.getVector3fMap ().array () >= min_pt.array ()).all () &&
+                      (point.getVector3fMap ().array () <= max_pt.array ()).all ());
+      }
+
+      tree.radiusSearch (query, 0.1, indices, distances);
+      reference.radiusSearch (query, 0.1, reference_indices, reference_distances);
+      ASSERT_EQ (reference_indices.size (), indices.size ());
+      for (std::size_t i = 0; i < indices.size (); ++i)
+        EXPECT_FLOAT_EQ (reference_distances[i], distances[i]);
+      if (same_indices)
+        EXPECT_EQ (reference_indices, indices);
+    }
+  };
+  compare (false);
+
+  // After compacting, the cloud of the tree holds exactly the remaining points
+  tree.compact ();
+  ASSERT_EQ (remaining->size (), tree.getInputCloud ()->size ());
+  for (std::size_t i = 0; i < remaining->size (); ++i)
+    EXPECT_EQ ((*remaining)[i].getVector3fMap (), (*tree.getInputCloud ())[i].getVector3fMap ());
+  compare (true);
+}
+
+TEST (PCL, IncrementalKdTree_Parameters)
+{
+  // The tree keeps its own point representation and epsilon, and the accessors of
+  // search::KdTree must not touch the FLANN tree it does not have
+  pcl::search::IncrementalKdTree<PointXYZ>::Ptr tree (new pcl::search::IncrementalKdTree<PointXYZ>);
+  tree->setInputCloud (unorganized_dense_cloud);
+  const pcl::search::KdTree<PointXYZ>::Ptr base = tree;
+  EXPECT_EQ (nullptr, base->getPointRepresentation ());
+  EXPECT_EQ (0.0f, base->getEpsilon ());
+
+  const pcl::PointRepresentation<PointXYZ>::ConstPtr representation (new pcl::DefaultPointRepresentation<PointXYZ>);
+  tree->setPointRepresentation (representation);
+  EXPECT_EQ (representation, tree->getPointRepresentation ());
+
+  // An epsilon of zero keeps the nearest neighbors exact, a larger one may only return
+  // neighbors within (1 + eps) of the exact distances
+  pcl::search::BruteForce<PointXYZ> reference (true);
+  reference.setInputCloud (unorganized_dense_cloud);
+  tree->setEpsilon (0.5f);
+  EXPECT_EQ (0.5f, tree->getEpsilon ());
+  pcl::Indices indices, reference_indices;
+  std::vector<float> distances, reference_distances;
+  for (const auto &query_index : unorganized_dense_cloud_query_indices)
+  {
+    const PointXYZ &query = (*unorganized_dense_cloud)[query_index];
+    tree->nearestKSearch (query, 5, indices, distances);
+    reference.nearestKSearch (query, 5, reference_indices, reference_distances);
+    ASSERT_EQ (reference_distances.size (), distances.size ());
+    for (std::size_t i = 0; i < distances.size (); ++i)
+      EXPECT_LE (distances[i], reference_distances[i] * 1.5f * 1.5f + 1e-6f);
+  }
+}
+
 /** \brief create subset of point in cloud to use as query points
   * \param[out] query_indices resulting query indices - not guaranteed to have size of query_count but guaranteed not to exceed that value
   * \param cloud input cloud required to check for nans and to get number of points
@@ -674,6 +786,8 @@ main (int argc, char** argv)
   unorganized_search_methods.push_back (&KDTreeNanoflann);
 #endif
   unorganized_search_methods.push_back (&octree_search);
+  unorganized_search_methods.push_back (&uniform_grid);
+  unorganized_search_methods.push_back (&incremental_kdtree);
   
   organized_search_methods.push_back (&brute_force);
   organized_search_methods.push_back (&KDTree);
@@ -682,6 +796,8 @@ main (int argc, char** argv)
   organized_search_methods.push_back (&KDTreeNanoflann);
 #endif
   organized_search_methods.push_back (&octree_search);
+  organized_search_methods.push_back (&uniform_grid);
+  organized_search_methods.push_back (&incremental_kdtree);
   organized_search_methods.push_back (&organized);
   
   createQueryIndices (unorganized_dense_cloud_query_indices, unorganized_dense_cloud, query_count);
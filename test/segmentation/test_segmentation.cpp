@@ -42,8 +42,12 @@
 #include <pcl/point_cloud.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/search/search.h>
+#include <pcl/search/uniform_grid.h>
+#include <pcl/common/centroid.h>
 #include <pcl/features/normal_3d.h>
 
+#include <pcl/segmentation/conditional_euclidean_clustering.h>
+#include <pcl/segmentation/extract_clusters.h>
 #include <pcl/segmentation/extract_polygonal_prism_data.h>
 #include <pcl/segmentation/segment_differences.h>
 #include <pcl/segmentation/region_growing.h>
@@ -385,6 +389,121 @@ TEST (ExtractPolygonalPrism, Segmentation)
   EXPECT_EQ (output.indices.size (), 0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, Parallel)
+{
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (index_t i = 0; i < static_cast<index_t> (another_cloud_->size ()); i += 2)
+    indices->push_back (i);
+
+  for (const double tolerance : {0.02, 0.05, 0.1})
+  {
+    EuclideanClusterExtraction<PointXYZ> ec;
+    ec.setInputCloud (another_cloud_);
+    ec.setIndices (indices);
+    ec.setClusterTolerance (tolerance);
+
+    std::vector<PointIndices> serial_clusters, parallel_clusters;
+    ec.extract (serial_clusters);
+    ec.setNumberOfThreads (4);
+    ec.extract (parallel_clusters);
+
+    // Same clusters, in the same order
+    ASSERT_EQ (parallel_clusters.size (), serial_clusters.size ());
+    for (std::size_t i = 0; i < serial_clusters.size (); ++i)
+      EXPECT_EQ (parallel_clusters[i].indices, serial_clusters[i].indices);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, RejectedInputCloud)
+{
+  // A grid without a valid cell size rejects every cloud
+  EuclideanClusterExtraction<PointXYZ> ec;
+  ec.setInputCloud (another_cloud_);
+  ec.setClusterTolerance (0.05);
+  ec.setSearchMethod (pcl::search::UniformGrid<PointXYZ>::Ptr (new pcl::search::UniformGrid<PointXYZ> (0.0)));
+
+  std::vector<PointIndices> clusters (1);
+  ec.extract (clusters);
+  EXPECT_TRUE (clusters.empty ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sort the indices of every cluster, then the clusters, so that clusterings can be compared independently of the
+// order in which the search method returns the neighbors
+std::vector<Indices>
+sortClusters (const std::vector<PointIndices> &clusters)
+{
+  std::vector<Indices> sorted;
+  for (const auto &cluster : clusters)
+  {
+    sorted.push_back (cluster.indices);
+    std::sort (sorted.back ().begin (), sorted.back ().end ());
+  }
+  std::sort (sorted.begin (), sorted.end ());
+  return (sorted);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, UniformGrid)
+{
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (index_t i = 0; i < static_cast<index_t> (another_cloud_->size ()); i += 2)
+    indices->push_back (i);
+
+  for (const double tolerance : {0.02, 0.05, 0.1})
+  {
+    EuclideanClusterExtraction<PointXYZ> ec;
+    ec.setInputCloud (another_cloud_);
+    ec.setIndices (indices);
+    ec.setClusterTolerance (tolerance);
+
+    std::vector<PointIndices> kdtree_clusters, grid_clusters;
+    ec.extract (kdtree_clusters);
+    ec.setSearchMethod (pcl::search::UniformGrid<PointXYZ>::Ptr (new pcl::search::UniformGrid<PointXYZ> (tolerance)));
+    ec.extract (grid_clusters);
+
+    EXPECT_FALSE (kdtree_clusters.empty ());
+    EXPECT_EQ (sortClusters (grid_clusters), sortClusters (kdtree_clusters));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (ConditionalEuclideanClustering, UniformGrid)
+{
+  pcl::IndicesPtr indices (new pcl::Indices);
+  for (index_t i = 0; i < static_cast<index_t> (another_cloud_->size ()); i += 2)
+    indices->push_back (i);
+
+  // A transitive condition (both points on the same side of a plane), so that the clusters do not depend on the
+  // order in which the neighbors are visited
+  Eigen::Vector4f centroid;
+  pcl::compute3DCentroid (*another_cloud_, *indices, centroid);
+  const float split = centroid.x ();
+  const auto same_side = [split] (const PointXYZ &a, const PointXYZ &b, float)
+  {
+    return ((a.x < split) == (b.x < split));
+  };
+
+  for (const float tolerance : {0.02f, 0.05f, 0.1f})
+  {
+    ConditionalEuclideanClustering<PointXYZ> cec;
+    cec.setInputCloud (another_cloud_);
+    cec.setIndices (indices);
+    cec.setConditionFunction (same_side);
+    cec.setClusterTolerance (tolerance);
+
+    pcl::IndicesClusters kdtree_clusters, grid_clusters;
+    cec.segment (kdtree_clusters);
+    cec.setSearchMethod (pcl::search::UniformGrid<PointXYZ>::Ptr (new pcl::search::UniformGrid<PointXYZ> (tolerance)));
+    cec.segment (grid_clusters);
+
+    EXPECT_FALSE (kdtree_clusters.empty ());
+    EXPECT_EQ (sortClusters (grid_clusters), sortClusters (kdtree_clusters));
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)